@@ -21,6 +21,8 @@
 #include "nm-default.h"
 
 #include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
 
 #include "nm-dbus-interface.h"
 #include "nm-connection.h"
@@ -534,3 +536,525 @@ nm_dispatcher_utils_construct_envp (const char *action,
 	return envp;
 }
 
+
+/*****************************************************************************/
+
+struct _NMDispatcherScriptDir {
+	char *dirname;
+	char *no_wait_dirname;
+
+	/* the scripts of @dirname, or %NULL if they must be read again. */
+	GPtrArray *scripts;
+
+	GFileMonitor *monitor;
+	GFileMonitor *monitor_no_wait;
+};
+
+static inline gboolean
+check_permissions (struct stat *s, const char **out_error_msg)
+{
+	g_return_val_if_fail (s != NULL, FALSE);
+	g_return_val_if_fail (out_error_msg != NULL, FALSE);
+	g_return_val_if_fail (*out_error_msg == NULL, FALSE);
+
+	/* Only accept regular files */
+	if (!S_ISREG (s->st_mode)) {
+		*out_error_msg = "not a regular file.";
+		return FALSE;
+	}
+
+	/* Only accept files owned by root */
+	if (s->st_uid != 0) {
+		*out_error_msg = "not owned by root.";
+		return FALSE;
+	}
+
+	/* Only accept files not writable by group or other, and not SUID */
+	if (s->st_mode & (S_IWGRP | S_IWOTH | S_ISUID)) {
+		*out_error_msg = "writable by group or other, or set-UID.";
+		return FALSE;
+	}
+
+	/* Only accept files executable by the owner */
+	if (!(s->st_mode & S_IXUSR)) {
+		*out_error_msg = "not executable by owner.";
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+check_filename (const char *file_name)
+{
+	static const char *bad_suffixes[] = {
+		"~",
+		".rpmsave",
+		".rpmorig",
+		".rpmnew",
+		".swp",
+	};
+	char *tmp;
+	guint i;
+
+	/* File must not be a backup file, package management file, or start with '.' */
+
+	if (file_name[0] == '.')
+		return FALSE;
+	for (i = 0; i < G_N_ELEMENTS (bad_suffixes); i++) {
+		if (g_str_has_suffix (file_name, bad_suffixes[i]))
+			return FALSE;
+	}
+	tmp = g_strrstr (file_name, ".dpkg-");
+	if (tmp && !strchr (&tmp[1], '.'))
+		return FALSE;
+	return TRUE;
+}
+
+static gboolean
+script_must_wait (const char *path, const char *no_wait_dirname)
+{
+	gs_free char *link = NULL;
+	gs_free char *dir = NULL;
+	gs_free char *real = NULL;
+	char *tmp;
+
+	link = g_file_read_link (path, NULL);
+	if (link) {
+		if (!g_path_is_absolute (link)) {
+			dir = g_path_get_dirname (path);
+			tmp = g_build_path ("/", dir, link, NULL);
+			g_free (link);
+			g_free (dir);
+			link = tmp;
+		}
+
+		dir = g_path_get_dirname (link);
+		real = realpath (dir, NULL);
+
+		if (real && !strcmp (real, no_wait_dirname))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+script_free (gpointer data)
+{
+	NMDispatcherScript *script = data;
+
+	g_free (script->path);
+	g_slice_free (NMDispatcherScript, script);
+}
+
+static int
+script_cmp (gconstpointer a, gconstpointer b)
+{
+	const NMDispatcherScript *script_a = *((const NMDispatcherScript *const *) a);
+	const NMDispatcherScript *script_b = *((const NMDispatcherScript *const *) b);
+
+	return strcmp (script_a->path, script_b->path);
+}
+
+static GPtrArray *
+find_scripts (const char *dirname, const char *no_wait_dirname)
+{
+	GDir *dir;
+	const char *filename;
+	GPtrArray *scripts;
+	GError *error = NULL;
+
+	scripts = g_ptr_array_new_with_free_func (script_free);
+
+	if (!(dir = g_dir_open (dirname, 0, &error))) {
+		g_message ("find-scripts: Failed to open dispatcher directory '%s': %s",
+		           dirname, error->message);
+		g_error_free (error);
+		return scripts;
+	}
+
+	while ((filename = g_dir_read_name (dir))) {
+		char *path;
+		struct stat	st;
+		int err;
+		const char *err_msg = NULL;
+
+		if (!check_filename (filename))
+			continue;
+
+		path = g_build_filename (dirname, filename, NULL);
+
+		err = stat (path, &st);
+		if (err)
+			g_warning ("find-scripts: Failed to stat '%s': %d", path, err);
+		else if (S_ISDIR (st.st_mode))
+			; /* silently skip. */
+		else if (!check_permissions (&st, &err_msg))
+			g_warning ("find-scripts: Cannot execute '%s': %s", path, err_msg);
+		else {
+			/* success */
+			NMDispatcherScript *script;
+
+			script = g_slice_new (NMDispatcherScript);
+			script->path = path;
+			script->wait = script_must_wait (path, no_wait_dirname);
+			g_ptr_array_add (scripts, script);
+			path = NULL;
+		}
+		g_free (path);
+	}
+	g_dir_close (dir);
+
+	g_ptr_array_sort (scripts, script_cmp);
+	return scripts;
+}
+
+static void
+monitor_changed_cb (GFileMonitor *monitor,
+                    GFile *file,
+                    GFile *other_file,
+                    GFileMonitorEvent event_type,
+                    gpointer user_data)
+{
+	NMDispatcherScriptDir *dir = user_data;
+
+	g_clear_pointer (&dir->scripts, g_ptr_array_unref);
+}
+
+static GFileMonitor *
+monitor_new (NMDispatcherScriptDir *dir, const char *dirname)
+{
+	gs_unref_object GFile *file = NULL;
+	GFileMonitor *monitor;
+	GError *error = NULL;
+
+	file = g_file_new_for_path (dirname);
+	monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, &error);
+	if (!monitor) {
+		g_message ("find-scripts: Failed to monitor directory '%s': %s",
+		           dirname, error->message);
+		g_error_free (error);
+		return NULL;
+	}
+	g_signal_connect (monitor, "changed", G_CALLBACK (monitor_changed_cb), dir);
+	return monitor;
+}
+
+/**
+ * nm_dispatcher_script_dir_new:
+ * @dirname: the directory with the scripts
+ * @no_wait_dirname: scripts that are symlinks into this directory
+ *   don't need to be waited for
+ * @monitor: whether to remember the scripts until the directories change
+ *
+ * Returns: the inventory of the scripts in @dirname.
+ */
+NMDispatcherScriptDir *
+nm_dispatcher_script_dir_new (const char *dirname,
+                              const char *no_wait_dirname,
+                              gboolean monitor)
+{
+	NMDispatcherScriptDir *dir;
+
+	g_return_val_if_fail (dirname, NULL);
+	g_return_val_if_fail (no_wait_dirname, NULL);
+
+	dir = g_slice_new0 (NMDispatcherScriptDir);
+	dir->dirname = g_strdup (dirname);
+	dir->no_wait_dirname = g_strdup (no_wait_dirname);
+
+	if (monitor) {
+		/* whether a script is "no-wait" depends on the target of its
+		 * symlink, so changes to the no-wait directory count too. Changes
+		 * to the permissions of a symlink target elsewhere are not noticed. */
+		dir->monitor = monitor_new (dir, dirname);
+		if (dir->monitor)
+			dir->monitor_no_wait = monitor_new (dir, no_wait_dirname);
+		if (!dir->monitor_no_wait)
+			g_clear_object (&dir->monitor);
+	}
+
+	return dir;
+}
+
+void
+nm_dispatcher_script_dir_free (NMDispatcherScriptDir *dir)
+{
+	guint i;
+
+	if (!dir)
+		return;
+
+	for (i = 0; i < 2; i++) {
+		GFileMonitor **monitor = i == 0 ? &dir->monitor : &dir->monitor_no_wait;
+
+		if (*monitor) {
+			g_signal_handlers_disconnect_by_func (*monitor, monitor_changed_cb, dir);
+			g_file_monitor_cancel (*monitor);
+			g_clear_object (monitor);
+		}
+	}
+	if (dir->scripts)
+		g_ptr_array_unref (dir->scripts);
+	g_free (dir->dirname);
+	g_free (dir->no_wait_dirname);
+	g_slice_free (NMDispatcherScriptDir, dir);
+}
+
+/**
+ * nm_dispatcher_script_dir_get_scripts:
+ * @dir: the inventory
+ *
+ * The scripts are only read again when the directory changed since the
+ * last call, or if it cannot be monitored. Changes are noticed when the
+ * main loop processes the events of the file monitors.
+ *
+ * Returns: (transfer full): the sorted array of #NMDispatcherScript.
+ */
+GPtrArray *
+nm_dispatcher_script_dir_get_scripts (NMDispatcherScriptDir *dir)
+{
+	g_return_val_if_fail (dir, NULL);
+
+	if (!dir->monitor)
+		return find_scripts (dir->dirname, dir->no_wait_dirname);
+
+	if (!dir->scripts)
+		dir->scripts = find_scripts (dir->dirname, dir->no_wait_dirname);
+	return g_ptr_array_ref (dir->scripts);
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_dispatcher_utils_get_lane:
+ * @device_props: the device properties of a request, or %NULL
+ *
+ * Requests are ordered by the device's interface, and not by the IP or
+ * VPN interface of the request, so that all events of one device stay
+ * ordered. VPN events carry the properties of their parent device.
+ *
+ * Returns: the lane for nm_dispatcher_lanes_push(), or %NULL for the
+ *   shared lane of requests without device.
+ */
+const char *
+nm_dispatcher_utils_get_lane (GVariant *device_props)
+{
+	const char *iface = NULL;
+
+	if (device_props)
+		g_variant_lookup (device_props, NMD_DEVICE_PROPS_INTERFACE, "&s", &iface);
+	return iface;
+}
+
+/* Each lane has the currently running item and the queue of waiting
+ * items. Lanes that have waiting items but none running are queued in
+ * @lanes_ready. */
+struct _NMDispatcherLane {
+	NMDispatcherLanes *lanes;
+	char *name;
+
+	gpointer current;
+	GQueue *waiting;
+
+	/* whether the lane is in @lanes_ready. */
+	gboolean ready;
+};
+
+struct _NMDispatcherLanes {
+	GHashTable *lanes;
+	GQueue *lanes_ready;
+	guint num_running;
+	guint max_parallel;
+
+	NMDispatcherLanesStartFunc start_func;
+	gpointer user_data;
+};
+
+static void
+lane_free (NMDispatcherLane *lane)
+{
+	g_queue_free (lane->waiting);
+	g_free (lane->name);
+	g_slice_free (NMDispatcherLane, lane);
+}
+
+/* queues @lane in @lanes_ready if it has waiting items but none running.
+ * Drops the lane if it has no items at all. */
+static void
+lane_check (NMDispatcherLane *lane)
+{
+	NMDispatcherLanes *lanes = lane->lanes;
+
+	if (lane->current || lane->ready)
+		return;
+
+	if (g_queue_is_empty (lane->waiting)) {
+		g_hash_table_remove (lanes->lanes, lane->name);
+		return;
+	}
+
+	lane->ready = TRUE;
+	g_queue_push_tail (lanes->lanes_ready, lane);
+}
+
+/**
+ * nm_dispatcher_lanes_new:
+ * @max_parallel: how many lanes run at most at the same time
+ * @start_func: starts an item. The item is then the current one of its
+ *   lane until nm_dispatcher_lane_complete(), which may also be called
+ *   from within @start_func.
+ * @user_data: passed to @start_func
+ *
+ * Items of one lane run one after another. Lanes run in parallel. With
+ * @max_parallel 1, all items share one lane and run strictly in the order
+ * they were pushed.
+ *
+ * Returns: the scheduler.
+ */
+NMDispatcherLanes *
+nm_dispatcher_lanes_new (guint max_parallel,
+                         NMDispatcherLanesStartFunc start_func,
+                         gpointer user_data)
+{
+	NMDispatcherLanes *lanes;
+
+	g_return_val_if_fail (max_parallel > 0, NULL);
+	g_return_val_if_fail (start_func, NULL);
+
+	lanes = g_slice_new0 (NMDispatcherLanes);
+	lanes->lanes = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) lane_free);
+	lanes->lanes_ready = g_queue_new ();
+	lanes->max_parallel = max_parallel;
+	lanes->start_func = start_func;
+	lanes->user_data = user_data;
+	return lanes;
+}
+
+void
+nm_dispatcher_lanes_free (NMDispatcherLanes *lanes)
+{
+	if (!lanes)
+		return;
+
+	g_queue_free (lanes->lanes_ready);
+	g_hash_table_destroy (lanes->lanes);
+	g_slice_free (NMDispatcherLanes, lanes);
+}
+
+/**
+ * nm_dispatcher_lanes_push:
+ * @lanes: the scheduler
+ * @name: (allow-none): the lane, %NULL for the shared lane
+ * @item: the item to run after the items already in the lane
+ *
+ * The item starts with the next nm_dispatcher_lanes_run().
+ *
+ * Returns: the lane of @item. It is valid until @item completes.
+ */
+NMDispatcherLane *
+nm_dispatcher_lanes_push (NMDispatcherLanes *lanes, const char *name, gpointer item)
+{
+	NMDispatcherLane *lane;
+
+	g_return_val_if_fail (lanes, NULL);
+	g_return_val_if_fail (item, NULL);
+
+	if (!name || lanes->max_parallel == 1)
+		name = "";
+
+	lane = g_hash_table_lookup (lanes->lanes, name);
+	if (!lane) {
+		lane = g_slice_new0 (NMDispatcherLane);
+		lane->lanes = lanes;
+		lane->name = g_strdup (name);
+		lane->waiting = g_queue_new ();
+		g_hash_table_insert (lanes->lanes, lane->name, lane);
+	}
+
+	g_queue_push_tail (lane->waiting, item);
+	lane_check (lane);
+	return lane;
+}
+
+/**
+ * nm_dispatcher_lanes_run:
+ * @lanes: the scheduler
+ *
+ * Starts the next item of ready lanes, as long as fewer than
+ * @max_parallel lanes are running. A lane goes to the end of the ready
+ * queue after each item, so that a busy lane doesn't starve the others.
+ */
+void
+nm_dispatcher_lanes_run (NMDispatcherLanes *lanes)
+{
+	g_return_if_fail (lanes);
+
+	while (lanes->num_running < lanes->max_parallel) {
+		NMDispatcherLane *lane;
+
+		lane = g_queue_pop_head (lanes->lanes_ready);
+		if (!lane)
+			return;
+
+		lane->ready = FALSE;
+		lane->current = g_queue_pop_head (lane->waiting);
+		nm_assert (lane->current);
+		lanes->num_running++;
+
+		lanes->start_func (lane->current, lanes->user_data);
+	}
+}
+
+/**
+ * nm_dispatcher_lane_is_current:
+ * @lane: the lane of @item
+ * @item: the item
+ *
+ * Returns: whether @item is running.
+ */
+gboolean
+nm_dispatcher_lane_is_current (NMDispatcherLane *lane, gpointer item)
+{
+	g_return_val_if_fail (lane, FALSE);
+
+	return lane->current == item;
+}
+
+/**
+ * nm_dispatcher_lane_complete:
+ * @lane: the lane of @item
+ * @item: the running item
+ *
+ * Completes @item and makes its lane ready for the next item. @lane
+ * may be freed. The next items start with nm_dispatcher_lanes_run().
+ */
+void
+nm_dispatcher_lane_complete (NMDispatcherLane *lane, gpointer item)
+{
+	NMDispatcherLanes *lanes;
+
+	g_return_if_fail (lane);
+	g_return_if_fail (lane->current == item);
+
+	lanes = lane->lanes;
+	lane->current = NULL;
+	nm_assert (lanes->num_running > 0);
+	lanes->num_running--;
+	lane_check (lane);
+}
+
+/**
+ * nm_dispatcher_lanes_is_empty:
+ * @lanes: the scheduler
+ *
+ * Returns: whether no item is running or waiting.
+ */
+gboolean
+nm_dispatcher_lanes_is_empty (NMDispatcherLanes *lanes)
+{
+	g_return_val_if_fail (lanes, TRUE);
+
+	return lanes->num_running == 0 && g_hash_table_size (lanes->lanes) == 0;
+}
@@ -39,5 +39,38 @@ nm_dispatcher_utils_construct_envp (const char *action,
                                     char **out_iface,
                                     const char **out_error_message);
 
+typedef struct {
+	char *path;
+	gboolean wait;
+} NMDispatcherScript;
+
+typedef struct _NMDispatcherScriptDir NMDispatcherScriptDir;
+
+NMDispatcherScriptDir *nm_dispatcher_script_dir_new (const char *dirname,
+                                                     const char *no_wait_dirname,
+                                                     gboolean monitor);
+void nm_dispatcher_script_dir_free (NMDispatcherScriptDir *dir);
+
+GPtrArray *nm_dispatcher_script_dir_get_scripts (NMDispatcherScriptDir *dir);
+
+const char *nm_dispatcher_utils_get_lane (GVariant *device_props);
+
+typedef struct _NMDispatcherLanes NMDispatcherLanes;
+typedef struct _NMDispatcherLane NMDispatcherLane;
+
+typedef void (*NMDispatcherLanesStartFunc) (gpointer item, gpointer user_data);
+
+NMDispatcherLanes *nm_dispatcher_lanes_new (guint max_parallel,
+                                            NMDispatcherLanesStartFunc start_func,
+                                            gpointer user_data);
+void nm_dispatcher_lanes_free (NMDispatcherLanes *lanes);
+
+NMDispatcherLane *nm_dispatcher_lanes_push (NMDispatcherLanes *lanes, const char *name, gpointer item);
+void nm_dispatcher_lanes_run (NMDispatcherLanes *lanes);
+gboolean nm_dispatcher_lanes_is_empty (NMDispatcherLanes *lanes);
+
+gboolean nm_dispatcher_lane_is_current (NMDispatcherLane *lane, gpointer item);
+void nm_dispatcher_lane_complete (NMDispatcherLane *lane, gpointer item);
+
 #endif  /* __NETWORKMANAGER_DISPATCHER_UTILS_H__ */
 
@@ -41,6 +41,7 @@
 static GMainLoop *loop = NULL;
 static gboolean debug = FALSE;
 static gboolean persist = FALSE;
+static gint max_parallel = 8;
 static guint quit_id;
 static guint request_id_counter = 0;
 
@@ -52,9 +53,18 @@ typedef struct {
 	/* Private data */
 	NMDBusDispatcher *dbus_dispatcher;
 
-	Request *current_request;
-	GQueue *requests_waiting;
+	/* Requests with "wait" scripts are run in order per interface, in
+	 * one lane per interface. Lanes of different interfaces run in
+	 * parallel. Requests without interface, like "hostname" and
+	 * "connectivity-change", share one lane. */
+	NMDispatcherLanes *lanes;
+
 	gint num_requests_pending;
+
+	/* the scripts for the actions, see script_dir_for_action(). */
+	NMDispatcherScriptDir *script_dir_default;
+	NMDispatcherScriptDir *script_dir_pre_up;
+	NMDispatcherScriptDir *script_dir_pre_down;
 } Handler;
 
 typedef struct {
@@ -89,10 +99,15 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
                gboolean request_debug,
                gpointer user_data);
 
+static void request_start (gpointer item, gpointer user_data);
+
 static void
 handler_init (Handler *h)
 {
-	h->requests_waiting = g_queue_new ();
+	h->lanes = nm_dispatcher_lanes_new (max_parallel, request_start, h);
+	h->script_dir_default = nm_dispatcher_script_dir_new (NMD_SCRIPT_DIR_DEFAULT, NMD_SCRIPT_DIR_NO_WAIT, TRUE);
+	h->script_dir_pre_up = nm_dispatcher_script_dir_new (NMD_SCRIPT_DIR_PRE_UP, NMD_SCRIPT_DIR_NO_WAIT, TRUE);
+	h->script_dir_pre_down = nm_dispatcher_script_dir_new (NMD_SCRIPT_DIR_PRE_DOWN, NMD_SCRIPT_DIR_NO_WAIT, TRUE);
 	h->dbus_dispatcher = nmdbus_dispatcher_skeleton_new ();
 	g_signal_connect (h->dbus_dispatcher, "handle-action",
 	                  G_CALLBACK (handle_action), h);
@@ -104,6 +119,7 @@ handler_class_init (HandlerClass *h_class)
 }
 
 static gboolean dispatch_one_script (Request *request);
+static gboolean complete_request (Request *request);
 
 typedef struct {
 	Request *request;
@@ -120,6 +136,7 @@ typedef struct {
 
 struct Request {
 	Handler *handler;
+	NMDispatcherLane *lane;
 
 	guint request_id;
 
@@ -226,45 +243,21 @@ quit_timeout_reschedule (void)
 	}
 }
 
-/**
- * next_request:
- *
- * @h: the handler
- * @request: (allow-none): the request to set as next. If %NULL, dequeue the next
- * waiting request. Otherwise, try to set the given request.
- *
- * Sets the currently active request (@current_request). The current request
- * is a request that has at least on "wait" script, because requests that only
- * consist of "no-wait" scripts are handled right away and not enqueued to
- * @requests_waiting nor set as @current_request.
- *
- * Returns: %TRUE, if there was currently not request in process and it set
- * a new request as current.
- */
-static gboolean
-next_request (Handler *h, Request *request)
+/*****************************************************************************/
+
+static void
+request_start (gpointer item, gpointer user_data)
 {
-	if (request) {
-		if (h->current_request) {
-			g_queue_push_tail (h->requests_waiting, request);
-			return FALSE;
-		}
-	} else {
-		/* when calling next_request() without explicit @request, we always
-		 * forcefully clear @current_request. That one is certainly
-		 * handled already. */
-		h->current_request = NULL;
-
-		request = g_queue_pop_head (h->requests_waiting);
-		if (!request)
-			return FALSE;
-	}
+	Request *request = item;
 
 	_LOG_R_I (request, "start running ordered scripts...");
 
-	h->current_request = request;
+	if (dispatch_one_script (request))
+		return;
 
-	return TRUE;
+	/* Try to complete the request. It will be either completed
+	 * now, or when all pending "no-wait" scripts return. */
+	complete_request (request);
 }
 
 /**
@@ -275,20 +268,23 @@ next_request (Handler *h, Request *request)
  * it sends the D-Bus response and releases the request resources.
  *
  * It also decreases @num_requests_pending and possibly does quit_timeout_reschedule().
+ *
+ * Returns: %TRUE if the request was completed and freed.
  */
-static void
+static gboolean
 complete_request (Request *request)
 {
 	GVariantBuilder results;
 	GVariant *ret;
 	guint i;
 	Handler *handler = request->handler;
+	NMDispatcherLane *lane = request->lane;
 
 	nm_assert (request);
 
 	/* Are there still pending scripts? Then do nothing (for now). */
 	if (request->num_scripts_done < request->scripts->len)
-		return;
+		return FALSE;
 
 	g_variant_builder_init (&results, G_VARIANT_TYPE ("a(sus)"));
 	for (i = 0; i < request->scripts->len; i++) {
@@ -305,16 +301,17 @@ complete_request (Request *request)
 
 	_LOG_R_D (request, "completed (%u scripts)", request->scripts->len);
 
-	if (handler->current_request == request)
-		handler->current_request = NULL;
+	if (lane && nm_dispatcher_lane_is_current (lane, request))
+		nm_dispatcher_lane_complete (lane, request);
 
 	request_free (request);
 
 	g_assert_cmpuint (handler->num_requests_pending, >, 0);
 	if (--handler->num_requests_pending <= 0) {
-		nm_assert (!handler->current_request && !g_queue_peek_head (handler->requests_waiting));
+		nm_assert (nm_dispatcher_lanes_is_empty (handler->lanes));
 		quit_timeout_reschedule ();
 	}
+	return TRUE;
 }
 
 static void
@@ -325,65 +322,35 @@ complete_script (ScriptInfo *script)
 	gboolean wait = script->wait;
 
 	request = script->request;
+	handler = request->handler;
 
 	if (wait) {
 		/* for "wait" scripts, try to schedule the next blocking script.
 		 * If that is successful, return (as we must wait for its completion). */
 		if (dispatch_one_script (request))
 			return;
-	}
-
-	handler = request->handler;
-
-	nm_assert (!wait || handler->current_request == request);
-
-	/* Try to complete the request. @request will be possibly free'd,
-	 * making @script and @request a dangling pointer. */
-	complete_request (request);
 
-	if (!wait) {
-		/* this was a "no-wait" script. We either completed the request,
-		 * or there is nothing to do. Especially, there is no need to
-		 * queue the next_request() -- because no-wait scripts don't block
-		 * requests. However, if this was the last "no-wait" script and
-		 * there are "wait" scripts ready to run, launch them.
-		 */
-		if (   handler->current_request == request
-		    && handler->current_request->num_scripts_nowait == 0) {
-
-			if (dispatch_one_script (handler->current_request))
-				return;
+		nm_assert (request->lane && nm_dispatcher_lane_is_current (request->lane, request));
 
-			complete_request (handler->current_request);
-		} else
-			return;
+		/* this was the last script of @request, which completes it and
+		 * frees its lane for the next request. */
+		complete_request (request);
 	} else {
-		/* if the script is a "wait" script, we already tried above to
-		 * dispatch the next script. As we didn't do that, it means we
-		 * just completed the last script of @request and we can continue
-		 * with the next request...
-		 *
-		 * Also, it cannot be that there is another request currently being
-		 * processed because only requests with "wait" scripts can become
-		 * @current_request. As there can only be one "wait" script running
-		 * at any time, it means complete_request() above completed @request. */
-		nm_assert (!handler->current_request);
+		/* this was a "no-wait" script. Try to complete the request. If
+		 * the request is the current one of its lane and this was the last
+		 * "no-wait" script, its "wait" scripts can start now. Requests
+		 * with only "no-wait" scripts never block a lane. */
+		if (   !complete_request (request)
+		    && request->lane
+		    && nm_dispatcher_lane_is_current (request->lane, request)
+		    && request->num_scripts_nowait == 0) {
+			if (dispatch_one_script (request))
+				return;
+			complete_request (request);
+		}
 	}
 
-	while (next_request (handler, NULL)) {
-		request = handler->current_request;
-
-		if (dispatch_one_script (request))
-			return;
-
-		/* Try to complete the request. It will be either completed
-		 * now, or when all pending "no-wait" scripts return. */
-		complete_request (request);
-
-		/* We can immediately start next_request(), because our current
-		 * @request has obviously no more "wait" scripts either.
-		 * Repeat... */
-	}
+	nm_dispatcher_lanes_run (handler->lanes);
 }
 
 static void
@@ -461,67 +428,6 @@ again:
 	return FALSE;
 }
 
-static inline gboolean
-check_permissions (struct stat *s, const char **out_error_msg)
-{
-	g_return_val_if_fail (s != NULL, FALSE);
-	g_return_val_if_fail (out_error_msg != NULL, FALSE);
-	g_return_val_if_fail (*out_error_msg == NULL, FALSE);
-
-	/* Only accept regular files */
-	if (!S_ISREG (s->st_mode)) {
-		*out_error_msg = "not a regular file.";
-		return FALSE;
-	}
-
-	/* Only accept files owned by root */
-	if (s->st_uid != 0) {
-		*out_error_msg = "not owned by root.";
-		return FALSE;
-	}
-
-	/* Only accept files not writable by group or other, and not SUID */
-	if (s->st_mode & (S_IWGRP | S_IWOTH | S_ISUID)) {
-		*out_error_msg = "writable by group or other, or set-UID.";
-		return FALSE;
-	}
-
-	/* Only accept files executable by the owner */
-	if (!(s->st_mode & S_IXUSR)) {
-		*out_error_msg = "not executable by owner.";
-		return FALSE;
-	}
-
-	return TRUE;
-}
-
-static gboolean
-check_filename (const char *file_name)
-{
-	static const char *bad_suffixes[] = {
-		"~",
-		".rpmsave",
-		".rpmorig",
-		".rpmnew",
-		".swp",
-	};
-	char *tmp;
-	guint i;
-
-	/* File must not be a backup file, package management file, or start with '.' */
-
-	if (file_name[0] == '.')
-		return FALSE;
-	for (i = 0; i < G_N_ELEMENTS (bad_suffixes); i++) {
-		if (g_str_has_suffix (file_name, bad_suffixes[i]))
-			return FALSE;
-	}
-	tmp = g_strrstr (file_name, ".dpkg-");
-	if (tmp && !strchr (&tmp[1], '.'))
-		return FALSE;
-	return TRUE;
-}
-
 #define SCRIPT_TIMEOUT 600  /* 10 minutes */
 
 static gboolean
@@ -577,87 +483,17 @@ dispatch_one_script (Request *request)
 	return FALSE;
 }
 
-static GSList *
-find_scripts (const char *str_action)
+static NMDispatcherScriptDir *
+script_dir_for_action (Handler *h, const char *str_action)
 {
-	GDir *dir;
-	const char *filename;
-	GSList *sorted = NULL;
-	GError *error = NULL;
-	const char *dirname;
-
 	if (   strcmp (str_action, NMD_ACTION_PRE_UP) == 0
 	    || strcmp (str_action, NMD_ACTION_VPN_PRE_UP) == 0)
-		dirname = NMD_SCRIPT_DIR_PRE_UP;
+		return h->script_dir_pre_up;
 	else if (   strcmp (str_action, NMD_ACTION_PRE_DOWN) == 0
 	         || strcmp (str_action, NMD_ACTION_VPN_PRE_DOWN) == 0)
-		dirname = NMD_SCRIPT_DIR_PRE_DOWN;
+		return h->script_dir_pre_down;
 	else
-		dirname = NMD_SCRIPT_DIR_DEFAULT;
-
-	if (!(dir = g_dir_open (dirname, 0, &error))) {
-		g_message ("find-scripts: Failed to open dispatcher directory '%s': %s",
-		           dirname, error->message);
-		g_error_free (error);
-		return NULL;
-	}
-
-	while ((filename = g_dir_read_name (dir))) {
-		char *path;
-		struct stat	st;
-		int err;
-		const char *err_msg = NULL;
-
-		if (!check_filename (filename))
-			continue;
-
-		path = g_build_filename (dirname, filename, NULL);
-
-		err = stat (path, &st);
-		if (err)
-			g_warning ("find-scripts: Failed to stat '%s': %d", path, err);
-		else if (S_ISDIR (st.st_mode))
-			; /* silently skip. */
-		else if (!check_permissions (&st, &err_msg))
-			g_warning ("find-scripts: Cannot execute '%s': %s", path, err_msg);
-		else {
-			/* success */
-			sorted = g_slist_insert_sorted (sorted, path, (GCompareFunc) g_strcmp0);
-			path = NULL;
-		}
-		g_free (path);
-	}
-	g_dir_close (dir);
-
-	return sorted;
-}
-
-static gboolean
-script_must_wait (const char *path)
-{
-	gs_free char *link = NULL;
-	gs_free char *dir = NULL;
-	gs_free char *real = NULL;
-	char *tmp;
-
-	link = g_file_read_link (path, NULL);
-	if (link) {
-		if (!g_path_is_absolute (link)) {
-			dir = g_path_get_dirname (path);
-			tmp = g_build_path ("/", dir, link, NULL);
-			g_free (link);
-			g_free (dir);
-			link = tmp;
-		}
-
-		dir = g_path_get_dirname (link);
-		real = realpath (dir, NULL);
-
-		if (real && !strcmp (real, NMD_SCRIPT_DIR_NO_WAIT))
-			return FALSE;
-	}
-
-	return TRUE;
+		return h->script_dir_default;
 }
 
 static gboolean
@@ -681,14 +517,13 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
                gpointer user_data)
 {
 	Handler *h = user_data;
-	GSList *sorted_scripts = NULL;
-	GSList *iter;
+	gs_unref_ptrarray GPtrArray *scripts = NULL;
 	Request *request;
 	char **p;
 	guint i, num_nowait = 0;
 	const char *error_message = NULL;
 
-	sorted_scripts = find_scripts (str_action);
+	scripts = nm_dispatcher_script_dir_get_scripts (script_dir_for_action (h, str_action));
 
 	request = g_slice_new0 (Request);
 	request->request_id = ++request_id_counter;
@@ -714,17 +549,17 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	                                                    &request->iface,
 	                                                    &error_message);
 
-	request->scripts = g_ptr_array_new_full (5, script_info_free);
-	for (iter = sorted_scripts; iter; iter = g_slist_next (iter)) {
+	request->scripts = g_ptr_array_new_full (scripts->len, script_info_free);
+	for (i = 0; i < scripts->len; i++) {
+		const NMDispatcherScript *script = scripts->pdata[i];
 		ScriptInfo *s;
 
 		s = g_slice_new0 (ScriptInfo);
 		s->request = request;
-		s->script = iter->data;
-		s->wait = script_must_wait (s->script);
+		s->script = g_strdup (script->path);
+		s->wait = script->wait;
 		g_ptr_array_add (request->scripts, s);
 	}
-	g_slist_free (sorted_scripts);
 
 	_LOG_R_I (request, "new request (%u scripts)", request->scripts->len);
 	if (   _LOG_R_D_enabled (request)
@@ -762,35 +597,20 @@ handle_action (NMDBusDispatcher *dbus_dispatcher,
 	}
 
 	if (num_nowait < request->scripts->len) {
-		/* The request has at least one wait script.
-		 * Try next_request() to schedule the request for
-		 * execution. This either enqueues the request or
-		 * sets it as h->current_request. */
-		if (next_request (h, request)) {
-			/* @request is now @current_request. Go ahead and
-			 * schedule the first wait script. */
-			if (!dispatch_one_script (request)) {
-				/* If that fails, we might be already finished with the
-				 * request. Try complete_request(). */
-				complete_request (request);
-
-				if (next_request (h, NULL)) {
-					/* As @request was successfully scheduled as next_request(), there is no
-					 * other request in queue that can be scheduled afterwards. Assert against
-					 * that, but call next_request() to clear current_request. */
-					g_assert_not_reached ();
-				}
-			}
-		}
+		/* The request has at least one wait script. Enqueue it to the lane
+		 * of its device, which runs it after the previous requests for the
+		 * same device. */
+		request->lane = nm_dispatcher_lanes_push (h->lanes,
+		                                          nm_dispatcher_utils_get_lane (device_props),
+		                                          request);
+		nm_dispatcher_lanes_run (h->lanes);
 	} else {
 		/* The request contains only no-wait scripts. Try to complete
 		 * the request right away (we might have failed to schedule any
 		 * of the scripts). It will be either completed now, or later
 		 * when the pending scripts return.
-		 * We don't enqueue it to h->requests_waiting.
-		 * There is no need to handle next_request(), because @request is
-		 * not the current request anyway and does not interfere with requests
-		 * that have any "wait" scripts. */
+		 * We don't enqueue it to a lane, because no-wait scripts don't
+		 * interfere with requests that have any "wait" scripts. */
 		complete_request (request);
 	}
 
@@ -901,6 +721,7 @@ main (int argc, char **argv)
 	GOptionEntry entries[] = {
 		{ "debug", 0, 0, G_OPTION_ARG_NONE, &debug, "Output to console rather than syslog", NULL },
 		{ "persist", 0, 0, G_OPTION_ARG_NONE, &persist, "Don't quit after a short timeout", NULL },
+		{ "max-parallel", 0, 0, G_OPTION_ARG_INT, &max_parallel, "Run scripts for at most N interfaces in parallel (default 8)", "N" },
 		{ NULL }
 	};
 
@@ -916,6 +737,9 @@ main (int argc, char **argv)
 
 	g_option_context_free (opt_ctx);
 
+	if (max_parallel < 1)
+		max_parallel = 1;
+
 	nm_g_type_init ();
 
 	g_unix_signal_add (SIGTERM, signal_handler, GINT_TO_POINTER (SIGTERM));
@@ -966,7 +790,10 @@ main (int argc, char **argv)
 
 	g_main_loop_run (loop);
 
-	g_queue_free (handler->requests_waiting);
+	nm_dispatcher_script_dir_free (handler->script_dir_default);
+	nm_dispatcher_script_dir_free (handler->script_dir_pre_up);
+	nm_dispatcher_script_dir_free (handler->script_dir_pre_down);
+	nm_dispatcher_lanes_free (handler->lanes);
 	g_object_unref (handler);
 
 	if (!debug)
@@ -0,0 +1,256 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "nm-dispatcher-utils.h"
+
+#include "nm-utils/nm-test-utils.h"
+
+NMTST_DEFINE ();
+
+/*****************************************************************************/
+
+static struct {
+	int events;
+	int scripts;
+	int change_every;
+} global_opt = {
+	.events = 10000,
+	.scripts = 20,
+	.change_every = 1000,
+};
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionContext *context;
+	GOptionEntry options[] = {
+		{ "events", 'n', 0, G_OPTION_ARG_INT, &global_opt.events, "Number of events (default 10000)", "N" },
+		{ "scripts", 's', 0, G_OPTION_ARG_INT, &global_opt.scripts, "Number of scripts in the directory (default 20)", "N" },
+		{ "change-every", 'c', 0, G_OPTION_ARG_INT, &global_opt.change_every, "Add a script after every N events (default 1000, 0 to disable)", "N" },
+		{ 0 },
+	};
+	gs_free_error GError *error = NULL;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "Fire events at the script inventory of nm-dispatcher and report the "
+	                                       "latency percentiles for looking up the scripts of an event, with and "
+	                                       "without monitoring the directories. Must run as root, because only "
+	                                       "scripts owned by root are accepted.");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, argc, argv, &error)) {
+		g_warning ("Error parsing command line arguments: %s", error->message);
+		g_option_context_free (context);
+		return FALSE;
+	}
+
+	g_option_context_free (context);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static void
+create_script (const char *dirname, const char *no_wait_dirname, int i)
+{
+	gs_free char *name = g_strdup_printf ("%02d-script-%d", i % 100, i);
+	gs_free char *path = NULL;
+	gs_free_error GError *error = NULL;
+
+	/* every third script is a "no-wait" script. */
+	path = g_build_filename (i % 3 ? dirname : no_wait_dirname, name, NULL);
+	if (!g_file_set_contents (path, "#!/bin/sh\nexit 0\n", -1, &error))
+		g_error ("cannot create script: %s", error->message);
+	if (chmod (path, 0755) < 0)
+		g_error ("cannot chmod script: %s", strerror (errno));
+
+	if (i % 3 == 0) {
+		gs_free char *link = g_build_filename (dirname, name, NULL);
+
+		if (symlink (path, link) < 0)
+			g_error ("cannot create symlink: %s", strerror (errno));
+	}
+}
+
+static void
+remove_dir (const char *dirname)
+{
+	GDir *dir;
+	const char *filename;
+	struct stat st;
+
+	dir = g_dir_open (dirname, 0, NULL);
+	if (dir) {
+		while ((filename = g_dir_read_name (dir))) {
+			gs_free char *path = g_build_filename (dirname, filename, NULL);
+
+			/* don't follow the symlinks to the no-wait scripts. */
+			if (   lstat (path, &st) == 0
+			    && S_ISDIR (st.st_mode))
+				remove_dir (path);
+			else if (g_unlink (path) < 0)
+				g_warning ("cannot remove %s: %s", path, strerror (errno));
+		}
+		g_dir_close (dir);
+	}
+	if (g_rmdir (dirname) < 0)
+		g_warning ("cannot remove %s: %s", dirname, strerror (errno));
+}
+
+static int
+cmp_gint64 (gconstpointer a, gconstpointer b)
+{
+	gint64 x = *((const gint64 *) a);
+	gint64 y = *((const gint64 *) b);
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void
+run (const char *dirname, const char *no_wait_dirname, gboolean monitor, int *n_scripts)
+{
+	NMDispatcherScriptDir *dir;
+	gint64 *latencies;
+	gint64 refresh_max = 0;
+	guint n_refreshes = 0;
+	int i;
+
+	dir = nm_dispatcher_script_dir_new (dirname, no_wait_dirname, monitor);
+	latencies = g_new (gint64, global_opt.events);
+
+	for (i = 0; i < global_opt.events; i++) {
+		gs_unref_ptrarray GPtrArray *scripts = NULL;
+		GPtrArray *paths;
+		gint64 start;
+		guint j;
+
+		if (   global_opt.change_every > 0
+		    && i > 0
+		    && i % global_opt.change_every == 0) {
+			gint64 changed;
+			guint expected;
+
+			create_script (dirname, no_wait_dirname, (*n_scripts)++);
+			expected = *n_scripts;
+
+			/* the daemon sees the change when its main loop runs. */
+			changed = g_get_monotonic_time ();
+			while (TRUE) {
+				gs_unref_ptrarray GPtrArray *s = NULL;
+
+				while (g_main_context_iteration (NULL, FALSE))
+					;
+				s = nm_dispatcher_script_dir_get_scripts (dir);
+				if (s->len == expected)
+					break;
+				if (g_get_monotonic_time () - changed > 5 * G_USEC_PER_SEC)
+					g_error ("the inventory did not notice the new script");
+				g_usleep (100);
+			}
+			refresh_max = MAX (refresh_max, g_get_monotonic_time () - changed);
+			n_refreshes++;
+		}
+
+		start = g_get_monotonic_time ();
+
+		/* what handle_action() does with the scripts. */
+		scripts = nm_dispatcher_script_dir_get_scripts (dir);
+		paths = g_ptr_array_new_full (scripts->len, g_free);
+		for (j = 0; j < scripts->len; j++)
+			g_ptr_array_add (paths, g_strdup (((NMDispatcherScript *) scripts->pdata[j])->path));
+		g_ptr_array_unref (paths);
+
+		latencies[i] = g_get_monotonic_time () - start;
+
+		if (scripts->len != (guint) *n_scripts)
+			g_error ("expected %d scripts but got %u", *n_scripts, scripts->len);
+	}
+
+	qsort (latencies, global_opt.events, sizeof (gint64), cmp_gint64);
+
+	printf ("%-12s p50 %6" G_GINT64_FORMAT " us, p90 %6" G_GINT64_FORMAT " us, "
+	        "p99 %6" G_GINT64_FORMAT " us, max %6" G_GINT64_FORMAT " us",
+	        monitor ? "monitored:" : "not cached:",
+	        latencies[global_opt.events / 2],
+	        latencies[(gint64) global_opt.events * 9 / 10],
+	        latencies[(gint64) global_opt.events * 99 / 100],
+	        latencies[global_opt.events - 1]);
+	if (n_refreshes)
+		printf (" (%u changes, noticed within %" G_GINT64_FORMAT " us)", n_refreshes, refresh_max);
+	printf ("\n");
+
+	g_free (latencies);
+	nm_dispatcher_script_dir_free (dir);
+}
+
+int
+main (int argc, char **argv)
+{
+	gs_free char *tmpdir = NULL;
+	gs_free char *dirname = NULL;
+	gs_free char *no_wait_dirname = NULL;
+	gs_free_error GError *error = NULL;
+	int n_scripts, i;
+
+	nmtst_init (&argc, &argv, TRUE);
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	if (getuid () != 0) {
+		printf ("must run as root\n");
+		return 77;
+	}
+
+	if (global_opt.events <= 0)
+		global_opt.events = 1;
+	if (global_opt.scripts < 0)
+		global_opt.scripts = 0;
+
+	tmpdir = g_dir_make_tmp ("nm-dispatcher-bench-XXXXXX", &error);
+	if (!tmpdir)
+		g_error ("cannot create directory: %s", error->message);
+
+	dirname = g_build_filename (tmpdir, "dispatcher.d", NULL);
+	no_wait_dirname = g_build_filename (dirname, "no-wait.d", NULL);
+	if (g_mkdir_with_parents (no_wait_dirname, 0755) < 0)
+		g_error ("cannot create directory: %s", strerror (errno));
+
+	for (i = 0; i < global_opt.scripts; i++)
+		create_script (dirname, no_wait_dirname, i);
+
+	printf ("%d events, %d scripts\n", global_opt.events, global_opt.scripts);
+
+	n_scripts = global_opt.scripts;
+	run (dirname, no_wait_dirname, FALSE, &n_scripts);
+	run (dirname, no_wait_dirname, TRUE, &n_scripts);
+
+	remove_dir (tmpdir);
+	return EXIT_SUCCESS;
+}
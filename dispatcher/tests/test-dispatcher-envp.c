@@ -23,6 +23,7 @@
 #include <arpa/inet.h>
 #include <stdlib.h>
 #include <string.h>
+#include <glib/gstdio.h>
 
 #include "nm-core-internal.h"
 #include "nm-dispatcher-utils.h"
@@ -650,6 +651,349 @@ test_up_empty_vpn_iface (void)
 
 /*****************************************************************************/
 
+typedef struct {
+	NMDispatcherLanes *lanes;
+	GHashTable *item_lanes;
+	GPtrArray *started;
+} LanesData;
+
+static void
+_lanes_start (gpointer item, gpointer user_data)
+{
+	LanesData *d = user_data;
+
+	g_ptr_array_add (d->started, item);
+}
+
+static void
+_lanes_init (LanesData *d, guint max_parallel)
+{
+	d->lanes = nm_dispatcher_lanes_new (max_parallel, _lanes_start, d);
+	d->item_lanes = g_hash_table_new (g_str_hash, g_str_equal);
+	d->started = g_ptr_array_new ();
+}
+
+static void
+_lanes_clear (LanesData *d)
+{
+	g_assert (nm_dispatcher_lanes_is_empty (d->lanes));
+	nm_dispatcher_lanes_free (d->lanes);
+	g_hash_table_destroy (d->item_lanes);
+	g_ptr_array_free (d->started, TRUE);
+}
+
+static void
+_lanes_push (LanesData *d, const char *lane, const char *item)
+{
+	g_hash_table_insert (d->item_lanes,
+	                     (gpointer) item,
+	                     nm_dispatcher_lanes_push (d->lanes, lane, (gpointer) item));
+	nm_dispatcher_lanes_run (d->lanes);
+}
+
+static void
+_lanes_complete (LanesData *d, const char *item)
+{
+	gpointer pushed_item, lane;
+
+	/* the scheduler compares items by pointer. Use the pushed one, the
+	 * compiler doesn't necessarily merge equal string literals. */
+	if (!g_hash_table_lookup_extended (d->item_lanes, item, &pushed_item, &lane))
+		g_assert_not_reached ();
+	g_assert (nm_dispatcher_lane_is_current (lane, pushed_item));
+	g_hash_table_remove (d->item_lanes, item);
+	nm_dispatcher_lane_complete (lane, pushed_item);
+	nm_dispatcher_lanes_run (d->lanes);
+}
+
+/* asserts the order in which the items started so far, terminated by NULL. */
+static void
+_lanes_assert_started (LanesData *d, ...)
+{
+	const char *item;
+	va_list ap;
+	guint i = 0;
+
+	va_start (ap, d);
+	while ((item = va_arg (ap, const char *))) {
+		g_assert_cmpint (i, <, d->started->len);
+		g_assert_cmpstr (d->started->pdata[i], ==, item);
+		i++;
+	}
+	va_end (ap);
+	g_assert_cmpint (i, ==, d->started->len);
+}
+
+static char *
+_lane_from_file (const char *file, char **out_expected_iface)
+{
+	gs_unref_variant GVariant *con_dict = NULL;
+	gs_unref_variant GVariant *con_props = NULL;
+	gs_unref_variant GVariant *device_props = NULL;
+	gs_unref_variant GVariant *device_proxy_props = NULL;
+	gs_unref_variant GVariant *device_ip4_props = NULL;
+	gs_unref_variant GVariant *device_ip6_props = NULL;
+	gs_unref_variant GVariant *device_dhcp4_props = NULL;
+	gs_unref_variant GVariant *device_dhcp6_props = NULL;
+	gs_free char *connectivity_change = NULL;
+	gs_unref_variant GVariant *vpn_proxy_props = NULL;
+	gs_unref_variant GVariant *vpn_ip4_props = NULL;
+	gs_unref_variant GVariant *vpn_ip6_props = NULL;
+	gs_free char *vpn_ip_iface = NULL;
+	gs_free char *action = NULL;
+	gs_unref_hashtable GHashTable *expected_env = NULL;
+	gs_free char *path = NULL;
+	GError *error = NULL;
+	gboolean success;
+
+	path = g_build_filename (SRCDIR, file, NULL);
+	success = get_dispatcher_file (path,
+	                               &con_dict,
+	                               &con_props,
+	                               &device_props,
+	                               &device_proxy_props,
+	                               &device_ip4_props,
+	                               &device_ip6_props,
+	                               &device_dhcp4_props,
+	                               &device_dhcp6_props,
+	                               &connectivity_change,
+	                               &vpn_ip_iface,
+	                               &vpn_proxy_props,
+	                               &vpn_ip4_props,
+	                               &vpn_ip6_props,
+	                               out_expected_iface,
+	                               &action,
+	                               &expected_env,
+	                               &error);
+	g_assert_no_error (error);
+	g_assert (success);
+
+	return g_strdup (nm_dispatcher_utils_get_lane (device_props));
+}
+
+static void
+test_lanes_device_order (void)
+{
+	LanesData d;
+
+	_lanes_init (&d, 8);
+
+	/* requests of one device run one after another, other devices run
+	 * in parallel. */
+	_lanes_push (&d, "eth0", "eth0-up");
+	_lanes_push (&d, "eth0", "eth0-down");
+	_lanes_push (&d, "wlan0", "wlan0-up");
+	_lanes_assert_started (&d, "eth0-up", "wlan0-up", NULL);
+
+	_lanes_complete (&d, "wlan0-up");
+	_lanes_assert_started (&d, "eth0-up", "wlan0-up", NULL);
+
+	_lanes_complete (&d, "eth0-up");
+	_lanes_assert_started (&d, "eth0-up", "wlan0-up", "eth0-down", NULL);
+
+	_lanes_complete (&d, "eth0-down");
+	_lanes_clear (&d);
+}
+
+static void
+test_lanes_vpn (void)
+{
+	gs_free char *lane_up = NULL;
+	gs_free char *lane_vpn_up = NULL;
+	gs_free char *lane_vpn_down = NULL;
+	gs_free char *iface_up = NULL;
+	gs_free char *iface_vpn_up = NULL;
+	gs_free char *iface_vpn_down = NULL;
+	LanesData d;
+
+	/* VPN events use the lane of their parent device, not the lane of
+	 * the VPN's IP interface. */
+	lane_up = _lane_from_file ("dispatcher-up", &iface_up);
+	lane_vpn_up = _lane_from_file ("dispatcher-vpn-up", &iface_vpn_up);
+	lane_vpn_down = _lane_from_file ("dispatcher-vpn-down", &iface_vpn_down);
+	g_assert_cmpstr (iface_up, ==, "wlan0");
+	g_assert_cmpstr (iface_vpn_up, ==, "tun0");
+	g_assert_cmpstr (iface_vpn_down, ==, "tun0");
+	g_assert_cmpstr (lane_up, ==, "wlan0");
+	g_assert_cmpstr (lane_vpn_up, ==, "wlan0");
+	g_assert_cmpstr (lane_vpn_down, ==, "wlan0");
+
+	_lanes_init (&d, 8);
+
+	_lanes_push (&d, lane_up, "up");
+	_lanes_push (&d, lane_vpn_up, "vpn-up");
+	_lanes_push (&d, "eth0", "eth0-up");
+	_lanes_assert_started (&d, "up", "eth0-up", NULL);
+
+	_lanes_complete (&d, "up");
+	_lanes_assert_started (&d, "up", "eth0-up", "vpn-up", NULL);
+
+	_lanes_complete (&d, "eth0-up");
+	_lanes_complete (&d, "vpn-up");
+	_lanes_clear (&d);
+}
+
+static void
+test_lanes_no_device (void)
+{
+	gs_unref_variant GVariant *device_props = NULL;
+	LanesData d;
+
+	/* "hostname" and "connectivity-change" have no device and share one
+	 * lane, so they stay ordered among themselves. */
+	device_props = g_variant_ref_sink (g_variant_new_array (G_VARIANT_TYPE ("{sv}"), NULL, 0));
+	g_assert (!nm_dispatcher_utils_get_lane (device_props));
+	g_assert (!nm_dispatcher_utils_get_lane (NULL));
+
+	_lanes_init (&d, 8);
+
+	_lanes_push (&d, NULL, NMD_ACTION_HOSTNAME);
+	_lanes_push (&d, NULL, NMD_ACTION_CONNECTIVITY_CHANGE);
+	_lanes_push (&d, "eth0", "eth0-up");
+	_lanes_assert_started (&d, NMD_ACTION_HOSTNAME, "eth0-up", NULL);
+
+	_lanes_complete (&d, NMD_ACTION_HOSTNAME);
+	_lanes_assert_started (&d, NMD_ACTION_HOSTNAME, "eth0-up", NMD_ACTION_CONNECTIVITY_CHANGE, NULL);
+
+	_lanes_complete (&d, "eth0-up");
+	_lanes_complete (&d, NMD_ACTION_CONNECTIVITY_CHANGE);
+	_lanes_clear (&d);
+}
+
+static void
+test_lanes_max_parallel_1 (void)
+{
+	LanesData d;
+
+	/* with --max-parallel=1, requests run strictly one at a time and in
+	 * the order they arrived, regardless of the device. */
+	_lanes_init (&d, 1);
+
+	_lanes_push (&d, "eth0", "eth0-up");
+	_lanes_push (&d, "eth0", "eth0-down");
+	_lanes_push (&d, "wlan0", "wlan0-up");
+	_lanes_push (&d, NULL, NMD_ACTION_HOSTNAME);
+	_lanes_assert_started (&d, "eth0-up", NULL);
+
+	_lanes_complete (&d, "eth0-up");
+	_lanes_assert_started (&d, "eth0-up", "eth0-down", NULL);
+
+	_lanes_complete (&d, "eth0-down");
+	_lanes_assert_started (&d, "eth0-up", "eth0-down", "wlan0-up", NULL);
+
+	_lanes_complete (&d, "wlan0-up");
+	_lanes_assert_started (&d, "eth0-up", "eth0-down", "wlan0-up", NMD_ACTION_HOSTNAME, NULL);
+
+	_lanes_complete (&d, NMD_ACTION_HOSTNAME);
+	_lanes_clear (&d);
+}
+
+/*****************************************************************************/
+
+static void
+_script_dir_assert_cached (NMDispatcherScriptDir *dir, GPtrArray *scripts)
+{
+	GPtrArray *scripts2;
+
+	scripts2 = nm_dispatcher_script_dir_get_scripts (dir);
+	g_assert (scripts2 == scripts);
+	g_ptr_array_unref (scripts2);
+}
+
+static GPtrArray *
+_script_dir_wait_changed (NMDispatcherScriptDir *dir, GPtrArray *scripts)
+{
+	const gint64 end = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+	GPtrArray *scripts2;
+
+	/* the inventory drops its list when the main loop processes the
+	 * events of the file monitors. */
+	while (TRUE) {
+		while (g_main_context_iteration (NULL, FALSE))
+			;
+		scripts2 = nm_dispatcher_script_dir_get_scripts (dir);
+		if (scripts2 != scripts) {
+			g_ptr_array_unref (scripts);
+			return scripts2;
+		}
+		g_ptr_array_unref (scripts2);
+		g_assert (g_get_monotonic_time () < end);
+		g_usleep (1000);
+	}
+}
+
+static void
+test_script_dir (void)
+{
+	gs_free char *tmpdir = NULL;
+	gs_free char *dirname = NULL;
+	gs_free char *no_wait_dirname = NULL;
+	gs_free char *subdir = NULL;
+	gs_free char *subdir_no_wait = NULL;
+	GError *error = NULL;
+	NMDispatcherScriptDir *dir;
+	GPtrArray *scripts, *scripts2;
+
+	tmpdir = g_dir_make_tmp ("nm-dispatcher-test-XXXXXX", &error);
+	g_assert_no_error (error);
+	dirname = g_build_filename (tmpdir, "dispatcher.d", NULL);
+	no_wait_dirname = g_build_filename (tmpdir, "no-wait.d", NULL);
+	subdir = g_build_filename (dirname, "subdir", NULL);
+	subdir_no_wait = g_build_filename (no_wait_dirname, "subdir", NULL);
+	g_assert_cmpint (g_mkdir (dirname, 0755), ==, 0);
+	g_assert_cmpint (g_mkdir (no_wait_dirname, 0755), ==, 0);
+
+	/* without monitoring, the scripts are read on every call. */
+	dir = nm_dispatcher_script_dir_new (dirname, no_wait_dirname, FALSE);
+	scripts = nm_dispatcher_script_dir_get_scripts (dir);
+	scripts2 = nm_dispatcher_script_dir_get_scripts (dir);
+	g_assert (scripts != scripts2);
+	g_assert_cmpint (scripts->len, ==, 0);
+	g_ptr_array_unref (scripts);
+	g_ptr_array_unref (scripts2);
+	nm_dispatcher_script_dir_free (dir);
+
+	/* with monitoring, the list is kept until a directory changes. Only
+	 * scripts owned by root are listed, so the test changes the directories
+	 * with subdirectories, which are silently skipped. */
+	dir = nm_dispatcher_script_dir_new (dirname, no_wait_dirname, TRUE);
+	scripts = nm_dispatcher_script_dir_get_scripts (dir);
+	scripts2 = nm_dispatcher_script_dir_get_scripts (dir);
+	g_ptr_array_unref (scripts2);
+	if (scripts2 != scripts) {
+		g_test_skip ("cannot monitor directories");
+		goto out;
+	}
+
+	g_assert_cmpint (g_mkdir (subdir, 0755), ==, 0);
+	scripts = _script_dir_wait_changed (dir, scripts);
+	g_assert_cmpint (scripts->len, ==, 0);
+	_script_dir_assert_cached (dir, scripts);
+
+	g_assert_cmpint (g_mkdir (subdir_no_wait, 0755), ==, 0);
+	scripts = _script_dir_wait_changed (dir, scripts);
+	_script_dir_assert_cached (dir, scripts);
+
+	g_assert_cmpint (g_rmdir (subdir), ==, 0);
+	scripts = _script_dir_wait_changed (dir, scripts);
+	_script_dir_assert_cached (dir, scripts);
+
+	g_assert_cmpint (g_rmdir (subdir_no_wait), ==, 0);
+	scripts = _script_dir_wait_changed (dir, scripts);
+	_script_dir_assert_cached (dir, scripts);
+
+out:
+	g_ptr_array_unref (scripts);
+	nm_dispatcher_script_dir_free (dir);
+	g_rmdir (subdir);
+	g_rmdir (subdir_no_wait);
+	g_assert_cmpint (g_rmdir (dirname), ==, 0);
+	g_assert_cmpint (g_rmdir (no_wait_dirname), ==, 0);
+	g_assert_cmpint (g_rmdir (tmpdir), ==, 0);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -666,6 +1010,13 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/dispatcher/up_empty_vpn_iface", test_up_empty_vpn_iface);
 
+	g_test_add_func ("/dispatcher/lanes/device_order", test_lanes_device_order);
+	g_test_add_func ("/dispatcher/lanes/vpn", test_lanes_vpn);
+	g_test_add_func ("/dispatcher/lanes/no_device", test_lanes_no_device);
+	g_test_add_func ("/dispatcher/lanes/max_parallel_1", test_lanes_max_parallel_1);
+
+	g_test_add_func ("/dispatcher/script_dir", test_script_dir);
+
 	return g_test_run ();
 }
 
@@ -142,6 +142,8 @@ NMConnection *_nm_simple_connection_new_from_dbus (GVariant      *dict,
                                                    NMSettingParseFlags parse_flags,
                                                    GError       **error);
 
+void _nm_setting_ensure_all_registered (void);
+
 /*
  * A setting's priority should roughly follow the OSI layer model, but it also
  * controls which settings get asked for secrets first.  Thus settings which
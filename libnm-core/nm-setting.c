@@ -40,6 +40,7 @@
 #include "nm-setting-team.h"
 #include "nm-setting-team-port.h"
 #include "nm-setting-vpn.h"
+#include "nm-setting-user.h"
 
 /**
  * SECTION:nm-setting
@@ -65,6 +66,20 @@ typedef struct {
 
 typedef struct {
 	const SettingInfo *info;
+
+	/* see _setting_hash(). The hashes are reset whenever a property changes.
+	 *
+	 * Note that nm_setting_compare() writes these fields, although it
+	 * otherwise only reads the settings. Comparing a setting that is shared
+	 * between threads is therefore not thread-safe. */
+	guint hash_exact;
+	guint hash_inferrable;
+	bool hash_exact_valid:1;
+	bool hash_inferrable_valid:1;
+
+	/* whether the setting was compared before. Only then the hash is
+	 * computed, so that a one-shot compare doesn't pay for it. */
+	bool hash_wanted:1;
 } NMSettingPrivate;
 
 enum {
@@ -229,6 +244,60 @@ nm_setting_lookup_type (const char *name)
 	return info ? info->type : G_TYPE_INVALID;
 }
 
+/**
+ * _nm_setting_ensure_all_registered:
+ *
+ * Setting types register themselves the first time their #GType
+ * is used, and the registry is not protected by a lock. Call this on
+ * the main thread before creating settings on other threads, so that
+ * the registry is complete and no longer modified.
+ */
+void
+_nm_setting_ensure_all_registered (void)
+{
+	static gsize initialized = 0;
+
+	if (!g_once_init_enter (&initialized))
+		return;
+
+	g_type_ensure (NM_TYPE_SETTING_802_1X);
+	g_type_ensure (NM_TYPE_SETTING_ADSL);
+	g_type_ensure (NM_TYPE_SETTING_BLUETOOTH);
+	g_type_ensure (NM_TYPE_SETTING_BOND);
+	g_type_ensure (NM_TYPE_SETTING_BRIDGE);
+	g_type_ensure (NM_TYPE_SETTING_BRIDGE_PORT);
+	g_type_ensure (NM_TYPE_SETTING_CDMA);
+	g_type_ensure (NM_TYPE_SETTING_CONNECTION);
+	g_type_ensure (NM_TYPE_SETTING_DCB);
+	g_type_ensure (NM_TYPE_SETTING_DUMMY);
+	g_type_ensure (NM_TYPE_SETTING_GENERIC);
+	g_type_ensure (NM_TYPE_SETTING_GSM);
+	g_type_ensure (NM_TYPE_SETTING_INFINIBAND);
+	g_type_ensure (NM_TYPE_SETTING_IP4_CONFIG);
+	g_type_ensure (NM_TYPE_SETTING_IP6_CONFIG);
+	g_type_ensure (NM_TYPE_SETTING_IP_TUNNEL);
+	g_type_ensure (NM_TYPE_SETTING_MACSEC);
+	g_type_ensure (NM_TYPE_SETTING_MACVLAN);
+	g_type_ensure (NM_TYPE_SETTING_OLPC_MESH);
+	g_type_ensure (NM_TYPE_SETTING_PPP);
+	g_type_ensure (NM_TYPE_SETTING_PPPOE);
+	g_type_ensure (NM_TYPE_SETTING_PROXY);
+	g_type_ensure (NM_TYPE_SETTING_SERIAL);
+	g_type_ensure (NM_TYPE_SETTING_TEAM);
+	g_type_ensure (NM_TYPE_SETTING_TEAM_PORT);
+	g_type_ensure (NM_TYPE_SETTING_TUN);
+	g_type_ensure (NM_TYPE_SETTING_USER);
+	g_type_ensure (NM_TYPE_SETTING_VLAN);
+	g_type_ensure (NM_TYPE_SETTING_VPN);
+	g_type_ensure (NM_TYPE_SETTING_VXLAN);
+	g_type_ensure (NM_TYPE_SETTING_WIMAX);
+	g_type_ensure (NM_TYPE_SETTING_WIRED);
+	g_type_ensure (NM_TYPE_SETTING_WIRELESS);
+	g_type_ensure (NM_TYPE_SETTING_WIRELESS_SECURITY);
+
+	g_once_init_leave (&initialized, 1);
+}
+
 gint
 _nm_setting_compare_priority (gconstpointer a, gconstpointer b)
 {
@@ -270,10 +339,27 @@ _nm_setting_slave_type_is_valid (const char *slave_type, const char **out_port_t
 
 /*****************************************************************************/
 
+/* How compare_property() compares a property. Properties of simple types
+ * that are serialized to D-Bus as-is are compared directly from their
+ * GValue. Everything else is compared by its D-Bus representation. */
+typedef enum {
+	PROPERTY_COMPARE_VARIANT,
+	PROPERTY_COMPARE_BOOLEAN,
+	PROPERTY_COMPARE_UCHAR,
+	PROPERTY_COMPARE_INT,
+	PROPERTY_COMPARE_UINT,
+	PROPERTY_COMPARE_INT64,
+	PROPERTY_COMPARE_UINT64,
+	PROPERTY_COMPARE_ENUM,
+	PROPERTY_COMPARE_FLAGS,
+	PROPERTY_COMPARE_STRING,
+} PropertyCompareType;
+
 typedef struct {
 	const char *name;
 	GParamSpec *param_spec;
 	const GVariantType *dbus_type;
+	PropertyCompareType compare_type;
 
 	NMSettingPropertyGetFunc get_func;
 	NMSettingPropertySynthFunc synth_func;
@@ -501,6 +587,53 @@ _nm_setting_use_legacy_property (NMSetting *setting,
 		return FALSE;
 }
 
+static const GVariantType *variant_type_for_gtype (GType type);
+
+static PropertyCompareType
+_property_get_compare_type (const NMSettingProperty *property)
+{
+	PropertyCompareType compare_type;
+	GType gtype;
+
+	if (   !property->param_spec
+	    || property->get_func
+	    || property->to_dbus)
+		return PROPERTY_COMPARE_VARIANT;
+
+	gtype = property->param_spec->value_type;
+	if (gtype == G_TYPE_BOOLEAN)
+		compare_type = PROPERTY_COMPARE_BOOLEAN;
+	else if (gtype == G_TYPE_UCHAR)
+		compare_type = PROPERTY_COMPARE_UCHAR;
+	else if (gtype == G_TYPE_INT)
+		compare_type = PROPERTY_COMPARE_INT;
+	else if (gtype == G_TYPE_UINT)
+		compare_type = PROPERTY_COMPARE_UINT;
+	else if (gtype == G_TYPE_INT64)
+		compare_type = PROPERTY_COMPARE_INT64;
+	else if (gtype == G_TYPE_UINT64)
+		compare_type = PROPERTY_COMPARE_UINT64;
+	else if (gtype == G_TYPE_STRING)
+		compare_type = PROPERTY_COMPARE_STRING;
+	else if (g_type_is_a (gtype, G_TYPE_ENUM))
+		compare_type = PROPERTY_COMPARE_ENUM;
+	else if (g_type_is_a (gtype, G_TYPE_FLAGS))
+		compare_type = PROPERTY_COMPARE_FLAGS;
+	else
+		return PROPERTY_COMPARE_VARIANT;
+
+	/* an explicit D-Bus type other than the natural one changes the value
+	 * that get_property_for_dbus() returns. */
+	if (property->dbus_type) {
+		if (NM_IN_SET (compare_type, PROPERTY_COMPARE_ENUM, PROPERTY_COMPARE_FLAGS))
+			return PROPERTY_COMPARE_VARIANT;
+		if (!g_variant_type_equal (property->dbus_type, variant_type_for_gtype (gtype)))
+			return PROPERTY_COMPARE_VARIANT;
+	}
+
+	return compare_type;
+}
+
 static GArray *
 nm_setting_class_ensure_properties (NMSettingClass *setting_class)
 {
@@ -548,6 +681,12 @@ nm_setting_class_ensure_properties (NMSettingClass *setting_class)
 	}
 	g_array_unref (overrides);
 
+	for (i = 0; i < properties->len; i++) {
+		NMSettingProperty *p = &g_array_index (properties, NMSettingProperty, i);
+
+		p->compare_type = _property_get_compare_type (p);
+	}
+
 	g_type_set_qdata (type, setting_properties_quark (), properties);
 	return properties;
 }
@@ -572,6 +711,22 @@ nm_setting_class_find_property (NMSettingClass *setting_class, const char *prope
 	return find_property (properties, property_name);
 }
 
+static const NMSettingProperty *
+nm_setting_class_find_property_by_pspec (NMSettingClass *setting_class, const GParamSpec *param_spec)
+{
+	const NMSettingProperty *properties;
+	guint n_properties, i;
+
+	properties = nm_setting_class_get_properties (setting_class, &n_properties);
+	for (i = 0; i < n_properties; i++) {
+		if (properties[i].param_spec == param_spec)
+			return &properties[i];
+	}
+
+	/* not one of our GParamSpecs. Fall back to the name. */
+	return nm_setting_class_find_property (setting_class, param_spec->name);
+}
+
 /*****************************************************************************/
 
 static const GVariantType *
@@ -1118,6 +1273,179 @@ _nm_setting_verify_secret_string (const char *str,
 	return TRUE;
 }
 
+static gboolean
+_property_values_equal (PropertyCompareType compare_type, const GValue *a, const GValue *b)
+{
+	switch (compare_type) {
+	case PROPERTY_COMPARE_BOOLEAN:
+		return !g_value_get_boolean (a) == !g_value_get_boolean (b);
+	case PROPERTY_COMPARE_UCHAR:
+		return g_value_get_uchar (a) == g_value_get_uchar (b);
+	case PROPERTY_COMPARE_INT:
+		return g_value_get_int (a) == g_value_get_int (b);
+	case PROPERTY_COMPARE_UINT:
+		return g_value_get_uint (a) == g_value_get_uint (b);
+	case PROPERTY_COMPARE_INT64:
+		return g_value_get_int64 (a) == g_value_get_int64 (b);
+	case PROPERTY_COMPARE_UINT64:
+		return g_value_get_uint64 (a) == g_value_get_uint64 (b);
+	case PROPERTY_COMPARE_ENUM:
+		return g_value_get_enum (a) == g_value_get_enum (b);
+	case PROPERTY_COMPARE_FLAGS:
+		return g_value_get_flags (a) == g_value_get_flags (b);
+	case PROPERTY_COMPARE_STRING:
+		/* on D-Bus, a %NULL string is sent as "". */
+		return nm_streq (g_value_get_string (a) ?: "", g_value_get_string (b) ?: "");
+	case PROPERTY_COMPARE_VARIANT:
+		break;
+	}
+	g_return_val_if_reached (FALSE);
+}
+
+static guint
+_property_value_hash (PropertyCompareType compare_type, const GValue *value)
+{
+	guint64 v;
+
+	switch (compare_type) {
+	case PROPERTY_COMPARE_BOOLEAN:
+		return !!g_value_get_boolean (value);
+	case PROPERTY_COMPARE_UCHAR:
+		return g_value_get_uchar (value);
+	case PROPERTY_COMPARE_INT:
+		return g_value_get_int (value);
+	case PROPERTY_COMPARE_UINT:
+		return g_value_get_uint (value);
+	case PROPERTY_COMPARE_INT64:
+		v = g_value_get_int64 (value);
+		return (guint) (v ^ (v >> 32));
+	case PROPERTY_COMPARE_UINT64:
+		v = g_value_get_uint64 (value);
+		return (guint) (v ^ (v >> 32));
+	case PROPERTY_COMPARE_ENUM:
+		return g_value_get_enum (value);
+	case PROPERTY_COMPARE_FLAGS:
+		return g_value_get_flags (value);
+	case PROPERTY_COMPARE_STRING:
+		return g_str_hash (g_value_get_string (value) ?: "");
+	case PROPERTY_COMPARE_VARIANT:
+		break;
+	}
+	g_return_val_if_reached (0);
+}
+
+/* Same result as comparing the values from get_property_for_dbus() with
+ * nm_property_compare(), but without creating the variants. */
+static gboolean
+_property_equal_direct (NMSetting *setting,
+                        NMSetting *other,
+                        const NMSettingProperty *property)
+{
+	GValue value1 = G_VALUE_INIT;
+	GValue value2 = G_VALUE_INIT;
+	gboolean is_default1, is_default2;
+	gboolean equal;
+
+	nm_assert (property->compare_type != PROPERTY_COMPARE_VARIANT);
+
+	g_value_init (&value1, property->param_spec->value_type);
+	g_value_init (&value2, property->param_spec->value_type);
+	g_object_get_property (G_OBJECT (setting), property->param_spec->name, &value1);
+	g_object_get_property (G_OBJECT (other), property->param_spec->name, &value2);
+
+	/* default values are omitted from the D-Bus representation. */
+	is_default1 = g_param_value_defaults (property->param_spec, &value1);
+	is_default2 = g_param_value_defaults (property->param_spec, &value2);
+	if (is_default1 || is_default2)
+		equal = is_default1 && is_default2;
+	else
+		equal = _property_values_equal (property->compare_type, &value1, &value2);
+
+	g_value_unset (&value1);
+	g_value_unset (&value2);
+	return equal;
+}
+
+static gboolean
+_property_hash_inferrable (NMSetting *setting, const NMSettingProperty *property)
+{
+	if (!NM_FLAGS_HAS (property->param_spec->flags, NM_SETTING_PARAM_INFERRABLE))
+		return FALSE;
+
+	/* the team settings compare their config relaxed with
+	 * %NM_SETTING_COMPARE_FLAG_INFERRABLE. */
+	if (   (   NM_IS_SETTING_TEAM (setting)
+	        && nm_streq (property->param_spec->name, NM_SETTING_TEAM_CONFIG))
+	    || (   NM_IS_SETTING_TEAM_PORT (setting)
+	        && nm_streq (property->param_spec->name, NM_SETTING_TEAM_PORT_CONFIG)))
+		return FALSE;
+
+	return TRUE;
+}
+
+/* A hash over the properties that are compared directly. If two settings
+ * of the same type have a different hash, they don't compare equal with
+ * @flags. That holds as long as the compare_property() implementations of
+ * subclasses only handle properties specially that are compared by their
+ * D-Bus representation, or only do so for other flags, or are excluded by
+ * _property_hash_inferrable().
+ *
+ * Only %NM_SETTING_COMPARE_FLAG_EXACT and %NM_SETTING_COMPARE_FLAG_INFERRABLE
+ * are supported. The hash is cached until a property of @setting changes.
+ * It is only computed from the second compare of @setting on. Returns
+ * %FALSE if there is no hash yet. */
+static gboolean
+_setting_hash (NMSetting *setting, NMSettingCompareFlags flags, guint *out_hash)
+{
+	NMSettingPrivate *priv = NM_SETTING_GET_PRIVATE (setting);
+	const gboolean inferrable = (flags == NM_SETTING_COMPARE_FLAG_INFERRABLE);
+	const NMSettingProperty *properties;
+	guint n_properties, i;
+	guint h = 5381;
+
+	nm_assert (NM_IN_SET (flags, NM_SETTING_COMPARE_FLAG_EXACT, NM_SETTING_COMPARE_FLAG_INFERRABLE));
+
+	if (inferrable ? priv->hash_inferrable_valid : priv->hash_exact_valid) {
+		*out_hash = inferrable ? priv->hash_inferrable : priv->hash_exact;
+		return TRUE;
+	}
+
+	if (!priv->hash_wanted) {
+		priv->hash_wanted = TRUE;
+		return FALSE;
+	}
+
+	properties = nm_setting_class_get_properties (NM_SETTING_GET_CLASS (setting), &n_properties);
+	for (i = 0; i < n_properties; i++) {
+		const NMSettingProperty *property = &properties[i];
+		GValue value = G_VALUE_INIT;
+
+		if (property->compare_type == PROPERTY_COMPARE_VARIANT)
+			continue;
+		if (   inferrable
+		    && !_property_hash_inferrable (setting, property))
+			continue;
+
+		g_value_init (&value, property->param_spec->value_type);
+		g_object_get_property (G_OBJECT (setting), property->param_spec->name, &value);
+		if (g_param_value_defaults (property->param_spec, &value))
+			h = (h << 5) + h;
+		else
+			h = (h << 5) + h + 1 + _property_value_hash (property->compare_type, &value);
+		g_value_unset (&value);
+	}
+
+	if (inferrable) {
+		priv->hash_inferrable = h;
+		priv->hash_inferrable_valid = TRUE;
+	} else {
+		priv->hash_exact = h;
+		priv->hash_exact_valid = TRUE;
+	}
+	*out_hash = h;
+	return TRUE;
+}
+
 static gboolean
 compare_property (NMSetting *setting,
                   NMSetting *other,
@@ -1156,9 +1484,12 @@ compare_property (NMSetting *setting,
 			return TRUE;
 	}
 
-	property = nm_setting_class_find_property (NM_SETTING_GET_CLASS (setting), prop_spec->name);
+	property = nm_setting_class_find_property_by_pspec (NM_SETTING_GET_CLASS (setting), prop_spec);
 	g_return_val_if_fail (property != NULL, FALSE);
 
+	if (property->compare_type != PROPERTY_COMPARE_VARIANT)
+		return _property_equal_direct (setting, other, property);
+
 	value1 = get_property_for_dbus (setting, property, TRUE);
 	value2 = get_property_for_dbus (other, property, TRUE);
 
@@ -1189,10 +1520,12 @@ nm_setting_compare (NMSetting *a,
                     NMSetting *b,
                     NMSettingCompareFlags flags)
 {
-	GParamSpec **property_specs;
-	guint n_property_specs;
+	const NMSettingProperty *properties;
+	guint n_properties;
 	gint same = TRUE;
 	guint i;
+	guint hash_a, hash_b;
+	gboolean has_hash_a, has_hash_b;
 
 	g_return_val_if_fail (NM_IS_SETTING (a), FALSE);
 	g_return_val_if_fail (NM_IS_SETTING (b), FALSE);
@@ -1201,10 +1534,25 @@ nm_setting_compare (NMSetting *a,
 	if (G_OBJECT_TYPE (a) != G_OBJECT_TYPE (b))
 		return FALSE;
 
+	/* Reject settings that differ in a simple property without looking at
+	 * the other properties. The hash is cached, so this pays off when the
+	 * same settings are compared again and again. */
+	if (NM_IN_SET (flags, NM_SETTING_COMPARE_FLAG_EXACT, NM_SETTING_COMPARE_FLAG_INFERRABLE)) {
+		has_hash_a = _setting_hash (a, flags, &hash_a);
+		has_hash_b = _setting_hash (b, flags, &hash_b);
+		if (   has_hash_a
+		    && has_hash_b
+		    && hash_a != hash_b)
+			return FALSE;
+	}
+
 	/* And now all properties */
-	property_specs = g_object_class_list_properties (G_OBJECT_GET_CLASS (a), &n_property_specs);
-	for (i = 0; i < n_property_specs && same; i++) {
-		GParamSpec *prop_spec = property_specs[i];
+	properties = nm_setting_class_get_properties (NM_SETTING_GET_CLASS (a), &n_properties);
+	for (i = 0; i < n_properties && same; i++) {
+		GParamSpec *prop_spec = properties[i].param_spec;
+
+		if (!prop_spec)
+			continue;
 
 		/* Fuzzy compare ignores secrets and properties defined with the FUZZY_IGNORE flag */
 		if (   NM_FLAGS_HAS (flags, NM_SETTING_COMPARE_FLAG_FUZZY)
@@ -1225,7 +1573,6 @@ nm_setting_compare (NMSetting *a,
 
 		same = NM_SETTING_GET_CLASS (a)->compare_property (a, b, prop_spec, flags);
 	}
-	g_free (property_specs);
 
 	return same;
 }
@@ -1314,8 +1661,8 @@ nm_setting_diff (NMSetting *a,
                  gboolean invert_results,
                  GHashTable **results)
 {
-	GParamSpec **property_specs;
-	guint n_property_specs;
+	const NMSettingProperty *properties;
+	guint n_properties;
 	guint i;
 	NMSettingDiffResult a_result = NM_SETTING_DIFF_RESULT_IN_A;
 	NMSettingDiffResult b_result = NM_SETTING_DIFF_RESULT_IN_B;
@@ -1358,12 +1705,15 @@ nm_setting_diff (NMSetting *a,
 	}
 
 	/* And now all properties */
-	property_specs = g_object_class_list_properties (G_OBJECT_GET_CLASS (a), &n_property_specs);
+	properties = nm_setting_class_get_properties (NM_SETTING_GET_CLASS (a), &n_properties);
 
-	for (i = 0; i < n_property_specs; i++) {
-		GParamSpec *prop_spec = property_specs[i];
+	for (i = 0; i < n_properties; i++) {
+		GParamSpec *prop_spec = properties[i].param_spec;
 		NMSettingDiffResult r = NM_SETTING_DIFF_RESULT_UNKNOWN;
 
+		if (!prop_spec)
+			continue;
+
 		/* Handle compare flags */
 		if (!should_compare_prop (a, prop_spec->name, flags, prop_spec->flags))
 			continue;
@@ -1425,7 +1775,6 @@ nm_setting_diff (NMSetting *a,
 				g_hash_table_insert (*results, g_strdup (prop_spec->name), GUINT_TO_POINTER (r));
 		}
 	}
-	g_free (property_specs);
 
 	/* Don't return an empty hash table */
 	if (results_created && !g_hash_table_size (*results)) {
@@ -1954,6 +2303,15 @@ constructed (GObject *object)
 	G_OBJECT_CLASS (nm_setting_parent_class)->constructed (object);
 }
 
+static void
+notify (GObject *object, GParamSpec *pspec)
+{
+	NMSettingPrivate *priv = NM_SETTING_GET_PRIVATE (object);
+
+	priv->hash_exact_valid = FALSE;
+	priv->hash_inferrable_valid = FALSE;
+}
+
 static void
 get_property (GObject *object, guint prop_id,
               GValue *value, GParamSpec *pspec)
@@ -1980,6 +2338,7 @@ nm_setting_class_init (NMSettingClass *setting_class)
 	/* virtual methods */
 	object_class->constructed  = constructed;
 	object_class->get_property = get_property;
+	object_class->notify       = notify;
 
 	setting_class->update_one_secret = update_one_secret;
 	setting_class->get_secret_flags = get_secret_flags;
@@ -1232,6 +1232,7 @@ nm_utils_ip4_dns_from_variant (GVariant *value)
 	gsize length;
 	char **dns;
 	int i;
+	char buf[NM_UTILS_INET_ADDRSTRLEN];
 
 	g_return_val_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE ("au")), NULL);
 
@@ -1239,7 +1240,7 @@ nm_utils_ip4_dns_from_variant (GVariant *value)
 	dns = g_new (char *, length + 1);
 
 	for (i = 0; i < length; i++)
-		dns[i] = g_strdup (nm_utils_inet4_ntop (array[i], NULL));
+		dns[i] = g_strdup (nm_utils_inet4_ntop (array[i], buf));
 	dns[i] = NULL;
 
 	return dns;
@@ -1310,6 +1311,7 @@ nm_utils_ip4_addresses_from_variant (GVariant *value, char **out_gateway)
 	GPtrArray *addresses;
 	GVariantIter iter;
 	GVariant *addr_var;
+	char buf[NM_UTILS_INET_ADDRSTRLEN];
 
 	g_return_val_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE ("aau")), NULL);
 
@@ -1337,7 +1339,7 @@ nm_utils_ip4_addresses_from_variant (GVariant *value, char **out_gateway)
 			g_ptr_array_add (addresses, addr);
 
 			if (addr_array[2] && out_gateway && !*out_gateway)
-				*out_gateway = g_strdup (nm_utils_inet4_ntop (addr_array[2], NULL));
+				*out_gateway = g_strdup (nm_utils_inet4_ntop (addr_array[2], buf));
 		} else {
 			g_warning ("Ignoring invalid IP4 address: %s", error->message);
 			g_clear_error (&error);
@@ -1564,6 +1566,7 @@ nm_utils_ip6_dns_from_variant (GVariant *value)
 	GVariant *ip_var;
 	char **dns;
 	int i;
+	char buf[NM_UTILS_INET_ADDRSTRLEN];
 
 	g_return_val_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE ("aay")), NULL);
 
@@ -1582,7 +1585,7 @@ nm_utils_ip6_dns_from_variant (GVariant *value)
 			continue;
 		}
 
-		dns[i++] = g_strdup (nm_utils_inet6_ntop (ip, NULL));
+		dns[i++] = g_strdup (nm_utils_inet6_ntop (ip, buf));
 		g_variant_unref (ip_var);
 	}
 	dns[i] = NULL;
@@ -1661,6 +1664,7 @@ nm_utils_ip6_addresses_from_variant (GVariant *value, char **out_gateway)
 	GVariant *addr_var, *gateway_var;
 	guint32 prefix;
 	GPtrArray *addresses;
+	char buf[NM_UTILS_INET_ADDRSTRLEN];
 
 	g_return_val_if_fail (g_variant_is_of_type (value, G_VARIANT_TYPE ("a(ayuay)")), NULL);
 
@@ -1701,7 +1705,7 @@ nm_utils_ip6_addresses_from_variant (GVariant *value, char **out_gateway)
 					goto next;
 				}
 				if (!IN6_IS_ADDR_UNSPECIFIED (gateway_bytes))
-					*out_gateway = g_strdup (nm_utils_inet6_ntop (gateway_bytes, NULL));
+					*out_gateway = g_strdup (nm_utils_inet6_ntop (gateway_bytes, buf));
 			}
 		} else {
 			g_warning ("Ignoring invalid IP6 address: %s", error->message);
@@ -0,0 +1,185 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "nm-utils/nm-test-utils.h"
+
+NMTST_DEFINE ();
+
+/*****************************************************************************/
+
+static struct {
+	int count;
+	int connections;
+} global_opt = {
+	.count = 100000,
+	.connections = 1000,
+};
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionContext *context;
+	GOptionEntry options[] = {
+		{ "count", 'n', 0, G_OPTION_ARG_INT, &global_opt.count, "Number of connection pairs to compare (default 100000)", "N" },
+		{ "connections", 'c', 0, G_OPTION_ARG_INT, &global_opt.connections, "Number of different connections (default 1000)", "N" },
+		{ 0 },
+	};
+	gs_free_error GError *error = NULL;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "Measure nm_connection_compare() and nm_connection_diff() on pairs of "
+	                                       "equal and of different connections.");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, argc, argv, &error)) {
+		g_warning ("Error parsing command line arguments: %s", error->message);
+		g_option_context_free (context);
+		return FALSE;
+	}
+
+	g_option_context_free (context);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static NMConnection *
+create_connection (int i)
+{
+	gs_free char *id = g_strdup_printf ("bench-%d", i);
+	gs_free char *ifname = g_strdup_printf ("bench%d", i);
+	gs_free char *address = g_strdup_printf ("10.%d.%d.1", (i / 256) % 256, i % 256);
+	NMConnection *connection;
+	NMSettingConnection *s_con;
+	NMSetting *s_wired, *s_ip4, *s_ip6;
+	NMIPAddress *addr;
+
+	connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, &s_con);
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_INTERFACE_NAME, ifname,
+	              NM_SETTING_CONNECTION_AUTOCONNECT, FALSE,
+	              NULL);
+
+	s_wired = NM_SETTING (nm_connection_get_setting_wired (connection));
+	g_object_set (s_wired, NM_SETTING_WIRED_MTU, 1400, NULL);
+
+	s_ip4 = nm_setting_ip4_config_new ();
+	g_object_set (s_ip4,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_MANUAL,
+	              NM_SETTING_IP_CONFIG_GATEWAY, "10.0.0.254",
+	              NULL);
+	addr = nm_ip_address_new (AF_INET, address, 24, NULL);
+	nm_setting_ip_config_add_address (NM_SETTING_IP_CONFIG (s_ip4), addr);
+	nm_ip_address_unref (addr);
+	nm_setting_ip_config_add_dns (NM_SETTING_IP_CONFIG (s_ip4), "192.0.2.1");
+	nm_connection_add_setting (connection, s_ip4);
+
+	s_ip6 = nm_setting_ip6_config_new ();
+	g_object_set (s_ip6,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP6_CONFIG_METHOD_AUTO,
+	              NULL);
+	nm_connection_add_setting (connection, s_ip6);
+
+	nmtst_assert_connection_verifies_without_normalization (connection);
+	return connection;
+}
+
+static double
+measure_compare (NMConnection **a, NMConnection **b, int n_connections, int count, int offset, gboolean expected)
+{
+	gint64 start;
+	int i;
+
+	start = g_get_monotonic_time ();
+	for (i = 0; i < count; i++) {
+		int j = i % n_connections;
+		int k = (i + offset) % n_connections;
+
+		if (nm_connection_compare (a[j], b[k], NM_SETTING_COMPARE_FLAG_EXACT) != expected)
+			g_error ("unexpected compare result for pair %d/%d", j, k);
+	}
+	return (g_get_monotonic_time () - start) * 1000.0 / count;
+}
+
+static double
+measure_diff (NMConnection **a, NMConnection **b, int n_connections, int count, int offset)
+{
+	gint64 start;
+	int i;
+
+	start = g_get_monotonic_time ();
+	for (i = 0; i < count; i++) {
+		GHashTable *diffs = NULL;
+
+		nm_connection_diff (a[i % n_connections],
+		                    b[(i + offset) % n_connections],
+		                    NM_SETTING_COMPARE_FLAG_EXACT,
+		                    &diffs);
+		if (diffs)
+			g_hash_table_destroy (diffs);
+	}
+	return (g_get_monotonic_time () - start) * 1000.0 / count;
+}
+
+int
+main (int argc, char **argv)
+{
+	NMConnection **connections, **clones;
+	int n, i;
+
+	nmtst_init (&argc, &argv, TRUE);
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	if (global_opt.count <= 0)
+		global_opt.count = 1;
+	n = MAX (global_opt.connections, 2);
+
+	connections = g_new (NMConnection *, n);
+	clones = g_new (NMConnection *, n);
+	for (i = 0; i < n; i++) {
+		connections[i] = create_connection (i);
+		clones[i] = nmtst_clone_connection (connections[i]);
+	}
+
+	printf ("%d comparisons of %d connections\n", global_opt.count, n);
+	printf ("compare equal:     %8.1f ns/pair\n",
+	        measure_compare (connections, clones, n, global_opt.count, 0, TRUE));
+	printf ("compare different: %8.1f ns/pair\n",
+	        measure_compare (connections, clones, n, global_opt.count, 1, FALSE));
+	printf ("diff equal:        %8.1f ns/pair\n",
+	        measure_diff (connections, clones, n, global_opt.count, 0));
+	printf ("diff different:    %8.1f ns/pair\n",
+	        measure_diff (connections, clones, n, global_opt.count, 1));
+
+	for (i = 0; i < n; i++) {
+		g_object_unref (connections[i]);
+		g_object_unref (clones[i]);
+	}
+	g_free (connections);
+	g_free (clones);
+	return EXIT_SUCCESS;
+}
@@ -371,6 +371,59 @@ test_dedup_multi (void)
 
 /*****************************************************************************/
 
+static void
+test_nm_slab (void)
+{
+	NMSlab *slab;
+	NMSlabStats stats;
+	gs_free gpointer *objs = NULL;
+	const guint n = 5000;
+	guint i, j;
+
+	slab = nm_slab_new ("test", 24);
+	objs = g_new (gpointer, n);
+
+	for (i = 0; i < n; i++) {
+		objs[i] = nm_slab_alloc0 (slab);
+		g_assert (objs[i]);
+		g_assert (((guint8 *) objs[i])[23] == 0);
+		memset (objs[i], i, 24);
+	}
+
+	nm_slab_get_stats (slab, &stats);
+	g_assert_cmpint (stats.obj_size, >=, 24);
+	g_assert_cmpint (stats.n_used, ==, n);
+	g_assert_cmpint (stats.n_bytes, >=, n * stats.obj_size);
+
+	/* free in random order and reuse some of the objects. */
+	for (i = 0; i < n; i++) {
+		gpointer tmp;
+
+		j = nmtst_get_rand_int () % n;
+		tmp = objs[i];
+		objs[i] = objs[j];
+		objs[j] = tmp;
+	}
+	for (i = 0; i < n / 2; i++)
+		nm_slab_free (slab, objs[i]);
+	for (i = 0; i < n / 4; i++) {
+		objs[i] = nm_slab_alloc0 (slab);
+		g_assert (((guint8 *) objs[i])[0] == 0);
+	}
+	for (i = 0; i < n / 4; i++)
+		nm_slab_free (slab, objs[i]);
+	for (i = n / 2; i < n; i++)
+		nm_slab_free (slab, objs[i]);
+
+	nm_slab_get_stats (slab, &stats);
+	g_assert_cmpint (stats.n_used, ==, 0);
+	g_assert_cmpint (stats.n_chunks, <=, 1);
+
+	nm_slab_destroy (slab);
+}
+
+/*****************************************************************************/
+
 static NMConnection *
 _connection_new_from_dbus (GVariant *dict, GError **error)
 {
@@ -2873,6 +2926,80 @@ test_setting_compare_wireless_cloned_mac_address (void)
 	g_clear_object (&new);
 }
 
+static void
+test_setting_compare_cached_hash (void)
+{
+	gs_unref_object NMSetting *old = NULL, *new = NULL;
+
+	old = nm_setting_connection_new ();
+	g_object_set (old,
+	              NM_SETTING_CONNECTION_ID, "cached hash",
+	              NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, 10,
+	              NULL);
+	new = nm_setting_duplicate (old);
+
+	/* the hash is only computed from the second compare on. Compare
+	 * twice, so that both settings cache their hash. */
+	g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	g_object_set (new, NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, 20, NULL);
+	g_assert (!nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (!nm_setting_compare (new, old, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	g_object_set (new, NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, 10, NULL);
+	g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	/* an explicit default value is the same as no value. */
+	g_object_set (new, NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY_DEFAULT, NULL);
+	g_object_set (old, NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY, NM_SETTING_CONNECTION_AUTOCONNECT_PRIORITY_DEFAULT, NULL);
+	g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	g_object_set (new, NM_SETTING_CONNECTION_ID, "other id", NULL);
+	g_assert (!nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+	g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_IGNORE_ID));
+}
+
+static void
+test_setting_compare_cached_hash_inferrable (void)
+{
+	gs_unref_object NMSetting *old = NULL, *new = NULL;
+	const char *config = "{ \"runner\": { \"name\": \"roundrobin\" } }";
+	gboolean config_equal;
+	guint i;
+
+	old = nm_setting_ip4_config_new ();
+	g_object_set (old,
+	              NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_AUTO,
+	              NM_SETTING_IP_CONFIG_DHCP_HOSTNAME, "host",
+	              NULL);
+	new = nm_setting_duplicate (old);
+
+	for (i = 0; i < 3; i++)
+		g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_INFERRABLE));
+
+	/* a property that is not inferrable doesn't affect the hash. */
+	g_object_set (new, NM_SETTING_IP_CONFIG_DHCP_HOSTNAME, "other", NULL);
+	g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_INFERRABLE));
+	g_assert (!nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+
+	g_object_set (new, NM_SETTING_IP_CONFIG_METHOD, NM_SETTING_IP4_CONFIG_METHOD_MANUAL, NULL);
+	g_assert (!nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_INFERRABLE));
+	g_clear_object (&old);
+	g_clear_object (&new);
+
+	/* the team config is compared relaxed and must not be part of the
+	 * inferrable hash. */
+	old = nm_setting_team_new ();
+	new = nm_setting_team_new ();
+	g_object_set (new, NM_SETTING_TEAM_CONFIG, config, NULL);
+	config_equal = _nm_utils_team_config_equal (NULL, config, FALSE);
+	for (i = 0; i < 3; i++) {
+		g_assert (nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_INFERRABLE) == config_equal);
+		g_assert (!nm_setting_compare (old, new, NM_SETTING_COMPARE_FLAG_EXACT));
+	}
+}
+
 static void
 test_setting_compare_timestamp (void)
 {
@@ -6079,6 +6206,7 @@ int main (int argc, char **argv)
 	nmtst_init (&argc, &argv, TRUE);
 
 	g_test_add_func ("/core/general/test_dedup_multi", test_dedup_multi);
+	g_test_add_func ("/core/general/test_nm_slab", test_nm_slab);
 	g_test_add_func ("/core/general/test_utils_str_utf8safe", test_utils_str_utf8safe);
 	g_test_add_func ("/core/general/test_nm_in_set", test_nm_in_set);
 	g_test_add_func ("/core/general/test_nm_in_strset", test_nm_in_strset);
@@ -6103,6 +6231,8 @@ int main (int argc, char **argv)
 	g_test_add_func ("/core/general/test_setting_compare_routes", test_setting_compare_routes);
 	g_test_add_func ("/core/general/test_setting_compare_wired_cloned_mac_address", test_setting_compare_wired_cloned_mac_address);
 	g_test_add_func ("/core/general/test_setting_compare_wirless_cloned_mac_address", test_setting_compare_wireless_cloned_mac_address);
+	g_test_add_func ("/core/general/test_setting_compare_cached_hash", test_setting_compare_cached_hash);
+	g_test_add_func ("/core/general/test_setting_compare_cached_hash_inferrable", test_setting_compare_cached_hash_inferrable);
 	g_test_add_func ("/core/general/test_setting_compare_timestamp", test_setting_compare_timestamp);
 #define ADD_FUNC(name, func, secret_flags, comp_flags, remove_secret) \
 	g_test_add_data_func_full ("/core/general/" G_STRINGIFY (func) "_" name, \
@@ -23,6 +23,8 @@
 
 #include "nm-dedup-multi.h"
 
+#include "nm-slab.h"
+
 /*****************************************************************************/
 
 typedef struct {
@@ -43,6 +45,11 @@ struct _NMDedupMultiIndex {
 	int ref_count;
 	GHashTable *idx_entries;
 	GHashTable *idx_objs;
+
+	/* the entries are allocated from slabs, to keep them close
+	 * together in memory. */
+	NMSlab *slab_entries;
+	NMSlab *slab_head_entries;
 };
 
 /*****************************************************************************/
@@ -338,7 +345,7 @@ _add (NMDedupMultiIndex *self,
 		head_entry = head_existing;
 
 	if (!head_entry) {
-		head_entry = g_slice_new0 (NMDedupMultiHeadEntry);
+		head_entry = nm_slab_alloc0 (self->slab_head_entries);
 		head_entry->is_head = TRUE;
 		head_entry->idx_type = idx_type;
 		c_list_init (&head_entry->lst_entries_head);
@@ -354,7 +361,7 @@ _add (NMDedupMultiIndex *self,
 		nm_assert (c_list_contains (&entry_order->lst_entries, &head_entry->lst_entries_head));
 	}
 
-	entry = g_slice_new0 (NMDedupMultiEntry);
+	entry = nm_slab_alloc0 (self->slab_entries);
 	entry->obj = obj_new;
 	entry->head = head_entry;
 
@@ -534,12 +541,12 @@ _remove_entry (NMDedupMultiIndex *self,
 		nm_assert_not_reached ();
 
 	c_list_unlink (&entry->lst_entries);
-	g_slice_free (NMDedupMultiEntry, entry);
+	nm_slab_free (self->slab_entries, entry);
 
 	if (head_entry) {
 		nm_assert (c_list_is_empty (&head_entry->lst_entries_head));
 		c_list_unlink (&head_entry->lst_idx);
-		g_slice_free (NMDedupMultiHeadEntry, head_entry);
+		nm_slab_free (self->slab_head_entries, head_entry);
 	}
 
 	nm_dedup_multi_obj_unref (obj);
@@ -957,6 +964,29 @@ nm_dedup_multi_objs_to_ptr_array_head (const NMDedupMultiHeadEntry *head_entry,
 
 /*****************************************************************************/
 
+/**
+ * nm_dedup_multi_index_get_stats:
+ * @self: the #NMDedupMultiIndex
+ * @out_stats: (out): the memory used by the entries of the index.
+ *   This does not include the objects, which are allocated by
+ *   their owners.
+ */
+void
+nm_dedup_multi_index_get_stats (const NMDedupMultiIndex *self,
+                                NMSlabStats *out_stats)
+{
+	NMSlabStats stats;
+
+	g_return_if_fail (self);
+	g_return_if_fail (out_stats);
+
+	nm_slab_get_stats (self->slab_entries, out_stats);
+	nm_slab_get_stats (self->slab_head_entries, &stats);
+	nm_slab_stats_add (out_stats, &stats);
+}
+
+/*****************************************************************************/
+
 NMDedupMultiIndex *
 nm_dedup_multi_index_new (void)
 {
@@ -966,6 +996,8 @@ nm_dedup_multi_index_new (void)
 	self->ref_count = 1;
 	self->idx_entries = g_hash_table_new ((GHashFunc) _dict_idx_entries_hash, (GEqualFunc) _dict_idx_entries_equal);
 	self->idx_objs    = g_hash_table_new ((GHashFunc) _dict_idx_objs_hash,    (GEqualFunc) _dict_idx_objs_equal);
+	self->slab_entries = nm_slab_new ("dedup-entry", sizeof (NMDedupMultiEntry));
+	self->slab_head_entries = nm_slab_new ("dedup-head-entry", sizeof (NMDedupMultiHeadEntry));
 	return self;
 }
 
@@ -1016,6 +1048,9 @@ more:
 	g_hash_table_unref (self->idx_entries);
 	g_hash_table_unref (self->idx_objs);
 
+	nm_slab_destroy (self->slab_entries);
+	nm_slab_destroy (self->slab_head_entries);
+
 	g_slice_free (NMDedupMultiIndex, self);
 	return NULL;
 }
@@ -24,6 +24,7 @@
 
 #include "nm-obj.h"
 #include "c-list.h"
+#include "nm-slab.h"
 
 /*****************************************************************************/
 
@@ -246,6 +247,9 @@ _nm_auto_unref_dedup_multi_index (NMDedupMultiIndex **v)
 }
 #define nm_auto_unref_dedup_multi_index nm_auto(_nm_auto_unref_dedup_multi_index)
 
+void nm_dedup_multi_index_get_stats (const NMDedupMultiIndex *self,
+                                     NMSlabStats *out_stats);
+
 #define NM_DEDUP_MULTI_ENTRY_MISSING      ((const NMDedupMultiEntry *)     GUINT_TO_POINTER (1))
 #define NM_DEDUP_MULTI_HEAD_ENTRY_MISSING ((const NMDedupMultiHeadEntry *) GUINT_TO_POINTER (1))
 
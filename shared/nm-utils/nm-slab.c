@@ -0,0 +1,281 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * (C) Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-slab.h"
+
+#include <stdlib.h>
+
+#include "c-list.h"
+
+/*****************************************************************************/
+
+/* chunks are aligned to their size, so that the chunk of an object is
+ * found by masking its address. */
+#define CHUNK_SIZE ((gsize) (64 * 1024))
+
+/* the same alignment that malloc() guarantees. */
+#define OBJ_ALIGN  ((gsize) (2 * sizeof (gpointer)))
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) & ~((a) - 1))
+
+/* with fewer objects per chunk, the slab isn't worth it and the objects
+ * are allocated with g_slice. */
+#define OBJS_PER_CHUNK_MIN 8
+
+typedef struct {
+	NMSlab *slab;
+
+	/* linked in NMSlab's lst_chunks. */
+	CList lst_chunks;
+
+	/* linked in NMSlab's lst_partial while the chunk has free objects. */
+	CList lst_partial;
+
+	/* freed objects. The first pointer of a free object links the next one. */
+	gpointer free_list;
+
+	guint n_used;
+
+	/* the number of objects at the end of the chunk that were never
+	 * handed out. Only when they are used up, @free_list is consulted. */
+	guint n_fresh;
+} Chunk;
+
+#define CHUNK_HEADER_SIZE ALIGN_UP (sizeof (Chunk), OBJ_ALIGN)
+
+struct _NMSlab {
+	char *name;
+	gsize obj_size;
+	guint objs_per_chunk;
+	CList lst_chunks;
+	CList lst_partial;
+
+	/* one chunk without used objects is kept, so that allocating and
+	 * freeing an object at the boundary doesn't allocate a chunk every
+	 * time. */
+	Chunk *chunk_empty;
+
+	guint n_chunks;
+	gsize n_used;
+
+	/* allocate with g_slice instead. Set with the environment variable
+	 * NM_SLAB_DISABLE=1, to compare memory usage and performance. */
+	bool use_slice;
+};
+
+/*****************************************************************************/
+
+static gboolean
+_env_disabled (void)
+{
+	static int disabled = -1;
+
+	if (G_UNLIKELY (disabled == -1)) {
+		const char *env = g_getenv ("NM_SLAB_DISABLE");
+
+		disabled = env && !NM_IN_STRSET (env, "", "0");
+	}
+	return disabled;
+}
+
+NMSlab *
+nm_slab_new (const char *name, gsize obj_size)
+{
+	NMSlab *slab;
+
+	g_return_val_if_fail (obj_size > 0, NULL);
+
+	slab = g_slice_new0 (NMSlab);
+	slab->name = g_strdup (name);
+	slab->obj_size = ALIGN_UP (MAX (obj_size, sizeof (gpointer)), OBJ_ALIGN);
+	slab->objs_per_chunk = (CHUNK_SIZE - CHUNK_HEADER_SIZE) / slab->obj_size;
+	slab->use_slice =    slab->objs_per_chunk < OBJS_PER_CHUNK_MIN
+	                  || _env_disabled ();
+	c_list_init (&slab->lst_chunks);
+	c_list_init (&slab->lst_partial);
+	return slab;
+}
+
+static void
+_chunk_free (NMSlab *slab, Chunk *chunk)
+{
+	nm_assert (chunk->slab == slab);
+
+	c_list_unlink (&chunk->lst_chunks);
+	slab->n_chunks--;
+	free (chunk);
+}
+
+void
+nm_slab_destroy (NMSlab *slab)
+{
+	Chunk *chunk, *chunk_safe;
+
+	if (!slab)
+		return;
+
+	nm_assert (slab->n_used == 0);
+
+	c_list_for_each_entry_safe (chunk, chunk_safe, &slab->lst_chunks, lst_chunks)
+		_chunk_free (slab, chunk);
+
+	nm_assert (slab->n_chunks == 0);
+
+	g_free (slab->name);
+	g_slice_free (NMSlab, slab);
+}
+
+/*****************************************************************************/
+
+static Chunk *
+_chunk_new (NMSlab *slab)
+{
+	gpointer mem;
+	Chunk *chunk;
+
+	if (posix_memalign (&mem, CHUNK_SIZE, CHUNK_SIZE) != 0)
+		g_error ("%s: failed to allocate %" G_GSIZE_FORMAT " bytes", G_STRLOC, CHUNK_SIZE);
+
+	chunk = mem;
+	chunk->slab = slab;
+	chunk->free_list = NULL;
+	chunk->n_used = 0;
+	chunk->n_fresh = slab->objs_per_chunk;
+	c_list_init (&chunk->lst_partial);
+	c_list_link_tail (&slab->lst_chunks, &chunk->lst_chunks);
+	slab->n_chunks++;
+	return chunk;
+}
+
+static inline Chunk *
+_chunk_from_obj (gpointer mem)
+{
+	return (Chunk *) (((gsize) mem) & ~(CHUNK_SIZE - 1));
+}
+
+gpointer
+nm_slab_alloc0 (NMSlab *slab)
+{
+	Chunk *chunk;
+	gpointer mem;
+
+	nm_assert (slab);
+
+	slab->n_used++;
+
+	if (slab->use_slice)
+		return g_slice_alloc0 (slab->obj_size);
+
+	if (!c_list_is_empty (&slab->lst_partial))
+		chunk = c_list_first_entry (&slab->lst_partial, Chunk, lst_partial);
+	else {
+		if (slab->chunk_empty) {
+			chunk = slab->chunk_empty;
+			slab->chunk_empty = NULL;
+		} else
+			chunk = _chunk_new (slab);
+		c_list_link_front (&slab->lst_partial, &chunk->lst_partial);
+	}
+
+	if (chunk->n_fresh > 0) {
+		mem = ((guint8 *) chunk) + CHUNK_HEADER_SIZE + (slab->objs_per_chunk - chunk->n_fresh) * slab->obj_size;
+		chunk->n_fresh--;
+	} else {
+		nm_assert (chunk->free_list);
+		mem = chunk->free_list;
+		chunk->free_list = *((gpointer *) mem);
+	}
+
+	if (++chunk->n_used == slab->objs_per_chunk)
+		c_list_unlink_init (&chunk->lst_partial);
+
+	memset (mem, 0, slab->obj_size);
+	return mem;
+}
+
+void
+nm_slab_free (NMSlab *slab, gpointer mem)
+{
+	Chunk *chunk;
+
+	nm_assert (slab);
+
+	if (!mem)
+		return;
+
+	nm_assert (slab->n_used > 0);
+	slab->n_used--;
+
+	if (slab->use_slice) {
+		g_slice_free1 (slab->obj_size, mem);
+		return;
+	}
+
+	chunk = _chunk_from_obj (mem);
+	nm_assert (chunk->slab == slab);
+	nm_assert (chunk->n_used > 0);
+
+	if (chunk->n_used-- == slab->objs_per_chunk) {
+		/* the chunk was full. Now it has room again. */
+		c_list_link_tail (&slab->lst_partial, &chunk->lst_partial);
+	}
+
+	if (chunk->n_used == 0) {
+		c_list_unlink_init (&chunk->lst_partial);
+		if (slab->chunk_empty)
+			_chunk_free (slab, chunk);
+		else {
+			chunk->free_list = NULL;
+			chunk->n_fresh = slab->objs_per_chunk;
+			slab->chunk_empty = chunk;
+		}
+		return;
+	}
+
+	*((gpointer *) mem) = chunk->free_list;
+	chunk->free_list = mem;
+}
+
+/*****************************************************************************/
+
+const char *
+nm_slab_get_name (const NMSlab *slab)
+{
+	g_return_val_if_fail (slab, NULL);
+
+	return slab->name;
+}
+
+void
+nm_slab_get_stats (const NMSlab *slab, NMSlabStats *out_stats)
+{
+	g_return_if_fail (slab);
+	g_return_if_fail (out_stats);
+
+	out_stats->obj_size = slab->obj_size;
+	out_stats->n_used = slab->n_used;
+	out_stats->n_chunks = slab->n_chunks;
+	out_stats->n_bytes =   slab->use_slice
+	                     ? slab->n_used * slab->obj_size
+	                     : slab->n_chunks * CHUNK_SIZE;
+}
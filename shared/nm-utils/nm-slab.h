@@ -0,0 +1,62 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * (C) Copyright 2018 Red Hat, Inc.
+ */
+
+#ifndef __NM_SLAB_H__
+#define __NM_SLAB_H__
+
+/*****************************************************************************/
+
+/* NMSlab is a pool for objects of one size. The objects are carved from
+ * large chunks, so that many objects of the same kind share few pages. It
+ * is not thread-safe: use it only for data that is owned by one thread,
+ * like the cache of NMPlatform. */
+typedef struct _NMSlab NMSlab;
+
+typedef struct {
+	/* the size of one object, after rounding up for alignment. */
+	gsize obj_size;
+
+	/* the number of objects currently allocated. */
+	gsize n_used;
+
+	/* the number of chunks and the memory that they occupy. */
+	guint n_chunks;
+	gsize n_bytes;
+} NMSlabStats;
+
+NMSlab *nm_slab_new (const char *name, gsize obj_size);
+void nm_slab_destroy (NMSlab *slab);
+
+gpointer nm_slab_alloc0 (NMSlab *slab);
+void nm_slab_free (NMSlab *slab, gpointer mem);
+
+const char *nm_slab_get_name (const NMSlab *slab);
+void nm_slab_get_stats (const NMSlab *slab, NMSlabStats *out_stats);
+
+static inline void
+nm_slab_stats_add (NMSlabStats *stats, const NMSlabStats *other)
+{
+	stats->n_used += other->n_used;
+	stats->n_chunks += other->n_chunks;
+	stats->n_bytes += other->n_bytes;
+}
+
+#endif /* __NM_SLAB_H__ */
@@ -18,9 +18,14 @@
 
 #include "nm-arping-manager.h"
 
-#include <netinet/in.h>
-#include <sys/types.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
 #include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/if_ether.h>
+#include <netpacket/packet.h>
+#include <linux/filter.h>
 
 #include "platform/nm-platform.h"
 #include "nm-utils.h"
@@ -28,6 +33,9 @@
 
 /*****************************************************************************/
 
+/* like arping, send a probe every second until the timeout expires. */
+#define PROBE_INTERVAL_MSEC 1000
+
 typedef enum {
 	STATE_INIT,
 	STATE_PROBING,
@@ -37,10 +45,12 @@ typedef enum {
 
 typedef struct {
 	in_addr_t address;
-	GPid pid;
-	guint watch;
 	gboolean duplicate;
 	NMArpingManager *manager;
+
+	/* only used with the arping helper. */
+	GPid pid;
+	guint watch;
 } AddressInfo;
 
 /*****************************************************************************/
@@ -56,9 +66,22 @@ typedef struct {
 	int            ifindex;
 	State          state;
 	GHashTable    *addresses;
-	guint          completed;
+	guint          n_duplicates;
 	guint          timer;
 	guint          round2_id;
+	guint          probe_id;
+
+	/* one AF_PACKET socket sends and receives the ARP packets for all
+	 * addresses. It is only open while probing or announcing. */
+	int            fd;
+	GIOChannel    *channel;
+	guint          channel_id;
+	guint8         hwaddr[ETH_ALEN];
+
+	/* the packet socket only speaks ARP over ethernet. Other links (like
+	 * IPoIB) are still probed by spawning arping for each address. */
+	gboolean       use_helper;
+	guint          n_completed;
 } NMArpingManagerPrivate;
 
 struct _NMArpingManager {
@@ -127,8 +150,279 @@ nm_arping_manager_add_address (NMArpingManager *self, in_addr_t address)
 	return TRUE;
 }
 
+/*****************************************************************************/
+
+static gboolean arp_receive_cb (GIOChannel *source, GIOCondition condition, gpointer user_data);
+
+static gboolean
+link_check (NMArpingManager *self, GError **error)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	const NMPlatformLink *plink;
+
+	plink = nm_platform_link_get (NM_PLATFORM_GET, priv->ifindex);
+	if (!plink) {
+		/* The device was probably just removed. */
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't find a link for ifindex %d", priv->ifindex);
+		return FALSE;
+	}
+
+	priv->use_helper = (plink->addr.len != ETH_ALEN);
+	return TRUE;
+}
+
+static void
+socket_close (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->channel_id);
+	g_clear_pointer (&priv->channel, g_io_channel_unref);
+	if (priv->fd >= 0) {
+		close (priv->fd);
+		priv->fd = -1;
+	}
+}
+
+static gboolean
+socket_open (NMArpingManager *self, GError **error)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	/* only pass ARP requests and replies for IPv4 over ethernet. */
+	static const struct sock_filter filter[] = {
+		BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct arphdr, ar_hrd)),
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPHRD_ETHER, 0, 9),
+		BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct arphdr, ar_pro)),
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETHERTYPE_IP, 0, 7),
+		BPF_STMT (BPF_LD + BPF_B + BPF_ABS, offsetof (struct arphdr, ar_hln)),
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ETH_ALEN, 0, 5),
+		BPF_STMT (BPF_LD + BPF_B + BPF_ABS, offsetof (struct arphdr, ar_pln)),
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, sizeof (in_addr_t), 0, 3),
+		BPF_STMT (BPF_LD + BPF_H + BPF_ABS, offsetof (struct arphdr, ar_op)),
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPOP_REQUEST, 2, 0),
+		BPF_JUMP (BPF_JMP + BPF_JEQ + BPF_K, ARPOP_REPLY, 1, 0),
+		BPF_STMT (BPF_RET + BPF_K, 0),
+		BPF_STMT (BPF_RET + BPF_K, sizeof (struct ether_arp)),
+	};
+	const struct sock_fprog fprog = {
+		.len = G_N_ELEMENTS (filter),
+		.filter = (struct sock_filter *) filter,
+	};
+	struct sockaddr_ll sll = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htons (ETH_P_ARP),
+		.sll_ifindex = priv->ifindex,
+	};
+	gconstpointer hwaddr;
+	size_t hwaddr_len = 0;
+	int errsv;
+
+	nm_assert (priv->fd < 0);
+
+	hwaddr = nm_platform_link_get_address (NM_PLATFORM_GET, priv->ifindex, &hwaddr_len);
+	if (!hwaddr || hwaddr_len != ETH_ALEN) {
+		/* The device was probably just removed. */
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't find an ethernet address for ifindex %d", priv->ifindex);
+		return FALSE;
+	}
+	memcpy (priv->hwaddr, hwaddr, ETH_ALEN);
+
+	priv->fd = socket (AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, htons (ETH_P_ARP));
+	if (priv->fd < 0) {
+		errsv = errno;
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't open packet socket: %s", g_strerror (errsv));
+		return FALSE;
+	}
+
+	if (   setsockopt (priv->fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof (fprog)) < 0
+	    || bind (priv->fd, (struct sockaddr *) &sll, sizeof (sll)) < 0) {
+		errsv = errno;
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't set up packet socket: %s", g_strerror (errsv));
+		socket_close (self);
+		return FALSE;
+	}
+
+	priv->channel = g_io_channel_unix_new (priv->fd);
+	priv->channel_id = g_io_add_watch (priv->channel, G_IO_IN | G_IO_ERR | G_IO_HUP, arp_receive_cb, self);
+	return TRUE;
+}
+
+static gboolean
+arp_send (NMArpingManager *self,
+          guint16 op,
+          in_addr_t sender_ip,
+          in_addr_t target_ip,
+          const guint8 *target_hwaddr)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	struct ether_arp arp = {
+		.arp_hrd = htons (ARPHRD_ETHER),
+		.arp_pro = htons (ETHERTYPE_IP),
+		.arp_hln = ETH_ALEN,
+		.arp_pln = sizeof (in_addr_t),
+		.arp_op = htons (op),
+	};
+	struct sockaddr_ll sll = {
+		.sll_family = AF_PACKET,
+		.sll_protocol = htons (ETH_P_ARP),
+		.sll_ifindex = priv->ifindex,
+		.sll_halen = ETH_ALEN,
+		.sll_addr = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff },
+	};
+
+	memcpy (arp.arp_sha, priv->hwaddr, ETH_ALEN);
+	memcpy (arp.arp_spa, &sender_ip, sizeof (in_addr_t));
+	if (target_hwaddr)
+		memcpy (arp.arp_tha, target_hwaddr, ETH_ALEN);
+	memcpy (arp.arp_tpa, &target_ip, sizeof (in_addr_t));
+
+	if (sendto (priv->fd, &arp, sizeof (arp), 0, (struct sockaddr *) &sll, sizeof (sll)) < 0) {
+		int errsv = errno;
+
+		_LOGW ("could not send ARP for address %s: %s",
+		       nm_utils_inet4_ntop (op == ARPOP_REQUEST && !sender_ip ? target_ip : sender_ip, NULL),
+		       g_strerror (errsv));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*****************************************************************************/
+
 static void
-arping_watch_cb (GPid pid, gint status, gpointer user_data)
+probe_done (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	nm_clear_g_source (&priv->timer);
+	nm_clear_g_source (&priv->probe_id);
+	socket_close (self);
+	priv->state = STATE_PROBE_DONE;
+
+	/* the handler might destroy @self. */
+	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+}
+
+static gboolean
+arp_receive_error (NMArpingManager *self, int errsv)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+
+	/* most likely the link went away (ENETDOWN). The socket stays readable
+	 * with an error, so stop using it instead of waking up until the
+	 * probe times out. */
+	_LOGD ("could not receive ARP: %s", g_strerror (errsv));
+	if (priv->state == STATE_PROBING)
+		probe_done (self);
+	else
+		socket_close (self);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+arp_receive_cb (GIOChannel *source, GIOCondition condition, gpointer user_data)
+{
+	NMArpingManager *self = user_data;
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	struct ether_arp arp;
+	in_addr_t sender_ip;
+	AddressInfo *info;
+	ssize_t n;
+
+	if (condition & (G_IO_ERR | G_IO_HUP)) {
+		int errsv = 0;
+		socklen_t errsv_len = sizeof (errsv);
+
+		if (   getsockopt (priv->fd, SOL_SOCKET, SO_ERROR, &errsv, &errsv_len) < 0
+		    || !errsv)
+			errsv = ENETDOWN;
+		return arp_receive_error (self, errsv);
+	}
+
+	while (TRUE) {
+		n = recv (priv->fd, &arp, sizeof (arp), 0);
+		if (n < 0) {
+			int errsv = errno;
+
+			if (errsv == EINTR)
+				continue;
+			if (NM_IN_SET (errsv, EAGAIN, EWOULDBLOCK))
+				return G_SOURCE_CONTINUE;
+			return arp_receive_error (self, errsv);
+		}
+
+		if (   (size_t) n < sizeof (arp)
+		    || priv->state != STATE_PROBING)
+			continue;
+
+		/* ignore our own packets. */
+		if (memcmp (arp.arp_sha, priv->hwaddr, ETH_ALEN) == 0)
+			continue;
+
+		memcpy (&sender_ip, arp.arp_spa, sizeof (in_addr_t));
+		info = g_hash_table_lookup (priv->addresses, GUINT_TO_POINTER (sender_ip));
+		if (!info || info->duplicate)
+			continue;
+
+		_LOGD ("%s already used in the %s network by %s",
+		       nm_utils_inet4_ntop (info->address, NULL),
+		       nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex),
+		       nm_utils_hwaddr_ntoa (arp.arp_sha, ETH_ALEN));
+		info->duplicate = TRUE;
+
+		if (++priv->n_duplicates == g_hash_table_size (priv->addresses)) {
+			/* all addresses are taken. No need to wait for the timeout. */
+			probe_done (self);
+			return G_SOURCE_REMOVE;
+		}
+	}
+}
+
+static guint
+probe_send_all (NMArpingManager *self)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	AddressInfo *info;
+	guint n_sent = 0;
+
+	g_hash_table_iter_init (&iter, priv->addresses);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		if (info->duplicate)
+			continue;
+		/* an ARP probe as of RFC 5227: without a sender address. */
+		if (arp_send (self, ARPOP_REQUEST, 0, info->address, NULL))
+			n_sent++;
+	}
+	return n_sent;
+}
+
+static gboolean
+probe_send_cb (gpointer user_data)
+{
+	probe_send_all (user_data);
+	return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+static void
+helper_kill (AddressInfo *info)
+{
+	nm_clear_g_source (&info->watch);
+	if (info->pid) {
+		nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4, "arping",
+		                           1000, NULL, NULL);
+		info->pid = 0;
+	}
+}
+
+static void
+helper_watch_cb (GPid pid, gint status, gpointer user_data)
 {
 	AddressInfo *info = user_data;
 	NMArpingManager *self = info->manager;
@@ -150,13 +444,110 @@ arping_watch_cb (GPid pid, gint status, gpointer user_data)
 		_LOGD ("stopped unexpectedly with status %d for %s", status, addr);
 	}
 
-	if (++priv->completed == g_hash_table_size (priv->addresses)) {
-		priv->state = STATE_PROBE_DONE;
-		nm_clear_g_source (&priv->timer);
-		g_signal_emit (self, signals[PROBE_TERMINATED], 0);
+	if (++priv->n_completed == g_hash_table_size (priv->addresses))
+		probe_done (self);
+}
+
+static gboolean
+helper_start_probe (NMArpingManager *self, guint timeout, GError **error)
+{
+	const char *argv[] = { NULL, "-D", "-q", "-I", NULL, "-c", NULL, "-w", NULL, NULL, NULL };
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	AddressInfo *info;
+	gs_free char *timeout_str = NULL;
+	gboolean success = FALSE;
+
+	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
+	if (!argv[4]) {
+		/* The device was probably just removed. */
+		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		             "can't find a name for ifindex %d", priv->ifindex);
+		return FALSE;
 	}
+
+	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
+	if (!argv[0]) {
+		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		                     "arping could not be found");
+		return FALSE;
+	}
+
+	timeout_str = g_strdup_printf ("%u", timeout / 1000 + 2);
+	argv[6] = timeout_str;
+	argv[8] = timeout_str;
+
+	g_hash_table_iter_init (&iter, priv->addresses);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		gs_free char *tmp_str = NULL;
+
+		argv[9] = nm_utils_inet4_ntop (info->address, NULL);
+		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
+
+		if (g_spawn_async (NULL, (char **) argv, NULL,
+		                   G_SPAWN_STDOUT_TO_DEV_NULL |
+		                   G_SPAWN_STDERR_TO_DEV_NULL |
+		                   G_SPAWN_DO_NOT_REAP_CHILD,
+		                   NULL, NULL, &info->pid, NULL)) {
+			info->watch = g_child_watch_add (info->pid, helper_watch_cb, info);
+			success = TRUE;
+		} else
+			priv->n_completed++;
+	}
+
+	if (!success) {
+		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+		                     "could not spawn arping process");
+	}
+	return success;
 }
 
+static void
+helper_send_announcements (NMArpingManager *self, const char *mode_arg)
+{
+	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	const char *argv[] = { NULL, mode_arg, "-q", "-I", NULL, "-c", "1", NULL, NULL };
+	int ip_arg = G_N_ELEMENTS (argv) - 2;
+	GError *error = NULL;
+	GHashTableIter iter;
+	AddressInfo *info;
+
+	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
+	if (!argv[4]) {
+		/* The device was probably just removed. */
+		_LOGW ("can't find a name for ifindex %d", priv->ifindex);
+		return;
+	}
+
+	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
+	if (!argv[0]) {
+		_LOGW ("arping could not be found; no ARPs will be sent");
+		return;
+	}
+
+	g_hash_table_iter_init (&iter, priv->addresses);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
+		gs_free char *tmp_str = NULL;
+
+		if (info->duplicate)
+			continue;
+
+		argv[ip_arg] = nm_utils_inet4_ntop (info->address, NULL);
+		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
+
+		if (!g_spawn_async (NULL, (char **) argv, NULL,
+		                    G_SPAWN_STDOUT_TO_DEV_NULL |
+		                    G_SPAWN_STDERR_TO_DEV_NULL,
+		                    NULL, NULL, NULL, &error)) {
+			_LOGW ("could not send ARP for address %s: %s", argv[ip_arg],
+			       error->message);
+			g_clear_error (&error);
+		}
+	}
+}
+
+/*****************************************************************************/
+
 static gboolean
 arping_timeout_cb (gpointer user_data)
 {
@@ -169,19 +560,16 @@ arping_timeout_cb (gpointer user_data)
 
 	g_hash_table_iter_init (&iter, priv->addresses);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		nm_clear_g_source (&info->watch);
-		if (info->pid) {
-			_LOGD ("DAD timed out for %s",
-			       nm_utils_inet4_ntop (info->address, NULL));
-			nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4,
-			                           "arping", 1000, NULL, NULL);
-			info->pid = 0;
-		}
+		if (priv->use_helper) {
+			if (info->pid) {
+				_LOGD ("DAD timed out for %s", nm_utils_inet4_ntop (info->address, NULL));
+				helper_kill (info);
+			}
+		} else if (!info->duplicate)
+			_LOGD ("DAD succeeded for %s", nm_utils_inet4_ntop (info->address, NULL));
 	}
 
-	priv->state = STATE_PROBE_DONE;
-	g_signal_emit (self, signals[PROBE_TERMINATED], 0);
-
+	probe_done (self);
 	return G_SOURCE_REMOVE;
 }
 
@@ -199,12 +587,7 @@ arping_timeout_cb (gpointer user_data)
 gboolean
 nm_arping_manager_start_probe (NMArpingManager *self, guint timeout, GError **error)
 {
-	const char *argv[] = { NULL, "-D", "-q", "-I", NULL, "-c", NULL, "-w", NULL, NULL, NULL };
 	NMArpingManagerPrivate *priv;
-	GHashTableIter iter;
-	AddressInfo *info;
-	gs_free char *timeout_str = NULL;
-	gboolean success = FALSE;
 
 	g_return_val_if_fail (NM_IS_ARPING_MANAGER (self), FALSE);
 	g_return_val_if_fail (!error || !*error, FALSE);
@@ -213,54 +596,38 @@ nm_arping_manager_start_probe (NMArpingManager *self, guint timeout, GError **er
 	priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
 	g_return_val_if_fail (priv->state == STATE_INIT, FALSE);
 
-	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
-	if (!argv[4]) {
-		/* The device was probably just removed. */
-		g_set_error (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		             "can't find a name for ifindex %d", priv->ifindex);
-		return FALSE;
-	}
-
-	priv->completed = 0;
-
-	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
-	if (!argv[0]) {
+	if (!g_hash_table_size (priv->addresses)) {
 		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		                     "arping could not be found");
+		                     "no addresses to probe");
 		return FALSE;
 	}
 
-	timeout_str = g_strdup_printf ("%u", timeout / 1000 + 2);
-	argv[6] = timeout_str;
-	argv[8] = timeout_str;
-
-	g_hash_table_iter_init (&iter, priv->addresses);
-
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		gs_free char *tmp_str = NULL;
+	if (!link_check (self, error))
+		return FALSE;
 
-		argv[9] = nm_utils_inet4_ntop (info->address, NULL);
-		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
+	priv->n_duplicates = 0;
+	priv->n_completed = 0;
 
-		if (g_spawn_async (NULL, (char **) argv, NULL,
-		                   G_SPAWN_STDOUT_TO_DEV_NULL |
-		                   G_SPAWN_STDERR_TO_DEV_NULL |
-		                   G_SPAWN_DO_NOT_REAP_CHILD,
-		                   NULL, NULL, &info->pid, NULL)) {
-			info->watch = g_child_watch_add (info->pid, arping_watch_cb, info);
-			success = TRUE;
+	if (priv->use_helper) {
+		if (!helper_start_probe (self, timeout, error))
+			return FALSE;
+	} else {
+		if (!socket_open (self, error))
+			return FALSE;
+
+		_LOGD ("probe %u addresses for %u ms", g_hash_table_size (priv->addresses), timeout);
+		if (!probe_send_all (self)) {
+			socket_close (self);
+			g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
+			                     "could not send ARP probes");
+			return FALSE;
 		}
-	}
 
-	if (success) {
-		priv->timer = g_timeout_add (timeout, arping_timeout_cb, self);
-		priv->state = STATE_PROBING;
-	} else {
-		g_set_error_literal (error, NM_DEVICE_ERROR, NM_DEVICE_ERROR_FAILED,
-		                     "could not spawn arping process");
+		priv->probe_id = g_timeout_add (PROBE_INTERVAL_MSEC, probe_send_cb, self);
 	}
-
-	return success;
+	priv->timer = g_timeout_add (timeout, arping_timeout_cb, self);
+	priv->state = STATE_PROBING;
+	return TRUE;
 }
 
 /**
@@ -279,6 +646,8 @@ nm_arping_manager_reset (NMArpingManager *self)
 
 	nm_clear_g_source (&priv->timer);
 	nm_clear_g_source (&priv->round2_id);
+	nm_clear_g_source (&priv->probe_id);
+	socket_close (self);
 	g_hash_table_remove_all (priv->addresses);
 
 	priv->state = STATE_INIT;
@@ -327,49 +696,30 @@ nm_arping_manager_check_address (NMArpingManager *self, in_addr_t address)
 }
 
 static void
-send_announcements (NMArpingManager *self, const char *mode_arg)
+send_announcements (NMArpingManager *self, guint16 op)
 {
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
-	const char *argv[] = { NULL, mode_arg, "-q", "-I", NULL, "-c", "1", NULL, NULL };
-	int ip_arg = G_N_ELEMENTS (argv) - 2;
-	GError *error = NULL;
+	static const guint8 broadcast[ETH_ALEN] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
 	GHashTableIter iter;
 	AddressInfo *info;
 
-	argv[4] = nm_platform_link_get_name (NM_PLATFORM_GET, priv->ifindex);
-	if (!argv[4]) {
-		/* The device was probably just removed. */
-		_LOGW ("can't find a name for ifindex %d", priv->ifindex);
+	if (priv->use_helper) {
+		helper_send_announcements (self, op == ARPOP_REPLY ? "-A" : "-U");
 		return;
 	}
 
-	argv[0] = nm_utils_find_helper ("arping", NULL, NULL);
-	if (!argv[0]) {
-		_LOGW ("arping could not be found; no ARPs will be sent");
+	if (priv->fd < 0)
 		return;
-	}
 
 	g_hash_table_iter_init (&iter, priv->addresses);
-
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info)) {
-		gs_free char *tmp_str = NULL;
-		gboolean success;
-
 		if (info->duplicate)
 			continue;
 
-		argv[ip_arg] = nm_utils_inet4_ntop (info->address, NULL);
-		_LOGD ("run %s", (tmp_str = g_strjoinv (" ", (char **) argv)));
-
-		success = g_spawn_async (NULL, (char **) argv, NULL,
-		                         G_SPAWN_STDOUT_TO_DEV_NULL |
-		                         G_SPAWN_STDERR_TO_DEV_NULL,
-		                         NULL, NULL, NULL, &error);
-		if (!success) {
-			_LOGW ("could not send ARP for address %s: %s", argv[ip_arg],
-			       error->message);
-			g_clear_error (&error);
-		}
+		/* gratuitous ARP, as sent by "arping -A" (reply) and "arping -U" (request). */
+		_LOGD ("announce %s", nm_utils_inet4_ntop (info->address, NULL));
+		arp_send (self, op, info->address, info->address,
+		          op == ARPOP_REPLY ? priv->hwaddr : broadcast);
 	}
 }
 
@@ -379,7 +729,8 @@ arp_announce_round2 (gpointer self)
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE ((NMArpingManager *) self);
 
 	priv->round2_id = 0;
-	send_announcements (self, "-U");
+	send_announcements (self, ARPOP_REQUEST);
+	socket_close (self);
 	priv->state = STATE_INIT;
 	g_hash_table_remove_all (priv->addresses);
 
@@ -396,11 +747,20 @@ void
 nm_arping_manager_announce_addresses (NMArpingManager *self)
 {
 	NMArpingManagerPrivate *priv = NM_ARPING_MANAGER_GET_PRIVATE (self);
+	gs_free_error GError *error = NULL;
 
 	g_return_if_fail (   priv->state == STATE_INIT
 	                  || priv->state == STATE_PROBE_DONE);
 
-	send_announcements (self, "-A");
+	if (   !link_check (self, &error)
+	    || (   !priv->use_helper
+	        && priv->fd < 0
+	        && !socket_open (self, &error))) {
+		_LOGW ("no ARPs will be sent: %s", error->message);
+		return;
+	}
+
+	send_announcements (self, ARPOP_REPLY);
 	nm_clear_g_source (&priv->round2_id);
 	priv->round2_id = g_timeout_add_seconds (2, arp_announce_round2, self);
 	priv->state = STATE_ANNOUNCING;
@@ -411,13 +771,7 @@ destroy_address_info (gpointer data)
 {
 	AddressInfo *info = (AddressInfo *) data;
 
-	nm_clear_g_source (&info->watch);
-
-	if (info->pid) {
-		nm_utils_kill_child_async (info->pid, SIGTERM, LOGD_IP4, "arping",
-		                           1000, NULL, NULL);
-	}
-
+	helper_kill (info);
 	g_slice_free (AddressInfo, info);
 }
 
@@ -431,6 +785,7 @@ nm_arping_manager_init (NMArpingManager *self)
 	priv->addresses = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 	                                         NULL, destroy_address_info);
 	priv->state = STATE_INIT;
+	priv->fd = -1;
 }
 
 NMArpingManager *
@@ -453,6 +808,8 @@ dispose (GObject *object)
 
 	nm_clear_g_source (&priv->timer);
 	nm_clear_g_source (&priv->round2_id);
+	nm_clear_g_source (&priv->probe_id);
+	socket_close (self);
 	g_clear_pointer (&priv->addresses, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (nm_arping_manager_parent_class)->dispose (object);
@@ -1957,8 +1957,13 @@ nm_device_get_connectivity_state (NMDevice *self)
 
 #if WITH_CONCHECK
 static void
-concheck_periodic (NMConnectivity *connectivity, NMDevice *self)
+concheck_periodic (NMConnectivity *connectivity, const char *iface, NMDevice *self)
 {
+	/* the periodic checks run per interface. %NULL asks all devices. */
+	if (   iface
+	    && !nm_streq0 (iface, nm_device_get_ip_iface (self)))
+		return;
+
 	nm_device_check_connectivity (self, NULL, NULL);
 }
 #endif
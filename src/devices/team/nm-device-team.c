@@ -575,7 +575,7 @@ teamd_start (NMDevice *device, NMConnection *connection)
 		g_ptr_array_add (argv, (gpointer) config);
 	}
 
-	if (nm_logging_enabled (LOGL_DEBUG, LOGD_TEAM))
+	if (nm_logging_backend_enabled (LOGL_DEBUG, LOGD_TEAM))
 		g_ptr_array_add (argv, (gpointer) "-gg");
 	g_ptr_array_add (argv, NULL);
 
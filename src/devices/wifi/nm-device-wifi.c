@@ -149,6 +149,8 @@ static gboolean check_scanning_allowed (NMDeviceWifi *self);
 
 static void schedule_scan (NMDeviceWifi *self, gboolean backoff);
 
+static void schedule_ap_list_dump (NMDeviceWifi *self);
+
 static void cleanup_association_attempt (NMDeviceWifi * self,
                                          gboolean disconnect);
 
@@ -1583,6 +1585,57 @@ schedule_scan (NMDeviceWifi *self, gboolean backoff)
 	}
 }
 
+static void
+ap_list_update_after_scan (NMDeviceWifi *self, NMSupplicantInterface *iface)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	gs_unref_hashtable GHashTable *aps_by_path = NULL;
+	gs_free const char **paths = NULL;
+	GHashTableIter iter;
+	NMWifiAP *ap;
+	gint32 now_s;
+	guint i;
+
+	if (nm_device_get_state (NM_DEVICE (self)) <= NM_DEVICE_STATE_UNAVAILABLE)
+		return;
+	if (priv->mode == NM_802_11_MODE_AP)
+		return;
+
+	/* The supplicant still knows all BSSs of the scan, and all their property
+	 * changes were already handled by supplicant_iface_bss_updated_cb(). Refresh
+	 * the APs in one go: the ones we have only need a new last-seen timestamp,
+	 * only the ones we dropped meanwhile are created again. Look the APs up by
+	 * supplicant path via a temporary hash, instead of searching the AP list
+	 * for each BSS. */
+	aps_by_path = g_hash_table_new (g_str_hash, g_str_equal);
+	g_hash_table_iter_init (&iter, priv->aps);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &ap)) {
+		const char *path = nm_wifi_ap_get_supplicant_path (ap);
+
+		if (path)
+			g_hash_table_insert (aps_by_path, (gpointer) path, ap);
+	}
+
+	now_s = nm_utils_get_monotonic_timestamp_s ();
+	paths = nm_supplicant_interface_get_bss_paths (iface, NULL);
+	for (i = 0; paths[i]; i++) {
+		gs_unref_variant GVariant *properties = NULL;
+
+		ap = g_hash_table_lookup (aps_by_path, paths[i]);
+		if (ap) {
+			nm_wifi_ap_set_last_seen (ap, now_s);
+			nm_wifi_ap_set_fake (ap, FALSE);
+			continue;
+		}
+
+		properties = nm_supplicant_interface_get_bss_properties (iface, paths[i]);
+		if (properties)
+			supplicant_iface_bss_updated_cb (iface, paths[i], properties, self);
+	}
+
+	schedule_ap_list_dump (self);
+}
+
 static void
 supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
                                gboolean success,
@@ -1592,6 +1645,8 @@ supplicant_iface_scan_done_cb (NMSupplicantInterface *iface,
 
 	_LOGD (LOGD_WIFI, "wifi-scan: scan-done callback: %s", success ? "successful" : "failed");
 
+	ap_list_update_after_scan (self, iface);
+
 	priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
 	schedule_scan (self, success);
 
@@ -384,7 +384,15 @@ nm_wifi_ap_get_flags (const NMWifiAP *ap)
 	return NM_WIFI_AP_GET_PRIVATE (ap)->flags;
 }
 
-static gboolean
+gint32
+nm_wifi_ap_get_last_seen (const NMWifiAP *ap)
+{
+	g_return_val_if_fail (NM_IS_WIFI_AP (ap), -1);
+
+	return NM_WIFI_AP_GET_PRIVATE (ap)->last_seen;
+}
+
+gboolean
 nm_wifi_ap_set_last_seen (NMWifiAP *ap, gint32 last_seen)
 {
 	NMWifiAPPrivate *priv;
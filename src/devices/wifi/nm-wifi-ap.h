@@ -89,6 +89,9 @@ gboolean          nm_wifi_ap_get_fake                 (const NMWifiAP *ap);
 gboolean          nm_wifi_ap_set_fake                 (NMWifiAP *ap,
                                                        gboolean fake);
 NM80211ApFlags    nm_wifi_ap_get_flags                (const NMWifiAP *self);
+gint32            nm_wifi_ap_get_last_seen            (const NMWifiAP *ap);
+gboolean          nm_wifi_ap_set_last_seen            (NMWifiAP *ap,
+                                                       gint32 last_seen);
 
 const char       *nm_wifi_ap_to_string                (const NMWifiAP *self,
                                                        char *str_buf,
@@ -23,8 +23,10 @@
 #include <string.h>
 
 #include "devices/wifi/nm-wifi-utils.h"
+#include "devices/wifi/nm-wifi-ap.h"
 
 #include "nm-core-internal.h"
+#include "NetworkManagerUtils.h"
 
 #include "nm-test-utils-core.h"
 
@@ -1336,6 +1338,52 @@ test_strength_wext (void)
 
 /*****************************************************************************/
 
+static GVariant *
+_bss_properties_new (gint16 signal)
+{
+	const guint8 bssid[6] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+	const char *ssid = "blahblah";
+	GVariantBuilder builder;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	g_variant_builder_add (&builder, "{sv}", "BSSID",
+	                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, bssid, sizeof (bssid), 1));
+	g_variant_builder_add (&builder, "{sv}", "SSID",
+	                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE, ssid, strlen (ssid), 1));
+	g_variant_builder_add (&builder, "{sv}", "Mode", g_variant_new_string ("infrastructure"));
+	g_variant_builder_add (&builder, "{sv}", "Signal", g_variant_new_int16 (signal));
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+}
+
+static void
+test_ap_last_seen (void)
+{
+	gs_unref_object NMWifiAP *ap = NULL;
+	gs_unref_variant GVariant *props = NULL;
+	gint32 now_s = nm_utils_get_monotonic_timestamp_s ();
+	gint8 strength;
+
+	props = _bss_properties_new (-60);
+	ap = nm_wifi_ap_new_from_properties ("/fi/w1/wpa_supplicant1/Interfaces/1/BSSs/1", props);
+	g_assert (ap);
+	g_assert_cmpstr (nm_wifi_ap_get_supplicant_path (ap), ==, "/fi/w1/wpa_supplicant1/Interfaces/1/BSSs/1");
+	g_assert_cmpint (nm_wifi_ap_get_last_seen (ap), >=, now_s);
+	strength = nm_wifi_ap_get_strength (ap);
+
+	/* after a scan, an AP that is still known only gets its timestamp refreshed,
+	 * without parsing the BSS properties again. */
+	g_assert (nm_wifi_ap_set_last_seen (ap, now_s - 100));
+	g_assert (!nm_wifi_ap_set_last_seen (ap, now_s - 100));
+	g_assert_cmpint (nm_wifi_ap_get_last_seen (ap), ==, now_s - 100);
+	g_assert_cmpint (nm_wifi_ap_get_strength (ap), ==, strength);
+
+	/* updating from the properties refreshes the timestamp too. */
+	g_assert (nm_wifi_ap_update_from_properties (ap, nm_wifi_ap_get_supplicant_path (ap), props));
+	g_assert_cmpint (nm_wifi_ap_get_last_seen (ap), >=, now_s);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -1498,5 +1546,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/wifi/strength/wext",
 	                 test_strength_wext);
 
+	g_test_add_func ("/wifi/ap/last_seen",
+	                 test_ap_last_seen);
+
 	return g_test_run ();
 }
@@ -669,11 +669,9 @@ nm_dhcp_dhclient_init (NMDhcpDhclient *self)
 	if (!priv->def_leasefile)
 		priv->def_leasefile = SYSCONFDIR "/dhclient6.leases";
 
+	/* the listener passes the events to NMDhcpManager, which looks up
+	 * the client instance by ifindex. */
 	priv->dhcp_listener = g_object_ref (nm_dhcp_listener_get ());
-	g_signal_connect (priv->dhcp_listener,
-	                  NM_DHCP_LISTENER_EVENT,
-	                  G_CALLBACK (nm_dhcp_client_handle_event),
-	                  self);
 }
 
 static void
@@ -681,12 +679,7 @@ dispose (GObject *object)
 {
 	NMDhcpDhclientPrivate *priv = NM_DHCP_DHCLIENT_GET_PRIVATE ((NMDhcpDhclient *) object);
 
-	if (priv->dhcp_listener) {
-		g_signal_handlers_disconnect_by_func (priv->dhcp_listener,
-		                                      G_CALLBACK (nm_dhcp_client_handle_event),
-		                                      NM_DHCP_DHCLIENT (object));
-		g_clear_object (&priv->dhcp_listener);
-	}
+	g_clear_object (&priv->dhcp_listener);
 
 	nm_clear_g_free (&priv->pid_file);
 	nm_clear_g_free (&priv->conf_file);
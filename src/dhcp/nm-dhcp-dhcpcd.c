@@ -212,11 +212,9 @@ nm_dhcp_dhcpcd_init (NMDhcpDhcpcd *self)
 {
 	NMDhcpDhcpcdPrivate *priv = NM_DHCP_DHCPCD_GET_PRIVATE (self);
 
+	/* the listener passes the events to NMDhcpManager, which looks up
+	 * the client instance by ifindex. */
 	priv->dhcp_listener = g_object_ref (nm_dhcp_listener_get ());
-	g_signal_connect (priv->dhcp_listener,
-	                  NM_DHCP_LISTENER_EVENT,
-	                  G_CALLBACK (nm_dhcp_client_handle_event),
-	                  self);
 }
 
 static void
@@ -224,12 +222,7 @@ dispose (GObject *object)
 {
 	NMDhcpDhcpcdPrivate *priv = NM_DHCP_DHCPCD_GET_PRIVATE ((NMDhcpDhcpcd *) object);
 
-	if (priv->dhcp_listener) {
-		g_signal_handlers_disconnect_by_func (priv->dhcp_listener,
-		                                      G_CALLBACK (nm_dhcp_client_handle_event),
-		                                      NM_DHCP_DHCPCD (object));
-		g_clear_object (&priv->dhcp_listener);
-	}
+	g_clear_object (&priv->dhcp_listener);
 
 	nm_clear_g_free (&priv->pid_file);
 
@@ -0,0 +1,155 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * (C) Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-dhcp-helper-api.h"
+
+#include <string.h>
+
+/*****************************************************************************/
+
+/**
+ * nm_dhcp_helper_notify_encode:
+ * @ifindex: the ifindex of the interface, or 0
+ * @envp: the environment of the DHCP client script
+ * @ignore: (allow-none): prefixes of variables that are not DHCP options
+ *
+ * Returns: the datagram for the notify socket, or %NULL if the options
+ *   don't fit into one datagram.
+ */
+GByteArray *
+nm_dhcp_helper_notify_encode (int ifindex,
+                              const char *const *envp,
+                              const char *const *ignore)
+{
+	NMDhcpHelperNotifyHeader header = {
+		.magic = NM_DHCP_HELPER_NOTIFY_MAGIC,
+		.ifindex = MAX (ifindex, 0),
+	};
+	GByteArray *data;
+	const char *const *item;
+
+	data = g_byte_array_sized_new (4096);
+	g_byte_array_append (data, (const guint8 *) &header, sizeof (header));
+
+	for (item = envp; item && *item; item++) {
+		NMDhcpHelperNotifyOption option;
+		const char *const *p;
+		const char *val;
+		gsize name_len, value_len;
+
+		/* Split on the = */
+		val = strchr (*item, '=');
+		if (!val || val == *item)
+			continue;
+		name_len = val - *item;
+		val++;
+		value_len = strlen (val);
+
+		/* Ignore non-DCHP-related environment variables */
+		for (p = ignore; p && *p; p++) {
+			if (strncmp (*item, *p, strlen (*p)) == 0)
+				break;
+		}
+		if (p && *p)
+			continue;
+
+		if (   name_len > G_MAXUINT16
+		    || value_len > G_MAXUINT16
+		    || data->len + sizeof (option) + name_len + value_len > NM_DHCP_HELPER_NOTIFY_MAX_SIZE) {
+			g_byte_array_unref (data);
+			return NULL;
+		}
+
+		option.name_len = name_len;
+		option.value_len = value_len;
+		g_byte_array_append (data, (const guint8 *) &option, sizeof (option));
+		g_byte_array_append (data, (const guint8 *) *item, name_len);
+		g_byte_array_append (data, (const guint8 *) val, value_len);
+	}
+
+	return data;
+}
+
+/**
+ * nm_dhcp_helper_notify_decode:
+ * @data: the received datagram
+ * @len: the length of @data
+ * @out_ifindex: (out): the ifindex from the header
+ *
+ * Returns: (transfer full): the options as an "a{sv}" variant
+ *   whose values are byte arrays, like the D-Bus method receives them.
+ *   %NULL if the datagram is malformed.
+ */
+GVariant *
+nm_dhcp_helper_notify_decode (const guint8 *data,
+                              gsize len,
+                              int *out_ifindex)
+{
+	NMDhcpHelperNotifyHeader header;
+	GVariantBuilder builder;
+	gsize pos;
+
+	g_return_val_if_fail (data || !len, NULL);
+
+	if (len < sizeof (header))
+		return NULL;
+	memcpy (&header, data, sizeof (header));
+	if (   header.magic != NM_DHCP_HELPER_NOTIFY_MAGIC
+	    || header.ifindex < 0)
+		return NULL;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	for (pos = sizeof (header); pos < len; ) {
+		NMDhcpHelperNotifyOption option;
+		gs_free char *name = NULL;
+
+		if (len - pos < sizeof (option))
+			goto fail;
+		memcpy (&option, &data[pos], sizeof (option));
+		pos += sizeof (option);
+
+		if (   option.name_len == 0
+		    || len - pos < (gsize) option.name_len + option.value_len)
+			goto fail;
+
+		name = g_strndup ((const char *) &data[pos], option.name_len);
+		if (   strlen (name) != option.name_len
+		    || !g_utf8_validate (name, -1, NULL))
+			goto fail;
+		pos += option.name_len;
+
+		g_variant_builder_add (&builder, "{sv}",
+		                       name,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  &data[pos], option.value_len, 1));
+		pos += option.value_len;
+	}
+
+	NM_SET_OUT (out_ifindex, header.ifindex);
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+
+fail:
+	g_variant_builder_clear (&builder);
+	return NULL;
+}
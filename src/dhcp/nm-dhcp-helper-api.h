@@ -33,4 +33,36 @@
 
 /*****************************************************************************/
 
+/* Besides the D-Bus method, NetworkManager listens for lease events on a
+ * datagram socket. A datagram is a NMDhcpHelperNotifyHeader, followed by
+ * the options. Each option is a NMDhcpHelperNotifyOption, followed by the
+ * name and the value, both without trailing NUL. All integers are in host
+ * byte order. */
+
+#define NM_DHCP_HELPER_NOTIFY_SOCKET_PATH       NMRUNDIR "/private-dhcp-notify"
+#define NM_DHCP_HELPER_NOTIFY_MAGIC             ((guint32) 0x4e4d4431u)
+#define NM_DHCP_HELPER_NOTIFY_MAX_SIZE          (64 * 1024)
+
+typedef struct {
+	guint32 magic;
+
+	/* the ifindex of the "interface" option, or 0 if unknown. */
+	gint32 ifindex;
+} NMDhcpHelperNotifyHeader;
+
+typedef struct {
+	guint16 name_len;
+	guint16 value_len;
+} NMDhcpHelperNotifyOption;
+
+GByteArray *nm_dhcp_helper_notify_encode (int ifindex,
+                                          const char *const *envp,
+                                          const char *const *ignore);
+
+GVariant *nm_dhcp_helper_notify_decode (const guint8 *data,
+                                        gsize len,
+                                        int *out_ifindex);
+
+/*****************************************************************************/
+
 #endif /* __NM_DHCP_HELPER_API_H__ */
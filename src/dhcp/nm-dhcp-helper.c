@@ -24,6 +24,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <errno.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "nm-utils/nm-vpn-plugin-macros.h"
 
@@ -62,7 +66,52 @@
 
 /*****************************************************************************/
 
-static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
+static const char *const ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
+
+static gboolean
+notify_socket (void)
+{
+	GByteArray *data;
+	struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+		.sun_path = NM_DHCP_HELPER_NOTIFY_SOCKET_PATH,
+	};
+	const char *iface;
+	int ifindex = 0;
+	int fd;
+	gboolean success;
+
+	iface = getenv ("interface");
+	if (iface)
+		ifindex = if_nametoindex (iface);
+
+	data = nm_dhcp_helper_notify_encode (ifindex, (const char *const *) environ, ignore);
+	if (!data) {
+		_LOGi ("the options are too large for the notify socket");
+		return FALSE;
+	}
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		_LOGW ("could not create socket: %s", g_strerror (errno));
+		g_byte_array_unref (data);
+		return FALSE;
+	}
+
+	/* don't block when NetworkManager falls behind and the socket queue is
+	 * full. D-Bus still works then, and NetworkManager handles the events
+	 * queued on the socket before the D-Bus call. */
+	success = sendto (fd, data->data, data->len, MSG_DONTWAIT, (struct sockaddr *) &addr, sizeof (addr)) >= 0;
+	if (!success) {
+		/* an older NetworkManager doesn't listen on the socket yet, or
+		 * the queue is full (EAGAIN). */
+		_LOGi ("could not send to the notify socket: %s (try D-Bus)", g_strerror (errno));
+	}
+
+	close (fd);
+	g_byte_array_unref (data);
+	return success;
+}
 
 static GVariant *
 build_signal_parameters (void)
@@ -134,6 +183,11 @@ main (int argc, char *argv[])
 	guint try_count = 0;
 	gint64 time_end;
 
+	/* the datagram needs no connection setup and no reply, so it is
+	 * cheap even when many clients renew their leases at once. */
+	if (notify_socket ())
+		return EXIT_SUCCESS;
+
 	nm_g_type_init ();
 
 	/* FIXME: g_dbus_connection_new_for_address_sync() tries to connect to the socket in
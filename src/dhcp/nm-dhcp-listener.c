@@ -22,6 +22,8 @@
 #include "nm-dhcp-listener.h"
 
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <string.h>
@@ -31,6 +33,7 @@
 
 #include "nm-dhcp-helper-api.h"
 #include "nm-dhcp-client.h"
+#include "nm-dhcp-manager.h"
 #include "nm-core-internal.h"
 #include "nm-bus-manager.h"
 #include "NetworkManagerUtils.h"
@@ -60,6 +63,12 @@ typedef struct {
 	gulong              new_conn_id;
 	gulong              dis_conn_id;
 	GHashTable *        connections;
+
+	/* the socket for NM_DHCP_HELPER_NOTIFY_SOCKET_PATH */
+	int                 notify_fd;
+	GIOChannel *        notify_channel;
+	guint               notify_id;
+	guint8 *            notify_buf;
 } NMDhcpListenerPrivate;
 
 struct _NMDhcpListener {
@@ -71,12 +80,6 @@ struct _NMDhcpListenerClass {
 	GObjectClass parent;
 };
 
-enum {
-	EVENT,
-	LAST_SIGNAL
-};
-static guint signals[LAST_SIGNAL] = { 0 };
-
 G_DEFINE_TYPE (NMDhcpListener, nm_dhcp_listener, G_TYPE_OBJECT)
 
 #define NM_DHCP_LISTENER_GET_PRIVATE(self) _NM_GET_PRIVATE(self, NMDhcpListener, NM_IS_DHCP_LISTENER)
@@ -135,65 +138,70 @@ get_option (GVariant *options, const char *key)
 }
 
 static void
-_method_call (GDBusConnection *connection,
-              const char *sender,
-              const char *object_path,
-              const char *interface_name,
-              const char *method_name,
-              GVariant *parameters,
-              GDBusMethodInvocation *invocation,
-              gpointer user_data)
+_handle_event (NMDhcpListener *self, int ifindex, GVariant *options)
 {
-	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
-	char *iface = NULL;
-	char *pid_str = NULL;
-	char *reason = NULL;
+	gs_free char *iface = NULL;
+	gs_free char *pid_str = NULL;
+	gs_free char *reason = NULL;
 	gint pid;
-	gboolean handled = FALSE;
-	GVariant *options;
-
-	if (!nm_streq0 (interface_name, NM_DHCP_HELPER_SERVER_INTERFACE_NAME))
-		g_return_if_reached ();
-	if (!nm_streq0 (method_name, NM_DHCP_HELPER_SERVER_METHOD_NOTIFY))
-		g_return_if_reached ();
-	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
-		g_return_if_reached ();
-
-	g_variant_get (parameters, "(@a{sv})", &options);
 
 	iface = get_option (options, "interface");
 	if (iface == NULL) {
 		_LOGW ("dhcp-event: didn't have associated interface.");
-		goto out;
+		return;
 	}
 
 	pid_str = get_option (options, "pid");
 	pid = _nm_utils_ascii_str_to_int64 (pid_str, 10, 0, G_MAXINT32, -1);
 	if (pid == -1) {
 		_LOGW ("dhcp-event: couldn't convert PID '%s' to an integer", pid_str ? pid_str : "(null)");
-		goto out;
+		return;
 	}
 
 	reason = get_option (options, "reason");
 	if (reason == NULL) {
 		_LOGW ("dhcp-event: (pid %d) DHCP event didn't have a reason", pid);
-		goto out;
+		return;
 	}
 
-	g_signal_emit (self, signals[EVENT], 0, iface, pid, options, reason, &handled);
-	if (!handled) {
+	if (!nm_dhcp_manager_handle_event (nm_dhcp_manager_get (), iface, ifindex, pid, options, reason)) {
 		if (g_ascii_strcasecmp (reason, "RELEASE") == 0) {
 			/* Ignore event when the dhcp client gets killed and we receive its last message */
 			_LOGD ("dhcp-event: (pid %d) unhandled RELEASE DHCP event for interface %s", pid, iface);
 		} else
 			_LOGW ("dhcp-event: (pid %d) unhandled DHCP event for interface %s", pid, iface);
 	}
+}
+
+static void notify_read_all (NMDhcpListener *self);
+
+static void
+_method_call (GDBusConnection *connection,
+              const char *sender,
+              const char *object_path,
+              const char *interface_name,
+              const char *method_name,
+              GVariant *parameters,
+              GDBusMethodInvocation *invocation,
+              gpointer user_data)
+{
+	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	gs_unref_variant GVariant *options = NULL;
 
-out:
-	g_free (iface);
-	g_free (pid_str);
-	g_free (reason);
-	g_variant_unref (options);
+	if (!nm_streq0 (interface_name, NM_DHCP_HELPER_SERVER_INTERFACE_NAME))
+		g_return_if_reached ();
+	if (!nm_streq0 (method_name, NM_DHCP_HELPER_SERVER_METHOD_NOTIFY))
+		g_return_if_reached ();
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(a{sv})")))
+		g_return_if_reached ();
+
+	/* the helper falls back to D-Bus when the notify socket is full.
+	 * Handle the events queued before first, so that this one does not
+	 * overtake them. */
+	notify_read_all (self);
+
+	g_variant_get (parameters, "(@a{sv})", &options);
+	_handle_event (self, 0, options);
 	g_dbus_method_invocation_return_value (invocation, NULL);
 }
 
@@ -287,6 +295,140 @@ dis_connection_cb (NMBusManager *mgr,
 
 /*****************************************************************************/
 
+static void
+notify_read_all (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	if (priv->notify_fd < 0)
+		return;
+
+	while (TRUE) {
+		union {
+			struct cmsghdr cmsghdr;
+			char buf[CMSG_SPACE (sizeof (struct ucred))];
+		} control;
+		struct iovec iov = {
+			.iov_base = priv->notify_buf,
+			.iov_len = NM_DHCP_HELPER_NOTIFY_MAX_SIZE,
+		};
+		struct msghdr msg = {
+			.msg_iov = &iov,
+			.msg_iovlen = 1,
+			.msg_control = &control,
+			.msg_controllen = sizeof (control),
+		};
+		gs_unref_variant GVariant *options = NULL;
+		const struct ucred *creds = NULL;
+		struct cmsghdr *cmsg;
+		ssize_t n;
+		int ifindex;
+
+		n = recvmsg (priv->notify_fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno != EAGAIN)
+				_LOGW ("dhcp-event: failure to receive from notify socket: %s", g_strerror (errno));
+			break;
+		}
+
+		for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+			if (   cmsg->cmsg_level == SOL_SOCKET
+			    && cmsg->cmsg_type == SCM_CREDENTIALS
+			    && cmsg->cmsg_len >= CMSG_LEN (sizeof (struct ucred)))
+				creds = (const struct ucred *) CMSG_DATA (cmsg);
+		}
+
+		/* the helper is run by the DHCP client, which runs as root. */
+		if (!creds || creds->uid != 0) {
+			_LOGW ("dhcp-event: ignore event from unprivileged sender (uid %lld)",
+			       creds ? (long long) creds->uid : -1LL);
+			continue;
+		}
+		if (msg.msg_flags & MSG_TRUNC) {
+			_LOGW ("dhcp-event: ignore truncated event");
+			continue;
+		}
+
+		options = nm_dhcp_helper_notify_decode (priv->notify_buf, n, &ifindex);
+		if (!options) {
+			_LOGW ("dhcp-event: ignore malformed event");
+			continue;
+		}
+
+		_handle_event (self, ifindex, options);
+	}
+}
+
+static gboolean
+notify_io_cb (GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+	/* read all pending events, so that a burst of renewals is handled
+	 * in one wakeup. */
+	notify_read_all (user_data);
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+notify_socket_open (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+		.sun_path = NM_DHCP_HELPER_NOTIFY_SOCKET_PATH,
+	};
+	const int one = 1;
+	int fd;
+
+	fd = socket (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+	if (fd < 0) {
+		_LOGW ("failure to create notify socket: %s", g_strerror (errno));
+		return;
+	}
+
+	if (setsockopt (fd, SOL_SOCKET, SO_PASSCRED, &one, sizeof (one)) < 0) {
+		_LOGW ("failure to enable credentials on notify socket: %s", g_strerror (errno));
+		close (fd);
+		return;
+	}
+
+	unlink (NM_DHCP_HELPER_NOTIFY_SOCKET_PATH);
+	if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+		_LOGW ("failure to bind notify socket %s: %s",
+		       NM_DHCP_HELPER_NOTIFY_SOCKET_PATH, g_strerror (errno));
+		close (fd);
+		return;
+	}
+	chmod (NM_DHCP_HELPER_NOTIFY_SOCKET_PATH, 0600);
+
+	priv->notify_fd = fd;
+	priv->notify_buf = g_malloc (NM_DHCP_HELPER_NOTIFY_MAX_SIZE);
+	priv->notify_channel = g_io_channel_unix_new (fd);
+	priv->notify_id = g_io_add_watch (priv->notify_channel,
+	                                  G_IO_IN,
+	                                  notify_io_cb,
+	                                  self);
+}
+
+static void
+notify_socket_close (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+
+	if (priv->notify_fd < 0)
+		return;
+
+	nm_clear_g_source (&priv->notify_id);
+	g_clear_pointer (&priv->notify_channel, g_io_channel_unref);
+	nm_clear_g_free (&priv->notify_buf);
+	close (priv->notify_fd);
+	priv->notify_fd = -1;
+	unlink (NM_DHCP_HELPER_NOTIFY_SOCKET_PATH);
+}
+
+/*****************************************************************************/
+
 static void
 nm_dhcp_listener_init (NMDhcpListener *self)
 {
@@ -307,6 +449,11 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	                                      NM_BUS_MANAGER_PRIVATE_CONNECTION_DISCONNECTED "::" PRIV_SOCK_TAG,
 	                                      G_CALLBACK (dis_connection_cb),
 	                                      self);
+
+	/* The helper prefers the notify socket. The D-Bus method stays for
+	 * helpers that fail to use it. */
+	priv->notify_fd = -1;
+	notify_socket_open (self);
 }
 
 static void
@@ -314,6 +461,8 @@ dispose (GObject *object)
 {
 	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE ((NMDhcpListener *) object);
 
+	notify_socket_close ((NMDhcpListener *) object);
+
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->new_conn_id);
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->dis_conn_id);
 	priv->dbus_mgr = NULL;
@@ -329,17 +478,4 @@ nm_dhcp_listener_class_init (NMDhcpListenerClass *listener_class)
 	GObjectClass *object_class = G_OBJECT_CLASS (listener_class);
 
 	object_class->dispose = dispose;
-
-	signals[EVENT] =
-	    g_signal_new (NM_DHCP_LISTENER_EVENT,
-	                  G_OBJECT_CLASS_TYPE (object_class),
-	                  G_SIGNAL_RUN_LAST, 0,
-	                  g_signal_accumulator_true_handled,
-	                  NULL, NULL,
-	                  G_TYPE_BOOLEAN,     /* listeners return TRUE if handled */
-	                  4,
-	                  G_TYPE_STRING,      /* iface */
-	                  G_TYPE_INT,         /* pid */
-	                  G_TYPE_VARIANT,     /* options */
-	                  G_TYPE_STRING);     /* reason */
 }
@@ -37,15 +37,24 @@
 #include "nm-utils/nm-dedup-multi.h"
 
 #include "nm-config.h"
+#include "platform/nm-platform.h"
 #include "NetworkManagerUtils.h"
 
 #define DHCP_TIMEOUT 45 /* default DHCP timeout, in seconds */
 
 /*****************************************************************************/
 
+/* There is at most one client per interface and address family, which
+ * is looked up for every lease event. */
+typedef struct {
+	int ifindex;
+	bool ipv6;
+	NMDhcpClient *client;
+} ClientEntry;
+
 typedef struct {
 	const NMDhcpClientFactory *client_factory;
-	GHashTable *        clients;
+	GHashTable *        clients;         /* set of ClientEntry */
 	char *              default_hostname;
 } NMDhcpManagerPrivate;
 
@@ -96,28 +105,47 @@ _client_factory_available (const NMDhcpClientFactory *client_factory)
 
 /*****************************************************************************/
 
+static guint
+_client_entry_hash (gconstpointer key)
+{
+	const ClientEntry *entry = key;
+
+	return ((guint) entry->ifindex << 1) ^ (entry->ipv6 ? 1u : 0u);
+}
+
+static gboolean
+_client_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const ClientEntry *entry_a = a;
+	const ClientEntry *entry_b = b;
+
+	return    entry_a->ifindex == entry_b->ifindex
+	       && entry_a->ipv6 == entry_b->ipv6;
+}
+
+static void
+_client_entry_free (gpointer data)
+{
+	ClientEntry *entry = data;
+
+	g_object_unref (entry->client);
+	g_slice_free (ClientEntry, entry);
+}
+
 static NMDhcpClient *
 get_client_for_ifindex (NMDhcpManager *manager, int ifindex, gboolean ip6)
 {
-	NMDhcpManagerPrivate *priv;
-	GHashTableIter iter;
-	gpointer value;
+	const ClientEntry needle = {
+		.ifindex = ifindex,
+		.ipv6 = ip6,
+	};
+	ClientEntry *entry;
 
 	g_return_val_if_fail (NM_IS_DHCP_MANAGER (manager), NULL);
 	g_return_val_if_fail (ifindex > 0, NULL);
 
-	priv = NM_DHCP_MANAGER_GET_PRIVATE (manager);
-
-	g_hash_table_iter_init (&iter, priv->clients);
-	while (g_hash_table_iter_next (&iter, NULL, &value)) {
-		NMDhcpClient *candidate = NM_DHCP_CLIENT (value);
-
-		if (   nm_dhcp_client_get_ifindex (candidate) == ifindex
-		    && nm_dhcp_client_get_ipv6 (candidate) == ip6)
-			return candidate;
-	}
-
-	return NULL;
+	entry = g_hash_table_lookup (NM_DHCP_MANAGER_GET_PRIVATE (manager)->clients, &needle);
+	return entry ? entry->client : NULL;
 }
 
 static void client_state_changed (NMDhcpClient *client,
@@ -130,6 +158,12 @@ static void client_state_changed (NMDhcpClient *client,
 static void
 remove_client (NMDhcpManager *self, NMDhcpClient *client)
 {
+	const ClientEntry needle = {
+		.ifindex = nm_dhcp_client_get_ifindex (client),
+		.ipv6 = nm_dhcp_client_get_ipv6 (client),
+	};
+	ClientEntry *entry;
+
 	g_signal_handlers_disconnect_by_func (client, client_state_changed, self);
 
 	/* Stopping the client is left up to the controlling device
@@ -137,7 +171,9 @@ remove_client (NMDhcpManager *self, NMDhcpClient *client)
 	 * the DHCP client.
 	 */
 
-	g_hash_table_remove (NM_DHCP_MANAGER_GET_PRIVATE (self)->clients, client);
+	entry = g_hash_table_lookup (NM_DHCP_MANAGER_GET_PRIVATE (self)->clients, &needle);
+	if (entry && entry->client == client)
+		g_hash_table_remove (NM_DHCP_MANAGER_GET_PRIVATE (self)->clients, entry);
 }
 
 static void
@@ -174,6 +210,7 @@ client_start (NMDhcpManager *self,
 {
 	NMDhcpManagerPrivate *priv;
 	NMDhcpClient *client;
+	ClientEntry *entry;
 	gboolean success = FALSE;
 
 	g_return_val_if_fail (self, NULL);
@@ -207,7 +244,11 @@ client_start (NMDhcpManager *self,
 	                       NM_DHCP_CLIENT_PRIORITY, priority,
 	                       NM_DHCP_CLIENT_TIMEOUT, timeout ? timeout : DHCP_TIMEOUT,
 	                       NULL);
-	g_hash_table_insert (NM_DHCP_MANAGER_GET_PRIVATE (self)->clients, client, g_object_ref (client));
+	entry = g_slice_new (ClientEntry);
+	entry->ifindex = ifindex;
+	entry->ipv6 = ipv6;
+	entry->client = g_object_ref (client);
+	g_hash_table_add (priv->clients, entry);
 	g_signal_connect (client, NM_DHCP_CLIENT_SIGNAL_STATE_CHANGED, G_CALLBACK (client_state_changed), self);
 
 	if (ipv6)
@@ -347,6 +388,53 @@ nm_dhcp_manager_get_lease_ip_configs (NMDhcpManager *self,
 	return NULL;
 }
 
+/**
+ * nm_dhcp_manager_handle_event:
+ * @self: the #NMDhcpManager
+ * @iface: the interface name from the event
+ * @ifindex: the interface index from the event, or 0 if the sender
+ *   didn't know it
+ * @pid: the PID of the DHCP client process
+ * @options: the DHCP options of the event as a "a{sv}" variant
+ * @reason: the reason of the event
+ *
+ * Passes a lease event from an external DHCP client to the client
+ * instance that is responsible for the interface.
+ *
+ * Returns: whether a client handled the event.
+ */
+gboolean
+nm_dhcp_manager_handle_event (NMDhcpManager *self,
+                              const char *iface,
+                              int ifindex,
+                              int pid,
+                              GVariant *options,
+                              const char *reason)
+{
+	int i;
+
+	g_return_val_if_fail (NM_IS_DHCP_MANAGER (self), FALSE);
+	g_return_val_if_fail (iface, FALSE);
+
+	if (ifindex <= 0)
+		ifindex = nm_platform_link_get_ifindex (NM_PLATFORM_GET, iface);
+	if (ifindex <= 0)
+		return FALSE;
+
+	for (i = 0; i < 2; i++) {
+		gs_unref_object NMDhcpClient *client = NULL;
+
+		/* the client might get removed while handling the event. */
+		client = nm_g_object_ref (get_client_for_ifindex (self, ifindex, i == 1));
+		if (!client)
+			continue;
+
+		if (nm_dhcp_client_handle_event (NULL, iface, pid, options, reason, client))
+			return TRUE;
+	}
+	return FALSE;
+}
+
 const char *
 nm_dhcp_manager_get_config (NMDhcpManager *self)
 {
@@ -423,22 +511,24 @@ nm_dhcp_manager_init (NMDhcpManager *self)
 	nm_log_info (LOGD_DHCP, "dhcp-init: Using DHCP client '%s'", client_factory->name);
 
 	priv->client_factory = client_factory;
-	priv->clients = g_hash_table_new_full (g_direct_hash, g_direct_equal,
-	                                       NULL,
-	                                       (GDestroyNotify) g_object_unref);
+	priv->clients = g_hash_table_new_full (_client_entry_hash, _client_entry_equal,
+	                                       _client_entry_free,
+	                                       NULL);
 }
 
 static void
 dispose (GObject *object)
 {
 	NMDhcpManagerPrivate *priv = NM_DHCP_MANAGER_GET_PRIVATE ((NMDhcpManager *) object);
-	GList *values, *iter;
+	GHashTableIter iter;
+	ClientEntry *entry;
 
 	if (priv->clients) {
-		values = g_hash_table_get_values (priv->clients);
-		for (iter = values; iter; iter = g_list_next (iter))
-			remove_client (NM_DHCP_MANAGER (object), NM_DHCP_CLIENT (iter->data));
-		g_list_free (values);
+		g_hash_table_iter_init (&iter, priv->clients);
+		while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL)) {
+			g_signal_handlers_disconnect_by_func (entry->client, client_state_changed, object);
+			g_hash_table_iter_remove (&iter);
+		}
 	}
 
 	G_OBJECT_CLASS (nm_dhcp_manager_parent_class)->dispose (object);
@@ -84,6 +84,13 @@ GSList *       nm_dhcp_manager_get_lease_ip_configs (NMDhcpManager *self,
                                                      gboolean ipv6,
                                                      guint32 default_route_metric);
 
+gboolean       nm_dhcp_manager_handle_event (NMDhcpManager *self,
+                                             const char *iface,
+                                             int ifindex,
+                                             int pid,
+                                             GVariant *options,
+                                             const char *reason);
+
 /* For testing only */
 extern const char* nm_dhcp_helper_path;
 
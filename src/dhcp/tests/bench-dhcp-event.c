@@ -0,0 +1,280 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "dhcp/nm-dhcp-helper-api.h"
+
+#include "nm-test-utils-core.h"
+
+NMTST_DEFINE ();
+
+/*****************************************************************************/
+
+static struct {
+	int events;
+	int interfaces;
+} global_opt = {
+	.events = 10000,
+	.interfaces = 500,
+};
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionContext *context;
+	GOptionEntry options[] = {
+		{ "events", 'n', 0, G_OPTION_ARG_INT, &global_opt.events, "Number of lease events (default 10000)", "N" },
+		{ "interfaces", 'i', 0, G_OPTION_ARG_INT, &global_opt.interfaces, "Number of interfaces renewing their lease (default 500)", "N" },
+		{ 0 },
+	};
+	gs_free_error GError *error = NULL;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "Measure passing DHCP lease events from nm-dhcp-helper to NetworkManager, "
+	                                       "as a datagram on the notify socket and as a D-Bus message.");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, argc, argv, &error)) {
+		g_warning ("Error parsing command line arguments: %s", error->message);
+		g_option_context_free (context);
+		return FALSE;
+	}
+
+	g_option_context_free (context);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static const char *const ignore[] = { "PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL };
+
+/* the environment of dhclient-script for a RENEW of the lease. */
+static char **
+create_env (int i)
+{
+	GPtrArray *env;
+
+	env = g_ptr_array_new ();
+	g_ptr_array_add (env, g_strdup ("PATH=/usr/sbin:/usr/bin:/sbin:/bin"));
+	g_ptr_array_add (env, g_strdup_printf ("interface=vlan%d", i));
+	g_ptr_array_add (env, g_strdup_printf ("pid=%d", 10000 + i));
+	g_ptr_array_add (env, g_strdup ("reason=RENEW"));
+	g_ptr_array_add (env, g_strdup_printf ("new_ip_address=10.%d.%d.100", (i / 256) % 256, i % 256));
+	g_ptr_array_add (env, g_strdup ("new_subnet_mask=255.255.255.0"));
+	g_ptr_array_add (env, g_strdup_printf ("new_network_number=10.%d.%d.0", (i / 256) % 256, i % 256));
+	g_ptr_array_add (env, g_strdup_printf ("new_broadcast_address=10.%d.%d.255", (i / 256) % 256, i % 256));
+	g_ptr_array_add (env, g_strdup_printf ("new_routers=10.%d.%d.1", (i / 256) % 256, i % 256));
+	g_ptr_array_add (env, g_strdup ("new_domain_name_servers=192.0.2.53 198.51.100.53"));
+	g_ptr_array_add (env, g_strdup ("new_domain_name=example.com"));
+	g_ptr_array_add (env, g_strdup ("new_domain_search=example.com. lab.example.com."));
+	g_ptr_array_add (env, g_strdup ("new_dhcp_lease_time=3600"));
+	g_ptr_array_add (env, g_strdup ("new_dhcp_renewal_time=1800"));
+	g_ptr_array_add (env, g_strdup ("new_dhcp_rebinding_time=3150"));
+	g_ptr_array_add (env, g_strdup ("new_dhcp_message_type=5"));
+	g_ptr_array_add (env, g_strdup_printf ("new_dhcp_server_identifier=10.%d.%d.1", (i / 256) % 256, i % 256));
+	g_ptr_array_add (env, g_strdup ("new_ntp_servers=192.0.2.123"));
+	g_ptr_array_add (env, g_strdup ("new_interface_mtu=1500"));
+	g_ptr_array_add (env, g_strdup ("new_expiry=1514764800"));
+	g_ptr_array_add (env, g_strdup_printf ("old_ip_address=10.%d.%d.100", (i / 256) % 256, i % 256));
+	g_ptr_array_add (env, g_strdup ("old_subnet_mask=255.255.255.0"));
+	g_ptr_array_add (env, g_strdup_printf ("old_routers=10.%d.%d.1", (i / 256) % 256, i % 256));
+	g_ptr_array_add (env, g_strdup ("old_dhcp_lease_time=3600"));
+	g_ptr_array_add (env, g_strdup ("SHLVL=1"));
+	g_ptr_array_add (env, g_strdup ("PWD=/"));
+	g_ptr_array_add (env, NULL);
+	return (char **) g_ptr_array_free (env, FALSE);
+}
+
+/* what the helper sends with the D-Bus method. */
+static GVariant *
+build_dbus_parameters (char **env)
+{
+	GVariantBuilder builder;
+	char **item;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+	for (item = env; *item; item++) {
+		gs_free char *name = g_strdup (*item);
+		const char *const *p;
+		char *val;
+
+		val = strchr (name, '=');
+		if (!val || val == name)
+			continue;
+		*val++ = '\0';
+
+		for (p = ignore; *p; p++) {
+			if (strncmp (name, *p, strlen (*p)) == 0)
+				break;
+		}
+		if (*p)
+			continue;
+
+		g_variant_builder_add (&builder, "{sv}",
+		                       name,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  val, strlen (val), 1));
+	}
+	return g_variant_new ("(a{sv})", &builder);
+}
+
+static void
+check_options (GVariant *options, int i)
+{
+	gs_unref_variant GVariant *value = NULL;
+	gs_free char *expected = g_strdup_printf ("vlan%d", i);
+	const guint8 *bytes;
+	gsize len;
+
+	if (!g_variant_lookup (options, "interface", "@ay", &value))
+		g_error ("the event has no interface");
+	bytes = g_variant_get_fixed_array (value, &len, 1);
+	if (len != strlen (expected) || memcmp (bytes, expected, len) != 0)
+		g_error ("the event has a wrong interface");
+}
+
+/*****************************************************************************/
+
+static double
+measure_socket (char ***envs, int n_envs, int n_events, gsize *out_size)
+{
+	guint8 *buf;
+	int fds[2];
+	gint64 start;
+	int i;
+
+	if (socketpair (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, fds) < 0)
+		g_error ("cannot create socketpair: %s", strerror (errno));
+
+	buf = g_malloc (NM_DHCP_HELPER_NOTIFY_MAX_SIZE);
+	*out_size = 0;
+
+	start = g_get_monotonic_time ();
+	for (i = 0; i < n_events; i++) {
+		gs_unref_variant GVariant *options = NULL;
+		GByteArray *data;
+		ssize_t n;
+		int ifindex;
+
+		data = nm_dhcp_helper_notify_encode (1 + (i % n_envs),
+		                                     (const char *const *) envs[i % n_envs],
+		                                     ignore);
+		if (send (fds[0], data->data, data->len, 0) < 0)
+			g_error ("cannot send event: %s", strerror (errno));
+		*out_size += data->len;
+		g_byte_array_unref (data);
+
+		n = recv (fds[1], buf, NM_DHCP_HELPER_NOTIFY_MAX_SIZE, 0);
+		if (n < 0)
+			g_error ("cannot receive event: %s", strerror (errno));
+
+		options = nm_dhcp_helper_notify_decode (buf, n, &ifindex);
+		if (!options || ifindex != 1 + (i % n_envs))
+			g_error ("cannot decode event");
+		check_options (options, i % n_envs);
+	}
+	start = g_get_monotonic_time () - start;
+
+	g_free (buf);
+	close (fds[0]);
+	close (fds[1]);
+	*out_size /= n_events;
+	return start * 1000.0 / n_events;
+}
+
+static double
+measure_dbus (char ***envs, int n_envs, int n_events, gsize *out_size)
+{
+	gint64 start;
+	int i;
+
+	*out_size = 0;
+
+	start = g_get_monotonic_time ();
+	for (i = 0; i < n_events; i++) {
+		gs_unref_object GDBusMessage *msg = NULL;
+		gs_unref_object GDBusMessage *msg2 = NULL;
+		gs_unref_variant GVariant *options = NULL;
+		gs_free guchar *blob = NULL;
+		gsize blob_len;
+
+		msg = g_dbus_message_new_method_call (NULL,
+		                                      NM_DHCP_HELPER_SERVER_OBJECT_PATH,
+		                                      NM_DHCP_HELPER_SERVER_INTERFACE_NAME,
+		                                      NM_DHCP_HELPER_SERVER_METHOD_NOTIFY);
+		g_dbus_message_set_body (msg, build_dbus_parameters (envs[i % n_envs]));
+		blob = g_dbus_message_to_blob (msg, &blob_len, G_DBUS_CAPABILITY_FLAGS_NONE, NULL);
+		if (!blob)
+			g_error ("cannot serialize message");
+		*out_size += blob_len;
+
+		msg2 = g_dbus_message_new_from_blob (blob, blob_len, G_DBUS_CAPABILITY_FLAGS_NONE, NULL);
+		if (!msg2)
+			g_error ("cannot parse message");
+		g_variant_get (g_dbus_message_get_body (msg2), "(@a{sv})", &options);
+		check_options (options, i % n_envs);
+	}
+	start = g_get_monotonic_time () - start;
+
+	*out_size /= n_events;
+	return start * 1000.0 / n_events;
+}
+
+int
+main (int argc, char **argv)
+{
+	char ***envs;
+	gsize size_socket, size_dbus;
+	double t_socket, t_dbus;
+	int i;
+
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	if (global_opt.events <= 0)
+		global_opt.events = 1;
+	if (global_opt.interfaces <= 0)
+		global_opt.interfaces = 1;
+
+	envs = g_new (char **, global_opt.interfaces);
+	for (i = 0; i < global_opt.interfaces; i++)
+		envs[i] = create_env (i);
+
+	t_socket = measure_socket (envs, global_opt.interfaces, global_opt.events, &size_socket);
+	t_dbus = measure_dbus (envs, global_opt.interfaces, global_opt.events, &size_dbus);
+
+	printf ("%d lease events of %d interfaces\n", global_opt.events, global_opt.interfaces);
+	printf ("notify socket: %8.1f ns/event, %4zu bytes/event\n", t_socket, size_socket);
+	printf ("D-Bus message: %8.1f ns/event, %4zu bytes/event "
+	        "(without connecting and authenticating per event)\n", t_dbus, size_dbus);
+
+	for (i = 0; i < global_opt.interfaces; i++)
+		g_strfreev (envs[i]);
+	g_free (envs);
+	return EXIT_SUCCESS;
+}
@@ -27,6 +27,7 @@
 #include "nm-utils.h"
 
 #include "dhcp/nm-dhcp-utils.h"
+#include "dhcp/nm-dhcp-helper-api.h"
 #include "platform/nm-platform.h"
 
 #include "nm-test-utils-core.h"
@@ -711,6 +712,150 @@ test_client_id_from_string (void)
 	COMPARE_ID (endcolon, TRUE, endcolon, strlen (endcolon));
 }
 
+/*****************************************************************************/
+
+static void
+_notify_assert_option (GVariant *options, const char *name, const char *expected)
+{
+	gs_unref_variant GVariant *value = NULL;
+	const guint8 *bytes;
+	gsize len;
+
+	value = g_variant_lookup_value (options, name, G_VARIANT_TYPE_BYTESTRING);
+	g_assert (value);
+	bytes = g_variant_get_fixed_array (value, &len, 1);
+	g_assert_cmpint (len, ==, strlen (expected));
+	g_assert (len == 0 || memcmp (bytes, expected, len) == 0);
+}
+
+static void
+_notify_append_option (GByteArray *data, const char *name, gsize name_len, const char *value, gsize value_len)
+{
+	NMDhcpHelperNotifyOption option = {
+		.name_len = name_len,
+		.value_len = value_len,
+	};
+
+	g_byte_array_append (data, (const guint8 *) &option, sizeof (option));
+	g_byte_array_append (data, (const guint8 *) name, name_len);
+	g_byte_array_append (data, (const guint8 *) value, value_len);
+}
+
+static GByteArray *
+_notify_new (guint32 magic)
+{
+	NMDhcpHelperNotifyHeader header = {
+		.magic = magic,
+		.ifindex = 3,
+	};
+	GByteArray *data;
+
+	data = g_byte_array_new ();
+	g_byte_array_append (data, (const guint8 *) &header, sizeof (header));
+	return data;
+}
+
+static void
+test_helper_notify_encode_decode (void)
+{
+	static const char *const envp[] = {
+		"interface=eth0",
+		"new_ip_address=192.168.1.5",
+		"new_domain_search=a.example.com b.example.com",
+		"empty=",
+		"=no-name",
+		"no-value",
+		"PATH=/usr/bin",
+		NULL,
+	};
+	static const char *const ignore[] = { "PATH=", NULL };
+	GByteArray *data;
+	gs_unref_variant GVariant *options = NULL;
+	int ifindex = -1;
+
+	data = nm_dhcp_helper_notify_encode (5, envp, ignore);
+	g_assert (data);
+
+	options = nm_dhcp_helper_notify_decode (data->data, data->len, &ifindex);
+	g_assert (options);
+	g_assert_cmpint (ifindex, ==, 5);
+	g_assert_cmpint (g_variant_n_children (options), ==, 4);
+	_notify_assert_option (options, "interface", "eth0");
+	_notify_assert_option (options, "new_ip_address", "192.168.1.5");
+	_notify_assert_option (options, "new_domain_search", "a.example.com b.example.com");
+	_notify_assert_option (options, "empty", "");
+	g_assert (!g_variant_lookup_value (options, "PATH", NULL));
+
+	g_byte_array_unref (data);
+}
+
+static void
+test_helper_notify_decode_invalid (void)
+{
+	GByteArray *data;
+	gs_unref_variant GVariant *options = NULL;
+	NMDhcpHelperNotifyOption option = { 0 };
+	int ifindex = -1;
+
+	/* a header without options is valid. */
+	data = _notify_new (NM_DHCP_HELPER_NOTIFY_MAGIC);
+	options = nm_dhcp_helper_notify_decode (data->data, data->len, &ifindex);
+	g_assert (options);
+	g_assert_cmpint (ifindex, ==, 3);
+	g_assert_cmpint (g_variant_n_children (options), ==, 0);
+	g_clear_pointer (&options, g_variant_unref);
+
+	/* truncated header. */
+	g_assert (!nm_dhcp_helper_notify_decode (NULL, 0, NULL));
+	g_assert (!nm_dhcp_helper_notify_decode (data->data, data->len - 1, NULL));
+	g_byte_array_unref (data);
+
+	/* wrong magic. */
+	data = _notify_new (~NM_DHCP_HELPER_NOTIFY_MAGIC);
+	_notify_append_option (data, "reason", 6, "BOUND", 5);
+	g_assert (!nm_dhcp_helper_notify_decode (data->data, data->len, NULL));
+	g_byte_array_unref (data);
+
+	/* truncated option header. */
+	data = _notify_new (NM_DHCP_HELPER_NOTIFY_MAGIC);
+	g_byte_array_append (data, (const guint8 *) &option, sizeof (option) - 1);
+	g_assert (!nm_dhcp_helper_notify_decode (data->data, data->len, NULL));
+	g_byte_array_unref (data);
+
+	/* empty name. */
+	data = _notify_new (NM_DHCP_HELPER_NOTIFY_MAGIC);
+	_notify_append_option (data, "", 0, "BOUND", 5);
+	g_assert (!nm_dhcp_helper_notify_decode (data->data, data->len, NULL));
+	g_byte_array_unref (data);
+
+	/* name with an embedded NUL. */
+	data = _notify_new (NM_DHCP_HELPER_NOTIFY_MAGIC);
+	_notify_append_option (data, "rea\0son", 7, "BOUND", 5);
+	g_assert (!nm_dhcp_helper_notify_decode (data->data, data->len, NULL));
+	g_byte_array_unref (data);
+
+	/* the value runs past the end of the datagram. */
+	data = _notify_new (NM_DHCP_HELPER_NOTIFY_MAGIC);
+	_notify_append_option (data, "reason", 6, "BOUND", 5);
+	options = nm_dhcp_helper_notify_decode (data->data, data->len, NULL);
+	g_assert (options);
+	g_clear_pointer (&options, g_variant_unref);
+	g_assert (!nm_dhcp_helper_notify_decode (data->data, data->len - 1, NULL));
+	g_byte_array_unref (data);
+
+	/* the option claims a longer value than was sent. */
+	data = _notify_new (NM_DHCP_HELPER_NOTIFY_MAGIC);
+	_notify_append_option (data, "reason", 6, "BOUND", 5);
+	option.name_len = 6;
+	option.value_len = G_MAXUINT16;
+	g_byte_array_append (data, (const guint8 *) &option, sizeof (option));
+	g_byte_array_append (data, (const guint8 *) "reason", 6);
+	g_assert (!nm_dhcp_helper_notify_decode (data->data, data->len, NULL));
+	g_byte_array_unref (data);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -738,6 +883,8 @@ int main (int argc, char **argv)
 	g_test_add_func ("/dhcp/ip4-prefix-classless", test_ip4_prefix_classless);
 	g_test_add_func ("/dhcp/client-id-from-string", test_client_id_from_string);
 	g_test_add_func ("/dhcp/vendor-option-metered", test_vendor_option_metered);
+	g_test_add_func ("/dhcp/helper-notify-encode-decode", test_helper_notify_encode_decode);
+	g_test_add_func ("/dhcp/helper-notify-decode-invalid", test_helper_notify_decode_invalid);
 
 	return g_test_run ();
 }
@@ -117,14 +117,23 @@ NM_DEFINE_SINGLETON_GETTER (NMDnsManager, nm_dns_manager_get, NM_TYPE_DNS_MANAGE
 /*****************************************************************************/
 
 typedef struct {
+	/* sorted by ip_config_data_compare(). */
 	GPtrArray *configs;
+
+	/* NMIP4Config/NMIP6Config -> NMDnsIPConfigData */
+	GHashTable *configs_idx;
+
 	GVariant *config_variant;
 	NMDnsIPConfigData *best_conf4, *best_conf6;
 
-	bool need_sort:1;
 	bool dns_touched:1;
 	bool is_stopped:1;
 
+	/* the last update_dns() left something to redo: resolv.conf could
+	 * not be written, or a caching plugin failed or was skipped. The next
+	 * update runs even if the DNS configuration didn't change. */
+	bool update_incomplete:1;
+
 	char *hostname;
 	guint updates_queue;
 
@@ -219,6 +228,7 @@ ip_config_data_new (gpointer config, NMDnsIPConfigType type, const char *iface)
 	data->config = g_object_ref (config);
 	data->iface = g_strdup (iface);
 	data->type = type;
+	data->_cache.dirty = TRUE;
 
 	return data;
 }
@@ -233,6 +243,9 @@ ip_config_data_destroy (gpointer ptr)
 
 	g_object_unref (data->config);
 	g_free (data->iface);
+	g_strfreev (data->_cache.nameservers);
+	g_strfreev (data->_cache.searches);
+	g_strfreev (data->_cache.options);
 	g_slice_free (NMDnsIPConfigData, data);
 }
 
@@ -259,12 +272,40 @@ ip_config_data_compare (const NMDnsIPConfigData *a, const NMDnsIPConfigData *b)
 	return 0;
 }
 
-static gint
-ip_config_data_ptr_compare (gconstpointer a, gconstpointer b)
+static void
+_configs_insert_sorted (GPtrArray *configs, NMDnsIPConfigData *data)
 {
-	const NMDnsIPConfigData *const *ptr_a = a, *const *ptr_b = b;
+	guint i;
+
+	/* after the configs that compare equal, like a stable sort. */
+	for (i = configs->len; i > 0; i--) {
+		if (ip_config_data_compare (configs->pdata[i - 1], data) <= 0)
+			break;
+	}
 
-	return ip_config_data_compare (*ptr_a, *ptr_b);
+	g_ptr_array_add (configs, NULL);
+	memmove (&configs->pdata[i + 1],
+	         &configs->pdata[i],
+	         (configs->len - 1 - i) * sizeof (gpointer));
+	configs->pdata[i] = data;
+}
+
+static void
+_configs_resort (GPtrArray *configs, NMDnsIPConfigData *data)
+{
+	guint i;
+
+	for (i = 0; i < configs->len; i++) {
+		if (configs->pdata[i] == data) {
+			memmove (&configs->pdata[i],
+			         &configs->pdata[i + 1],
+			         (configs->len - 1 - i) * sizeof (gpointer));
+			configs->pdata[configs->len - 1] = NULL;
+			g_ptr_array_set_size (configs, configs->len - 1);
+			break;
+		}
+	}
+	_configs_insert_sorted (configs, data);
 }
 
 static void
@@ -335,6 +376,12 @@ merge_one_ip4_config (NMResolvConfData *rc, NMIP4Config *src)
 		option = nm_ip4_config_get_dns_option (src, i);
 		add_dns_option_item (rc->options, option, FALSE);
 	}
+}
+
+static void
+merge_one_ip4_config_nis (NMResolvConfData *rc, NMIP4Config *src)
+{
+	guint32 num, i;
 
 	/* NIS stuff */
 	num = nm_ip4_config_get_num_nis_servers (src);
@@ -407,16 +454,112 @@ merge_one_ip6_config (NMResolvConfData *rc, NMIP6Config *src, const char *iface)
 	}
 }
 
+static char **
+_ptrarray_to_strv (GPtrArray *parray)
+{
+	if (parray->len > 0)
+		g_ptr_array_add (parray, NULL);
+	return (char **) g_ptr_array_free (parray, parray->len == 0);
+}
+
+static void
+ip_config_data_update_cache (NMDnsIPConfigData *data)
+{
+	NMResolvConfData rc = {
+		.nameservers = g_ptr_array_new (),
+		.searches = g_ptr_array_new (),
+		.options = g_ptr_array_new (),
+	};
+	GChecksum *sum;
+	gsize len = HASH_LEN;
+
+	if (!data->_cache.dirty)
+		return;
+
+	sum = g_checksum_new (G_CHECKSUM_SHA1);
+
+	if (NM_IS_IP4_CONFIG (data->config)) {
+		NMIP4Config *config = (NMIP4Config *) data->config;
+		const char *nis_domain = nm_ip4_config_get_nis_domain (config);
+		guint32 i, num_nis = nm_ip4_config_get_num_nis_servers (config);
+
+		merge_one_ip4_config (&rc, config);
+		nm_ip4_config_hash (config, sum, TRUE);
+
+		/* the NIS data ends up in the netconfig output too. */
+		for (i = 0; i < num_nis; i++) {
+			guint32 nis = nm_ip4_config_get_nis_server (config, i);
+
+			g_checksum_update (sum, (const guint8 *) &nis, sizeof (nis));
+		}
+		if (nis_domain)
+			g_checksum_update (sum, (const guint8 *) nis_domain, strlen (nis_domain) + 1);
+
+		data->_cache.has_dns =    nm_ip4_config_get_num_nameservers (config)
+		                       || nm_ip4_config_get_num_domains (config)
+		                       || nm_ip4_config_get_num_searches (config)
+		                       || nm_ip4_config_get_num_dns_options (config)
+		                       || nm_ip4_config_get_num_wins (config)
+		                       || num_nis
+		                       || nis_domain;
+	} else if (NM_IS_IP6_CONFIG (data->config)) {
+		NMIP6Config *config = (NMIP6Config *) data->config;
+
+		merge_one_ip6_config (&rc, config, data->iface);
+		nm_ip6_config_hash (config, sum, TRUE);
+
+		data->_cache.has_dns =    nm_ip6_config_get_num_nameservers (config)
+		                       || nm_ip6_config_get_num_domains (config)
+		                       || nm_ip6_config_get_num_searches (config)
+		                       || nm_ip6_config_get_num_dns_options (config);
+	} else
+		g_return_if_reached ();
+
+	g_strfreev (data->_cache.nameservers);
+	g_strfreev (data->_cache.searches);
+	g_strfreev (data->_cache.options);
+	data->_cache.nameservers = _ptrarray_to_strv (rc.nameservers);
+	data->_cache.searches = _ptrarray_to_strv (rc.searches);
+	data->_cache.options = _ptrarray_to_strv (rc.options);
+
+	g_checksum_get_digest (sum, data->_cache.hash, &len);
+	g_checksum_free (sum);
+
+	data->_cache.dirty = FALSE;
+}
+
+static void
+add_string_item_idx (GPtrArray *array, GHashTable *idx, const char *str)
+{
+	char *s;
+
+	if (g_hash_table_contains (idx, str))
+		return;
+
+	s = g_strdup (str);
+	g_ptr_array_add (array, s);
+	g_hash_table_add (idx, s);
+}
+
 static void
 merge_one_ip_config_data (NMResolvConfData *rc,
+                          GHashTable *nameservers_idx,
+                          GHashTable *searches_idx,
                           NMDnsIPConfigData *data)
 {
+	char **iter;
+
+	ip_config_data_update_cache (data);
+
+	for (iter = data->_cache.nameservers; iter && *iter; iter++)
+		add_string_item_idx (rc->nameservers, nameservers_idx, *iter);
+	for (iter = data->_cache.searches; iter && *iter; iter++)
+		add_string_item_idx (rc->searches, searches_idx, *iter);
+	for (iter = data->_cache.options; iter && *iter; iter++)
+		add_dns_option_item (rc->options, *iter, FALSE);
+
 	if (NM_IS_IP4_CONFIG (data->config))
-		merge_one_ip4_config (rc, (NMIP4Config *) data->config);
-	else if (NM_IS_IP6_CONFIG (data->config))
-		merge_one_ip6_config (rc, (NMIP6Config *) data->config, data->iface);
-	else
-		g_return_if_reached ();
+		merge_one_ip4_config_nis (rc, (NMIP4Config *) data->config);
 }
 
 static GPid
@@ -893,13 +1036,25 @@ compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global, guint8 buffer
 	if (global)
 		nm_global_dns_config_update_checksum (global, sum);
 	else {
+		/* Hash what resolv.conf and the plugins get: the DNS data of
+		 * each config with its position, interface, type and priority.
+		 * Configs without any DNS data contribute nothing, so adding or
+		 * removing them leaves the hash unchanged. Only the configs that
+		 * changed since the last time are hashed again. */
 		for (i = 0; i < priv->configs->len; i++) {
 			NMDnsIPConfigData *data = priv->configs->pdata[i];
+			guint32 type = data->type;
+			gint32 prio;
+
+			ip_config_data_update_cache (data);
+			if (!data->_cache.has_dns)
+				continue;
 
-			if (NM_IS_IP4_CONFIG (data->config))
-				nm_ip4_config_hash ((NMIP4Config *) data->config, sum, TRUE);
-			else if (NM_IS_IP6_CONFIG (data->config))
-				nm_ip6_config_hash ((NMIP6Config *) data->config, sum, TRUE);
+			prio = nm_dns_ip_config_data_get_dns_priority (data);
+			g_checksum_update (sum, data->_cache.hash, HASH_LEN);
+			g_checksum_update (sum, (const guint8 *) &prio, sizeof (prio));
+			g_checksum_update (sum, (const guint8 *) data->iface, strlen (data->iface) + 1);
+			g_checksum_update (sum, (const guint8 *) &type, sizeof (type));
 		}
 	}
 
@@ -977,16 +1132,10 @@ get_nameserver_list (void *config, GString **str)
 	return (*str)->str;
 }
 
-static char **
-_ptrarray_to_strv (GPtrArray *parray)
-{
-	if (parray->len > 0)
-		g_ptr_array_add (parray, NULL);
-	return (char **) g_ptr_array_free (parray, parray->len == 0);
-}
-
+/* Besides collecting the data, this refreshes the cached contribution
+ * (the _cache field) of the configs that changed. */
 static void
-_collect_resolv_conf_data (NMDnsManager *self, /* only for logging context, no other side-effects */
+_collect_resolv_conf_data (NMDnsManager *self, /* only for logging context */
                            NMGlobalDnsConfig *global_config,
                            const GPtrArray *configs,
                            const char *hostname,
@@ -1009,6 +1158,8 @@ _collect_resolv_conf_data (NMDnsManager *self, /* only for logging context, no o
 		merge_global_dns_config (&rc, global_config);
 	else {
 		nm_auto_free_gstring GString *tmp_gstring = NULL;
+		gs_unref_hashtable GHashTable *nameservers_idx = g_hash_table_new (g_str_hash, g_str_equal);
+		gs_unref_hashtable GHashTable *searches_idx = g_hash_table_new (g_str_hash, g_str_equal);
 		int prio, first_prio = 0;
 		NMDnsIPConfigData *current;
 		gboolean v4;
@@ -1038,7 +1189,7 @@ _collect_resolv_conf_data (NMDnsManager *self, /* only for logging context, no o
 			}
 
 			if (!skip)
-				merge_one_ip_config_data (&rc, current);
+				merge_one_ip_config_data (&rc, nameservers_idx, searches_idx, current);
 		}
 	}
 
@@ -1093,6 +1244,7 @@ update_dns (NMDnsManager *self,
 	gs_strfreev char **nis_servers = NULL;
 	gboolean caching = FALSE, update = TRUE;
 	gboolean resolv_conf_updated = FALSE;
+	gboolean incomplete = FALSE;
 	SpawnResult result = SR_ERROR;
 	NMConfigData *data;
 	NMGlobalDnsConfig *global_config;
@@ -1120,11 +1272,6 @@ update_dns (NMDnsManager *self,
 	data = nm_config_get_data (priv->config);
 	global_config = nm_config_data_get_global_dns_config (data);
 
-	if (priv->need_sort) {
-		g_ptr_array_sort (priv->configs, ip_config_data_ptr_compare);
-		priv->need_sort = FALSE;
-	}
-
 	/* Update hash with config we're applying */
 	compute_hash (self, global_config, priv->hash);
 
@@ -1140,6 +1287,7 @@ update_dns (NMDnsManager *self,
 			if (no_caching) {
 				_LOGD ("update-dns: plugin %s ignored (caching disabled)",
 				       plugin_name);
+				incomplete = TRUE;
 				goto skip;
 			}
 			caching = TRUE;
@@ -1156,6 +1304,7 @@ update_dns (NMDnsManager *self,
 			 * caching DNS configuration to resolv.conf.
 			 */
 			caching = FALSE;
+			incomplete = TRUE;
 		}
 
 	skip:
@@ -1214,6 +1363,9 @@ update_dns (NMDnsManager *self,
 	g_clear_pointer (&priv->config_variant, g_variant_unref);
 	_notify (self, PROP_CONFIGURATION);
 
+	priv->update_incomplete =    incomplete
+	                          || (update && result != SR_SUCCESS);
+
 	return !update || result == SR_SUCCESS;
 }
 
@@ -1278,11 +1430,49 @@ plugin_child_quit (NMDnsPlugin *plugin, int exit_status, gpointer user_data)
 }
 
 static void
-ip_config_dns_priority_changed (gpointer config,
-                                GParamSpec *pspec,
-                                NMDnsManager *self)
+ip_config_notify (gpointer config,
+                  GParamSpec *pspec,
+                  NMDnsManager *self)
 {
-	NM_DNS_MANAGER_GET_PRIVATE (self)->need_sort = TRUE;
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	NMDnsIPConfigData *data;
+
+	data = g_hash_table_lookup (priv->configs_idx, config);
+	if (!data)
+		g_return_if_reached ();
+
+	/* the property names are the same for NMIP4Config and NMIP6Config. */
+	if (nm_streq (pspec->name, NM_IP4_CONFIG_DNS_PRIORITY))
+		_configs_resort (priv->configs, data);
+	else if (NM_IN_STRSET (pspec->name, NM_IP4_CONFIG_NAMESERVERS,
+	                                    NM_IP4_CONFIG_DOMAINS,
+	                                    NM_IP4_CONFIG_SEARCHES,
+	                                    NM_IP4_CONFIG_DNS_OPTIONS,
+	                                    NM_IP4_CONFIG_WINS_SERVERS))
+		data->_cache.dirty = TRUE;
+}
+
+static gboolean
+_commit_if_changed (NMDnsManager *self, GError **error)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	guint8 new[HASH_LEN];
+
+	/* with a global configuration, the hash doesn't cover the IP configs,
+	 * but plugins still get them. */
+	if (nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)))
+		return update_dns (self, FALSE, error);
+
+	/* retry a failed write of resolv.conf and re-enable caching. */
+	if (priv->update_incomplete)
+		return update_dns (self, FALSE, error);
+
+	compute_hash (self, NULL, new);
+	if (memcmp (new, priv->hash, sizeof (new)) == 0) {
+		_LOGD ("update-dns: DNS configuration did not change");
+		return TRUE;
+	}
+	return update_dns (self, FALSE, error);
 }
 
 static void
@@ -1295,7 +1485,8 @@ forget_data (NMDnsManager *self, NMDnsIPConfigData *data)
 	else if (data == priv->best_conf6)
 		priv->best_conf6 = NULL;
 
-	g_signal_handlers_disconnect_by_func (data->config, ip_config_dns_priority_changed, self);
+	g_signal_handlers_disconnect_by_func (data->config, ip_config_notify, self);
+	g_hash_table_remove (priv->configs_idx, data->config);
 }
 
 static gboolean
@@ -1308,7 +1499,6 @@ nm_dns_manager_add_ip_config (NMDnsManager *self,
 	GError *error = NULL;
 	NMDnsIPConfigData *data;
 	gboolean v4 = NM_IS_IP4_CONFIG (config);
-	guint i;
 
 	g_return_val_if_fail (NM_IS_DNS_MANAGER (self), FALSE);
 	g_return_val_if_fail (config, FALSE);
@@ -1316,43 +1506,32 @@ nm_dns_manager_add_ip_config (NMDnsManager *self,
 
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 
-	for (i = 0; i < priv->configs->len; i++) {
-		data = priv->configs->pdata[i];
-		if (data->config == config) {
-			if (   nm_streq (data->iface, iface)
-			    && data->type == cfg_type)
-				return FALSE;
-			else {
-				forget_data (self, data);
-				g_ptr_array_remove_index_fast (priv->configs, i);
-				break;
-			}
-		}
+	data = g_hash_table_lookup (priv->configs_idx, config);
+	if (data) {
+		if (   nm_streq (data->iface, iface)
+		    && data->type == cfg_type)
+			return FALSE;
+		forget_data (self, data);
+		g_ptr_array_remove (priv->configs, data);
 	}
 
 	data = ip_config_data_new (config, cfg_type, iface);
-	g_ptr_array_add (priv->configs, data);
-	g_signal_connect (config,
-	                  v4 ?
-	                    "notify::" NM_IP4_CONFIG_DNS_PRIORITY :
-	                    "notify::" NM_IP6_CONFIG_DNS_PRIORITY,
-	                  (GCallback) ip_config_dns_priority_changed, self);
-	priv->need_sort = TRUE;
+	_configs_insert_sorted (priv->configs, data);
+	g_hash_table_insert (priv->configs_idx, config, data);
+	g_signal_connect (config, "notify", (GCallback) ip_config_notify, self);
 
 	if (cfg_type == NM_DNS_IP_CONFIG_TYPE_BEST_DEVICE) {
+		NMDnsIPConfigData **best = v4 ? &priv->best_conf4 : &priv->best_conf6;
+
 		/* Only one best-device per IP version is allowed */
-		if (v4) {
-			if (priv->best_conf4)
-				priv->best_conf4->type = NM_DNS_IP_CONFIG_TYPE_DEFAULT;
-			priv->best_conf4 = data;
-		} else {
-			if (priv->best_conf6)
-				priv->best_conf6->type = NM_DNS_IP_CONFIG_TYPE_DEFAULT;
-			priv->best_conf6 = data;
+		if (*best) {
+			(*best)->type = NM_DNS_IP_CONFIG_TYPE_DEFAULT;
+			_configs_resort (priv->configs, *best);
 		}
+		*best = data;
 	}
 
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
+	if (!priv->updates_queue && !_commit_if_changed (self, &error)) {
 		_LOGW ("could not commit DNS changes: %s", error->message);
 		g_clear_error (&error);
 	}
@@ -1384,29 +1563,25 @@ nm_dns_manager_remove_ip_config (NMDnsManager *self, gpointer config)
 	NMDnsManagerPrivate *priv;
 	GError *error = NULL;
 	NMDnsIPConfigData *data;
-	guint i;
 
 	g_return_val_if_fail (NM_IS_DNS_MANAGER (self), FALSE);
 	g_return_val_if_fail (config, FALSE);
 
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 
-	for (i = 0; i < priv->configs->len; i++) {
-		data = priv->configs->pdata[i];
-
-		if (data->config == config) {
-			forget_data (self, data);
-			g_ptr_array_remove_index (priv->configs, i);
+	data = g_hash_table_lookup (priv->configs_idx, config);
+	if (!data)
+		return FALSE;
 
-			if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-				_LOGW ("could not commit DNS changes: %s", error->message);
-				g_clear_error (&error);
-			}
+	forget_data (self, data);
+	g_ptr_array_remove (priv->configs, data);
 
-			return TRUE;
-		}
+	if (!priv->updates_queue && !_commit_if_changed (self, &error)) {
+		_LOGW ("could not commit DNS changes: %s", error->message);
+		g_clear_error (&error);
 	}
-	return FALSE;
+
+	return TRUE;
 }
 
 gboolean
@@ -1510,11 +1685,6 @@ nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	g_return_if_fail (priv->updates_queue > 0);
 
-	if (priv->need_sort) {
-		g_ptr_array_sort (priv->configs, ip_config_data_ptr_compare);
-		priv->need_sort = FALSE;
-	}
-
 	compute_hash (self, nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)), new);
 	changed = (memcmp (new, priv->prev_hash, sizeof (new)) != 0) ? TRUE : FALSE;
 	_LOGD ("(%s): DNS configuration %s", func, changed ? "changed" : "did not change");
@@ -2065,6 +2235,7 @@ nm_dns_manager_init (NMDnsManager *self)
 
 	priv->config = g_object_ref (nm_config_get ());
 	priv->configs = g_ptr_array_new_full (8, ip_config_data_destroy);
+	priv->configs_idx = g_hash_table_new (g_direct_hash, g_direct_equal);
 
 	/* Set the initial hash */
 	compute_hash (self, NULL, NM_DNS_MANAGER_GET_PRIVATE (self)->hash);
@@ -2104,6 +2275,7 @@ dispose (GObject *object)
 		g_ptr_array_free (priv->configs, TRUE);
 		priv->configs = NULL;
 	}
+	g_clear_pointer (&priv->configs_idx, g_hash_table_unref);
 
 	nm_clear_g_source (&priv->plugin_ratelimit.timer);
 
@@ -42,6 +42,17 @@ typedef struct {
 	gpointer config;
 	NMDnsIPConfigType type;
 	char *iface;
+
+	/* private to NMDnsManager. What the config contributes to resolv.conf
+	 * and the hash of its DNS settings, valid until the config changes. */
+	struct {
+		char **nameservers;
+		char **searches;
+		char **options;
+		guint8 hash[20];
+		bool has_dns:1;
+		bool dirty:1;
+	} _cache;
 } NMDnsIPConfigData;
 
 int nm_dns_ip_config_data_get_dns_priority (const NMDnsIPConfigData *config);
@@ -44,6 +44,9 @@
 #define SYSTEMD_RESOLVED_DBUS_SERVICE "org.freedesktop.resolve1"
 #define SYSTEMD_RESOLVED_DBUS_PATH "/org/freedesktop/resolve1"
 
+/* how long to wait before sending the links again after a failed call. */
+#define RESEND_DELAY_SEC 5
+
 /*****************************************************************************/
 
 typedef struct {
@@ -51,14 +54,29 @@ typedef struct {
 	GList *configs;
 } InterfaceConfig;
 
+/* The arguments of the SetLinkDNS and SetLinkDomains calls for a link,
+ * as wanted and as last sent to resolved. A link without wanted
+ * arguments has no configuration anymore and waits for its RevertLink. */
+typedef struct {
+	int ifindex;
+	GVariant *dns;
+	GVariant *domains;
+	GVariant *sent_dns;
+	GVariant *sent_domains;
+	guint update_id;
+} LinkState;
+
 /*****************************************************************************/
 
 typedef struct {
 	GDBusProxy *resolve;
 	GCancellable *init_cancellable;
 	GCancellable *update_cancellable;
-	GQueue dns_updates;
-	GQueue domain_updates;
+
+	/* ifindex -> LinkState */
+	GHashTable *links;
+	guint update_id;
+	guint resend_id;
 } NMDnsSystemdResolvedPrivate;
 
 struct _NMDnsSystemdResolved {
@@ -81,11 +99,49 @@ G_DEFINE_TYPE (NMDnsSystemdResolved, nm_dns_systemd_resolved, NM_TYPE_DNS_PLUGIN
 
 /*****************************************************************************/
 
+static void
+link_state_free (gpointer data)
+{
+	LinkState *link = data;
+
+	nm_clear_g_variant (&link->dns);
+	nm_clear_g_variant (&link->domains);
+	nm_clear_g_variant (&link->sent_dns);
+	nm_clear_g_variant (&link->sent_domains);
+	g_slice_free (LinkState, link);
+}
+
+static void
+links_mark_dirty (NMDnsSystemdResolved *self)
+{
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+	GHashTableIter iter;
+	LinkState *link;
+
+	g_hash_table_iter_init (&iter, priv->links);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &link)) {
+		nm_clear_g_variant (&link->sent_dns);
+		nm_clear_g_variant (&link->sent_domains);
+	}
+}
+
+static void send_updates (NMDnsSystemdResolved *self);
+
+static gboolean
+resend_cb (gpointer user_data)
+{
+	NMDnsSystemdResolved *self = user_data;
+
+	NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self)->resend_id = 0;
+	send_updates (self);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 call_done (GObject *source, GAsyncResult *r, gpointer user_data)
 {
-	GVariant *v;
-	GError *error = NULL;
+	gs_unref_variant GVariant *v = NULL;
+	gs_free_error GError *error = NULL;
 	NMDnsSystemdResolved *self = (NMDnsSystemdResolved *) user_data;
 
 	v = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), r, &error);
@@ -94,11 +150,37 @@ call_done (GObject *source, GAsyncResult *r, gpointer user_data)
 		return;
 
 	if (error != NULL) {
+		NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+		gs_free char *owner = NULL;
+
 		_LOGW ("Failed: %s\n", error->message);
-		g_error_free (error);
+
+		/* we don't know which links resolved has now. Send all of them
+		 * again. If resolved is gone, that happens once it reappears. */
+		links_mark_dirty (self);
+		owner = g_dbus_proxy_get_name_owner (priv->resolve);
+		if (owner && !priv->resend_id)
+			priv->resend_id = g_timeout_add_seconds (RESEND_DELAY_SEC, resend_cb, self);
 	}
 }
 
+static void
+revert_done (GObject *source, GAsyncResult *r, gpointer user_data)
+{
+	gs_unref_variant GVariant *v = NULL;
+	gs_free_error GError *error = NULL;
+	NMDnsSystemdResolved *self = (NMDnsSystemdResolved *) user_data;
+
+	v = g_dbus_proxy_call_finish (G_DBUS_PROXY (source), r, &error);
+
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+		return;
+
+	/* this fails when the link is already gone, which is fine. */
+	if (error != NULL)
+		_LOGD ("Failed to revert link: %s", error->message);
+}
+
 static void
 add_interface_configuration (NMDnsSystemdResolved *self,
                              GArray *interfaces,
@@ -215,24 +297,12 @@ update_add_ip4_config (NMDnsSystemdResolved *self,
 	}
 }
 
-static void
-free_pending_updates (NMDnsSystemdResolved *self)
-{
-	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
-	GVariant *v;
-
-	while ((v = g_queue_pop_head (&priv->dns_updates)) != NULL)
-		g_variant_unref (v);
-
-	while ((v = g_queue_pop_head (&priv->domain_updates)) != NULL)
-		g_variant_unref (v);
-}
-
 static void
 prepare_one_interface (NMDnsSystemdResolved *self, InterfaceConfig *ic)
 {
 	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 	GVariantBuilder dns, domains;
+	LinkState *link;
 	GList *l;
 
 	g_variant_builder_init (&dns, G_VARIANT_TYPE ("(ia(iay))"));
@@ -254,38 +324,88 @@ prepare_one_interface (NMDnsSystemdResolved *self, InterfaceConfig *ic)
 	g_variant_builder_close (&dns);
 	g_variant_builder_close (&domains);
 
-	g_queue_push_tail (&priv->dns_updates,
-	                   g_variant_ref_sink (g_variant_builder_end (&dns)));
-	g_queue_push_tail (&priv->domain_updates,
-	                   g_variant_ref_sink (g_variant_builder_end (&domains)));
+	link = g_hash_table_lookup (priv->links, GINT_TO_POINTER (ic->ifindex));
+	if (!link) {
+		link = g_slice_new0 (LinkState);
+		link->ifindex = ic->ifindex;
+		g_hash_table_insert (priv->links, GINT_TO_POINTER (link->ifindex), link);
+	}
+	link->update_id = priv->update_id;
+
+	nm_clear_g_variant (&link->dns);
+	link->dns = g_variant_ref_sink (g_variant_builder_end (&dns));
+	nm_clear_g_variant (&link->domains);
+	link->domains = g_variant_ref_sink (g_variant_builder_end (&domains));
 }
 
 static void
-send_updates (NMDnsSystemdResolved *self)
+send_call (NMDnsSystemdResolved *self, const char *method, GVariant *args)
 {
 	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
-	GVariant *v;
 
-	nm_clear_g_cancellable (&priv->update_cancellable);
+	g_dbus_proxy_call (priv->resolve, method, args,
+	                   G_DBUS_CALL_FLAGS_NONE,
+	                   -1, priv->update_cancellable,
+	                   nm_streq (method, "RevertLink") ? revert_done : call_done,
+	                   self);
+}
+
+static gboolean
+send_link_arg (NMDnsSystemdResolved *self, const char *method, GVariant *arg, GVariant **sent_arg)
+{
+	if (*sent_arg && g_variant_equal (*sent_arg, arg))
+		return FALSE;
+
+	send_call (self, method, arg);
+	nm_clear_g_variant (sent_arg);
+	*sent_arg = g_variant_ref (arg);
+	return TRUE;
+}
+
+/* Send the calls for the links whose wanted arguments differ from what
+ * was last sent. Until the proxy is ready, nothing is sent and the links
+ * only remember what they want. */
+static void
+send_updates (NMDnsSystemdResolved *self)
+{
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+	GHashTableIter iter;
+	LinkState *link;
+	guint n_calls = 0, n_saved = 0;
 
 	if (!priv->resolve)
 		return;
 
-	priv->update_cancellable = g_cancellable_new ();
+	nm_clear_g_source (&priv->resend_id);
+
+	/* the calls are not cancelled by later updates, because these only
+	 * contain the links that changed since. D-Bus keeps the order of the
+	 * calls, so that the last one for a link wins. */
+	if (!priv->update_cancellable)
+		priv->update_cancellable = g_cancellable_new ();
+
+	g_hash_table_iter_init (&iter, priv->links);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &link)) {
+		if (!link->dns) {
+			/* links without configuration go back to the settings that
+			 * resolved has by itself. */
+			send_call (self, "RevertLink", g_variant_new ("(i)", link->ifindex));
+			g_hash_table_iter_remove (&iter);
+			n_calls++;
+			continue;
+		}
 
-	while ((v = g_queue_pop_head (&priv->dns_updates)) != NULL) {
-		g_dbus_proxy_call (priv->resolve, "SetLinkDNS", v,
-		                   G_DBUS_CALL_FLAGS_NONE,
-		                   -1, priv->update_cancellable, call_done, self);
-		g_variant_unref (v);
+		if (send_link_arg (self, "SetLinkDNS", link->dns, &link->sent_dns))
+			n_calls++;
+		else
+			n_saved++;
+		if (send_link_arg (self, "SetLinkDomains", link->domains, &link->sent_domains))
+			n_calls++;
+		else
+			n_saved++;
 	}
 
-	while ((v = g_queue_pop_head (&priv->domain_updates)) != NULL) {
-		g_dbus_proxy_call (priv->resolve, "SetLinkDomains", v,
-		                   G_DBUS_CALL_FLAGS_NONE,
-		                   -1, priv->update_cancellable, call_done, self);
-		g_variant_unref (v);
-	}
+	_LOGD ("update links: %u calls, %u calls saved for unchanged links", n_calls, n_saved);
 }
 
 static gboolean
@@ -295,7 +415,10 @@ update (NMDnsPlugin *plugin,
         const char *hostname)
 {
 	NMDnsSystemdResolved *self = NM_DNS_SYSTEMD_RESOLVED (plugin);
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 	GArray *interfaces = g_array_new (TRUE, TRUE, sizeof (InterfaceConfig));
+	GHashTableIter iter;
+	LinkState *link;
 	guint i;
 	int prio, first_prio = 0;
 
@@ -310,7 +433,7 @@ update (NMDnsPlugin *plugin,
 		add_interface_configuration (self, interfaces, configs->pdata[i], skip);
 	}
 
-	free_pending_updates (self);
+	priv->update_id++;
 
 	for (i = 0; i < interfaces->len; i++) {
 		InterfaceConfig *ic = &g_array_index (interfaces, InterfaceConfig, i);
@@ -321,6 +444,15 @@ update (NMDnsPlugin *plugin,
 
 	g_array_free (interfaces, TRUE);
 
+	/* links without configuration are reverted by send_updates(). */
+	g_hash_table_iter_init (&iter, priv->links);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &link)) {
+		if (link->update_id == priv->update_id)
+			continue;
+		nm_clear_g_variant (&link->dns);
+		nm_clear_g_variant (&link->domains);
+	}
+
 	send_updates (self);
 
 	return TRUE;
@@ -342,6 +474,24 @@ get_name (NMDnsPlugin *plugin)
 
 /*****************************************************************************/
 
+static void
+name_owner_changed (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	NMDnsSystemdResolved *self = user_data;
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+	gs_free char *owner = NULL;
+
+	owner = g_dbus_proxy_get_name_owner (priv->resolve);
+	if (!owner)
+		return;
+
+	/* resolved (re)started and doesn't know the links yet. Send all of
+	 * them again. */
+	_LOGD ("resolved appeared, send all links");
+	links_mark_dirty (self);
+	send_updates (self);
+}
+
 static void
 resolved_proxy_created (GObject *source, GAsyncResult *r, gpointer user_data)
 {
@@ -364,6 +514,11 @@ resolved_proxy_created (GObject *source, GAsyncResult *r, gpointer user_data)
 	}
 
 	priv->resolve = resolve;
+	g_signal_connect (priv->resolve, "notify::g-name-owner",
+	                  G_CALLBACK (name_owner_changed), self);
+
+	/* nothing was sent before, send the full state of all links. */
+	links_mark_dirty (self);
 	send_updates (self);
 }
 
@@ -376,8 +531,8 @@ nm_dns_systemd_resolved_init (NMDnsSystemdResolved *self)
 	NMBusManager *dbus_mgr;
 	GDBusConnection *connection;
 
-	g_queue_init (&priv->dns_updates);
-	g_queue_init (&priv->domain_updates);
+	priv->links = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                     NULL, link_state_free);
 
 	dbus_mgr = nm_bus_manager_get ();
 	g_return_if_fail (dbus_mgr);
@@ -410,8 +565,12 @@ dispose (GObject *object)
 	NMDnsSystemdResolved *self = NM_DNS_SYSTEMD_RESOLVED (object);
 	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 
-	free_pending_updates (self);
-	g_clear_object (&priv->resolve);
+	nm_clear_g_source (&priv->resend_id);
+	if (priv->resolve) {
+		g_signal_handlers_disconnect_by_func (priv->resolve, name_owner_changed, self);
+		g_clear_object (&priv->resolve);
+	}
+	g_clear_pointer (&priv->links, g_hash_table_destroy);
 	nm_clear_g_cancellable (&priv->init_cancellable);
 	nm_clear_g_cancellable (&priv->update_cancellable);
 
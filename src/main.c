@@ -141,6 +141,7 @@ nm_main_config_reload (int signal)
 		break;
 	case SIGUSR2:
 		reload_flags = NM_CONFIG_CHANGE_CAUSE_SIGUSR2;
+		nm_platform_log_memory_stats (NM_PLATFORM_GET);
 		break;
 	default:
 		g_return_if_reached ();
@@ -341,6 +342,16 @@ main (int argc, char *argv[])
 		}
 	}
 
+	if (!nm_logging_ring_setup (nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                                             NM_CONFIG_KEYFILE_GROUP_LOGGING,
+	                                                             NM_CONFIG_KEYFILE_KEY_LOGGING_RING_BUFFER_LEVEL,
+	                                                             NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY),
+	                            &error)) {
+		fprintf (stderr, _("Error in configuration file: %s.\n"),
+		         error->message);
+		exit (1);
+	}
+
 	if (global_opt.become_daemon && !nm_config_get_is_debug (config)) {
 		if (daemon (0, 0) < 0) {
 			int saved_errno;
@@ -381,7 +392,19 @@ main (int argc, char *argv[])
 	             );
 
 	/* Set up platform interaction layer */
-	nm_linux_platform_setup ();
+	nm_linux_platform_setup_full (nm_config_data_get_value_boolean (nm_config_get_data_orig (config),
+	                                                                NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                NM_CONFIG_KEYFILE_KEY_MAIN_NETLINK_THREAD,
+	                                                                FALSE),
+	                              nm_config_data_get_value_cached (nm_config_get_data_orig (config),
+	                                                               NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                               NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_ROUTE_PROTOCOLS,
+	                                                               NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY),
+	                              _nm_utils_ascii_str_to_int64 (nm_config_data_get_value_cached (nm_config_get_data_orig (config),
+	                                                                                             NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                                             NM_CONFIG_KEYFILE_KEY_MAIN_NETLINK_READ_BUDGET,
+	                                                                                             NM_CONFIG_GET_VALUE_STRIP),
+	                                                            10, 0, 10000, 0));
 
 	NM_UTILS_KEEP_ALIVE (config, nm_netns_get (), "NMConfig-depends-on-NMNetns");
 
@@ -390,6 +413,12 @@ main (int argc, char *argv[])
 	                                                         NM_CONFIG_KEYFILE_KEY_MAIN_AUTH_POLKIT,
 	                                                         NM_CONFIG_DEFAULT_MAIN_AUTH_POLKIT_BOOL));
 
+	nm_exported_object_class_set_notify_latency (_nm_utils_ascii_str_to_int64 (nm_config_data_get_value_cached (NM_CONFIG_GET_DATA_ORIG,
+	                                                                                                           NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                                                                                           NM_CONFIG_KEYFILE_KEY_MAIN_PROPERTIES_CHANGED_LATENCY,
+	                                                                                                           NM_CONFIG_GET_VALUE_STRIP),
+	                                                                          10, 0, 10000, 0));
+
 	nm_manager_setup ();
 
 	if (!nm_bus_manager_get_connection (nm_bus_manager_get ())) {
@@ -597,7 +597,7 @@ nm_config_data_log (const NMConfigData *self,
 
 	g_return_if_fail (NM_IS_CONFIG_DATA (self));
 
-	if (!stream && !nm_logging_enabled (LOGL_DEBUG, LOGD_CORE))
+	if (!stream && !nm_logging_backend_enabled (LOGL_DEBUG, LOGD_CORE))
 		return;
 
 	if (!prefix)
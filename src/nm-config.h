@@ -64,7 +64,12 @@
 #define NM_CONFIG_KEYFILE_KEY_MAIN_DEBUG                    "debug"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_HOSTNAME_MODE            "hostname-mode"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_SLAVES_ORDER             "slaves-order"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_PROPERTIES_CHANGED_LATENCY "properties-changed-latency"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_NETLINK_THREAD           "netlink-thread"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_ROUTE_PROTOCOLS   "ignore-route-protocols"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_NETLINK_READ_BUDGET      "netlink-read-budget"
 #define NM_CONFIG_KEYFILE_KEY_LOGGING_BACKEND               "backend"
+#define NM_CONFIG_KEYFILE_KEY_LOGGING_RING_BUFFER_LEVEL     "ring-buffer-level"
 #define NM_CONFIG_KEYFILE_KEY_CONFIG_ENABLE                 "enable"
 #define NM_CONFIG_KEYFILE_KEY_ATOMIC_SECTION_WAS            ".was"
 #define NM_CONFIG_KEYFILE_KEY_KEYFILE_PATH                  "path"
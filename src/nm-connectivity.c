@@ -32,14 +32,32 @@
 
 /*****************************************************************************/
 
+/* after the connectivity of an interface changed, and for a few checks
+ * while it has no full connectivity, the periodic check of the interface
+ * runs after the configured interval divided by this. Otherwise, it backs
+ * off again to the configured interval. */
+#define PERIODIC_CHECK_SPEEDUP      8
+#define PERIODIC_CHECK_MIN_INTERVAL 5
+#define PERIODIC_CHECK_MAX_FAST     3
+
+/* after a successful check the rest of the response is still read, so
+ * that the connection can be reused. But not more than this. */
+#define RESPONSE_MAX_SIZE           (16 * 1024)
+
 typedef struct {
 	char *uri;
 	char *response;
 	guint interval;
 	NMConfig *config;
-	guint periodic_check_id;
 	CURLM *curl_mhandle;
 	guint curl_timer;
+
+	/* iface -> Probe */
+	GHashTable *probes;
+
+	/* while the periodic check of an interface is emitted. Other checks
+	 * don't reuse connections. */
+	bool in_periodic_check:1;
 } NMConnectivityPrivate;
 
 struct _NMConnectivity {
@@ -99,19 +117,162 @@ NM_UTILS_LOOKUP_STR_DEFINE (nm_connectivity_state_to_string, NMConnectivityState
 /*****************************************************************************/
 
 typedef struct {
-	GSimpleAsyncResult *simple;
+	NMConnectivity *self;
+
+	/* the GSimpleAsyncResult of all requests for the interface that
+	 * came while the check was running. */
+	GSList *simples;
+
 	char *response;
 	CURL *curl_ehandle;
 	size_t msg_size;
 	char *msg;
-	struct curl_slist *request_headers;
 	guint timeout_id;
 	char *ifspec;
+
+	/* the result, once it is known while the rest of the response
+	 * is still read. */
+	NMConnectivityState result;
+	bool has_result:1;
 } ConCheckCbData;
 
+/* the connectivity checks of one interface. */
+typedef struct {
+	NMConnectivity *self;
+	char *iface;
+	ConCheckCbData *cb_data;
+	NMConnectivityState last_state;
+	gint64 last_ts;
+
+	/* the interval for the next periodic check. Between the configured
+	 * interval and a fraction of it. */
+	guint cur_interval;
+	guint periodic_check_id;
+
+	/* the sped up checks since the state last changed. */
+	guint n_fast;
+
+	/* the DNS cache of the interface. The cache of the multi handle would
+	 * be shared by all interfaces, and an address resolved on one uplink
+	 * would hide a captive portal that hijacks DNS on another one. */
+	CURLSH *curl_share;
+} Probe;
+
+static gboolean
+probe_release_share (Probe *probe)
+{
+	if (probe->curl_share) {
+		/* fails while an easy handle still uses the share. */
+		if (curl_share_cleanup (probe->curl_share) != CURLSHE_OK)
+			return FALSE;
+		probe->curl_share = NULL;
+	}
+	return TRUE;
+}
+
+static void
+probe_free (gpointer data)
+{
+	Probe *probe = data;
+
+	nm_clear_g_source (&probe->periodic_check_id);
+	probe_release_share (probe);
+	g_free (probe->iface);
+	g_slice_free (Probe, probe);
+}
+
+static gboolean probe_periodic_check (gpointer user_data);
+
+static void
+probe_schedule (Probe *probe)
+{
+	NMConnectivity *self = probe->self;
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	guint min_interval;
+
+	nm_clear_g_source (&probe->periodic_check_id);
+	if (!nm_connectivity_check_enabled (self))
+		return;
+
+	min_interval = MIN (MAX (priv->interval / PERIODIC_CHECK_SPEEDUP, PERIODIC_CHECK_MIN_INTERVAL),
+	                    priv->interval);
+	probe->cur_interval = CLAMP (probe->cur_interval, min_interval, priv->interval);
+
+	_LOGT ("(%s) next periodic check in %u seconds", probe->iface, probe->cur_interval);
+	probe->periodic_check_id = g_timeout_add_seconds (probe->cur_interval, probe_periodic_check, probe);
+}
+
+static gboolean
+probe_periodic_check (gpointer user_data)
+{
+	Probe *probe = user_data;
+	NMConnectivity *self = probe->self;
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+
+	probe->periodic_check_id = 0;
+
+	/* forget the interface once it is no longer checked. */
+	if (   !probe->cb_data
+	    && nm_utils_get_monotonic_timestamp_s () - probe->last_ts > 2 * (gint64) priv->interval
+	    && probe_release_share (probe)) {
+		g_hash_table_remove (priv->probes, probe->iface);
+		return G_SOURCE_REMOVE;
+	}
+
+	/* the result of the check schedules the next one. This one is only
+	 * for when no result comes. */
+	probe_schedule (probe);
+
+	priv->in_periodic_check = TRUE;
+	g_signal_emit (self, signals[PERIODIC_CHECK], 0, probe->iface);
+	priv->in_periodic_check = FALSE;
+	return G_SOURCE_REMOVE;
+}
+
+static void
+probe_update_state (NMConnectivity *self, const char *iface, NMConnectivityState state)
+{
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	Probe *probe;
+	gboolean changed;
+
+	if (!priv->probes)
+		return;
+
+	probe = g_hash_table_lookup (priv->probes, iface);
+	if (!probe)
+		return;
+
+	probe->cb_data = NULL;
+	changed =    probe->last_ts != 0
+	          && probe->last_state != state;
+	probe->last_state = state;
+	probe->last_ts = nm_utils_get_monotonic_timestamp_s ();
+
+	if (changed)
+		probe->n_fast = 0;
+
+	if (   changed
+	    || (   state != NM_CONNECTIVITY_FULL
+	        && probe->n_fast < PERIODIC_CHECK_MAX_FAST)) {
+		/* check again soon, after a change and for a few times while
+		 * the check fails. An uplink that stays without full connectivity
+		 * (like a LAN-only one) doesn't keep being checked that often. */
+		probe->n_fast++;
+		probe->cur_interval = 0;
+	} else {
+		/* while the state is stable, the interval grows back to the
+		 * configured one. */
+		probe->cur_interval = MIN (probe->cur_interval * 2, priv->interval);
+	}
+	probe_schedule (probe);
+}
+
 static void
 finish_cb_data (ConCheckCbData *cb_data, NMConnectivityState new_state)
 {
+	GSList *simples, *iter;
+
 	/* Contrary to what cURL manual claim it is *not* safe to remove
 	 * the easy handle "at any moment"; specifically not from the
 	 * write function. Thus here we just dissociate the cb_data from
@@ -119,13 +280,23 @@ finish_cb_data (ConCheckCbData *cb_data, NMConnectivityState new_state)
 	 * message goes to CURLMSG_DONE in curl_check_connectivity(). */
 	curl_easy_setopt (cb_data->curl_ehandle, CURLOPT_PRIVATE, NULL);
 
-	g_simple_async_result_set_op_res_gssize (cb_data->simple, new_state);
-	g_simple_async_result_complete (cb_data->simple);
-	g_object_unref (cb_data->simple);
-	curl_slist_free_all (cb_data->request_headers);
+	probe_update_state (cb_data->self, &cb_data->ifspec[3], new_state);
+
+	simples = g_slist_reverse (cb_data->simples);
 	g_free (cb_data->response);
+	g_free (cb_data->msg);
+	g_free (cb_data->ifspec);
 	g_source_remove (cb_data->timeout_id);
 	g_slice_free (ConCheckCbData, cb_data);
+
+	for (iter = simples; iter; iter = iter->next) {
+		GSimpleAsyncResult *simple = iter->data;
+
+		g_simple_async_result_set_op_res_gssize (simple, new_state);
+		g_simple_async_result_complete (simple);
+		g_object_unref (simple);
+	}
+	g_slist_free (simples);
 }
 
 static void
@@ -153,7 +324,9 @@ curl_check_connectivity (CURLM *mhandle, CURLMcode ret)
 		if (cb_data) {
 			/* If cb_data is still there this message hasn't been
 			 * taken care of. Do so now. */
-			if (msg->data.result == CURLE_OK) {
+			if (cb_data->has_result)
+				finish_cb_data (cb_data, cb_data->result);
+			else if (msg->data.result == CURLE_OK) {
 				/* If we get here, it means that easy_write_cb() didn't read enough
 				 * bytes to be able to do a match. */
 				_LOG2I ("response shorter than expected '%s'; assuming captive portal.",
@@ -274,11 +447,15 @@ easy_header_cb (char *buffer, size_t size, size_t nitems, void *userdata)
 	ConCheckCbData *cb_data = userdata;
 	size_t len = size * nitems;
 
-	if (   len >= sizeof (HEADER_STATUS_ONLINE) - 1
+	if (   !cb_data->has_result
+	    && len >= sizeof (HEADER_STATUS_ONLINE) - 1
 	    && !g_ascii_strncasecmp (buffer, HEADER_STATUS_ONLINE, sizeof (HEADER_STATUS_ONLINE) - 1)) {
 		_LOG2D ("status header found, check successful");
-		finish_cb_data (cb_data, NM_CONNECTIVITY_FULL);
-		return 0;
+
+		/* finish when the response is read completely, so that the
+		 * connection can be reused. */
+		cb_data->result = NM_CONNECTIVITY_FULL;
+		cb_data->has_result = TRUE;
 	}
 
 	return len;
@@ -290,20 +467,32 @@ easy_write_cb (void *buffer, size_t size, size_t nmemb, void *userdata)
 	ConCheckCbData *cb_data = userdata;
 	size_t len = size * nmemb;
 
+	if (cb_data->has_result) {
+		/* skip the rest of the response. */
+		cb_data->msg_size += len;
+		if (cb_data->msg_size > RESPONSE_MAX_SIZE) {
+			finish_cb_data (cb_data, cb_data->result);
+			return 0;
+		}
+		return len;
+	}
+
 	cb_data->msg = g_realloc (cb_data->msg, cb_data->msg_size + len);
 	memcpy (cb_data->msg + cb_data->msg_size, buffer, len);
 	cb_data->msg_size += len;
 
 	if (cb_data->msg_size >= strlen (cb_data->response)) {
 		/* We already have enough data -- check response */
-		if (g_str_has_prefix (cb_data->msg, cb_data->response)) {
+		if (strncmp (cb_data->msg, cb_data->response, strlen (cb_data->response)) == 0) {
 			_LOG2D ("check successful.");
-			finish_cb_data (cb_data, NM_CONNECTIVITY_FULL);
-		} else {
-			_LOG2I ("response did not match expected response '%s'; assuming captive portal.",
-			        cb_data->response);
-			finish_cb_data (cb_data, NM_CONNECTIVITY_PORTAL);
+			cb_data->result = NM_CONNECTIVITY_FULL;
+			cb_data->has_result = TRUE;
+			return len;
 		}
+
+		_LOG2I ("response did not match expected response '%s'; assuming captive portal.",
+		        cb_data->response);
+		finish_cb_data (cb_data, NM_CONNECTIVITY_PORTAL);
 		return 0;
 	}
 
@@ -314,12 +503,11 @@ static gboolean
 timeout_cb (gpointer user_data)
 {
 	ConCheckCbData *cb_data = user_data;
-	NMConnectivity *self = NM_CONNECTIVITY (g_async_result_get_source_object (G_ASYNC_RESULT (cb_data->simple)));
-	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (self);
+	NMConnectivityPrivate *priv = NM_CONNECTIVITY_GET_PRIVATE (cb_data->self);
 	CURL *ehandle = cb_data->curl_ehandle;
 
 	_LOG2I ("timed out");
-	finish_cb_data (cb_data, NM_CONNECTIVITY_LIMITED);
+	finish_cb_data (cb_data, cb_data->has_result ? cb_data->result : NM_CONNECTIVITY_LIMITED);
 	curl_multi_remove_handle (priv->curl_mhandle, ehandle);
 	curl_easy_cleanup (ehandle);
 
@@ -335,6 +523,8 @@ nm_connectivity_check_async (NMConnectivity      *self,
 	NMConnectivityPrivate *priv;
 	GSimpleAsyncResult *simple;
 	CURL *ehandle = NULL;
+	Probe *probe = NULL;
+	gboolean fresh = FALSE;
 
 	g_return_if_fail (NM_IS_CONNECTIVITY (self));
 	priv = NM_CONNECTIVITY_GET_PRIVATE (self);
@@ -342,16 +532,50 @@ nm_connectivity_check_async (NMConnectivity      *self,
 	simple = g_simple_async_result_new (G_OBJECT (self), callback, user_data,
 	                                    nm_connectivity_check_async);
 
-	if (priv->uri && priv->interval && priv->curl_mhandle)
+	if (priv->uri && priv->interval && priv->curl_mhandle) {
+		probe = g_hash_table_lookup (priv->probes, iface);
+		if (!probe) {
+			probe = g_slice_new0 (Probe);
+			probe->self = self;
+			probe->iface = g_strdup (iface);
+			probe->last_state = NM_CONNECTIVITY_UNKNOWN;
+			probe->cur_interval = priv->interval;
+			g_hash_table_insert (priv->probes, probe->iface, probe);
+		} else if (probe->cb_data) {
+			ConCheckCbData *cb_data = probe->cb_data;
+
+			/* a check of the interface is already running. Its result
+			 * is good for this request too. */
+			cb_data->simples = g_slist_prepend (cb_data->simples, simple);
+			_LOG2D ("check already in progress");
+			return;
+		}
+
+		/* other than the periodic checks, a check is requested when the
+		 * network behind the interface may have changed (like after an
+		 * activation). Don't let the cached connections and addresses of
+		 * the previous network hide a captive portal of the new one. */
+		fresh = !priv->in_periodic_check;
+		if (fresh)
+			probe_release_share (probe);
+
+		if (!probe->curl_share) {
+			probe->curl_share = curl_share_init ();
+			if (probe->curl_share)
+				curl_share_setopt (probe->curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		}
+
 		ehandle = curl_easy_init ();
+	}
 
 	if (ehandle) {
 		ConCheckCbData *cb_data = g_slice_new0 (ConCheckCbData);
 
+		cb_data->self = self;
 		cb_data->curl_ehandle = ehandle;
-		cb_data->request_headers = curl_slist_append (NULL, "Connection: close");
 		cb_data->ifspec = g_strdup_printf ("if!%s", iface);
-		cb_data->simple = simple;
+		cb_data->simples = g_slist_prepend (NULL, simple);
+		probe->cb_data = cb_data;
 		if (priv->response)
 			cb_data->response = g_strdup (priv->response);
 		else
@@ -363,8 +587,19 @@ nm_connectivity_check_async (NMConnectivity      *self,
 		curl_easy_setopt (ehandle, CURLOPT_HEADERFUNCTION, easy_header_cb);
 		curl_easy_setopt (ehandle, CURLOPT_HEADERDATA, cb_data);
 		curl_easy_setopt (ehandle, CURLOPT_PRIVATE, cb_data);
-		curl_easy_setopt (ehandle, CURLOPT_HTTPHEADER, cb_data->request_headers);
 		curl_easy_setopt (ehandle, CURLOPT_INTERFACE, cb_data->ifspec);
+
+		/* the connection stays in the cache of the multi handle and the
+		 * resolved address in the cache of the interface, for the next
+		 * check of the interface. The addresses expire after the default
+		 * timeout of libcurl. */
+		if (probe->curl_share)
+			curl_easy_setopt (ehandle, CURLOPT_SHARE, probe->curl_share);
+		if (fresh)
+			curl_easy_setopt (ehandle, CURLOPT_FRESH_CONNECT, 1L);
+#if LIBCURL_VERSION_NUM >= 0x071900
+		curl_easy_setopt (ehandle, CURLOPT_TCP_KEEPALIVE, 1L);
+#endif
 		curl_multi_add_handle (priv->curl_mhandle, ehandle);
 
 		cb_data->timeout_id = g_timeout_add_seconds (30, timeout_cb, cb_data);
@@ -405,13 +640,6 @@ nm_connectivity_check_enabled (NMConnectivity *self)
 
 /*****************************************************************************/
 
-static gboolean
-periodic_check (gpointer user_data)
-{
-	g_signal_emit (NM_CONNECTIVITY (user_data), signals[PERIODIC_CHECK], 0);
-	return G_SOURCE_CONTINUE;
-}
-
 static void
 update_config (NMConnectivity *self, NMConfigData *config_data)
 {
@@ -464,9 +692,20 @@ update_config (NMConnectivity *self, NMConfigData *config_data)
 	}
 
 	if (changed) {
-		nm_clear_g_source (&priv->periodic_check_id);
+		GHashTableIter iter;
+		Probe *probe;
+
+		g_hash_table_iter_init (&iter, priv->probes);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &probe)) {
+			probe->cur_interval = priv->interval;
+			probe->n_fast = 0;
+			probe_schedule (probe);
+		}
+
+		/* check all interfaces with the new configuration, which also
+		 * starts the periodic checks if they were disabled before. */
 		if (nm_connectivity_check_enabled (self))
-			priv->periodic_check_id = g_timeout_add_seconds (priv->interval, periodic_check, self);
+			g_signal_emit (self, signals[PERIODIC_CHECK], 0, NULL);
 	}
 }
 
@@ -500,6 +739,8 @@ nm_connectivity_init (NMConnectivity *self)
 		curl_multi_setopt (priv->curl_mhandle, CURLOPT_VERBOSE, 1);
 	}
 
+	priv->probes = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, probe_free);
+
 	priv->config = g_object_ref (nm_config_get ());
 
 	update_config (self, nm_config_get_data (priv->config));
@@ -526,7 +767,7 @@ dispose (GObject *object)
 
 	curl_multi_cleanup (priv->curl_mhandle);
 	curl_global_cleanup ();
-	nm_clear_g_source (&priv->periodic_check_id);
+	g_clear_pointer (&priv->probes, g_hash_table_unref);
 
 	G_OBJECT_CLASS (nm_connectivity_parent_class)->dispose (object);
 }
@@ -541,7 +782,7 @@ nm_connectivity_class_init (NMConnectivityClass *klass)
 	                  G_OBJECT_CLASS_TYPE (object_class),
 	                  G_SIGNAL_RUN_FIRST,
 	                  0, NULL, NULL, NULL,
-	                  G_TYPE_NONE, 0);
+	                  G_TYPE_NONE, 1, G_TYPE_STRING);
 
 	object_class->dispose = dispose;
 }
@@ -640,7 +640,7 @@ _dispatcher_call (NMDispatcherAction action,
 		                                               &vpn_proxy_props,
 		                                               &vpn_ip4_props,
 		                                               &vpn_ip6_props,
-		                                               nm_logging_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
+		                                               nm_logging_backend_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
 		                                G_VARIANT_TYPE ("(a(sus))"),
 		                                G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT,
 		                                NULL, &error);
@@ -678,7 +678,7 @@ _dispatcher_call (NMDispatcherAction action,
 		                                  &vpn_proxy_props,
 		                                  &vpn_ip4_props,
 		                                  &vpn_ip6_props,
-		                                  nm_logging_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
+		                                  nm_logging_backend_enabled (LOGL_DEBUG, LOGD_DISPATCH)),
 		                   G_DBUS_CALL_FLAGS_NONE, CALL_TIMEOUT,
 		                   NULL, dispatcher_done_cb, info);
 		success = TRUE;
@@ -25,6 +25,8 @@
 #include <stdarg.h>
 #include <string.h>
 
+#include "nm-utils/c-list.h"
+
 #include "nm-bus-manager.h"
 
 #include "devices/nm-device.h"
@@ -39,6 +41,21 @@
 
 static gboolean quitting = FALSE;
 
+/* All objects with pending property changes are queued in one list and
+ * flushed together by a single main-loop source. @latency_msec bounds
+ * how long a change may be delayed to be batched with others. */
+static struct {
+	CList pending_lst_head;
+	guint source_id;
+	guint latency_msec;
+
+	/* number of emitted PropertiesChanged signals per D-Bus interface
+	 * type, for diagnostics. */
+	GHashTable *signal_counts;
+} notify_flusher = {
+	.pending_lst_head = C_LIST_INIT (notify_flusher.pending_lst_head),
+};
+
 /*****************************************************************************/
 
 NM_GOBJECT_PROPERTIES_DEFINE (NMExportedObject,
@@ -52,13 +69,15 @@ typedef struct {
 } InterfaceData;
 
 typedef struct _NMExportedObjectPrivate {
+	NMExportedObject *self;
 	NMBusManager *bus_mgr;
 	char *path;
 
 	InterfaceData *interfaces;
 	guint num_interfaces;
 
-	guint notify_idle_id;
+	/* linked in notify_flusher.pending_lst_head while there are pending notifies. */
+	CList pending_notify_lst;
 
 #ifdef _ASSERT_NO_EARLY_EXPORT
 	bool _constructed:1;
@@ -87,6 +106,9 @@ static NM_CACHED_QUARK_FCN ("NMExportedObjectClassInfo", nm_exported_object_clas
 #define _NMLOG2_DOMAIN      LOGD_DBUS_PROPS
 #define _NMLOG2(level, ...) __NMLOG_DEFAULT_WITH_ADDR (level, _NMLOG2_DOMAIN, "properties-changed", __VA_ARGS__)
 
+#define _LOG2T_no_self(...) nm_log (LOGL_TRACE, _NMLOG2_DOMAIN, NULL, NULL, "properties-changed: " __VA_ARGS__)
+#define _LOG2D_no_self(...) nm_log (LOGL_DEBUG, _NMLOG2_DOMAIN, NULL, NULL, "properties-changed: " __VA_ARGS__)
+
 /*****************************************************************************/
 
 /* "AddConnectionUnsaved" -> "handle-add-connection-unsaved" */
@@ -722,7 +744,7 @@ nm_exported_object_unexport (NMExportedObject *self)
 
 	g_clear_pointer (&priv->path, g_free);
 
-	nm_clear_g_source (&priv->notify_idle_id);
+	c_list_unlink_init (&priv->pending_notify_lst);
 
 	_notify (self, PROP_PATH);
 }
@@ -779,10 +801,41 @@ nm_exported_object_get_interface_by_type (NMExportedObject *self, GType interfac
 
 /*****************************************************************************/
 
+static void
+_notify_flusher_log_stats (void)
+{
+	GHashTableIter iter;
+	gpointer type, count;
+
+	if (   !notify_flusher.signal_counts
+	    || !_LOG2D_ENABLED ())
+		return;
+
+	g_hash_table_iter_init (&iter, notify_flusher.signal_counts);
+	while (g_hash_table_iter_next (&iter, &type, &count)) {
+		_LOG2D_no_self ("emitted %u signals on %s",
+		                GPOINTER_TO_UINT (count),
+		                g_type_name (GPOINTER_TO_SIZE (type)));
+	}
+}
+
 void
 nm_exported_object_class_set_quitting (void)
 {
 	quitting = TRUE;
+	_notify_flusher_log_stats ();
+}
+
+/**
+ * nm_exported_object_class_set_notify_latency:
+ * @latency_msec: the maximum time in milliseconds that property
+ *   changes are delayed to be batched into fewer PropertiesChanged
+ *   signals. With zero, pending changes are emitted on the next idle.
+ */
+void
+nm_exported_object_class_set_notify_latency (guint latency_msec)
+{
+	notify_flusher.latency_msec = latency_msec;
 }
 
 /*****************************************************************************/
@@ -799,13 +852,25 @@ _sort_pending_notifies (gconstpointer a, gconstpointer b, gpointer       user_da
 	               ((const PendingNotifiesItem *) b)->property_name);
 }
 
-static gboolean
-idle_emit_properties_changed (gpointer self)
+static void
+_notify_flusher_count_signal (GType interface_type)
 {
-	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (NM_EXPORTED_OBJECT (self));
-	guint k;
+	gpointer key = GSIZE_TO_POINTER (interface_type);
+	guint count;
+
+	if (!notify_flusher.signal_counts)
+		notify_flusher.signal_counts = g_hash_table_new (NULL, NULL);
+
+	count = GPOINTER_TO_UINT (g_hash_table_lookup (notify_flusher.signal_counts, key));
+	g_hash_table_insert (notify_flusher.signal_counts, key, GUINT_TO_POINTER (count + 1));
+}
 
-	priv->notify_idle_id = 0;
+static guint
+emit_properties_changed (NMExportedObject *self)
+{
+	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
+	guint k;
+	guint n_signals = 0;
 
 	for (k = 0; k < priv->num_interfaces; k++) {
 		InterfaceData *ifdata = &priv->interfaces[k];
@@ -850,13 +915,67 @@ idle_emit_properties_changed (gpointer self)
 		}
 
 		g_signal_emit (ifdata->interface, ifdata->property_changed_signal_id, 0, variant);
+		n_signals++;
+		_notify_flusher_count_signal (G_OBJECT_TYPE (ifdata->interface));
 
+		/* emitting the signal may have unexported the object. */
+		if (!priv->interfaces)
+			break;
 		g_hash_table_remove_all (ifdata->pending_notifies);
 	}
 
+	return n_signals;
+}
+
+static gboolean
+_notify_flusher_dispatch (gpointer user_data)
+{
+	CList batch;
+	guint n_objects = 0;
+	guint n_signals = 0;
+
+	notify_flusher.source_id = 0;
+
+	/* Objects that get new notifications while we emit are queued
+	 * anew and handled by the next dispatch. */
+	c_list_init (&batch);
+	c_list_splice (&batch, &notify_flusher.pending_lst_head);
+
+	while (!c_list_is_empty (&batch)) {
+		NMExportedObjectPrivate *priv;
+		gs_unref_object NMExportedObject *self = NULL;
+
+		priv = c_list_first_entry (&batch, NMExportedObjectPrivate, pending_notify_lst);
+		c_list_unlink_init (&priv->pending_notify_lst);
+
+		self = g_object_ref (priv->self);
+		n_signals += emit_properties_changed (self);
+		n_objects++;
+	}
+
+	_LOG2T_no_self ("flushed %u signals for %u objects", n_signals, n_objects);
+
 	return G_SOURCE_REMOVE;
 }
 
+static void
+_notify_flusher_schedule (NMExportedObject *self)
+{
+	NMExportedObjectPrivate *priv = NM_EXPORTED_OBJECT_GET_PRIVATE (self);
+
+	if (c_list_is_linked (&priv->pending_notify_lst))
+		return;
+
+	c_list_link_tail (&notify_flusher.pending_lst_head, &priv->pending_notify_lst);
+
+	if (!notify_flusher.source_id) {
+		if (notify_flusher.latency_msec == 0)
+			notify_flusher.source_id = g_idle_add (_notify_flusher_dispatch, NULL);
+		else
+			notify_flusher.source_id = g_timeout_add (notify_flusher.latency_msec, _notify_flusher_dispatch, NULL);
+	}
+}
+
 static void
 nm_exported_object_notify (GObject *object, GParamSpec *pspec)
 {
@@ -962,8 +1081,7 @@ vtype_found:
 	} else
 		g_variant_unref (value_variant);
 
-	if (!priv->notify_idle_id)
-		priv->notify_idle_id = g_idle_add (idle_emit_properties_changed, self);
+	_notify_flusher_schedule (self);
 }
 
 /*****************************************************************************/
@@ -992,6 +1110,9 @@ nm_exported_object_init (NMExportedObject *self)
 
 	priv = G_TYPE_INSTANCE_GET_PRIVATE (self, NM_TYPE_EXPORTED_OBJECT, NMExportedObjectPrivate);
 	self->_priv = priv;
+
+	priv->self = self;
+	c_list_init (&priv->pending_notify_lst);
 }
 
 static void
@@ -1028,7 +1149,7 @@ dispose (GObject *object)
 	} else if (nm_clear_g_free (&priv->path))
 		_notify (self, PROP_PATH);
 
-	nm_clear_g_source (&priv->notify_idle_id);
+	c_list_unlink_init (&priv->pending_notify_lst);
 
 	G_OBJECT_CLASS (nm_exported_object_parent_class)->dispose (object);
 }
@@ -27,6 +27,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <errno.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <strings.h>
@@ -80,6 +81,9 @@ typedef struct {
 	GLogLevelFlags g_log_level;
 } LogLevelDesc;
 
+/* the union of _backend_enabled_state and ring.enabled_state. This is what
+ * nm_logging_enabled() checks, so that messages are formatted if at least
+ * one of the two sinks wants them. */
 NMLogDomain _nm_logging_enabled_state[_LOGL_N_REAL] = {
 	/* nm_logging_setup ("INFO", LOGD_DEFAULT_STRING, NULL, NULL);
 	 *
@@ -90,6 +94,45 @@ NMLogDomain _nm_logging_enabled_state[_LOGL_N_REAL] = {
 	[LOGL_ERR]  = LOGD_DEFAULT,
 };
 
+/* the state as configured via nm_logging_setup(), which determines what gets
+ * passed on to the logging backend (journal, syslog, glib). */
+static NMLogDomain _backend_enabled_state[_LOGL_N_REAL] = {
+	[LOGL_INFO] = LOGD_DEFAULT,
+	[LOGL_WARN] = LOGD_DEFAULT,
+	[LOGL_ERR]  = LOGD_DEFAULT,
+};
+
+/* The in-memory ring buffer. It has a fixed number of fixed-size slots
+ * which are allocated once and never freed. Writers reserve a slot by
+ * atomically incrementing @head, so recording a message does neither
+ * allocate nor take a lock nor issue a syscall. A slot is published by setting
+ * its @seq to the reserved sequence number plus one; readers skip slots whose
+ * @seq doesn't match (because they are still being written or were already
+ * overwritten). */
+#define RING_N_RECORDS   8192
+#define RING_RECORD_SIZE 256
+
+typedef struct {
+	volatile gint seq;
+	guint8 level;
+	NMLogDomain domain;
+	gint64 timestamp_us;
+	char msg[RING_RECORD_SIZE - 24];
+} RingRecord;
+
+G_STATIC_ASSERT (sizeof (RingRecord) == RING_RECORD_SIZE);
+G_STATIC_ASSERT (RING_N_RECORDS > 0 && (RING_N_RECORDS & (RING_N_RECORDS - 1)) == 0);
+
+static struct {
+	RingRecord *records;
+	volatile gint head;
+	NMLogLevel log_level;
+	bool crash_handler_installed:1;
+	NMLogDomain enabled_state[_LOGL_N_REAL];
+} ring = {
+	.log_level = _LOGL_OFF,
+};
+
 static struct Global {
 	NMLogLevel log_level;
 	bool uses_syslog:1;
@@ -249,6 +292,17 @@ nm_logging_set_syslog_identifier (const char *domain)
 
 /*****************************************************************************/
 
+static void
+_enabled_state_update (void)
+{
+	int i;
+
+	for (i = 0; i < G_N_ELEMENTS (_nm_logging_enabled_state); i++)
+		_nm_logging_enabled_state[i] = _backend_enabled_state[i] | ring.enabled_state[i];
+}
+
+/*****************************************************************************/
+
 static gboolean
 match_log_level (const char  *level,
                  NMLogLevel  *out_level,
@@ -275,7 +329,7 @@ nm_logging_setup (const char  *level,
                   GError     **error)
 {
 	GString *unrecognized = NULL;
-	NMLogDomain new_logging[G_N_ELEMENTS (_nm_logging_enabled_state)];
+	NMLogDomain new_logging[G_N_ELEMENTS (_backend_enabled_state)];
 	NMLogLevel new_log_level = global.log_level;
 	char **tmp, **iter;
 	int i;
@@ -299,7 +353,7 @@ nm_logging_setup (const char  *level,
 		if (new_log_level == _LOGL_KEEP) {
 			new_log_level = global.log_level;
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-				new_logging[i] = _nm_logging_enabled_state[i];
+				new_logging[i] = _backend_enabled_state[i];
 		}
 	}
 
@@ -381,7 +435,7 @@ nm_logging_setup (const char  *level,
 
 		if (domain_log_level == _LOGL_KEEP) {
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-				new_logging[i] = (new_logging[i] & ~bits) | (_nm_logging_enabled_state[i] & bits);
+				new_logging[i] = (new_logging[i] & ~bits) | (_backend_enabled_state[i] & bits);
 		} else {
 			for (i = 0; i < G_N_ELEMENTS (new_logging); i++) {
 				if (i < domain_log_level)
@@ -403,7 +457,8 @@ nm_logging_setup (const char  *level,
 
 	global.log_level = new_log_level;
 	for (i = 0; i < G_N_ELEMENTS (new_logging); i++)
-		_nm_logging_enabled_state[i] = new_logging[i];
+		_backend_enabled_state[i] = new_logging[i];
+	_enabled_state_update ();
 
 	if (   had_platform_debug
 	    && _nm_logging_clear_platform_logging_cache
@@ -468,7 +523,7 @@ _domains_to_string (gboolean include_level_override)
 	str = g_string_sized_new (75);
 	for (diter = &global.domain_desc[0]; diter->name; diter++) {
 		/* If it's set for any lower level, it will also be set for LOGL_ERR */
-		if (!(diter->num & _nm_logging_enabled_state[LOGL_ERR]))
+		if (!(diter->num & _backend_enabled_state[LOGL_ERR]))
 			continue;
 
 		if (str->len)
@@ -480,15 +535,15 @@ _domains_to_string (gboolean include_level_override)
 
 		/* Check if it's logging at a lower level than the default. */
 		for (i = 0; i < global.log_level; i++) {
-			if (diter->num & _nm_logging_enabled_state[i]) {
+			if (diter->num & _backend_enabled_state[i]) {
 				g_string_append_printf (str, ":%s", global.level_desc[i].name);
 				break;
 			}
 		}
 		/* Check if it's logging at a higher level than the default. */
-		if (!(diter->num & _nm_logging_enabled_state[global.log_level])) {
-			for (i = global.log_level + 1; i < G_N_ELEMENTS (_nm_logging_enabled_state); i++) {
-				if (diter->num & _nm_logging_enabled_state[i]) {
+		if (!(diter->num & _backend_enabled_state[global.log_level])) {
+			for (i = global.log_level + 1; i < G_N_ELEMENTS (_backend_enabled_state); i++) {
+				if (diter->num & _backend_enabled_state[i]) {
 					g_string_append_printf (str, ":%s", global.level_desc[i].name);
 					break;
 				}
@@ -521,6 +576,25 @@ nm_logging_all_domains_to_string (void)
 	return str->str;
 }
 
+/**
+ * nm_logging_backend_enabled:
+ * @level: the logging level
+ * @domain: the logging domain(s)
+ *
+ * Unlike nm_logging_enabled(), this ignores the in-memory ring buffer.
+ * Use it to decide things that should only follow the configured
+ * logging, like the verbosity of helper processes.
+ *
+ * Returns: whether messages of @level and @domain are passed on
+ *   to the logging backend.
+ **/
+gboolean
+nm_logging_backend_enabled (NMLogLevel level, NMLogDomain domain)
+{
+	return    (guint) level < G_N_ELEMENTS (_backend_enabled_state)
+	       && NM_FLAGS_ANY (_backend_enabled_state[level], domain);
+}
+
 /**
  * nm_logging_get_level:
  * @domain: find the lowest enabled logging level for the
@@ -537,11 +611,297 @@ nm_logging_get_level (NMLogDomain domain)
 
 	G_STATIC_ASSERT (LOGL_TRACE == 0);
 	while (   sl > LOGL_TRACE
-	       && nm_logging_enabled (sl - 1, domain))
+	       && NM_FLAGS_ANY (_backend_enabled_state[sl - 1], domain))
 		sl--;
 	return sl;
 }
 
+/*****************************************************************************/
+
+static RingRecord *
+_ring_record_reserve (NMLogLevel level, NMLogDomain domain, guint *out_seq)
+{
+	RingRecord *r;
+	guint seq;
+
+	nm_assert (ring.records);
+
+	seq = (guint) g_atomic_int_add (&ring.head, 1);
+	r = &ring.records[seq & (RING_N_RECORDS - 1)];
+
+	/* invalidate the slot before overwriting it, so that a concurrent reader
+	 * doesn't pick up a partially written record. */
+	g_atomic_int_set (&r->seq, 0);
+
+	r->level = level;
+	r->domain = domain;
+	r->timestamp_us = g_get_real_time ();
+	*out_seq = seq;
+	return r;
+}
+
+static void
+_ring_record_commit (RingRecord *r, guint seq)
+{
+	g_atomic_int_set (&r->seq, (gint) (seq + 1));
+}
+
+static void
+_ring_record_v (NMLogLevel level, NMLogDomain domain, const char *fmt, va_list args)
+{
+	RingRecord *r;
+	guint seq;
+
+	r = _ring_record_reserve (level, domain, &seq);
+	g_vsnprintf (r->msg, sizeof (r->msg), fmt, args);
+	_ring_record_commit (r, seq);
+}
+
+static void
+_ring_record_msg (NMLogLevel level, NMLogDomain domain, const char *msg)
+{
+	RingRecord *r;
+	guint seq;
+
+	r = _ring_record_reserve (level, domain, &seq);
+	g_strlcpy (r->msg, msg, sizeof (r->msg));
+	_ring_record_commit (r, seq);
+}
+
+/* The helpers below format a record without g_snprintf() and without
+ * allocating, so that they are async-signal-safe and can be used by
+ * _ring_crash_handler(). */
+
+static void
+_ring_fmt_str (char **p, char *end, const char *str, gsize min_width)
+{
+	gsize n = 0;
+
+	for (; *str && *p < end; str++, n++)
+		*((*p)++) = *str;
+	for (; n < min_width && *p < end; n++)
+		*((*p)++) = ' ';
+}
+
+static void
+_ring_fmt_uint (char **p, char *end, guint64 num, guint min_digits)
+{
+	char digits[21];
+	guint n = 0;
+
+	do {
+		digits[n++] = '0' + (num % 10);
+		num /= 10;
+	} while (num > 0 || n < min_digits);
+	while (n > 0 && *p < end)
+		*((*p)++) = digits[--n];
+}
+
+static gsize
+_ring_record_format (const RingRecord *r, char *buf, gsize buf_len)
+{
+	const LogDesc *diter;
+	const char *domain = "";
+	char *p = buf;
+	char *end = &buf[buf_len - 2];
+	guint64 ts = r->timestamp_us > 0 ? (guint64) r->timestamp_us : 0;
+
+	for (diter = &global.domain_desc[0]; diter->name; diter++) {
+		if (NM_FLAGS_ANY (r->domain, diter->num)) {
+			domain = diter->name;
+			break;
+		}
+	}
+
+	/* "%-7s [%lld.%04lld] [%s] %s\n". If the line is truncated,
+	 * still terminate it with a newline. */
+	_ring_fmt_str (&p, end, global.level_desc[r->level].level_str, 7);
+	_ring_fmt_str (&p, end, " [", 0);
+	_ring_fmt_uint (&p, end, ts / G_USEC_PER_SEC, 1);
+	_ring_fmt_str (&p, end, ".", 0);
+	_ring_fmt_uint (&p, end, (ts % G_USEC_PER_SEC) / 100, 4);
+	_ring_fmt_str (&p, end, "] [", 0);
+	_ring_fmt_str (&p, end, domain, 0);
+	_ring_fmt_str (&p, end, "] ", 0);
+	_ring_fmt_str (&p, end, r->msg, 0);
+	*(p++) = '\n';
+	*p = '\0';
+	return p - buf;
+}
+
+typedef void (*RingForeachFunc) (const char *line, gsize len, gpointer user_data);
+
+static void
+_ring_foreach (RingForeachFunc func, gpointer user_data)
+{
+	char line[RING_RECORD_SIZE + 64];
+	RingRecord r;
+	guint head, seq, n;
+
+	if (!ring.records)
+		return;
+
+	head = (guint) g_atomic_int_get (&ring.head);
+	n = MIN (head, (guint) RING_N_RECORDS);
+	for (seq = head - n; seq != head; seq++) {
+		const RingRecord *slot = &ring.records[seq & (RING_N_RECORDS - 1)];
+
+		if ((guint) g_atomic_int_get (&slot->seq) != seq + 1)
+			continue;
+		memcpy (&r, (const void *) slot, sizeof (r));
+		if ((guint) g_atomic_int_get (&slot->seq) != seq + 1) {
+			/* the record got overwritten while we were copying it. */
+			continue;
+		}
+		r.msg[sizeof (r.msg) - 1] = '\0';
+		func (line, _ring_record_format (&r, line, sizeof (line)), user_data);
+	}
+}
+
+static void
+_ring_dump_to_gstring (const char *line, gsize len, gpointer user_data)
+{
+	g_string_append_len (user_data, line, len);
+}
+
+/**
+ * nm_logging_ring_dump:
+ *
+ * Returns: (transfer full): the content of the in-memory ring
+ *   buffer, formatted as text with one line per message (oldest first).
+ *   The string is empty if the ring buffer is not enabled.
+ */
+char *
+nm_logging_ring_dump (void)
+{
+	GString *str;
+
+	str = g_string_sized_new (ring.records ? RING_N_RECORDS * 100 : 0);
+	_ring_foreach (_ring_dump_to_gstring, str);
+	return g_string_free (str, FALSE);
+}
+
+static void
+_ring_dump_to_fd (const char *line, gsize len, gpointer user_data)
+{
+	int fd = GPOINTER_TO_INT (user_data);
+
+	while (len > 0) {
+		ssize_t n;
+
+		n = write (fd, line, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return;
+		}
+		line += n;
+		len -= n;
+	}
+}
+
+static void
+_ring_crash_handler (int signo)
+{
+	static const char header[] = "NetworkManager: fatal signal, dumping log ring buffer:\n";
+
+	/* only write() and the allocation-free formatting of _ring_record_format()
+	 * are used here, both are async-signal-safe. */
+	_ring_dump_to_fd (header, sizeof (header) - 1, GINT_TO_POINTER (STDERR_FILENO));
+	_ring_foreach (_ring_dump_to_fd, GINT_TO_POINTER (STDERR_FILENO));
+
+	/* the handler was reset to SIG_DFL (SA_RESETHAND). Re-raise the signal
+	 * to terminate (and dump core) as usual. */
+	raise (signo);
+}
+
+static void
+_ring_crash_handler_install (void)
+{
+	struct sigaction sa = {
+		.sa_handler = _ring_crash_handler,
+		.sa_flags = SA_RESETHAND | SA_NODEFER,
+	};
+	const int signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+	int i;
+
+	if (ring.crash_handler_installed)
+		return;
+	ring.crash_handler_installed = TRUE;
+
+	sigemptyset (&sa.sa_mask);
+	for (i = 0; i < G_N_ELEMENTS (signals); i++)
+		sigaction (signals[i], &sa, NULL);
+}
+
+/**
+ * nm_logging_ring_setup:
+ * @level: the level starting from which messages of all domains are
+ *   recorded in the ring buffer, or "OFF" to disable it.
+ * @error: (allow-none): return location for a #GError
+ *
+ * The ring buffer records messages in memory, independently of what
+ * is configured via nm_logging_setup(). It allows to keep verbose
+ * logging enabled at all times and fetch the messages only when
+ * something went wrong, via nm_logging_ring_dump() or when the
+ * process crashes.
+ *
+ * As with nm_logging_setup(), the VPN_PLUGIN domain is not recorded
+ * at DEBUG and TRACE level, because it may expose sensitive data.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nm_logging_ring_setup (const char *level, GError **error)
+{
+	NMLogLevel new_log_level;
+	gboolean had_platform_debug;
+	int i;
+
+	g_return_val_if_fail (!error || !*error, FALSE);
+
+	if (!level || !*level)
+		new_log_level = _LOGL_OFF;
+	else if (!match_log_level (level, &new_log_level, error))
+		return FALSE;
+
+	if (new_log_level == _LOGL_KEEP)
+		return TRUE;
+
+	if (   new_log_level != _LOGL_OFF
+	    && !ring.records) {
+		/* never freed, see _ring_foreach(). */
+		ring.records = g_new0 (RingRecord, RING_N_RECORDS);
+		_ring_crash_handler_install ();
+	}
+
+	had_platform_debug = nm_logging_enabled (LOGL_DEBUG, LOGD_PLATFORM);
+
+	ring.log_level = new_log_level;
+	for (i = 0; i < G_N_ELEMENTS (ring.enabled_state); i++) {
+		if (i < new_log_level)
+			ring.enabled_state[i] = 0;
+		else if (i < LOGL_INFO)
+			ring.enabled_state[i] = LOGD_ALL & ~LOGD_VPN_PLUGIN;
+		else
+			ring.enabled_state[i] = LOGD_ALL;
+	}
+	_enabled_state_update ();
+
+	if (   had_platform_debug
+	    && _nm_logging_clear_platform_logging_cache
+	    && !nm_logging_enabled (LOGL_DEBUG, LOGD_PLATFORM))
+		_nm_logging_clear_platform_logging_cache ();
+
+	return TRUE;
+}
+
+const char *
+nm_logging_ring_level_to_string (void)
+{
+	return global.level_desc[ring.log_level].name;
+}
+
 #if SYSTEMD_JOURNAL
 static void
 _iovec_set (struct iovec *iov, const void *str, gsize len)
@@ -619,10 +979,23 @@ _nm_log_impl (const char *file,
 		errno = error;
 	}
 
+	if (!(_backend_enabled_state[level] & domain)) {
+		/* only the ring buffer wants the message. Format it right into
+		 * its slot, without allocating. */
+		va_start (args, fmt);
+		_ring_record_v (level, domain, fmt, args);
+		va_end (args);
+		errno = errno_saved;
+		return;
+	}
+
 	va_start (args, fmt);
 	msg = g_strdup_vprintf (fmt, args);
 	va_end (args);
 
+	if (ring.enabled_state[level] & domain)
+		_ring_record_msg (level, domain, msg);
+
 #define MESSAGE_FMT "%s%-7s [%ld.%04ld] %s"
 #define MESSAGE_ARG(global, tv, msg) \
     (global).prefix, \
@@ -660,7 +1033,7 @@ _nm_log_impl (const char *file,
 				int i_domain = _NUM_MAX_FIELDS_SYSLOG_FACILITY;
 				const char *s_domain_1 = NULL;
 				NMLogDomain dom_all = domain;
-				NMLogDomain dom = dom_all & _nm_logging_enabled_state[level];
+				NMLogDomain dom = dom_all & _backend_enabled_state[level];
 
 				for (diter = &global.domain_desc[0]; diter->name; diter++) {
 					if (!NM_FLAGS_HAS (dom_all, diter->num))
@@ -213,6 +213,8 @@ nm_logging_enabled (NMLogLevel level, NMLogDomain domain)
 	       && !!(_nm_logging_enabled_state[level] & domain);
 }
 
+gboolean nm_logging_backend_enabled (NMLogLevel level, NMLogDomain domain);
+
 NMLogLevel nm_logging_get_level (NMLogDomain domain);
 
 const char *nm_logging_all_levels_to_string (void);
@@ -229,6 +231,10 @@ void nm_logging_set_prefix (const char *format, ...) _nm_printf (1, 2);
 void     nm_logging_syslog_openlog (const char *logging_backend, gboolean debug);
 gboolean nm_logging_syslog_enabled (void);
 
+gboolean    nm_logging_ring_setup (const char *level, GError **error);
+const char *nm_logging_ring_level_to_string (void);
+char       *nm_logging_ring_dump (void);
+
 /*****************************************************************************/
 
 /* This is the default definition of _NMLOG_ENABLED(). Special implementations
@@ -118,6 +118,17 @@ typedef struct {
 	NMMetered metered;
 
 	GSList *devices;
+
+	/* Lookup indexes for @devices. @devices stays the authoritative list
+	 * and keeps the order in which devices are exported on D-Bus. */
+	struct {
+		GHashTable *entries;     /* NMDevice -> DeviceIdxEntry */
+		GHashTable *by_ifindex;  /* ifindex -> NMDevice */
+		GHashTable *by_iface;    /* char *iface -> GSList of NMDevice */
+		GHashTable *by_ip_iface; /* char *ip_iface -> GSList of NMDevice */
+		GHashTable *by_path;     /* char *dbus-path -> NMDevice */
+	} device_idx;
+
 	NMState state;
 	NMConfig *config;
 	NMConnectivityState connectivity_state;
@@ -502,6 +513,26 @@ _get_activatable_connections_filter (NMSettings *settings,
 	return !active_connection_find_first (user_data, connection, NULL, NM_ACTIVE_CONNECTION_STATE_DEACTIVATING);
 }
 
+/**
+ * nm_manager_is_connection_activatable:
+ * @manager: the #NMManager
+ * @connection: the #NMSettingsConnection
+ *
+ * Returns: %TRUE if @connection would be part of the list returned by
+ *   nm_manager_get_activatable_connections(), that is, it is neither
+ *   volatile nor already active.
+ */
+gboolean
+nm_manager_is_connection_activatable (NMManager *manager, NMSettingsConnection *connection)
+{
+	g_return_val_if_fail (NM_IS_MANAGER (manager), FALSE);
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (connection), FALSE);
+
+	return _get_activatable_connections_filter (NM_MANAGER_GET_PRIVATE (manager)->settings,
+	                                            connection,
+	                                            manager);
+}
+
 /* Filter out connections that are already active.
  * nm_settings_get_connections_sorted() returns sorted list. We need to preserve the
  * order so that we didn't change auto-activation order (recent timestamps
@@ -651,32 +682,177 @@ impl_manager_reload (NMManager *self,
 
 /*****************************************************************************/
 
+/* The device index remembers for each device the keys under which it is
+ * currently indexed. It is updated when a device is added or removed and
+ * whenever the device notifies a change of its ifindex or interface names.
+ * As notifications can be frozen while a device realizes, lookups always
+ * verify a hit against the device's current value. */
+typedef struct {
+	int ifindex;
+	char *iface;
+	char *ip_iface;
+	char *path;
+} DeviceIdxEntry;
+
+static void
+_device_idx_list_add (GHashTable *table, const char *key, NMDevice *device)
+{
+	GSList *list;
+
+	list = g_hash_table_lookup (table, key);
+	if (list) {
+		/* appending to a non-empty list keeps the head unchanged */
+		list = g_slist_append (list, device);
+		nm_assert (list == g_hash_table_lookup (table, key));
+	} else
+		g_hash_table_insert (table, g_strdup (key), g_slist_prepend (NULL, device));
+}
+
+static void
+_device_idx_list_remove (GHashTable *table, const char *key, NMDevice *device)
+{
+	GSList *list, *list_new;
+
+	list = g_hash_table_lookup (table, key);
+	if (!list)
+		return;
+
+	list_new = g_slist_remove (list, device);
+	if (!list_new)
+		g_hash_table_remove (table, key);
+	else if (list_new != list)
+		g_hash_table_insert (table, g_strdup (key), list_new);
+}
+
+static void
+_device_idx_update_str (GHashTable *table, char **p_key, const char *key, NMDevice *device)
+{
+	if (nm_streq0 (*p_key, key))
+		return;
+
+	if (*p_key) {
+		_device_idx_list_remove (table, *p_key, device);
+		nm_clear_g_free (p_key);
+	}
+	if (key) {
+		_device_idx_list_add (table, key, device);
+		*p_key = g_strdup (key);
+	}
+}
+
+static void
+_device_idx_update (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceIdxEntry *entry;
+	int ifindex;
+	const char *path;
+
+	entry = g_hash_table_lookup (priv->device_idx.entries, device);
+	if (!entry)
+		return;
+
+	ifindex = nm_device_get_ifindex (device);
+	if (entry->ifindex != ifindex) {
+		if (   entry->ifindex > 0
+		    && g_hash_table_lookup (priv->device_idx.by_ifindex, GINT_TO_POINTER (entry->ifindex)) == device)
+			g_hash_table_remove (priv->device_idx.by_ifindex, GINT_TO_POINTER (entry->ifindex));
+		entry->ifindex = ifindex;
+		if (ifindex > 0)
+			g_hash_table_insert (priv->device_idx.by_ifindex, GINT_TO_POINTER (ifindex), device);
+	}
+
+	_device_idx_update_str (priv->device_idx.by_iface, &entry->iface, nm_device_get_iface (device), device);
+	_device_idx_update_str (priv->device_idx.by_ip_iface, &entry->ip_iface, nm_device_get_ip_iface (device), device);
+
+	path = nm_exported_object_get_path (NM_EXPORTED_OBJECT (device));
+	if (!nm_streq0 (entry->path, path)) {
+		if (   entry->path
+		    && g_hash_table_lookup (priv->device_idx.by_path, entry->path) == device)
+			g_hash_table_remove (priv->device_idx.by_path, entry->path);
+		g_free (entry->path);
+		entry->path = g_strdup (path);
+		if (path)
+			g_hash_table_insert (priv->device_idx.by_path, g_strdup (path), device);
+	}
+}
+
+static void
+_device_idx_add (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	nm_assert (!g_hash_table_contains (priv->device_idx.entries, device));
+
+	g_hash_table_insert (priv->device_idx.entries, device, g_slice_new0 (DeviceIdxEntry));
+	_device_idx_update (self, device);
+}
+
+static void
+_device_idx_remove (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceIdxEntry *entry;
+
+	entry = g_hash_table_lookup (priv->device_idx.entries, device);
+	if (!entry)
+		return;
+
+	if (   entry->ifindex > 0
+	    && g_hash_table_lookup (priv->device_idx.by_ifindex, GINT_TO_POINTER (entry->ifindex)) == device)
+		g_hash_table_remove (priv->device_idx.by_ifindex, GINT_TO_POINTER (entry->ifindex));
+	_device_idx_update_str (priv->device_idx.by_iface, &entry->iface, NULL, device);
+	_device_idx_update_str (priv->device_idx.by_ip_iface, &entry->ip_iface, NULL, device);
+	if (   entry->path
+	    && g_hash_table_lookup (priv->device_idx.by_path, entry->path) == device)
+		g_hash_table_remove (priv->device_idx.by_path, entry->path);
+	g_free (entry->path);
+
+	g_hash_table_remove (priv->device_idx.entries, device);
+	g_slice_free (DeviceIdxEntry, entry);
+}
+
+static const GSList *
+_device_idx_lookup_iface (NMManager *self, const char *iface)
+{
+	return g_hash_table_lookup (NM_MANAGER_GET_PRIVATE (self)->device_idx.by_iface, iface);
+}
+
 NMDevice *
 nm_manager_get_device_by_path (NMManager *manager, const char *path)
 {
-	GSList *iter;
+	NMDevice *device;
 
 	g_return_val_if_fail (path != NULL, NULL);
 
-	for (iter = NM_MANAGER_GET_PRIVATE (manager)->devices; iter; iter = iter->next) {
-		if (!strcmp (nm_exported_object_get_path (NM_EXPORTED_OBJECT (iter->data)), path))
-			return NM_DEVICE (iter->data);
-	}
+	device = g_hash_table_lookup (NM_MANAGER_GET_PRIVATE (manager)->device_idx.by_path, path);
+	if (   device
+	    && nm_streq0 (nm_exported_object_get_path (NM_EXPORTED_OBJECT (device)), path))
+		return device;
 	return NULL;
 }
 
 NMDevice *
 nm_manager_get_device_by_ifindex (NMManager *manager, int ifindex)
 {
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (manager);
+	NMDevice *device;
 	GSList *iter;
 
-	for (iter = NM_MANAGER_GET_PRIVATE (manager)->devices; iter; iter = iter->next) {
-		NMDevice *device = NM_DEVICE (iter->data);
-
-		if (nm_device_get_ifindex (device) == ifindex)
-			return device;
+	if (ifindex <= 0) {
+		/* not indexed. Only unrealized devices have no ifindex. */
+		for (iter = priv->devices; iter; iter = iter->next) {
+			device = NM_DEVICE (iter->data);
+			if (nm_device_get_ifindex (device) == ifindex)
+				return device;
+		}
+		return NULL;
 	}
 
+	device = g_hash_table_lookup (priv->device_idx.by_ifindex, GINT_TO_POINTER (ifindex));
+	if (   device
+	    && nm_device_get_ifindex (device) == ifindex)
+		return device;
 	return NULL;
 }
 
@@ -701,11 +877,12 @@ find_device_by_permanent_hw_addr (NMManager *manager, const char *hwaddr)
 static NMDevice *
 find_device_by_ip_iface (NMManager *self, const gchar *iface)
 {
-	GSList *iter;
+	const GSList *iter;
 
 	g_return_val_if_fail (iface != NULL, NULL);
 
-	for (iter = NM_MANAGER_GET_PRIVATE (self)->devices; iter; iter = g_slist_next (iter)) {
+	iter = g_hash_table_lookup (NM_MANAGER_GET_PRIVATE (self)->device_idx.by_ip_iface, iface);
+	for (; iter; iter = g_slist_next (iter)) {
 		NMDevice *candidate = iter->data;
 
 		if (   nm_device_is_real (candidate)
@@ -736,13 +913,12 @@ find_device_by_iface (NMManager *self,
                       NMConnection *connection,
                       NMConnection *slave)
 {
-	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDevice *fallback = NULL;
-	GSList *iter;
+	const GSList *iter;
 
 	g_return_val_if_fail (iface != NULL, NULL);
 
-	for (iter = priv->devices; iter; iter = iter->next) {
+	for (iter = _device_idx_lookup_iface (self, iface); iter; iter = iter->next) {
 		NMDevice *candidate = iter->data;
 
 		if (strcmp (nm_device_get_iface (candidate), iface))
@@ -1058,6 +1234,7 @@ remove_device (NMManager *self,
 
 	nm_settings_device_removed (priv->settings, device, quitting);
 	priv->devices = g_slist_remove (priv->devices, device);
+	_device_idx_remove (self, device);
 
 	_parent_notify_changed (self, device, TRUE);
 
@@ -1983,6 +2160,7 @@ device_ifindex_changed (NMDevice *device,
                         GParamSpec *pspec,
                         NMManager *self)
 {
+	_device_idx_update (self, device);
 	_parent_notify_changed (self, device, FALSE);
 }
 
@@ -1992,14 +2170,19 @@ device_ip_iface_changed (NMDevice *device,
                          NMManager *self)
 {
 	const char *ip_iface = nm_device_get_ip_iface (device);
-	GSList *iter;
+	const GSList *iter;
+
+	_device_idx_update (self, device);
+
+	if (!ip_iface)
+		return;
 
 	/* Remove NMDevice objects that are actually child devices of others,
 	 * when the other device finally knows its IP interface name.  For example,
 	 * remove the PPP interface that's a child of a WWAN device, since it's
 	 * not really a standalone NMDevice.
 	 */
-	for (iter = NM_MANAGER_GET_PRIVATE (self)->devices; iter; iter = iter->next) {
+	for (iter = _device_idx_lookup_iface (self, ip_iface); iter; iter = iter->next) {
 		NMDevice *candidate = NM_DEVICE (iter->data);
 
 		if (   candidate != device
@@ -2016,6 +2199,8 @@ device_iface_changed (NMDevice *device,
                       GParamSpec *pspec,
                       NMManager *self)
 {
+	_device_idx_update (self, device);
+
 	/* Virtual connections may refer to the new device name as
 	 * parent device, retry to activate them.
 	 */
@@ -2137,6 +2322,7 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 	g_slist_free (remove);
 
 	priv->devices = g_slist_append (priv->devices, g_object_ref (device));
+	_device_idx_add (self, device);
 
 	g_signal_connect (device, NM_DEVICE_STATE_CHANGED,
 	                  G_CALLBACK (manager_device_state_changed),
@@ -2204,6 +2390,7 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 	                               manager_sleeping (self));
 
 	dbus_path = nm_exported_object_export (NM_EXPORTED_OBJECT (device));
+	_device_idx_update (self, device);
 	_LOG2I (LOGD_DEVICE, device, "new %s device (%s)", type_desc, dbus_path);
 
 	nm_settings_device_added (priv->settings, device);
@@ -2291,6 +2478,7 @@ platform_link_added (NMManager *self,
 {
 	NMDeviceFactory *factory;
 	NMDevice *device = NULL;
+	gs_free_slist GSList *candidates = NULL;
 	GSList *iter;
 
 	g_return_if_fail (ifindex > 0);
@@ -2298,8 +2486,10 @@ platform_link_added (NMManager *self,
 	if (nm_manager_get_device_by_ifindex (self, ifindex))
 		return;
 
-	/* Let unrealized devices try to realize themselves with the link */
-	for (iter = NM_MANAGER_GET_PRIVATE (self)->devices; iter; iter = iter->next) {
+	/* Let unrealized devices try to realize themselves with the link. Iterate
+	 * a copy, because realizing a device updates the index. */
+	candidates = g_slist_copy ((GSList *) _device_idx_lookup_iface (self, plink->name));
+	for (iter = candidates; iter; iter = iter->next) {
 		NMDevice *candidate = iter->data;
 		gboolean compatible = TRUE;
 		gs_free_error GError *error = NULL;
@@ -2320,6 +2510,7 @@ platform_link_added (NMManager *self,
 		                                    NM_UNMAN_FLAG_OP_FORGET,
 		                                    &compatible,
 		                                    &error)) {
+			_device_idx_update (self, candidate);
 			_device_realize_finish (self, candidate, plink);
 			return;
 		}
@@ -2438,7 +2629,8 @@ _platform_link_cb_idle (PlatformLinkCbData *data)
 					_LOG2W (LOGD_DEVICE, device, "failed to unrealize: %s", error->message);
 					g_clear_error (&error);
 					remove_device (self, device, FALSE, TRUE);
-				}
+				} else
+					_device_idx_update (self, device);
 			} else {
 				/* Hardware and external devices always get removed when their kernel link is gone */
 				remove_device (self, device, FALSE, TRUE);
@@ -4942,6 +5134,26 @@ impl_manager_get_logging (NMManager *manager,
 	                                                      nm_logging_domains_to_string ()));
 }
 
+static void
+impl_manager_get_log_buffer (NMManager *self,
+                             GDBusMethodInvocation *context)
+{
+	gs_free char *log = NULL;
+
+	/* The buffer may contain verbose messages that the regular log doesn't,
+	 * so it's root-only just like SetLogging. */
+	if (!nm_bus_manager_ensure_uid (nm_bus_manager_get (),
+	                                context,
+	                                G_MAXULONG,
+	                                NM_MANAGER_ERROR,
+	                                NM_MANAGER_ERROR_PERMISSION_DENIED))
+		return;
+
+	log = nm_logging_ring_dump ();
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(s)", log));
+}
+
 typedef struct {
 	guint remaining;
 	GDBusMethodInvocation *context;
@@ -6110,6 +6322,12 @@ nm_manager_init (NMManager *self)
 
 	priv->capabilities = g_array_new (FALSE, FALSE, sizeof (guint32));
 
+	priv->device_idx.entries = g_hash_table_new (NULL, NULL);
+	priv->device_idx.by_ifindex = g_hash_table_new (NULL, NULL);
+	priv->device_idx.by_iface = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->device_idx.by_ip_iface = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->device_idx.by_path = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
 	/* Initialize rfkill structures and states */
 	memset (priv->radio_states, 0, sizeof (priv->radio_states));
 
@@ -6425,6 +6643,13 @@ finalize (GObject *object)
 
 	g_array_free (priv->capabilities, TRUE);
 
+	nm_assert (g_hash_table_size (priv->device_idx.entries) == 0);
+	g_hash_table_unref (priv->device_idx.entries);
+	g_hash_table_unref (priv->device_idx.by_ifindex);
+	g_hash_table_unref (priv->device_idx.by_iface);
+	g_hash_table_unref (priv->device_idx.by_ip_iface);
+	g_hash_table_unref (priv->device_idx.by_path);
+
 	G_OBJECT_CLASS (nm_manager_parent_class)->finalize (object);
 }
 
@@ -6680,6 +6905,7 @@ nm_manager_class_init (NMManagerClass *manager_class)
 	                                        "GetPermissions", impl_manager_get_permissions,
 	                                        "SetLogging", impl_manager_set_logging,
 	                                        "GetLogging", impl_manager_get_logging,
+	                                        "GetLogBuffer", impl_manager_get_log_buffer,
 	                                        "CheckConnectivity", impl_manager_check_connectivity,
 	                                        "state", impl_manager_get_state,
 	                                        "CheckpointCreate", impl_manager_checkpoint_create,
@@ -87,6 +87,8 @@ const GSList *nm_manager_get_active_connections        (NMManager *manager);
 NMSettingsConnection **nm_manager_get_activatable_connections (NMManager *manager,
                                                                guint *out_len,
                                                                gboolean sort);
+gboolean nm_manager_is_connection_activatable (NMManager *manager,
+                                               NMSettingsConnection *connection);
 
 void          nm_manager_write_device_state (NMManager *manager);
 
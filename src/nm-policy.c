@@ -70,6 +70,15 @@ typedef struct {
 
 	GHashTable *devices;
 
+	/* Index of the settings connections by their connection.interface-name.
+	 * A connection that has an interface-name can only autoconnect on the
+	 * device with that name, so auto_activate_device() only needs to
+	 * consider the connections without interface-name plus those locked
+	 * to the device. */
+	GHashTable *connections_by_ifname;  /* char *ifname -> set of NMSettingsConnection */
+	GHashTable *connections_any_ifname; /* set of NMSettingsConnection */
+	GHashTable *connection_ifnames;     /* NMSettingsConnection -> char *ifname or NULL */
+
 	GSList *pending_secondaries;
 
 	NMSettings *settings;
@@ -1081,6 +1090,111 @@ activate_data_free (ActivateData *data)
 	g_slice_free (ActivateData, data);
 }
 
+/*****************************************************************************/
+
+static void
+_connection_ifname_index_remove (NMPolicy *self, NMSettingsConnection *connection)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	gpointer ifname;
+	GHashTable *set;
+
+	if (!g_hash_table_lookup_extended (priv->connection_ifnames, connection, NULL, &ifname))
+		return;
+
+	if (ifname) {
+		set = g_hash_table_lookup (priv->connections_by_ifname, ifname);
+		if (set) {
+			g_hash_table_remove (set, connection);
+			if (g_hash_table_size (set) == 0)
+				g_hash_table_remove (priv->connections_by_ifname, ifname);
+		}
+	} else
+		g_hash_table_remove (priv->connections_any_ifname, connection);
+
+	/* frees @ifname */
+	g_hash_table_remove (priv->connection_ifnames, connection);
+}
+
+static void
+_connection_ifname_index_update (NMPolicy *self, NMSettingsConnection *connection)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	const char *ifname;
+	gpointer old_ifname;
+	GHashTable *set;
+
+	ifname = nm_connection_get_interface_name (NM_CONNECTION (connection));
+
+	if (g_hash_table_lookup_extended (priv->connection_ifnames, connection, NULL, &old_ifname)) {
+		if (nm_streq0 (old_ifname, ifname))
+			return;
+		_connection_ifname_index_remove (self, connection);
+	}
+
+	if (ifname) {
+		set = g_hash_table_lookup (priv->connections_by_ifname, ifname);
+		if (!set) {
+			set = g_hash_table_new (NULL, NULL);
+			g_hash_table_insert (priv->connections_by_ifname, g_strdup (ifname), set);
+		}
+		g_hash_table_add (set, connection);
+	} else
+		g_hash_table_add (priv->connections_any_ifname, connection);
+
+	g_hash_table_insert (priv->connection_ifnames, connection, g_strdup (ifname));
+}
+
+static void
+_autoconnect_candidates_append (NMPolicy *self, GPtrArray *candidates, GHashTable *set)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	GHashTableIter h_iter;
+	NMSettingsConnection *connection;
+
+	if (!set)
+		return;
+
+	g_hash_table_iter_init (&h_iter, set);
+	while (g_hash_table_iter_next (&h_iter, (gpointer *) &connection, NULL)) {
+		if (nm_manager_is_connection_activatable (priv->manager, connection))
+			g_ptr_array_add (candidates, connection);
+	}
+}
+
+/* Like nm_manager_get_activatable_connections() with sorting, but restricted
+ * to connections that are not locked to a different interface than @device. */
+static NMSettingsConnection **
+_get_autoconnect_candidates (NMPolicy *self, NMDevice *device, guint *out_len)
+{
+	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	const char *iface;
+	GHashTable *by_ifname = NULL;
+	GPtrArray *candidates;
+	guint len;
+
+	iface = nm_device_get_iface (device);
+	if (iface)
+		by_ifname = g_hash_table_lookup (priv->connections_by_ifname, iface);
+
+	candidates = g_ptr_array_sized_new (  g_hash_table_size (priv->connections_any_ifname)
+	                                    + (by_ifname ? g_hash_table_size (by_ifname) : 0)
+	                                    + 1);
+	_autoconnect_candidates_append (self, candidates, priv->connections_any_ifname);
+	_autoconnect_candidates_append (self, candidates, by_ifname);
+
+	len = candidates->len;
+	if (len > 1)
+		g_qsort_with_data (candidates->pdata, len, sizeof (gpointer), nm_settings_connection_cmp_autoconnect_priority_p_with_data, NULL);
+	g_ptr_array_add (candidates, NULL);
+
+	_LOGT (LOGD_DEVICE, "auto-activate: %u of %u connections are candidates for device %s",
+	       len, g_hash_table_size (priv->connection_ifnames), iface ?: "(null)");
+
+	*out_len = len;
+	return (NMSettingsConnection **) g_ptr_array_free (candidates, FALSE);
+}
+
 static void
 auto_activate_device (NMPolicy *self,
                       NMDevice *device)
@@ -1103,7 +1217,7 @@ auto_activate_device (NMPolicy *self,
 	if (nm_device_get_act_request (device))
 		return;
 
-	connections = nm_manager_get_activatable_connections (priv->manager, &len, TRUE);
+	connections = _get_autoconnect_candidates (self, device, &len);
 	if (!connections[0])
 		return;
 
@@ -2059,6 +2173,7 @@ connection_added (NMSettings *settings,
 	NMPolicyPrivate *priv = user_data;
 	NMPolicy *self = _PRIV_TO_SELF (priv);
 
+	_connection_ifname_index_update (self, connection);
 	schedule_activate_all (self);
 }
 
@@ -2149,6 +2264,7 @@ connection_updated (NMSettings *settings,
 		nm_settings_connection_reset_autoconnect_retries (connection);
 	}
 
+	_connection_ifname_index_update (self, connection);
 	schedule_activate_all (self);
 }
 
@@ -2186,6 +2302,7 @@ connection_removed (NMSettings *settings,
 {
 	NMPolicyPrivate *priv = user_data;
 
+	_connection_ifname_index_remove (_PRIV_TO_SELF (priv), connection);
 	_deactivate_if_active (priv->manager, connection);
 }
 
@@ -2328,6 +2445,9 @@ nm_policy_init (NMPolicy *self)
 		priv->hostname_mode = NM_POLICY_HOSTNAME_MODE_FULL;
 
 	priv->devices = g_hash_table_new (NULL, NULL);
+	priv->connections_by_ifname = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+	priv->connections_any_ifname = g_hash_table_new (NULL, NULL);
+	priv->connection_ifnames = g_hash_table_new_full (NULL, NULL, NULL, g_free);
 	priv->ip6_prefix_delegations = g_array_new (FALSE, FALSE, sizeof (IP6PrefixDelegation));
 	g_array_set_clear_func (priv->ip6_prefix_delegations, clear_ip6_prefix_delegation);
 }
@@ -2337,7 +2457,9 @@ constructed (GObject *object)
 {
 	NMPolicy *self = NM_POLICY (object);
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
+	NMSettingsConnection *const*connections;
 	char *hostname = NULL;
+	guint i, len;
 
 	/* Grab hostname on startup and use that if nothing provides one */
 	if ((hostname = _get_hostname (self))) {
@@ -2377,6 +2499,10 @@ constructed (GObject *object)
 	g_signal_connect (priv->settings, NM_SETTINGS_SIGNAL_CONNECTION_VISIBILITY_CHANGED, (GCallback) connection_visibility_changed, priv);
 	g_signal_connect (priv->settings, NM_SETTINGS_SIGNAL_AGENT_REGISTERED,              (GCallback) secret_agent_registered, priv);
 
+	connections = nm_settings_get_connections (priv->settings, &len);
+	for (i = 0; i < len; i++)
+		_connection_ifname_index_update (self, connections[i]);
+
 	G_OBJECT_CLASS (nm_policy_parent_class)->constructed (object);
 
 	_LOGD (LOGD_DNS, "hostname-mode: %s", _hostname_mode_to_string (priv->hostname_mode));
@@ -2477,6 +2603,9 @@ finalize (GObject *object)
 	NMPolicyPrivate *priv = NM_POLICY_GET_PRIVATE (self);
 
 	g_hash_table_unref (priv->devices);
+	g_hash_table_unref (priv->connection_ifnames);
+	g_hash_table_unref (priv->connections_any_ifname);
+	g_hash_table_unref (priv->connections_by_ifname);
 
 	G_OBJECT_CLASS (nm_policy_parent_class)->finalize (object);
 
@@ -113,6 +113,9 @@ typedef struct {
 
 	/* a compare function for two routes that considers only the fields network/plen,metric. */
 	int (*route_id_cmp) (const NMPlatformIPXRoute *r1, const NMPlatformIPXRoute *r2);
+
+	/* lookup the visible platform route with the ID of @route, but on @ifindex and with @metric. */
+	const NMPlatformIPXRoute *(*plat_route_get) (NMPlatform *platform, int ifindex, const NMPlatformIPXRoute *route, guint32 metric);
 } VTableIP;
 
 static const VTableIP vtable_v4, vtable_v6;
@@ -306,55 +309,38 @@ _route_index_create (const VTableIP *vtable, const GArray *routes)
 	return index;
 }
 
-static RouteIndex *
-_route_index_create_from_platform (const VTableIP *vtable,
-                                   NMPlatform *platform,
-                                   int ifindex,
-                                   gboolean ignore_kernel_routes,
-                                   GPtrArray **out_storage)
+static const NMPlatformIPXRoute *
+_v4_plat_route_get (NMPlatform *platform, int ifindex, const NMPlatformIPXRoute *route, guint32 metric)
 {
-	RouteIndex *index;
-	guint i, j, len;
-	GPtrArray *storage;
-
-	nm_assert (out_storage && !*out_storage);
-
-	storage = nm_platform_lookup_route_visible_clone (platform,
-	                                                  vtable->vt->obj_type,
-	                                                  ifindex,
-	                                                  FALSE,
-	                                                  ignore_kernel_routes
-	                                                    ? nm_platform_lookup_predicate_routes_skip_rtprot_kernel
-	                                                    : NULL,
-	                                                  NULL);
-	if (!storage)
-		return _route_index_create (vtable, NULL);
-
-	len = storage->len;
-	index = g_malloc (sizeof (RouteIndex) + len * sizeof (NMPlatformIPXRoute *));
-
-	j = 0;
-	for (i = 0; i < len; i++) {
-		const NMPlatformIPXRoute *ipx_route = NMP_OBJECT_CAST_IPX_ROUTE (storage->pdata[i]);
-
-		if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (ipx_route))
-			continue;
+	return (const NMPlatformIPXRoute *) nm_platform_ip4_route_get (platform, ifindex, route->r4.network, route->rx.plen, metric);
+}
 
-		/* we cast away the const-ness of the NMPObjects. The caller must
-		 * ensure not to modify the object via index->entries. */
-		index->entries[j++] = (NMPlatformIPXRoute *) ipx_route;
-	}
-	index->entries[j] = NULL;
-	index->len = j;
+static const NMPlatformIPXRoute *
+_v6_plat_route_get (NMPlatform *platform, int ifindex, const NMPlatformIPXRoute *route, guint32 metric)
+{
+	return (const NMPlatformIPXRoute *) nm_platform_ip6_route_get (platform, ifindex, route->r6.network, route->rx.plen, metric);
+}
 
-	/* this is a stable sort, which is very important at this point. */
-	g_qsort_with_data (index->entries,
-	                   index->len,
-	                   sizeof (NMPlatformIPXRoute *),
-	                   (GCompareDataFunc) _route_index_create_sort,
-	                   (gpointer) vtable);
-	*out_storage = storage;
-	return index;
+/* Find the platform route that corresponds to @route on @ifindex with @metric.
+ *
+ * This is a lookup by ID in the platform cache, which is hashed. Thus, we
+ * don't need to fetch and sort all routes of the interface, which can be a
+ * lot on hosts that have a full routing table. */
+static const NMPlatformIPXRoute *
+_plat_route_get (const VTableIP *vtable, NMPlatform *platform, int ifindex, const NMPlatformIPXRoute *route, gint64 metric, gboolean ignore_kernel_routes)
+{
+	const NMPlatformIPXRoute *plat_route;
+
+	nm_assert (metric >= 0 && metric <= G_MAXUINT32);
+
+	plat_route = vtable->plat_route_get (platform, ifindex, route, metric);
+	if (   !plat_route
+	    || NM_PLATFORM_IP_ROUTE_IS_DEFAULT (plat_route))
+		return NULL;
+	if (   ignore_kernel_routes
+	    && plat_route->rx.rt_source == NM_IP_CONFIG_SOURCE_RTPROT_KERNEL)
+		return NULL;
+	return plat_route;
 }
 
 static int
@@ -392,6 +378,39 @@ _route_index_find (const VTableIP *vtable, const RouteIndex *index, const NMPlat
 	return ~idx;
 }
 
+static int
+_vx_route_dest_cmp_full (const NMPlatformIPXRoute *r1, const NMPlatformIPXRoute *r2, const VTableIP *vtable)
+{
+	return vtable->route_dest_cmp (r1, r2);
+}
+
+/* Returns whether @index contains a route on @ifindex with the same destination
+ * as @needle, which is configured with the same metric as @needle (according to
+ * @effective_metrics). */
+static gboolean
+_route_index_has_effective (const VTableIP *vtable, const RouteIndex *index, const gint64 *effective_metrics, int ifindex, const NMPlatformIPXRoute *needle)
+{
+	gssize idx;
+
+	/* @index is sorted by route_id_cmp(), which implies sorting by route_dest_cmp(). */
+	idx = _nm_utils_ptrarray_find_binary_search ((gconstpointer *) index->entries, index->len, needle, (GCompareDataFunc) _vx_route_dest_cmp_full, (gpointer) vtable);
+	if (idx < 0)
+		return FALSE;
+
+	while (   idx > 0
+	       && vtable->route_dest_cmp (index->entries[idx - 1], needle) == 0)
+		idx--;
+
+	for (; idx < index->len; idx++) {
+		if (vtable->route_dest_cmp (index->entries[idx], needle) != 0)
+			break;
+		if (   index->entries[idx]->rx.ifindex == ifindex
+		    && effective_metrics[idx] == needle->rx.metric)
+			return TRUE;
+	}
+	return FALSE;
+}
+
 static guint
 _route_index_reverse_idx (const VTableIP *vtable, const RouteIndex *index, guint idx_idx, const GArray *routes)
 {
@@ -412,6 +431,71 @@ _route_index_reverse_idx (const VTableIP *vtable, const RouteIndex *index, guint
 	return offset;
 }
 
+static guint *
+_route_index_positions (const VTableIP *vtable, const RouteIndex *index, const GArray *routes, const GArray *deleted, guint *out_len)
+{
+	gs_free guint *remap = NULL;
+	guint *positions;
+	guint i, j, n;
+
+	/* Return the entries of @index as positions into @routes, as they will be
+	 * after removing the (sorted) indexes @deleted from @routes. Removed entries
+	 * are dropped, the order of the others is preserved. */
+
+	nm_assert (index->len == routes->len);
+
+	remap = g_new (guint, index->len);
+	for (i = 0, j = 0, n = 0; i < index->len; i++) {
+		if (   deleted
+		    && j < deleted->len
+		    && g_array_index (deleted, guint, j) == i) {
+			remap[i] = G_MAXUINT;
+			j++;
+		} else
+			remap[i] = n++;
+	}
+
+	positions = g_new (guint, n + 1);
+	for (i = 0, n = 0; i < index->len; i++) {
+		guint p = remap[_route_index_reverse_idx (vtable, index, i, routes)];
+
+		if (p != G_MAXUINT)
+			positions[n++] = p;
+	}
+	*out_len = n;
+	return positions;
+}
+
+static RouteIndex *
+_route_index_merge (const VTableIP *vtable, const GArray *routes, const guint *positions, guint n_positions)
+{
+	RouteIndex *index;
+	guint len = routes->len;
+	guint i_old = 0, i_new = n_positions, n = 0;
+
+	/* Create the index for @routes, where @positions are the sorted positions of
+	 * the entries that were already indexed and the remaining ones were appended
+	 * to @routes in sorted order. Merging both is linear, so we don't have to
+	 * re-sort all entries like _route_index_create() does. On equal IDs the older
+	 * entry comes first, which is what the stable sort would do too. */
+
+	nm_assert (n_positions <= len);
+
+	index = g_malloc (sizeof (RouteIndex) + len * sizeof (NMPlatformIPXRoute *));
+	index->len = len;
+	while (i_old < n_positions || i_new < len) {
+		if (   i_old < n_positions
+		    && (   i_new >= len
+		        || vtable->route_id_cmp (VTABLE_ROUTE_INDEX (vtable, routes, positions[i_old]),
+		                                 VTABLE_ROUTE_INDEX (vtable, routes, i_new)) <= 0))
+			index->entries[n++] = VTABLE_ROUTE_INDEX (vtable, routes, positions[i_old++]);
+		else
+			index->entries[n++] = VTABLE_ROUTE_INDEX (vtable, routes, i_new++);
+	}
+	index->entries[n] = NULL;
+	return index;
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -481,21 +565,6 @@ _get_next_known_route (const VTableIP *vtable, const RouteIndex *index, gboolean
 	return NULL;
 }
 
-static const NMPlatformIPXRoute *
-_get_next_plat_route (const RouteIndex *index, gboolean start_at_zero, guint *cur_idx)
-{
-	if (start_at_zero)
-		*cur_idx = 0;
-	else
-		++*cur_idx;
-
-	/* get next route from the platform index. */
-	if (*cur_idx < index->len)
-		return index->entries[*cur_idx];
-	*cur_idx = index->len;
-	return NULL;
-}
-
 static int
 _sort_indexes_cmp (guint *a, guint *b)
 {
@@ -503,34 +572,47 @@ _sort_indexes_cmp (guint *a, guint *b)
 	g_return_val_if_reached (0);
 }
 
+static void
+_route_add_batch_append (const VTableIP *vtable, GArray *batch, const NMPlatformIPXRoute *route, int ifindex, gint64 metric)
+{
+	NMPlatformIPXRoute *r;
+
+	g_array_set_size (batch, batch->len + 1);
+	r = VTABLE_ROUTE_INDEX (vtable, batch, batch->len - 1);
+	memcpy (r, route, vtable->vt->sizeof_route);
+	if (ifindex > 0)
+		r->rx.ifindex = ifindex;
+	if (metric >= 0)
+		r->rx.metric = metric;
+}
+
 /*****************************************************************************/
 
 static gboolean
 _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const GArray *known_routes, gboolean ignore_kernel_routes, gboolean full_sync)
 {
 	NMRouteManagerPrivate *priv = NM_ROUTE_MANAGER_GET_PRIVATE (self);
-	gs_unref_ptrarray GPtrArray *plat_routes = NULL;
 	RouteEntries *ipx_routes;
-	RouteIndex *plat_routes_idx, *known_routes_idx;
+	RouteIndex *known_routes_idx;
 	gboolean success = TRUE;
 	guint i, i_type;
 	GArray *to_delete_indexes = NULL;
 	GPtrArray *to_add_routes = NULL;
-	guint i_known_routes, i_plat_routes, i_ipx_routes;
+	guint i_known_routes, i_ipx_routes;
 	const NMPlatformIPXRoute *cur_known_route, *cur_plat_route;
 	NMPlatformIPXRoute *cur_ipx_route;
 	gint64 *p_effective_metric = NULL;
 	gboolean ipx_routes_changed = FALSE;
 	gint64 *effective_metrics = NULL;
+	gs_unref_array GArray *to_add_batch = NULL;
 
 	nm_platform_process_events (priv->platform);
 
 	ipx_routes = vtable->vt->is_ip4 ? &priv->ip4_routes : &priv->ip6_routes;
 
-	/* the objects referenced by play_routes_idx are shared from the platform cache. They
-	 * must not be modified. */
-	plat_routes_idx = _route_index_create_from_platform (vtable, priv->platform, ifindex, ignore_kernel_routes, &plat_routes);
-
+	/* @known_routes is a fresh array from the caller on every sync, so it must be
+	 * sorted here. It only contains the routes configured for @ifindex, not the
+	 * routes in the kernel. */
 	known_routes_idx = _route_index_create (vtable, known_routes);
 
 	effective_metrics = &g_array_index (ipx_routes->effective_metrics, gint64, 0);
@@ -614,12 +696,9 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 		 * known by route-manager, and are now deleted.
 		 ***************************************************************************/
 
-		/* iterate over @to_delete_indexes and @plat_routes.
-		 * @to_delete_indexes contains the indexes (relative to ipx_routes->index) of items
+		/* @to_delete_indexes contains the indexes (relative to ipx_routes->index) of items
 		 * we are about to delete. */
-		cur_plat_route = _get_next_plat_route (plat_routes_idx, TRUE, &i_plat_routes);
 		for (i = 0; i < to_delete_indexes->len; i++) {
-			int route_dest_cmp_result = 0;
 			i_ipx_routes = g_array_index (to_delete_indexes, guint, i);
 			cur_ipx_route = ipx_routes->index->entries[i_ipx_routes];
 			p_effective_metric = &effective_metrics[i_ipx_routes];
@@ -629,25 +708,11 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 			if (*p_effective_metric == -1)
 				continue;
 
-			/* skip over @plat_routes that are ordered before our @cur_ipx_route. */
-			while (   cur_plat_route
-			       && (route_dest_cmp_result = vtable->route_dest_cmp (cur_plat_route, cur_ipx_route)) <= 0) {
-				if (   route_dest_cmp_result == 0
-				    && cur_plat_route->rx.metric >= *p_effective_metric)
-					break;
-				cur_plat_route = _get_next_plat_route (plat_routes_idx, FALSE, &i_plat_routes);
-			}
-
-			if (!cur_plat_route) {
-				/* no more platform routes. Break the loop. */
-				break;
-			}
-
-			if (   route_dest_cmp_result == 0
-			    && cur_plat_route->rx.metric == *p_effective_metric) {
+			cur_plat_route = _plat_route_get (vtable, priv->platform, ifindex, cur_ipx_route, *p_effective_metric, ignore_kernel_routes);
+			if (cur_plat_route) {
 				/* we are about to delete cur_ipx_route and we have a matching route
 				 * in platform. Delete it. */
-				_LOGt (vtable->vt->addr_family, "%3d: platform rt-rm #%u - %s", ifindex, i_plat_routes,
+				_LOGt (vtable->vt->addr_family, "%3d: platform rt-rm - %s", ifindex,
 				       vtable->vt->route_to_string (cur_plat_route, NULL, 0));
 				vtable->vt->route_delete (priv->platform, ifindex, cur_plat_route);
 			}
@@ -656,6 +721,9 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 
 	/* Update @ipx_routes with the just learned changes. */
 	if (to_delete_indexes || to_add_routes) {
+		gs_free guint *positions = NULL;
+		guint n_positions;
+
 		if (to_delete_indexes) {
 			for (i = 0; i < to_delete_indexes->len; i++) {
 				guint idx = g_array_index (to_delete_indexes, guint, i);
@@ -665,6 +733,14 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 				g_array_index (to_delete_indexes, guint, i) = _route_index_reverse_idx (vtable, ipx_routes->index, idx, ipx_routes->entries);
 			}
 			g_array_sort (to_delete_indexes, (GCompareFunc) _sort_indexes_cmp);
+		}
+
+		/* Removing and appending entries below invalidates the pointers in @ipx_routes->index.
+		 * Remember its order as positions into @ipx_routes->entries, so that afterwards we
+		 * only have to merge in the added routes instead of sorting all managed routes again. */
+		positions = _route_index_positions (vtable, ipx_routes->index, ipx_routes->entries, to_delete_indexes, &n_positions);
+
+		if (to_delete_indexes) {
 			nm_utils_array_remove_at_indexes (ipx_routes->entries, &g_array_index (to_delete_indexes, guint, 0), to_delete_indexes->len);
 			nm_utils_array_remove_at_indexes (ipx_routes->effective_metrics_reverse, &g_array_index (to_delete_indexes, guint, 0), to_delete_indexes->len);
 			g_array_unref (to_delete_indexes);
@@ -693,7 +769,7 @@ _vx_route_sync (const VTableIP *vtable, NMRouteManager *self, int ifindex, const
 			g_ptr_array_unref (to_add_routes);
 		}
 		g_free (ipx_routes->index);
-		ipx_routes->index = _route_index_create (vtable, ipx_routes->entries);
+		ipx_routes->index = _route_index_merge (vtable, ipx_routes->entries, positions, n_positions);
 		ipx_routes_changed = TRUE;
 		ASSERT_route_index_valid (vtable, ipx_routes->entries, ipx_routes->index, TRUE);
 	}
@@ -788,38 +864,30 @@ next:
 		 * the interface.
 		 ***************************************************************************/
 
-		/* iterate over @plat_routes and @ipx_routes */
-		cur_plat_route = _get_next_plat_route (plat_routes_idx, TRUE, &i_plat_routes);
-		cur_ipx_route = _get_next_ipx_route (ipx_routes->index, TRUE, &i_ipx_routes, ifindex);
-		if (cur_ipx_route)
-			p_effective_metric = &effective_metrics[i_ipx_routes];
-		while (cur_plat_route) {
-			int route_dest_cmp_result = 0;
+		gs_unref_ptrarray GPtrArray *plat_routes = NULL;
+
+		/* Iterate over all routes of @ifindex in platform and delete those, for which we
+		 * don't have a route with matching destination and effective metric. */
+		plat_routes = nm_platform_lookup_route_visible_clone (priv->platform,
+		                                                      vtable->vt->obj_type,
+		                                                      ifindex,
+		                                                      FALSE,
+		                                                      ignore_kernel_routes
+		                                                        ? nm_platform_lookup_predicate_routes_skip_rtprot_kernel
+		                                                        : NULL,
+		                                                      NULL);
+		for (i = 0; plat_routes && i < plat_routes->len; i++) {
+			cur_plat_route = NMP_OBJECT_CAST_IPX_ROUTE (plat_routes->pdata[i]);
+
+			if (NM_PLATFORM_IP_ROUTE_IS_DEFAULT (cur_plat_route))
+				continue;
 
 			g_assert (cur_plat_route->rx.ifindex == ifindex);
 
-			_LOGt (vtable->vt->addr_family, "%3d: platform rt    #%u - %s", ifindex, i_plat_routes, vtable->vt->route_to_string (cur_plat_route, NULL, 0));
-
-			/* skip over @cur_ipx_route that are ordered before @cur_plat_route */
-			while (   cur_ipx_route
-			       && ((route_dest_cmp_result = vtable->route_dest_cmp (cur_ipx_route, cur_plat_route)) <= 0)) {
-				if (   route_dest_cmp_result == 0
-				    && *p_effective_metric != -1
-				    && *p_effective_metric >= cur_plat_route->rx.metric) {
-					break;
-				}
-				cur_ipx_route = _get_next_ipx_route (ipx_routes->index, FALSE, &i_ipx_routes, ifindex);
-				if (cur_ipx_route)
-					p_effective_metric = &effective_metrics[i_ipx_routes];
-			}
+			_LOGt (vtable->vt->addr_family, "%3d: platform rt    #%u - %s", ifindex, i, vtable->vt->route_to_string (cur_plat_route, NULL, 0));
 
-			/* if @cur_ipx_route is not equal to @plat_route, the route must be deleted. */
-			if (   !cur_ipx_route
-			    || route_dest_cmp_result != 0
-			    || *p_effective_metric != cur_plat_route->rx.metric)
+			if (!_route_index_has_effective (vtable, ipx_routes->index, effective_metrics, ifindex, cur_plat_route))
 				vtable->vt->route_delete (priv->platform, ifindex, cur_plat_route);
-
-			cur_plat_route = _get_next_plat_route (plat_routes_idx, FALSE, &i_plat_routes);
 		}
 	}
 
@@ -837,6 +905,8 @@ next:
 	if (ipx_routes_changed) {
 		GArray *gateway_routes = NULL;
 
+		to_add_batch = g_array_new (FALSE, FALSE, vtable->vt->sizeof_route);
+
 		/* @effective_metrics_reverse contains the list of assigned metrics from the last
 		 * sync. Walk through it and see what changes there are (and possibly restore a
 		 * shadowed route).
@@ -890,34 +960,45 @@ next:
 					gateway_routes = g_array_new (FALSE, FALSE, sizeof (guint));
 				g_array_append_val (gateway_routes, i_ipx_routes);
 			} else
-				vtable->vt->route_add (priv->platform, 0, cur_ipx_route, *p_effective_metric);
+				_route_add_batch_append (vtable, to_add_batch, cur_ipx_route, 0, *p_effective_metric);
+		}
+
+		if (to_add_batch->len > 0) {
+			vtable->vt->route_add_batch (priv->platform, (const NMPlatformIPXRoute *) to_add_batch->data, to_add_batch->len, NULL);
+			g_array_set_size (to_add_batch, 0);
 		}
 
 		if (gateway_routes) {
 			for (i = 0; i < gateway_routes->len; i++) {
 				i_ipx_routes = g_array_index (gateway_routes, guint, i);
-				vtable->vt->route_add (priv->platform, 0,
-				                       ipx_routes->index->entries[i_ipx_routes],
-				                       effective_metrics[i_ipx_routes]);
+				_route_add_batch_append (vtable, to_add_batch,
+				                         ipx_routes->index->entries[i_ipx_routes],
+				                         0,
+				                         effective_metrics[i_ipx_routes]);
 			}
+			vtable->vt->route_add_batch (priv->platform, (const NMPlatformIPXRoute *) to_add_batch->data, to_add_batch->len, NULL);
+			g_array_set_size (to_add_batch, 0);
 			g_array_unref (gateway_routes);
 		}
 	}
 
 	/***************************************************************************
 	 * Sync @ipx_routes for @ifindex to platform
+	 *
+	 * The routes to add are collected and passed to platform as one batch per
+	 * type, so that we don't wait for kernel's reply after each route.
 	 **************************************************************************/
 
+	if (!to_add_batch)
+		to_add_batch = g_array_new (FALSE, FALSE, vtable->vt->sizeof_route);
+
 	for (i_type = 0; i_type < 2; i_type++) {
-		/* iterate (twice) over @ipx_routes and @plat_routes */
-		cur_plat_route = _get_next_plat_route (plat_routes_idx, TRUE, &i_plat_routes);
+		/* iterate (twice) over @ipx_routes */
 		cur_ipx_route = _get_next_ipx_route (ipx_routes->index, TRUE, &i_ipx_routes, ifindex);
 		/* Iterate here over @ipx_routes instead of @known_routes. That is done because
 		 * we need to know whether a route is shadowed by another route, and that
 		 * requires to look at @ipx_routes. */
 		for (; cur_ipx_route; cur_ipx_route = _get_next_ipx_route (ipx_routes->index, FALSE, &i_ipx_routes, ifindex)) {
-			int route_dest_cmp_result = -1;
-
 			if (   (i_type == 0 && !VTABLE_IS_DEVICE_ROUTE (vtable, cur_ipx_route))
 			    || (i_type == 1 && VTABLE_IS_DEVICE_ROUTE (vtable, cur_ipx_route))) {
 				/* Make two runs over the list of @ipx_routes. On the first, only add
@@ -932,34 +1013,36 @@ next:
 				continue;
 			}
 
-			/* skip over @plat_routes that are ordered before our @cur_ipx_route. */
-			while (   cur_plat_route
-			       && (route_dest_cmp_result = vtable->route_dest_cmp (cur_plat_route, cur_ipx_route)) <= 0) {
-				if (   route_dest_cmp_result == 0
-				    && cur_plat_route->rx.metric >= *p_effective_metric)
-					break;
-				cur_plat_route = _get_next_plat_route (plat_routes_idx, FALSE, &i_plat_routes);
-			}
-
-			/* only add the route if we don't have an identical route in @plat_routes,
+			/* only add the route if we don't have an identical route in platform,
 			 * i.e. if @cur_plat_route is different from @cur_ipx_route. */
+			cur_plat_route = _plat_route_get (vtable, priv->platform, ifindex, cur_ipx_route, *p_effective_metric, ignore_kernel_routes);
 			if (   !cur_plat_route
-			    || route_dest_cmp_result != 0
-			    || !_route_equals_ignoring_ifindex (vtable, cur_plat_route, cur_ipx_route, *p_effective_metric)) {
+			    || !_route_equals_ignoring_ifindex (vtable, cur_plat_route, cur_ipx_route, *p_effective_metric))
+				_route_add_batch_append (vtable, to_add_batch, cur_ipx_route, ifindex, *p_effective_metric);
+		}
+
+		if (to_add_batch->len > 0) {
+			gs_free gboolean *add_success = g_new (gboolean, to_add_batch->len);
+
+			if (!vtable->vt->route_add_batch (priv->platform, (const NMPlatformIPXRoute *) to_add_batch->data, to_add_batch->len, add_success)) {
+				for (i = 0; i < to_add_batch->len; i++) {
+					const NMPlatformIPXRoute *r = VTABLE_ROUTE_INDEX (vtable, to_add_batch, i);
 
-				if (!vtable->vt->route_add (priv->platform, ifindex, cur_ipx_route, *p_effective_metric)) {
-					if (cur_ipx_route->rx.rt_source < NM_IP_CONFIG_SOURCE_USER) {
+					if (add_success[i])
+						continue;
+					if (r->rx.rt_source < NM_IP_CONFIG_SOURCE_USER) {
 						_LOGD (vtable->vt->addr_family,
 						       "ignore error adding IPv%c route to kernel: %s",
 						       vtable->vt->is_ip4 ? '4' : '6',
-						       vtable->vt->route_to_string (cur_ipx_route, NULL, 0));
+						       vtable->vt->route_to_string (r, NULL, 0));
 					} else {
-						/* Remember that there was a failure, but for now continue trying
-						 * to sync the remaining routes. */
+						/* Remember that there was a failure, but continue
+						 * with the remaining routes. */
 						success = FALSE;
 					}
 				}
 			}
+			g_array_set_size (to_add_batch, 0);
 		}
 	}
 
@@ -967,7 +1050,6 @@ next:
 		g_signal_emit (self, signals[IP4_ROUTES_CHANGED], 0);
 
 	g_free (known_routes_idx);
-	g_free (plat_routes_idx);
 
 	return success;
 }
@@ -1237,12 +1319,14 @@ static const VTableIP vtable_v4 = {
 	.vt                             = &nm_platform_vtable_route_v4,
 	.route_dest_cmp                 = (int (*) (const NMPlatformIPXRoute *, const NMPlatformIPXRoute *)) _v4_route_dest_cmp,
 	.route_id_cmp                   = (int (*) (const NMPlatformIPXRoute *, const NMPlatformIPXRoute *)) _v4_route_id_cmp,
+	.plat_route_get                 = _v4_plat_route_get,
 };
 
 static const VTableIP vtable_v6 = {
 	.vt                             = &nm_platform_vtable_route_v6,
 	.route_dest_cmp                 = (int (*) (const NMPlatformIPXRoute *, const NMPlatformIPXRoute *)) _v6_route_dest_cmp,
 	.route_id_cmp                   = (int (*) (const NMPlatformIPXRoute *, const NMPlatformIPXRoute *)) _v6_route_id_cmp,
+	.plat_route_get                 = _v6_plat_route_get,
 };
 
 /*****************************************************************************/
@@ -26,6 +26,8 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <poll.h>
 #include <fcntl.h>
 #include <dlfcn.h>
 #include <arpa/inet.h>
@@ -49,6 +51,7 @@
 #include "nmp-netns.h"
 #include "nm-platform-utils.h"
 #include "nm-platform-private.h"
+#include "nmp-netlink.h"
 #include "wifi/wifi-utils.h"
 #include "wifi/wifi-utils-wext.h"
 #include "nm-utils/unaligned.h"
@@ -56,9 +59,13 @@
 
 #define VLAN_FLAG_MVRP 0x8
 
-/* nm-internal error codes for libnl. Make sure they don't overlap. */
-#define _NLE_NM_NOBUFS 500
-#define _NLE_MSG_TRUNC 501
+#ifndef SOL_NETLINK
+#define SOL_NETLINK 270
+#endif
+
+#ifndef NETLINK_GET_STRICT_CHK
+#define NETLINK_GET_STRICT_CHK 12
+#endif
 
 /*****************************************************************************/
 
@@ -262,6 +269,11 @@ static void cache_on_change (NMPlatform *platform,
                              const NMPObject *obj_new);
 static void cache_prune_all (NMPlatform *platform);
 static gboolean event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks);
+static gboolean _nl_dump_in_progress (NMPlatform *platform);
+static gboolean delayed_action_deferred_cb (gpointer user_data);
+
+/* how long to back off when the kernel is still busy with another dump. */
+#define RESYNC_RETRY_MS 100
 
 /*****************************************************************************/
 
@@ -1825,9 +1837,12 @@ errout:
 	return obj_result;
 }
 
-/* Copied and heavily modified from libnl3's rtnl_route_parse() and parse_multipath(). */
+/* Copied and heavily modified from libnl3's rtnl_route_parse() and parse_multipath().
+ *
+ * @ignore_protocols: (allow-none): an array of 256 booleans, indexed by
+ *   rtm_protocol. Routes of the protocols set in there are ignored. */
 static NMPObject *
-_new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
+_new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only, const bool *ignore_protocols)
 {
 	static struct nla_policy policy[RTA_MAX+1] = {
 		[RTA_IIF]       = { .type = NLA_U32 },
@@ -1868,6 +1883,17 @@ _new_from_nl_route (struct nlmsghdr *nlh, gboolean id_only)
 	if (rtm->rtm_type != RTN_UNICAST)
 		goto errout;
 
+	/* check what we can before parsing the attributes. On hosts with a full
+	 * routing table, most routes are dropped here. Tables with an id larger
+	 * than 255 are reported as RT_TABLE_COMPAT, their RTA_TABLE is checked
+	 * below. */
+	if (   ignore_protocols
+	    && ignore_protocols[rtm->rtm_protocol])
+		goto errout;
+
+	if (!NM_IN_SET (rtm->rtm_table, RT_TABLE_UNSPEC, RT_TABLE_MAIN, RT_TABLE_COMPAT))
+		goto errout;
+
 	err = nlmsg_parse (nlh, sizeof (struct rtmsg), tb, RTA_MAX, policy);
 	if (err < 0)
 		goto errout;
@@ -2065,33 +2091,31 @@ errout:
  *   If a cache is given, the object is completed with information from the cache.
  * @nlh: the netlink message header
  * @id_only: whether only to create an empty object with only the ID fields set.
+ * @route_ignore_protocols: (allow-none): see _new_from_nl_route().
  *
  * Returns: %NULL or a newly created NMPObject instance.
  **/
 static NMPObject *
-nmp_object_new_from_nl (NMPlatform *platform, const NMPCache *cache, struct nl_msg *msg, gboolean id_only)
+nmp_object_new_from_nl (NMPlatform *platform,
+                        const NMPCache *cache,
+                        struct nlmsghdr *nlh,
+                        gboolean id_only,
+                        const bool *route_ignore_protocols)
 {
-	struct nlmsghdr *msghdr;
-
-	if (nlmsg_get_proto (msg) != NETLINK_ROUTE)
-		return NULL;
-
-	msghdr = nlmsg_hdr (msg);
-
-	switch (msghdr->nlmsg_type) {
+	switch (nlh->nlmsg_type) {
 	case RTM_NEWLINK:
 	case RTM_DELLINK:
 	case RTM_GETLINK:
 	case RTM_SETLINK:
-		return _new_from_nl_link (platform, cache, msghdr, id_only);
+		return _new_from_nl_link (platform, cache, nlh, id_only);
 	case RTM_NEWADDR:
 	case RTM_DELADDR:
 	case RTM_GETADDR:
-		return _new_from_nl_addr (msghdr, id_only);
+		return _new_from_nl_addr (nlh, id_only);
 	case RTM_NEWROUTE:
 	case RTM_DELROUTE:
 	case RTM_GETROUTE:
-		return _new_from_nl_route (msghdr, id_only);
+		return _new_from_nl_route (nlh, id_only, route_ignore_protocols);
 	default:
 		return NULL;
 	}
@@ -2521,14 +2545,11 @@ static int _support_kernel_extended_ifa_flags = -1;
 #define _support_kernel_extended_ifa_flags_still_undecided() (G_UNLIKELY (_support_kernel_extended_ifa_flags == -1))
 
 static void
-_support_kernel_extended_ifa_flags_detect (struct nl_msg *msg)
+_support_kernel_extended_ifa_flags_detect (struct nlmsghdr *msg_hdr)
 {
-	struct nlmsghdr *msg_hdr;
-
 	if (!_support_kernel_extended_ifa_flags_still_undecided ())
 		return;
 
-	msg_hdr = nlmsg_hdr (msg);
 	if (msg_hdr->nlmsg_type != RTM_NEWADDR)
 		return;
 
@@ -2566,6 +2587,18 @@ typedef struct {
 	gint *out_refresh_all_in_progess;
 } DelayedActionWaitForNlResponseData;
 
+typedef struct _NetlinkThreadItem NetlinkThreadItem;
+
+struct _NetlinkThreadItem {
+	NetlinkThreadItem *next;
+	/* the result of nmp_netlink_recv(). Either the length of @buf or a
+	 * negative libnl error code. */
+	int n;
+	bool has_creds;
+	struct ucred creds;
+	guint8 buf[];
+};
+
 typedef struct {
 	struct nl_sock *nlh;
 	guint32 nlh_seq_next;
@@ -2576,11 +2609,65 @@ typedef struct {
 	GIOChannel *event_channel;
 	guint event_id;
 
+	/* receives from @nlh. Used by the reader thread if there is one,
+	 * otherwise by the main thread. */
+	NMPNetlinkRecvBuf *recv_buf;
+
+	/* whether the kernel accepted NETLINK_GET_STRICT_CHK. Then dump requests
+	 * are filtered by the kernel. */
+	bool nlh_strict_chk;
+
+	/* routes with these rtm_protocol values are not cached. */
+	bool route_ignore_protocols_any;
+	bool route_ignore_protocols[256];
+
+	/* with "netlink-thread", the event socket is drained by a dedicated
+	 * thread. The received buffers are handed over to the main thread
+	 * via a lock-free list and @event_channel watches @wakeup_fd instead
+	 * of the netlink socket. */
+	struct {
+		GThread *thread;
+		int wakeup_fd;
+		int stop_fd;
+		NetlinkThreadItem *pushed;  /* LIFO, pushed by the reader thread. */
+		NetlinkThreadItem *pending; /* FIFO, owned by the main thread. */
+		NetlinkThreadItem *current; /* returned by the last _nl_recv(). */
+		int queued_bytes;           /* atomic, the payload of @pushed and @pending. */
+		int overflow;               /* atomic, set while the reader drops datagrams. */
+		int queue_max_bytes;        /* atomic, NL_THREAD_QUEUE_MAX_BYTES unless changed by tests. */
+		bool enabled;
+	} nl_thread;
+
+	/* with a "netlink-read-budget", the event handler yields to the main
+	 * loop after reading for @budget_ns, even if more events are queued.
+	 * @end_ns is only set while the event handler runs. */
+	struct {
+		gint64 budget_ns;
+		gint64 end_ns;
+		guint idle_id;
+	} read_budget;
+
+	/* after the event socket overran, the cache is resynchronized one
+	 * object type after the other, without blocking the main loop. See
+	 * resync_start(). */
+	struct {
+		DelayedActionType pending;
+		DelayedActionType current;
+		guint32 seq;
+		guint generation;
+		gint64 start_ns;
+		guint source_id;
+	} resync;
+
 	bool pruning[_DELAYED_ACTION_IDX_REFRESH_ALL_NUM];
 
 	bool sysctl_get_warned;
 	GHashTable *sysctl_get_prev_values;
 
+	/* per-interface sysctl values as last written or read, to skip
+	 * redundant writes. See _sysctl_cache_parse_path(). */
+	GHashTable *sysctl_cache; /* char *ifname -> (char *path -> char *value) */
+
 	NMUdevClient *udev_client;
 
 	struct {
@@ -2592,6 +2679,12 @@ typedef struct {
 		 * by type. */
 		gint refresh_all_in_progess[_DELAYED_ACTION_IDX_REFRESH_ALL_NUM];
 
+		/* refresh all actions that were not sent because another dump was
+		 * still running. They are scheduled again once it terminated, see
+		 * do_request_all_no_delayed_actions(). */
+		DelayedActionType refresh_all_deferred;
+		guint refresh_all_deferred_id;
+
 		GPtrArray *list_master_connected;
 		GPtrArray *list_refresh_link;
 		GArray *list_wait_for_nl_response;
@@ -2615,8 +2708,20 @@ G_DEFINE_TYPE (NMLinuxPlatform, nm_linux_platform, NM_TYPE_PLATFORM)
 
 #define NM_LINUX_PLATFORM_GET_PRIVATE(self) _NM_GET_PRIVATE_VOID(self, NMLinuxPlatform, NM_IS_LINUX_PLATFORM)
 
+enum {
+	PROP_0,
+	PROP_NETLINK_THREAD,
+	PROP_ROUTE_IGNORE_PROTOCOLS,
+	PROP_NETLINK_READ_BUDGET,
+	LAST_PROP,
+};
+
 NMPlatform *
-nm_linux_platform_new (gboolean log_with_ptr, gboolean netns_support)
+nm_linux_platform_new_full (gboolean log_with_ptr,
+                            gboolean netns_support,
+                            gboolean netlink_thread,
+                            const char *route_ignore_protocols,
+                            guint netlink_read_budget)
 {
 	gboolean use_udev = FALSE;
 
@@ -2628,13 +2733,30 @@ nm_linux_platform_new (gboolean log_with_ptr, gboolean netns_support)
 	                     NM_PLATFORM_LOG_WITH_PTR, log_with_ptr,
 	                     NM_PLATFORM_USE_UDEV, use_udev,
 	                     NM_PLATFORM_NETNS_SUPPORT, netns_support,
+	                     NM_LINUX_PLATFORM_NETLINK_THREAD, netlink_thread,
+	                     NM_LINUX_PLATFORM_ROUTE_IGNORE_PROTOCOLS, route_ignore_protocols,
+	                     NM_LINUX_PLATFORM_NETLINK_READ_BUDGET, netlink_read_budget,
 	                     NULL);
 }
 
+NMPlatform *
+nm_linux_platform_new (gboolean log_with_ptr, gboolean netns_support)
+{
+	return nm_linux_platform_new_full (log_with_ptr, netns_support, FALSE, NULL, 0);
+}
+
+void
+nm_linux_platform_setup_full (gboolean netlink_thread,
+                              const char *route_ignore_protocols,
+                              guint netlink_read_budget)
+{
+	nm_platform_setup (nm_linux_platform_new_full (FALSE, FALSE, netlink_thread, route_ignore_protocols, netlink_read_budget));
+}
+
 void
 nm_linux_platform_setup (void)
 {
-	nm_platform_setup (nm_linux_platform_new (FALSE, FALSE));
+	nm_linux_platform_setup_full (FALSE, NULL, 0);
 }
 
 /*****************************************************************************/
@@ -2689,6 +2811,111 @@ _log_dbg_sysctl_set_impl (NMPlatform *platform, const char *pathid, int dirfd, c
 		} \
 	} G_STMT_END
 
+/*****************************************************************************/
+
+typedef enum {
+	SYSCTL_CACHE_PATH_NONE,
+	SYSCTL_CACHE_PATH_IFNAME,
+	SYSCTL_CACHE_PATH_ALL,
+} SysctlCachePathType;
+
+/* Only per-interface options below /proc/sys/net/ipv[46]/{conf,neigh}/
+ * are cached. The cache is dropped when the link is renamed, removed or
+ * changes its MTU, which cache_on_change() tracks. "mtu", "hop_limit"
+ * and "disable_ipv6" are never cached, because kernel updates them on its
+ * own (the latter after a DAD failure). Any other value that is changed
+ * behind our back is only noticed on the next sysctl_get().
+ *
+ * Writing to "all" may propagate to every interface, so it invalidates
+ * the entire cache. */
+static SysctlCachePathType
+_sysctl_cache_parse_path (const char *path, char *out_ifname /* IFNAMSIZ */)
+{
+	static const char *const prefixes[] = {
+		"/proc/sys/net/ipv4/conf/",
+		"/proc/sys/net/ipv6/conf/",
+		"/proc/sys/net/ipv4/neigh/",
+		"/proc/sys/net/ipv6/neigh/",
+	};
+	const char *ifname = NULL;
+	const char *option;
+	gsize l;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (prefixes); i++) {
+		if (g_str_has_prefix (path, prefixes[i])) {
+			ifname = &path[strlen (prefixes[i])];
+			break;
+		}
+	}
+	if (!ifname)
+		return SYSCTL_CACHE_PATH_NONE;
+
+	option = strchr (ifname, '/');
+	if (!option)
+		return SYSCTL_CACHE_PATH_NONE;
+	l = option - ifname;
+	option++;
+	if (   l == 0
+	    || l >= IFNAMSIZ
+	    || !option[0]
+	    || strchr (option, '/'))
+		return SYSCTL_CACHE_PATH_NONE;
+
+	memcpy (out_ifname, ifname, l);
+	out_ifname[l] = '\0';
+
+	if (nm_streq (out_ifname, "all"))
+		return SYSCTL_CACHE_PATH_ALL;
+	if (   nm_streq (out_ifname, "default")
+	    || NM_IN_STRSET (option, "mtu", "hop_limit", "disable_ipv6"))
+		return SYSCTL_CACHE_PATH_NONE;
+	return SYSCTL_CACHE_PATH_IFNAME;
+}
+
+static const char *
+_sysctl_cache_lookup (NMPlatform *platform, const char *ifname, const char *path)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	GHashTable *values;
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	return values ? g_hash_table_lookup (values, path) : NULL;
+}
+
+static void
+_sysctl_cache_update (NMPlatform *platform, const char *ifname, const char *path, const char *value)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	GHashTable *values;
+
+	values = g_hash_table_lookup (priv->sysctl_cache, ifname);
+	if (!value) {
+		if (values)
+			g_hash_table_remove (values, path);
+		return;
+	}
+
+	if (!values) {
+		values = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+		g_hash_table_insert (priv->sysctl_cache, g_strdup (ifname), values);
+	}
+	g_hash_table_insert (values, g_strdup (path), g_strdup (value));
+}
+
+static void
+_sysctl_cache_clear (NMPlatform *platform, const char *ifname)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	if (ifname)
+		g_hash_table_remove (priv->sysctl_cache, ifname);
+	else
+		g_hash_table_remove_all (priv->sysctl_cache);
+}
+
+/*****************************************************************************/
+
 static gboolean
 sysctl_set (NMPlatform *platform, const char *pathid, int dirfd, const char *path, const char *value)
 {
@@ -2699,6 +2926,8 @@ sysctl_set (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 	char *actual;
 	gs_free char *actual_free = NULL;
 	int errsv;
+	SysctlCachePathType cache_type = SYSCTL_CACHE_PATH_NONE;
+	char cache_ifname[IFNAMSIZ];
 
 	g_return_val_if_fail (path != NULL, FALSE);
 	g_return_val_if_fail (value != NULL, FALSE);
@@ -2706,12 +2935,19 @@ sysctl_set (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 	ASSERT_SYSCTL_ARGS (pathid, dirfd, path);
 
 	if (dirfd < 0) {
+		pathid = path;
+
 		if (!nm_platform_netns_push (platform, &netns)) {
 			errno = ENETDOWN;
 			return FALSE;
 		}
 
-		pathid = path;
+		cache_type = _sysctl_cache_parse_path (path, cache_ifname);
+		if (   cache_type == SYSCTL_CACHE_PATH_IFNAME
+		    && nm_streq0 (_sysctl_cache_lookup (platform, cache_ifname, path), value)) {
+			_LOGD ("sysctl: setting '%s' to '%s' (skipped, value is unchanged)", pathid, value);
+			return TRUE;
+		}
 
 		fd = open (path, O_WRONLY | O_TRUNC | O_CLOEXEC);
 		if (fd == -1) {
@@ -2779,6 +3015,11 @@ sysctl_set (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 		       path, value);
 	}
 
+	if (cache_type == SYSCTL_CACHE_PATH_ALL)
+		_sysctl_cache_clear (platform, NULL);
+	else if (cache_type == SYSCTL_CACHE_PATH_IFNAME)
+		_sysctl_cache_update (platform, cache_ifname, path, nwrote < len - 1 ? NULL : value);
+
 	if (nwrote < len - 1) {
 		if (close (fd) != 0) {
 			if (errsv != 0)
@@ -2861,6 +3102,8 @@ sysctl_get (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 	nm_auto_pop_netns NMPNetns *netns = NULL;
 	GError *error = NULL;
 	char *contents;
+	SysctlCachePathType cache_type = SYSCTL_CACHE_PATH_NONE;
+	char cache_ifname[IFNAMSIZ];
 
 	ASSERT_SYSCTL_ARGS (pathid, dirfd, path);
 
@@ -2868,9 +3111,13 @@ sysctl_get (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 		if (!nm_platform_netns_push (platform, &netns))
 			return NULL;
 		pathid = path;
+		cache_type = _sysctl_cache_parse_path (path, cache_ifname);
 	}
 
 	if (nm_utils_file_get_contents (dirfd, path, 1*1024*1024, &contents, NULL, &error) < 0) {
+		if (cache_type == SYSCTL_CACHE_PATH_IFNAME)
+			_sysctl_cache_update (platform, cache_ifname, path, NULL);
+
 		/* We assume FAILED means EOPNOTSUP */
 		if (   g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT)
 		    || g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NODEV)
@@ -2884,6 +3131,9 @@ sysctl_get (NMPlatform *platform, const char *pathid, int dirfd, const char *pat
 
 	g_strstrip (contents);
 
+	if (cache_type == SYSCTL_CACHE_PATH_IFNAME)
+		_sysctl_cache_update (platform, cache_ifname, path, contents);
+
 	_log_dbg_sysctl_get (platform, pathid, contents);
 
 	return contents;
@@ -3025,6 +3275,12 @@ delayed_action_refresh_all_in_progress (NMPlatform *platform, DelayedActionType
 	if (priv->delayed_action.refresh_all_in_progess[delayed_action_refresh_all_to_idx (action_type)] > 0)
 		return TRUE;
 
+	if (NM_FLAGS_ANY (priv->delayed_action.refresh_all_deferred, action_type))
+		return TRUE;
+
+	if (NM_FLAGS_ANY (priv->resync.pending | priv->resync.current, action_type))
+		return TRUE;
+
 	return FALSE;
 }
 
@@ -3126,6 +3382,13 @@ delayed_action_handle_one (NMPlatform *platform)
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	gpointer user_data;
 
+	if (   priv->delayed_action.refresh_all_deferred
+	    && !_nl_dump_in_progress (platform)) {
+		_LOGt_delayed_action (priv->delayed_action.refresh_all_deferred, NULL, "schedule deferred");
+		priv->delayed_action.flags |= priv->delayed_action.refresh_all_deferred;
+		priv->delayed_action.refresh_all_deferred = DELAYED_ACTION_TYPE_NONE;
+	}
+
 	if (priv->delayed_action.flags == DELAYED_ACTION_TYPE_NONE)
 		return FALSE;
 
@@ -3216,9 +3479,26 @@ delayed_action_handle_all (NMPlatform *platform, gboolean read_netlink)
 
 	cache_prune_all (platform);
 
+	if (   priv->delayed_action.refresh_all_deferred
+	    && !priv->delayed_action.refresh_all_deferred_id) {
+		priv->delayed_action.refresh_all_deferred_id = g_timeout_add (RESYNC_RETRY_MS,
+		                                                              delayed_action_deferred_cb,
+		                                                              platform);
+	}
+
 	return any;
 }
 
+static gboolean
+delayed_action_deferred_cb (gpointer user_data)
+{
+	NMPlatform *platform = user_data;
+
+	NM_LINUX_PLATFORM_GET_PRIVATE (platform)->delayed_action.refresh_all_deferred_id = 0;
+	delayed_action_handle_all (platform, TRUE);
+	return G_SOURCE_REMOVE;
+}
+
 static void
 delayed_action_schedule (NMPlatform *platform, DelayedActionType action_type, gpointer user_data)
 {
@@ -3356,6 +3636,20 @@ cache_on_change (NMPlatform *platform,
 
 	switch (klass->obj_type) {
 	case NMP_OBJECT_TYPE_LINK:
+		{
+			/* cached sysctl values are only valid as long as the link
+			 * keeps its name and MTU (which kernel propagates to the
+			 * IPv6 options). */
+			if (   !obj_old
+			    || !obj_new
+			    || !nm_streq (obj_old->link.name, obj_new->link.name)
+			    || obj_old->link.mtu != obj_new->link.mtu) {
+				if (obj_old)
+					_sysctl_cache_clear (platform, obj_old->link.name);
+				if (obj_new)
+					_sysctl_cache_clear (platform, obj_new->link.name);
+			}
+		}
 		{
 			/* check whether changing a slave link can cause a master link (bridge or bond) to go up/down */
 			if (   obj_old
@@ -3612,6 +3906,100 @@ _nl_send_auto_with_seq (NMPlatform *platform,
 	return nle;
 }
 
+/* Upper bound for the size of one batched write to the netlink socket. Kernel
+ * processes all messages of a single sendmsg() in order. */
+#define NL_SEND_BATCH_MAX_BYTES (32 * 1024)
+
+/**
+ * _nl_send_batch_with_seq:
+ * @platform: the #NMPlatform
+ * @nlmsgs: the messages to send. Entries may be %NULL, in which case
+ *   they are skipped and their result is left untouched.
+ * @len: the number of messages in @nlmsgs.
+ * @out_seq_results: an array of @len elements which receives the
+ *   result for each message once the corresponding ACK arrives.
+ *
+ * Like _nl_send_auto_with_seq(), but packs the messages into as few
+ * writes as possible. Each message gets its own sequence number and
+ * we schedule waiting for all of them, without blocking between
+ * the messages.
+ *
+ * Returns: the number of messages that could not be sent.
+ */
+static guint
+_nl_send_batch_with_seq (NMPlatform *platform,
+                         struct nl_msg **nlmsgs,
+                         guint len,
+                         WaitForNlResponseResult *out_seq_results)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_free guint8 *buf = NULL;
+	gs_free guint32 *seqs = NULL;
+	gsize buf_alloc = NL_SEND_BATCH_MAX_BYTES;
+	guint i, j, i_start;
+	guint n_failed = 0;
+	int nle;
+
+	buf = g_malloc (buf_alloc);
+	seqs = g_new0 (guint32, len);
+
+	i = 0;
+	while (i < len) {
+		gsize buf_len = 0;
+
+		/* pack as many messages as fit into one write. */
+		for (i_start = i; i < len; i++) {
+			struct nlmsghdr *hdr;
+			gsize msg_len;
+
+			if (!nlmsgs[i])
+				continue;
+
+			hdr = nlmsg_hdr (nlmsgs[i]);
+			msg_len = NLMSG_ALIGN (hdr->nlmsg_len);
+
+			if (buf_len + msg_len > buf_alloc) {
+				if (buf_len > 0)
+					break;
+				/* an unexpectedly large message. Grow the buffer. */
+				buf_alloc = msg_len;
+				buf = g_realloc (buf, buf_alloc);
+			}
+
+			/* complete the message with a sequence number (ensuring it's not zero). */
+			seqs[i] = priv->nlh_seq_next++ ?: priv->nlh_seq_next++;
+			hdr->nlmsg_seq = seqs[i];
+			nl_complete_msg (priv->nlh, nlmsgs[i]);
+
+			memcpy (&buf[buf_len], hdr, hdr->nlmsg_len);
+			memset (&buf[buf_len + hdr->nlmsg_len], 0, msg_len - hdr->nlmsg_len);
+			buf_len += msg_len;
+		}
+
+		if (buf_len == 0)
+			break;
+
+		nle = nl_sendto (priv->nlh, buf, buf_len);
+		if (nle < 0)
+			_LOGD ("netlink: send: failed sending batch of messages: %s (%d)", nl_geterror (nle), nle);
+
+		for (j = i_start; j < i; j++) {
+			if (!seqs[j])
+				continue;
+			if (nle >= 0)
+				delayed_action_schedule_WAIT_FOR_NL_RESPONSE (platform, seqs[j], &out_seq_results[j], NULL);
+			else
+				n_failed++;
+		}
+
+		/* Process pending events and ACKs without blocking, so that
+		 * the socket receive buffer doesn't overflow while we keep sending. */
+		event_handler_read_netlink (platform, FALSE);
+	}
+
+	return n_failed;
+}
+
 static void
 do_request_link_no_delayed_actions (NMPlatform *platform, int ifindex, const char *name)
 {
@@ -3654,6 +4042,85 @@ do_request_link (NMPlatform *platform, int ifindex, const char *name)
 	delayed_action_handle_all (platform, FALSE);
 }
 
+static int
+_nl_msg_append_dump_header (NMPlatform *platform,
+                            struct nl_msg *nlmsg,
+                            NMPObjectType obj_type,
+                            int addr_family)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	int nle;
+
+	if (!priv->nlh_strict_chk) {
+		const struct rtgenmsg gmsg = {
+			.rtgen_family = addr_family,
+		};
+
+		return nlmsg_append (nlmsg, &gmsg, sizeof (gmsg), NLMSG_ALIGNTO);
+	}
+
+	/* with NETLINK_GET_STRICT_CHK, the kernel requires the full header
+	 * of the object type and filters route dumps by the table and type
+	 * set in it. */
+	switch (obj_type) {
+	case NMP_OBJECT_TYPE_LINK: {
+		const struct ifinfomsg ifi = {
+			.ifi_family = addr_family,
+		};
+
+		return nlmsg_append (nlmsg, &ifi, sizeof (ifi), NLMSG_ALIGNTO);
+	}
+	case NMP_OBJECT_TYPE_IP4_ADDRESS:
+	case NMP_OBJECT_TYPE_IP6_ADDRESS: {
+		const struct ifaddrmsg ifa = {
+			.ifa_family = addr_family,
+		};
+
+		return nlmsg_append (nlmsg, &ifa, sizeof (ifa), NLMSG_ALIGNTO);
+	}
+	case NMP_OBJECT_TYPE_IP4_ROUTE:
+	case NMP_OBJECT_TYPE_IP6_ROUTE: {
+		const struct rtmsg rtm = {
+			.rtm_family = addr_family,
+			.rtm_table = RT_TABLE_MAIN,
+			.rtm_type = RTN_UNICAST,
+		};
+
+		nle = nlmsg_append (nlmsg, &rtm, sizeof (rtm), NLMSG_ALIGNTO);
+		if (nle < 0)
+			return nle;
+		return nla_put_u32 (nlmsg, RTA_TABLE, RT_TABLE_MAIN);
+	}
+	default:
+		nm_assert_not_reached ();
+		return -NLE_INVAL;
+	}
+}
+
+static void resync_schedule_next (NMPlatform *platform, guint delay_ms);
+
+/* whether a dump that we sent is not yet terminated. */
+static gboolean
+_nl_dump_in_progress (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	const DelayedActionWaitForNlResponseData *data;
+	guint i;
+
+	if (priv->resync.current)
+		return TRUE;
+
+	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE)) {
+		for (i = 0; i < priv->delayed_action.list_wait_for_nl_response->len; i++) {
+			data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, i);
+			if (   data->out_refresh_all_in_progess
+			    && !data->seq_result)
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 static void
 do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType action_type)
 {
@@ -3663,26 +4130,13 @@ do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType actio
 	nm_assert (!NM_FLAGS_ANY (action_type, ~DELAYED_ACTION_TYPE_REFRESH_ALL));
 	action_type &= DELAYED_ACTION_TYPE_REFRESH_ALL;
 
-	FOR_EACH_DELAYED_ACTION (iflags, action_type) {
-		priv->pruning[delayed_action_refresh_all_to_idx (iflags)] = TRUE;
-		nmp_cache_dirty_set_all (nm_platform_get_cache (platform),
-		                         delayed_action_refresh_to_object_type (iflags));
-	}
-
 	FOR_EACH_DELAYED_ACTION (iflags, action_type) {
 		NMPObjectType obj_type = delayed_action_refresh_to_object_type (iflags);
 		const NMPClass *klass = nmp_class_from_type (obj_type);
 		nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
-		struct rtgenmsg gmsg = {
-			.rtgen_family = klass->addr_family,
-		};
 		int nle;
 		gint *out_refresh_all_in_progess;
 
-		out_refresh_all_in_progess = &priv->delayed_action.refresh_all_in_progess[delayed_action_refresh_all_to_idx (iflags)];
-		nm_assert (*out_refresh_all_in_progess >= 0);
-		*out_refresh_all_in_progess += 1;
-
 		/* clear any delayed action that request a refresh of this object type. */
 		priv->delayed_action.flags &= ~iflags;
 		_LOGt_delayed_action (iflags, NULL, "handle (do-request-all)");
@@ -3692,7 +4146,27 @@ do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType actio
 			_LOGt_delayed_action (DELAYED_ACTION_TYPE_REFRESH_LINK, NULL, "clear (do-request-all)");
 		}
 
+		/* The kernel runs only one dump per socket at a time and fails
+		 * another dump request with EBUSY. Without the reader thread, reading
+		 * until EAGAIN lets the kernel fill in the rest of a running dump. With
+		 * "netlink-thread", or while a resync dump is in flight, the dump may
+		 * still run. Don't block the main loop until it terminates, but defer
+		 * the request. delayed_action_handle_one() sends it once the dump is
+		 * done. */
 		event_handler_read_netlink (platform, FALSE);
+		if (_nl_dump_in_progress (platform)) {
+			_LOGt_delayed_action (iflags, NULL, "defer (do-request-all)");
+			priv->delayed_action.refresh_all_deferred |= iflags;
+			continue;
+		}
+		priv->delayed_action.refresh_all_deferred &= ~iflags;
+
+		out_refresh_all_in_progess = &priv->delayed_action.refresh_all_in_progess[delayed_action_refresh_all_to_idx (iflags)];
+		nm_assert (*out_refresh_all_in_progess >= 0);
+		*out_refresh_all_in_progess += 1;
+
+		priv->pruning[delayed_action_refresh_all_to_idx (iflags)] = TRUE;
+		nmp_cache_dirty_set_all (nm_platform_get_cache (platform), obj_type);
 
 		/* reimplement
 		 *   nl_rtgen_request (sk, klass->rtm_gettype, klass->addr_family, NLM_F_DUMP);
@@ -3702,7 +4176,7 @@ do_request_all_no_delayed_actions (NMPlatform *platform, DelayedActionType actio
 		if (!nlmsg)
 			continue;
 
-		nle = nlmsg_append (nlmsg, &gmsg, sizeof (gmsg), NLMSG_ALIGNTO);
+		nle = _nl_msg_append_dump_header (platform, nlmsg, obj_type, klass->addr_family);
 		if (nle < 0)
 			continue;
 
@@ -3720,64 +4194,231 @@ do_request_one_type (NMPlatform *platform, NMPObjectType obj_type)
 	delayed_action_handle_all (platform, FALSE);
 }
 
+/*****************************************************************************
+ * incremental resync
+ *
+ * When the event socket overruns, we lost events and must dump the kernel
+ * state again. Instead of dumping all object types at once and blocking in
+ * delayed_action_handle_all() until the cache is pruned, the types are dumped
+ * one after another. Each dump is sent without waiting for the response, its
+ * messages are processed by the regular event handler together with all
+ * other events, and the type is pruned when the dump terminates with
+ * NLMSG_DONE. Before a type is dumped, its cache entries are marked dirty
+ * and every object that the dump (or a concurrent event) reports clears the
+ * mark again. The next type is requested from an idle handler, so that the
+ * main loop runs in between. When the kernel is still busy with another
+ * dump, the request is retried after RESYNC_RETRY_MS.
+ *
+ * Another overrun restarts the resync with a new generation. The dump in
+ * progress is abandoned and its messages are drained.
+ *****************************************************************************/
+
+static gboolean resync_idle_cb (gpointer user_data);
+
 static void
-event_seq_check_refresh_all (NMPlatform *platform, guint32 seq_number)
+resync_schedule_next (NMPlatform *platform, guint delay_ms)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	DelayedActionWaitForNlResponseData *data;
-	guint i;
 
-	if (NM_IN_SET (seq_number, 0, priv->nlh_seq_last_seen))
+	if (   priv->resync.source_id
+	    || !priv->resync.pending)
 		return;
 
-	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE)) {
-		nm_assert (priv->delayed_action.list_wait_for_nl_response->len > 0);
+	if (delay_ms)
+		priv->resync.source_id = g_timeout_add (delay_ms, resync_idle_cb, platform);
+	else
+		priv->resync.source_id = g_idle_add_full (G_PRIORITY_DEFAULT, resync_idle_cb, platform, NULL);
+}
 
-		for (i = 0; i < priv->delayed_action.list_wait_for_nl_response->len; i++) {
-			data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, i);
+static void
+resync_start (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 
-			if (data->seq_number == priv->nlh_seq_last_seen) {
-				if (data->out_refresh_all_in_progess) {
-					nm_assert (*data->out_refresh_all_in_progess > 0);
-					*data->out_refresh_all_in_progess -= 1;
-					data->out_refresh_all_in_progess = NULL;
-					break;
-				}
-			}
-		}
+	priv->resync.generation++;
+	priv->resync.start_ns = nm_utils_get_monotonic_timestamp_ns ();
+
+	if (priv->resync.current) {
+		_LOGD ("netlink: resync[%u]: abandon dump %u", priv->resync.generation, priv->resync.seq);
+		priv->resync.current = DELAYED_ACTION_TYPE_NONE;
+		priv->resync.seq = 0;
 	}
 
-	priv->nlh_seq_last_seen = seq_number;
+	priv->resync.pending = DELAYED_ACTION_TYPE_REFRESH_ALL;
+	_LOGD ("netlink: resync[%u]: start", priv->resync.generation);
+	resync_schedule_next (platform, 0);
 }
 
 static void
-event_seq_check (NMPlatform *platform, guint32 seq_number, WaitForNlResponseResult seq_result)
+resync_dump_next (NMPlatform *platform)
 {
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	DelayedActionWaitForNlResponseData *data;
-	guint i;
-
-	if (seq_number == 0)
-		return;
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+	DelayedActionType iflags;
+	NMPObjectType obj_type;
+	const NMPClass *klass;
+	guint32 seq;
+	int nle;
 
-	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE)) {
-		nm_assert (priv->delayed_action.list_wait_for_nl_response->len > 0);
+	nm_assert (!priv->resync.current);
 
-		for (i = 0; i < priv->delayed_action.list_wait_for_nl_response->len; i++) {
-			data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, i);
+	if (!priv->resync.pending)
+		return;
 
-			if (data->seq_number == seq_number) {
-				/* We potentially receive many parts partial responses for the same sequence number.
-				 * Thus, we only remember the result, and collect it later. */
-				if (data->seq_result < 0) {
-					/* we already saw an error for this seqence number.
-					 * Preserve it. */
-				} else if (   seq_result != WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN
-				           || data->seq_result == WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN)
-					data->seq_result = seq_result;
-				return;
-			}
-		}
+	if (_nl_dump_in_progress (platform)) {
+		/* a blocking dump did not terminate yet. Sending another dump
+		 * now would only fail with EBUSY. */
+		resync_schedule_next (platform, RESYNC_RETRY_MS);
+		return;
+	}
+
+	FOR_EACH_DELAYED_ACTION (iflags, priv->resync.pending)
+		break;
+	priv->resync.pending &= ~iflags;
+
+	obj_type = delayed_action_refresh_to_object_type (iflags);
+	klass = nmp_class_from_type (obj_type);
+
+	nlmsg = nlmsg_alloc_simple (klass->rtm_gettype, NLM_F_DUMP);
+	if (!nlmsg)
+		goto fallback;
+	nle = _nl_msg_append_dump_header (platform, nlmsg, obj_type, klass->addr_family);
+	if (nle < 0)
+		goto fallback;
+
+	seq = priv->nlh_seq_next++ ?: priv->nlh_seq_next++;
+	nlmsg_hdr (nlmsg)->nlmsg_seq = seq;
+
+	nmp_cache_dirty_set_all (nm_platform_get_cache (platform), obj_type);
+
+	nle = nl_send_auto (priv->nlh, nlmsg);
+	if (nle < 0) {
+		_LOGD ("netlink: resync[%u]: failed sending dump request: %s (%d)",
+		       priv->resync.generation, nl_geterror (nle), nle);
+		goto fallback;
+	}
+
+	_LOGT ("netlink: resync[%u]: dump %s with sequence number %u",
+	       priv->resync.generation, klass->obj_type_name, seq);
+	priv->resync.current = iflags;
+	priv->resync.seq = seq;
+	return;
+
+fallback:
+	/* fall back to the blocking refresh of this type. */
+	delayed_action_schedule (platform, iflags, NULL);
+	resync_schedule_next (platform, 0);
+}
+
+static gboolean
+resync_idle_cb (gpointer user_data)
+{
+	NMPlatform *platform = user_data;
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	priv->resync.source_id = 0;
+	if (!priv->resync.current)
+		resync_dump_next (platform);
+	if (priv->delayed_action.flags)
+		delayed_action_handle_all (platform, FALSE);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+event_seq_check_refresh_all (NMPlatform *platform, guint32 seq_number)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	DelayedActionWaitForNlResponseData *data;
+	guint i;
+
+	if (NM_IN_SET (seq_number, 0, priv->nlh_seq_last_seen))
+		return;
+
+	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE)) {
+		nm_assert (priv->delayed_action.list_wait_for_nl_response->len > 0);
+
+		for (i = 0; i < priv->delayed_action.list_wait_for_nl_response->len; i++) {
+			data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, i);
+
+			if (data->seq_number == priv->nlh_seq_last_seen) {
+				if (data->out_refresh_all_in_progess) {
+					nm_assert (*data->out_refresh_all_in_progess > 0);
+					*data->out_refresh_all_in_progess -= 1;
+					data->out_refresh_all_in_progess = NULL;
+					break;
+				}
+			}
+		}
+	}
+
+	priv->nlh_seq_last_seen = seq_number;
+}
+
+static void
+event_seq_check_resync (NMPlatform *platform, const struct nlmsghdr *hdr, WaitForNlResponseResult seq_result)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	DelayedActionType iflags;
+	guint delay_ms = 0;
+
+	if (   !priv->resync.current
+	    || hdr->nlmsg_seq != priv->resync.seq
+	    || !NM_IN_SET (hdr->nlmsg_type, NLMSG_DONE, NLMSG_ERROR))
+		return;
+
+	iflags = priv->resync.current;
+	priv->resync.current = DELAYED_ACTION_TYPE_NONE;
+	priv->resync.seq = 0;
+
+	if (seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK)
+		cache_prune_one_type (platform, delayed_action_refresh_to_object_type (iflags));
+	else if (seq_result == -EBUSY) {
+		/* another dump is still running. Back off instead of retrying
+		 * from idle right away, which would spin until it completes. */
+		priv->resync.pending |= iflags;
+		delay_ms = RESYNC_RETRY_MS;
+	} else {
+		_LOGD ("netlink: resync[%u]: dump failed (%d)", priv->resync.generation, (int) seq_result);
+		delayed_action_schedule (platform, iflags, NULL);
+	}
+
+	if (priv->resync.pending)
+		resync_schedule_next (platform, delay_ms);
+	else {
+		_LOGD ("netlink: resync[%u]: complete after %u ms",
+		       priv->resync.generation,
+		       (guint) ((nm_utils_get_monotonic_timestamp_ns () - priv->resync.start_ns) / (NM_UTILS_NS_PER_SECOND / 1000)));
+	}
+}
+
+static void
+event_seq_check (NMPlatform *platform, guint32 seq_number, WaitForNlResponseResult seq_result)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	DelayedActionWaitForNlResponseData *data;
+	guint i;
+
+	if (seq_number == 0)
+		return;
+
+	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE)) {
+		nm_assert (priv->delayed_action.list_wait_for_nl_response->len > 0);
+
+		for (i = 0; i < priv->delayed_action.list_wait_for_nl_response->len; i++) {
+			data = &g_array_index (priv->delayed_action.list_wait_for_nl_response, DelayedActionWaitForNlResponseData, i);
+
+			if (data->seq_number == seq_number) {
+				/* We potentially receive many parts partial responses for the same sequence number.
+				 * Thus, we only remember the result, and collect it later. */
+				if (data->seq_result < 0) {
+					/* we already saw an error for this seqence number.
+					 * Preserve it. */
+				} else if (   seq_result != WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_UNKNOWN
+				           || data->seq_result == WAIT_FOR_NL_RESPONSE_RESULT_UNKNOWN)
+					data->seq_result = seq_result;
+				return;
+			}
+		}
 	}
 
 #ifdef NM_MORE_LOGGING
@@ -3788,30 +4429,52 @@ event_seq_check (NMPlatform *platform, guint32 seq_number, WaitForNlResponseResu
 }
 
 static void
-event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_events)
+event_valid_msg (NMPlatform *platform, struct nlmsghdr *msghdr, gboolean handle_events)
 {
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
 	nm_auto_nmpobj NMPObject *obj = NULL;
 	NMPCacheOpsType cache_op;
-	struct nlmsghdr *msghdr;
 	char buf_nlmsg_type[16];
 	gboolean id_only = FALSE;
 	NMPCache *cache = nm_platform_get_cache (platform);
-
-	msghdr = nlmsg_hdr (msg);
+	int nlmsg_type = msghdr->nlmsg_type;
+	const bool *route_ignore_protocols = NULL;
 
 	if (_support_kernel_extended_ifa_flags_still_undecided () && msghdr->nlmsg_type == RTM_NEWADDR)
-		_support_kernel_extended_ifa_flags_detect (msg);
+		_support_kernel_extended_ifa_flags_detect (msghdr);
 
 	if (!handle_events)
 		return;
 
-	if (NM_IN_SET (msghdr->nlmsg_type, RTM_DELLINK, RTM_DELADDR, RTM_DELROUTE)) {
+	if (priv->route_ignore_protocols_any) {
+		route_ignore_protocols = priv->route_ignore_protocols;
+
+		/* A route of an ignored protocol is not cached. But it can replace
+		 * a route that is in the cache, which kernel announces with a single
+		 * RTM_NEWROUTE with NLM_F_REPLACE. Treat such an event like the deletion
+		 * of the route ID, so that the stale route doesn't stay in the cache.
+		 * An appended route doesn't affect the cached one, and dump results
+		 * just leave out the route. */
+		if (   nlmsg_type == RTM_NEWROUTE
+		    && NM_FLAGS_HAS (msghdr->nlmsg_flags, NLM_F_REPLACE)
+		    && nlmsg_valid_hdr (msghdr, sizeof (struct rtmsg))
+		    && route_ignore_protocols[((const struct rtmsg *) nlmsg_data (msghdr))->rtm_protocol]) {
+			nlmsg_type = RTM_DELROUTE;
+			route_ignore_protocols = NULL;
+		}
+	}
+
+	if (NM_IN_SET (nlmsg_type, RTM_DELLINK, RTM_DELADDR, RTM_DELROUTE)) {
 		/* The event notifies about a deleted object. We don't need to initialize all
 		 * fields of the object. */
 		id_only = TRUE;
 	}
 
-	obj = nmp_object_new_from_nl (platform, cache, msg, id_only);
+	obj = nmp_object_new_from_nl (platform,
+	                              cache,
+	                              msghdr,
+	                              id_only,
+	                              route_ignore_protocols);
 	if (!obj) {
 		_LOGT ("event-notification: %s, seq %u: ignore",
 		       _nl_nlmsg_type_to_str (msghdr->nlmsg_type, buf_nlmsg_type, sizeof (buf_nlmsg_type)),
@@ -3828,7 +4491,7 @@ event_valid_msg (NMPlatform *platform, struct nl_msg *msg, gboolean handle_event
 		nm_auto_nmpobj const NMPObject *obj_old = NULL;
 		nm_auto_nmpobj const NMPObject *obj_new = NULL;
 
-		switch (msghdr->nlmsg_type) {
+		switch (nlmsg_type) {
 
 		case RTM_NEWLINK:
 		case RTM_NEWADDR:
@@ -3979,6 +4642,77 @@ do_add_addrroute (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *
 	return obj && seq_result == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
 }
 
+static gboolean
+do_add_addrroute_batch (NMPlatform *platform,
+                        const NMPObject *obj_ids,
+                        struct nl_msg **nlmsgs,
+                        guint len,
+                        gboolean *out_success)
+{
+	gs_free WaitForNlResponseResult *seq_results = NULL;
+	char s_buf[256];
+	const NMPObject *obj;
+	NMPCache *cache = nm_platform_get_cache (platform);
+	gboolean success = TRUE;
+	gboolean refetched = FALSE;
+	guint i;
+
+	nm_assert (len > 0);
+
+	seq_results = g_new0 (WaitForNlResponseResult, len);
+
+	event_handler_read_netlink (platform, FALSE);
+
+	_LOGD ("do-add-%s: sending batch of %u requests",
+	       NMP_OBJECT_GET_CLASS (&obj_ids[0])->obj_type_name,
+	       len);
+
+	_nl_send_batch_with_seq (platform, nlmsgs, len, seq_results);
+
+	/* wait for the ACKs of all requests at once. */
+	delayed_action_handle_all (platform, FALSE);
+
+	for (i = 0; i < len; i++) {
+		const NMPObject *obj_id = &obj_ids[i];
+		gboolean s;
+
+		if (!nlmsgs[i] || !seq_results[i]) {
+			_LOGE ("do-add-%s[%s]: failure sending netlink request",
+			       NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+			       nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0));
+			s = FALSE;
+			goto next;
+		}
+
+		_NMLOG (seq_results[i] == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK
+		            ? LOGL_DEBUG
+		            : LOGL_ERR,
+		        "do-add-%s[%s]: %s",
+		        NMP_OBJECT_GET_CLASS (obj_id)->obj_type_name,
+		        nmp_object_to_string (obj_id, NMP_OBJECT_TO_STRING_ID, NULL, 0),
+		        wait_for_nl_response_to_string (seq_results[i], s_buf, sizeof (s_buf)));
+
+		/* Like do_add_addrroute(), double check that the object is in the cache.
+		 * But only refetch at most once for the entire batch. */
+		obj = nmp_cache_lookup_obj (cache, obj_id);
+		if (   !obj
+		    && !refetched) {
+			refetched = TRUE;
+			do_request_one_type (platform, NMP_OBJECT_GET_TYPE (obj_id));
+			obj = nmp_cache_lookup_obj (cache, obj_id);
+		}
+
+		s = obj && seq_results[i] == WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
+next:
+		if (out_success)
+			out_success[i] = s;
+		if (!s)
+			success = FALSE;
+	}
+
+	return success;
+}
+
 static gboolean
 do_delete_object (NMPlatform *platform, const NMPObject *obj_id, struct nl_msg *nlmsg)
 {
@@ -5685,39 +6419,79 @@ ip_route_get_lock_flag (NMPlatformIPRoute *route)
 	       | (((guint32) route->lock_mtu) << RTAX_MTU);
 }
 
-static gboolean
-ip4_route_add (NMPlatform *platform, const NMPlatformIP4Route *route)
+static struct nl_msg *
+_nl_msg_new_ip4_route_add (const NMPlatformIP4Route *route, NMPObject *out_obj_id)
 {
-	NMPObject obj_id;
-	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
 	in_addr_t network;
 
 	network = nm_utils_ip4_address_clear_host_address (route->network, route->plen);
 
+	nmp_object_stackinit_id_ip4_route (out_obj_id, route->ifindex, network, route->plen, route->metric);
+
 	/* FIXME: take the scope from route into account */
-	nlmsg = _nl_msg_new_route (RTM_NEWROUTE,
-	                           NLM_F_CREATE | NLM_F_REPLACE,
-	                           AF_INET,
-	                           route->ifindex,
-	                           route->rt_source,
-	                           route->gateway ? RT_SCOPE_UNIVERSE : RT_SCOPE_LINK,
-	                           &network,
-	                           route->plen,
-	                           &route->gateway,
-	                           route->metric,
-	                           route->mss,
-	                           route->pref_src ? &route->pref_src : NULL,
-	                           NULL,
-	                           0,
-	                           route->tos,
-	                           route->window,
-	                           route->cwnd,
-	                           route->initcwnd,
-	                           route->initrwnd,
-	                           route->mtu,
-	                           ip_route_get_lock_flag ((NMPlatformIPRoute *) route));
-
-	nmp_object_stackinit_id_ip4_route (&obj_id, route->ifindex, network, route->plen, route->metric);
+	return _nl_msg_new_route (RTM_NEWROUTE,
+	                          NLM_F_CREATE | NLM_F_REPLACE,
+	                          AF_INET,
+	                          route->ifindex,
+	                          route->rt_source,
+	                          route->gateway ? RT_SCOPE_UNIVERSE : RT_SCOPE_LINK,
+	                          &network,
+	                          route->plen,
+	                          &route->gateway,
+	                          route->metric,
+	                          route->mss,
+	                          route->pref_src ? &route->pref_src : NULL,
+	                          NULL,
+	                          0,
+	                          route->tos,
+	                          route->window,
+	                          route->cwnd,
+	                          route->initcwnd,
+	                          route->initrwnd,
+	                          route->mtu,
+	                          ip_route_get_lock_flag ((NMPlatformIPRoute *) route));
+}
+
+static struct nl_msg *
+_nl_msg_new_ip6_route_add (const NMPlatformIP6Route *route, NMPObject *out_obj_id)
+{
+	struct in6_addr network;
+
+	nm_utils_ip6_address_clear_host_address (&network, &route->network, route->plen);
+
+	nmp_object_stackinit_id_ip6_route (out_obj_id, route->ifindex, &network, route->plen, route->metric);
+
+	/* FIXME: take the scope from route into account */
+	return _nl_msg_new_route (RTM_NEWROUTE,
+	                          NLM_F_CREATE | NLM_F_REPLACE,
+	                          AF_INET6,
+	                          route->ifindex,
+	                          route->rt_source,
+	                          IN6_IS_ADDR_UNSPECIFIED (&route->gateway) ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE,
+	                          &network,
+	                          route->plen,
+	                          &route->gateway,
+	                          route->metric,
+	                          route->mss,
+	                          !IN6_IS_ADDR_UNSPECIFIED (&route->pref_src) ? &route->pref_src : NULL,
+	                          !IN6_IS_ADDR_UNSPECIFIED (&route->src) ? &route->src : NULL,
+	                          route->src_plen,
+	                          route->tos,
+	                          route->window,
+	                          route->cwnd,
+	                          route->initcwnd,
+	                          route->initrwnd,
+	                          route->mtu,
+	                          ip_route_get_lock_flag ((NMPlatformIPRoute *) route));
+}
+
+static gboolean
+ip4_route_add (NMPlatform *platform, const NMPlatformIP4Route *route)
+{
+	NMPObject obj_id;
+	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
+
+	nlmsg = _nl_msg_new_ip4_route_add (route, &obj_id);
 	return do_add_addrroute (platform, &obj_id, nlmsg);
 }
 
@@ -5726,37 +6500,57 @@ ip6_route_add (NMPlatform *platform, const NMPlatformIP6Route *route)
 {
 	NMPObject obj_id;
 	nm_auto_nlmsg struct nl_msg *nlmsg = NULL;
-	struct in6_addr network;
 
-	nm_utils_ip6_address_clear_host_address (&network, &route->network, route->plen);
-
-	/* FIXME: take the scope from route into account */
-	nlmsg = _nl_msg_new_route (RTM_NEWROUTE,
-	                           NLM_F_CREATE | NLM_F_REPLACE,
-	                           AF_INET6,
-	                           route->ifindex,
-	                           route->rt_source,
-	                           IN6_IS_ADDR_UNSPECIFIED (&route->gateway) ? RT_SCOPE_LINK : RT_SCOPE_UNIVERSE,
-	                           &network,
-	                           route->plen,
-	                           &route->gateway,
-	                           route->metric,
-	                           route->mss,
-	                           !IN6_IS_ADDR_UNSPECIFIED (&route->pref_src) ? &route->pref_src : NULL,
-	                           !IN6_IS_ADDR_UNSPECIFIED (&route->src) ? &route->src : NULL,
-	                           route->src_plen,
-	                           route->tos,
-	                           route->window,
-	                           route->cwnd,
-	                           route->initcwnd,
-	                           route->initrwnd,
-	                           route->mtu,
-	                           ip_route_get_lock_flag ((NMPlatformIPRoute *) route));
-
-	nmp_object_stackinit_id_ip6_route (&obj_id, route->ifindex, &network, route->plen, route->metric);
+	nlmsg = _nl_msg_new_ip6_route_add (route, &obj_id);
 	return do_add_addrroute (platform, &obj_id, nlmsg);
 }
 
+static gboolean
+ip4_route_add_batch (NMPlatform *platform, const NMPlatformIP4Route *routes, guint len, gboolean *out_success)
+{
+	gs_free NMPObject *obj_ids = NULL;
+	struct nl_msg **nlmsgs;
+	gboolean success;
+	guint i;
+
+	obj_ids = g_new (NMPObject, len);
+	nlmsgs = g_new (struct nl_msg *, len);
+	for (i = 0; i < len; i++)
+		nlmsgs[i] = _nl_msg_new_ip4_route_add (&routes[i], &obj_ids[i]);
+
+	success = do_add_addrroute_batch (platform, obj_ids, nlmsgs, len, out_success);
+
+	for (i = 0; i < len; i++) {
+		if (nlmsgs[i])
+			nlmsg_free (nlmsgs[i]);
+	}
+	g_free (nlmsgs);
+	return success;
+}
+
+static gboolean
+ip6_route_add_batch (NMPlatform *platform, const NMPlatformIP6Route *routes, guint len, gboolean *out_success)
+{
+	gs_free NMPObject *obj_ids = NULL;
+	struct nl_msg **nlmsgs;
+	gboolean success;
+	guint i;
+
+	obj_ids = g_new (NMPObject, len);
+	nlmsgs = g_new (struct nl_msg *, len);
+	for (i = 0; i < len; i++)
+		nlmsgs[i] = _nl_msg_new_ip6_route_add (&routes[i], &obj_ids[i]);
+
+	success = do_add_addrroute_batch (platform, obj_ids, nlmsgs, len, out_success);
+
+	for (i = 0; i < len; i++) {
+		if (nlmsgs[i])
+			nlmsg_free (nlmsgs[i]);
+	}
+	g_free (nlmsgs);
+	return success;
+}
+
 static gboolean
 ip4_route_delete (NMPlatform *platform, int ifindex, in_addr_t network, guint8 plen, guint32 metric)
 {
@@ -5866,6 +6660,9 @@ ip6_route_delete (NMPlatform *platform, int ifindex, struct in6_addr network, gu
 
 /*****************************************************************************/
 
+/* the number of datagrams to receive with one recvmmsg() call. */
+#define NL_RECV_N_SLOTS       16
+
 #define EVENT_CONDITIONS      ((GIOCondition) (G_IO_IN | G_IO_PRI))
 #define ERROR_CONDITIONS      ((GIOCondition) (G_IO_ERR | G_IO_NVAL))
 #define DISCONNECT_CONDITIONS ((GIOCondition) (G_IO_HUP))
@@ -5875,80 +6672,342 @@ event_handler (GIOChannel *channel,
                GIOCondition io_condition,
                gpointer user_data)
 {
-	delayed_action_handle_all (NM_PLATFORM (user_data), TRUE);
+	NMPlatform *platform = NM_PLATFORM (user_data);
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	if (priv->read_budget.budget_ns)
+		priv->read_budget.end_ns = nm_utils_get_monotonic_timestamp_ns () + priv->read_budget.budget_ns;
+	delayed_action_handle_all (platform, TRUE);
+	priv->read_budget.end_ns = 0;
 	return TRUE;
 }
 
+static gboolean
+_read_budget_idle_cb (gpointer user_data)
+{
+	NMPlatform *platform = user_data;
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	priv->read_budget.idle_id = 0;
+	event_handler (NULL, G_IO_IN, platform);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+_read_budget_exceeded (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	if (!priv->read_budget.end_ns)
+		return FALSE;
+
+	/* somebody waits for a response. Don't stop reading. */
+	if (NM_FLAGS_HAS (priv->delayed_action.flags, DELAYED_ACTION_TYPE_WAIT_FOR_NL_RESPONSE))
+		return FALSE;
+
+	return nm_utils_get_monotonic_timestamp_ns () >= priv->read_budget.end_ns;
+}
+
+static void
+_read_budget_yield (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	/* there may be more to read, but the socket is not necessarily readable
+	 * anymore: the receive buffer or the reader thread could already hold the
+	 * remaining datagrams. Continue from an idle handler. */
+	_LOGt ("netlink: read: budget exceeded, continue later");
+	priv->read_budget.end_ns = 0;
+	if (!priv->read_budget.idle_id)
+		priv->read_budget.idle_id = g_idle_add_full (G_PRIORITY_DEFAULT, _read_budget_idle_cb, platform, NULL);
+}
+
+/*****************************************************************************
+ * netlink reader thread
+ *
+ * With "netlink-thread" enabled, a dedicated thread drains the event socket
+ * as soon as data arrives, so that a burst of events from the kernel does
+ * not overrun the socket receive buffer while the main loop is busy.
+ * The thread only receives. The raw buffers are handed to the main thread
+ * which parses them and updates the cache as before. Parsing cannot move to
+ * the thread, because nmp_object_new_from_nl() consults the cache for links.
+ *
+ * The hand-off is lock-free: the reader pushes items onto the @pushed list
+ * with a compare-and-swap and signals @wakeup_fd. The main thread takes the
+ * whole list at once and reverses it into @pending to restore the receive
+ * order.
+ *
+ * The queue is bounded like the socket receive buffer it replaces. When the
+ * main thread falls behind by more than NL_THREAD_QUEUE_MAX_BYTES, the reader
+ * queues -_NLE_NM_NOBUFS, as the kernel reports an overrun, and drops
+ * datagrams until the main thread took that item. The main thread then
+ * resynchronizes the cache as after an overrun of the socket.
+ *****************************************************************************/
+
+#define NL_THREAD_QUEUE_MAX_BYTES (8*1024*1024)
+
+/* how long the reader waits before polling again after poll() failed. */
+#define NL_THREAD_POLL_RETRY_US   (100*1000)
+
+static void
+_nl_thread_item_free (NetlinkThreadItem *item)
+{
+	g_free (item);
+}
+
+static void
+_nl_thread_item_free_list (NetlinkThreadItem *item)
+{
+	while (item) {
+		NetlinkThreadItem *next = item->next;
+
+		_nl_thread_item_free (item);
+		item = next;
+	}
+}
+
+static void
+_nl_thread_push (NMLinuxPlatformPrivate *priv, NetlinkThreadItem *item)
+{
+	NetlinkThreadItem *old;
+
+	do {
+		old = g_atomic_pointer_get (&priv->nl_thread.pushed);
+		item->next = old;
+	} while (!g_atomic_pointer_compare_and_exchange (&priv->nl_thread.pushed, old, item));
+}
+
+static NetlinkThreadItem *
+_nl_thread_pop (NMLinuxPlatformPrivate *priv)
+{
+	NetlinkThreadItem *item, *list, *reversed;
+	guint64 counter;
+
+	if (!priv->nl_thread.pending) {
+		/* reset the eventfd before taking the list. An item pushed after
+		 * this point signals the eventfd again and is not missed. */
+		if (read (priv->nl_thread.wakeup_fd, &counter, sizeof (counter)) < 0)
+			nm_assert (errno == EAGAIN);
+
+		do {
+			list = g_atomic_pointer_get (&priv->nl_thread.pushed);
+			if (!list)
+				return NULL;
+		} while (!g_atomic_pointer_compare_and_exchange (&priv->nl_thread.pushed, list, NULL));
+
+		reversed = NULL;
+		while (list) {
+			item = list;
+			list = item->next;
+			item->next = reversed;
+			reversed = item;
+		}
+		priv->nl_thread.pending = reversed;
+	}
+
+	item = priv->nl_thread.pending;
+	priv->nl_thread.pending = item->next;
+	item->next = NULL;
+	return item;
+}
+
+static gpointer
+_nl_thread_func (gpointer user_data)
+{
+	NMLinuxPlatformPrivate *priv = user_data;
+	struct pollfd pfd[2];
+	const guint64 one = 1;
+	gboolean poll_failed = FALSE;
+
+	memset (pfd, 0, sizeof (pfd));
+	pfd[0].fd = nl_socket_get_fd (priv->nlh);
+	pfd[0].events = POLLIN;
+	pfd[1].fd = priv->nl_thread.stop_fd;
+	pfd[1].events = POLLIN;
+
+	while (TRUE) {
+		gboolean any = FALSE;
+
+		if (poll (pfd, G_N_ELEMENTS (pfd), -1) < 0) {
+			int errsv = errno;
+			NetlinkThreadItem *item;
+
+			if (errsv == EINTR)
+				continue;
+
+			/* hand the error to the main thread like a failed receive, but
+			 * only once while poll() keeps failing. Then retry. */
+			if (!poll_failed) {
+				poll_failed = TRUE;
+				item = g_malloc (sizeof (NetlinkThreadItem));
+				item->next = NULL;
+				item->n = -nl_syserr2nlerr (errsv);
+				item->has_creds = FALSE;
+				_nl_thread_push (priv, item);
+				if (write (priv->nl_thread.wakeup_fd, &one, sizeof (one)) < 0)
+					nm_assert (errno == EAGAIN);
+			}
+			g_usleep (NL_THREAD_POLL_RETRY_US);
+			continue;
+		}
+		poll_failed = FALSE;
+
+		if (pfd[1].revents)
+			break;
+
+		while (TRUE) {
+			NetlinkThreadItem *item;
+			const struct ucred *creds;
+			guint8 *buf;
+			int n;
+
+			n = nmp_netlink_recv (priv->recv_buf, pfd[0].fd, &buf, &creds);
+			if (n == -NLE_AGAIN)
+				break;
+
+			if (   n > 0
+			    && g_atomic_int_get (&priv->nl_thread.overflow)) {
+				/* the main thread resynchronizes anyway. */
+				continue;
+			}
+
+			if (   n > 0
+			    && g_atomic_int_get (&priv->nl_thread.queued_bytes) > g_atomic_int_get (&priv->nl_thread.queue_max_bytes) - n) {
+				g_atomic_int_set (&priv->nl_thread.overflow, 1);
+				n = -_NLE_NM_NOBUFS;
+			}
+
+			/* the datagram is copied out of the receive buffer, because the
+			 * main thread consumes it later. */
+			item = g_malloc (sizeof (NetlinkThreadItem) + MAX (n, 0));
+			item->next = NULL;
+			item->n = n;
+			item->has_creds = !!creds;
+			if (creds)
+				item->creds = *creds;
+			if (n > 0) {
+				memcpy (item->buf, buf, n);
+				g_atomic_int_add (&priv->nl_thread.queued_bytes, n);
+			}
+
+			_nl_thread_push (priv, item);
+			any = TRUE;
+
+			if (n <= 0 && n != -_NLE_MSG_TRUNC && n != -_NLE_NM_NOBUFS) {
+				/* unexpected error. Let the main thread handle it and
+				 * poll again. */
+				break;
+			}
+		}
+
+		if (any) {
+			if (write (priv->nl_thread.wakeup_fd, &one, sizeof (one)) < 0)
+				nm_assert (errno == EAGAIN);
+		}
+	}
+
+	return NULL;
+}
+
+static void
+_nl_thread_start (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+
+	priv->nl_thread.wakeup_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+	priv->nl_thread.stop_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (   priv->nl_thread.wakeup_fd < 0
+	    || priv->nl_thread.stop_fd < 0)
+		g_error ("netlink: cannot create eventfd for reader thread: %s", strerror (errno));
+
+	priv->nl_thread.thread = g_thread_new ("nm-netlink", _nl_thread_func, priv);
+	_LOGD ("netlink: reading events on a dedicated thread");
+}
+
+static void
+_nl_thread_stop (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	const guint64 one = 1;
+
+	if (!priv->nl_thread.thread)
+		return;
+
+	if (write (priv->nl_thread.stop_fd, &one, sizeof (one)) < 0)
+		nm_assert_not_reached ();
+	g_thread_join (g_steal_pointer (&priv->nl_thread.thread));
+
+	g_clear_pointer (&priv->nl_thread.current, _nl_thread_item_free);
+	_nl_thread_item_free_list (g_steal_pointer (&priv->nl_thread.pending));
+	_nl_thread_item_free_list (g_steal_pointer (&priv->nl_thread.pushed));
+	priv->nl_thread.queued_bytes = 0;
+	priv->nl_thread.overflow = 0;
+
+	/* @wakeup_fd is closed together with @event_channel. */
+	close (priv->nl_thread.stop_fd);
+	priv->nl_thread.stop_fd = -1;
+}
+
+/* Receive the next datagram, either directly from the socket or from
+ * the reader thread. Has the same semantics as nmp_netlink_recv(). */
+static int
+_nl_recv (NMPlatform *platform,
+          guint8 **out_buf,
+          const struct ucred **out_creds)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	NetlinkThreadItem *item;
+
+	if (!priv->nl_thread.thread) {
+		return nmp_netlink_recv (priv->recv_buf,
+		                         nl_socket_get_fd (priv->nlh),
+		                         out_buf,
+		                         out_creds);
+	}
+
+	g_clear_pointer (&priv->nl_thread.current, _nl_thread_item_free);
+
+	*out_buf = NULL;
+	*out_creds = NULL;
+
+	item = _nl_thread_pop (priv);
+	if (!item)
+		return -NLE_AGAIN;
+
+	priv->nl_thread.current = item;
+	if (item->n > 0) {
+		g_atomic_int_add (&priv->nl_thread.queued_bytes, -item->n);
+		*out_buf = item->buf;
+	} else if (item->n == -_NLE_NM_NOBUFS) {
+		/* the reader may queue again. */
+		g_atomic_int_set (&priv->nl_thread.overflow, 0);
+	}
+	if (item->has_creds)
+		*out_creds = &item->creds;
+	return item->n;
+}
+
 /*****************************************************************************/
 
 /* copied from libnl3's recvmsgs() */
 static int
 event_handler_recvmsgs (NMPlatform *platform, gboolean handle_events)
 {
-	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
-	struct nl_sock *sk = priv->nlh;
 	int n, err = 0, multipart = 0, interrupted = 0;
 	struct nlmsghdr *hdr;
 	WaitForNlResponseResult seq_result;
-
-	/*
-	nla is passed on to not only to nl_recv() but may also be passed
-	to a function pointer provided by the caller which may or may not
-	initialize the variable. Thomas Graf.
-	*/
-	struct sockaddr_nl nla = {0};
-	nm_auto_free struct ucred *creds = NULL;
-	nm_auto_free unsigned char *buf = NULL;
+	const struct ucred *creds;
+	guint8 *buf;
 
 continue_reading:
-	g_clear_pointer (&buf, free);
-	g_clear_pointer (&creds, free);
-	errno = 0;
-	n = nl_recv (sk, &nla, &buf, &creds);
-
-	if (n <= 0) {
-		/* workaround libnl3 <= 3.2.15 returning danling pointers in case nl_recv()
-		 * fails. Fixed by libnl3 69468517d0de1675d80f24661ff57a5dbac7275c. */
-		buf = NULL;
-		creds = NULL;
-	}
-
-	switch (n) {
-	case 0:
-		/* Work around a libnl bug fixed in 3.2.22 (375a6294) */
-		if (errno == EAGAIN) {
-			/* EAGAIN is equal to EWOULDBLOCK. If it would not be, we'd have to
-			 * workaround libnl3 mapping EWOULDBLOCK to -NLE_FAILURE. */
-			G_STATIC_ASSERT (EAGAIN == EWOULDBLOCK);
-			n = -NLE_AGAIN;
-		}
-		break;
-	case -NLE_MSG_TRUNC: {
-		int buf_size;
+	n = _nl_recv (platform, &buf, &creds);
 
+	if (n == -_NLE_MSG_TRUNC) {
 		/* the message receive buffer was too small. We lost one message, which
-		 * is unfortunate. Try to double the buffer size for the next time. */
-		buf_size = nl_socket_get_msg_buf_size (sk);
-		if (buf_size < 512*1024) {
-			buf_size *= 2;
-			_LOGT ("netlink: recvmsg: increase message buffer size for recvmsg() to %d bytes", buf_size);
-			if (nl_socket_set_msg_buf_size (sk, buf_size) < 0)
-				nm_assert_not_reached ();
-			if (!handle_events)
-				goto continue_reading;
-		}
-		n = -_NLE_MSG_TRUNC;
-		break;
-	}
-	case -NLE_NOMEM:
-		if (errno == ENOBUFS) {
-			/* we are very much interested in a overrun of the receive buffer.
-			 * nl_recv() maps all kinds of errors to NLE_NOMEM, so check also
-			 * for errno explicitly. And if so, hack our own return code to signal
-			 * the overrun. */
-			n = -_NLE_NM_NOBUFS;
-		}
-		break;
+		 * is unfortunate. The buffer grows for the next time. */
+		_LOGT ("netlink: recvmsg: message truncated, increase message buffer size");
+		if (!handle_events)
+			goto continue_reading;
 	}
 
 	if (n <= 0)
@@ -5956,20 +7015,10 @@ continue_reading:
 
 	hdr = (struct nlmsghdr *) buf;
 	while (nlmsg_ok (hdr, n)) {
-		nm_auto_nlmsg struct nl_msg *msg = NULL;
 		gboolean abort_parsing = FALSE;
 		gboolean process_valid_msg = FALSE;
 		guint32 seq_number;
 
-		msg = nlmsg_convert (hdr);
-		if (!msg) {
-			err = -NLE_NOMEM;
-			goto out;
-		}
-
-		nlmsg_set_proto (msg, NETLINK_ROUTE);
-		nlmsg_set_src (msg, &nla);
-
 		if (!creds || creds->pid) {
 			if (creds)
 				_LOGT ("netlink: recvmsg: received non-kernel message (pid %d)", creds->pid);
@@ -5982,9 +7031,6 @@ continue_reading:
 		_LOGt ("netlink: recvmsg: new message type %d, seq %u",
 		       hdr->nlmsg_type, hdr->nlmsg_seq);
 
-		if (creds)
-			nlmsg_set_creds (msg, creds);
-
 		if (hdr->nlmsg_flags & NLM_F_MULTI)
 			multipart = 1;
 
@@ -6040,14 +7086,14 @@ continue_reading:
 				_LOGD ("netlink: recvmsg: error message from kernel: %s (%d) for request %d",
 				       strerror (errsv),
 				       errsv,
-				       nlmsg_hdr (msg)->nlmsg_seq);
+				       hdr->nlmsg_seq);
 				seq_result = -errsv;
 			} else
 				seq_result = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
 		} else
 			process_valid_msg = TRUE;
 
-		seq_number = nlmsg_hdr (msg)->nlmsg_seq;
+		seq_number = hdr->nlmsg_seq;
 
 		/* check whether the seq number is different from before, and
 		 * whether the previous number (@nlh_seq_last_seen) is a pending
@@ -6063,12 +7109,14 @@ continue_reading:
 			 * get along with broken kernels. NL_SKIP has no
 			 * effect on this.  */
 
-			event_valid_msg (platform, msg, handle_events);
+			event_valid_msg (platform, hdr, handle_events);
 
 			seq_result = WAIT_FOR_NL_RESPONSE_RESULT_RESPONSE_OK;
 		}
 
 		event_seq_check (platform, seq_number, seq_result);
+		if (handle_events)
+			event_seq_check_resync (platform, hdr, seq_result);
 
 		if (abort_parsing)
 			goto stop;
@@ -6078,7 +7126,11 @@ continue_reading:
 	}
 
 	if (multipart) {
-		/* Multipart message not yet complete, continue reading */
+		/* Multipart message not yet complete, continue reading. A large
+		 * dump is read in several runs when we are over budget. */
+		if (   handle_events
+		    && _read_budget_exceeded (platform))
+			return 0;
 		goto continue_reading;
 	}
 stop:
@@ -6088,12 +7140,88 @@ stop:
 		 * Repeat reading. */
 		goto continue_reading;
 	}
-out:
 	if (interrupted)
 		err = -NLE_DUMP_INTR;
 	return err;
 }
 
+/* for tests: start the resync as after an overrun of the event socket. */
+void
+_nm_linux_platform_resync_start (NMPlatform *platform)
+{
+	g_return_if_fail (NM_IS_LINUX_PLATFORM (platform));
+
+	resync_start (platform);
+}
+
+/* for tests: refresh all object types with blocking dumps, like after
+ * a failed resync dump. */
+void
+_nm_linux_platform_refresh_all (NMPlatform *platform)
+{
+	g_return_if_fail (NM_IS_LINUX_PLATFORM (platform));
+
+	delayed_action_schedule (platform, DELAYED_ACTION_TYPE_REFRESH_ALL, NULL);
+	delayed_action_handle_all (platform, FALSE);
+}
+
+/* for tests: whether a resync or a deferred refresh is not yet done. */
+gboolean
+_nm_linux_platform_resync_is_running (NMPlatform *platform)
+{
+	NMLinuxPlatformPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_LINUX_PLATFORM (platform), FALSE);
+
+	priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	return    priv->resync.pending
+	       || priv->resync.current
+	       || priv->delayed_action.refresh_all_deferred;
+}
+
+/* for tests: lower the limit of the reader thread's queue, to provoke
+ * an overflow. 0 restores the default. */
+void
+_nm_linux_platform_nl_thread_set_queue_max (NMPlatform *platform, int max_bytes)
+{
+	g_return_if_fail (NM_IS_LINUX_PLATFORM (platform));
+
+	g_atomic_int_set (&NM_LINUX_PLATFORM_GET_PRIVATE (platform)->nl_thread.queue_max_bytes,
+	                  max_bytes > 0 ? max_bytes : NL_THREAD_QUEUE_MAX_BYTES);
+}
+
+/* for tests: set the read budget with a finer granularity than the
+ * "netlink-read-budget" property. */
+void
+_nm_linux_platform_read_budget_set (NMPlatform *platform, gint64 budget_ns)
+{
+	g_return_if_fail (NM_IS_LINUX_PLATFORM (platform));
+
+	NM_LINUX_PLATFORM_GET_PRIVATE (platform)->read_budget.budget_ns = budget_ns;
+}
+
+/* for tests: process the netlink messages in @buf like the event
+ * handler does, without checking sequence numbers. Returns the number
+ * of processed messages. */
+guint
+_nm_linux_platform_process_datagram (NMPlatform *platform, guint8 *buf, int len)
+{
+	struct nlmsghdr *hdr;
+	guint n_msgs = 0;
+
+	g_return_val_if_fail (NM_IS_LINUX_PLATFORM (platform), 0);
+
+	hdr = (struct nlmsghdr *) buf;
+	while (nlmsg_ok (hdr, len)) {
+		if (hdr->nlmsg_type >= RTM_BASE) {
+			event_valid_msg (platform, hdr, TRUE);
+			n_msgs++;
+		}
+		hdr = nlmsg_next (hdr, &len);
+	}
+	return n_msgs;
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -6139,21 +7267,20 @@ event_handler_read_netlink (NMPlatform *platform, gboolean wait_for_acks)
 					            }
 					            _reason;
 					       }));
+					resync_start (platform);
 					event_handler_recvmsgs (platform, FALSE);
 					delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_RESYNC);
-					delayed_action_schedule (platform,
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_LINKS |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ADDRESSES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ADDRESSES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP4_ROUTES |
-					                         DELAYED_ACTION_TYPE_REFRESH_ALL_IP6_ROUTES,
-					                         NULL);
 					break;
 				default:
 					_LOGE ("netlink: read: failed to retrieve incoming events: %s (%d)", nl_geterror (nle), nle);
 					break;
 			}
 			any = TRUE;
+
+			if (_read_budget_exceeded (platform)) {
+				_read_budget_yield (platform);
+				return any;
+			}
 		}
 
 after_read:
@@ -6196,7 +7323,9 @@ after_read:
 		timeout_ms = (data_next.timeout_abs_ns - now_ns) / (NM_UTILS_NS_PER_SECOND / 1000);
 
 		memset (&pfd, 0, sizeof (pfd));
-		pfd.fd = nl_socket_get_fd (priv->nlh);
+		pfd.fd =   priv->nl_thread.thread
+		         ? priv->nl_thread.wakeup_fd
+		         : nl_socket_get_fd (priv->nlh);
 		pfd.events = POLLIN;
 		r = poll (&pfd, 1, MAX (1, timeout_ms));
 
@@ -6346,10 +7475,69 @@ nm_linux_platform_init (NMLinuxPlatform *self)
 	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (self);
 
 	priv->nlh_seq_next = 1;
+	priv->nl_thread.wakeup_fd = -1;
+	priv->nl_thread.stop_fd = -1;
+	priv->nl_thread.queue_max_bytes = NL_THREAD_QUEUE_MAX_BYTES;
 	priv->delayed_action.list_master_connected = g_ptr_array_new ();
 	priv->delayed_action.list_refresh_link = g_ptr_array_new ();
 	priv->delayed_action.list_wait_for_nl_response = g_array_new (FALSE, TRUE, sizeof (DelayedActionWaitForNlResponseData));
 	priv->wifi_data = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) wifi_utils_deinit);
+	priv->sysctl_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_hash_table_unref);
+}
+
+static void
+_route_ignore_protocols_parse (NMPlatform *platform, const char *str)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (platform);
+	gs_strfreev char **tokens = NULL;
+	guint i;
+	int rtprot;
+
+	if (!str)
+		return;
+
+	tokens = _nm_utils_strsplit_set (str, ",; \t", 0);
+	for (i = 0; tokens && tokens[i]; i++) {
+		rtprot = nmp_utils_rtprot_from_string (tokens[i]);
+		if (rtprot < 0) {
+			_LOGW ("invalid routing protocol \"%s\" in %s",
+			       tokens[i], NM_LINUX_PLATFORM_ROUTE_IGNORE_PROTOCOLS);
+			continue;
+		}
+		if (NM_IN_SET (rtprot, RTPROT_KERNEL, RTPROT_BOOT, RTPROT_STATIC, RTPROT_RA, RTPROT_DHCP)) {
+			/* NetworkManager would no longer see the routes that it configures. */
+			_LOGW ("routing protocol \"%s\" in %s is used by NetworkManager and cannot be ignored",
+			       tokens[i], NM_LINUX_PLATFORM_ROUTE_IGNORE_PROTOCOLS);
+			continue;
+		}
+		priv->route_ignore_protocols[rtprot] = TRUE;
+		priv->route_ignore_protocols_any = TRUE;
+	}
+}
+
+static void
+set_property (GObject *object, guint prop_id,
+              const GValue *value, GParamSpec *pspec)
+{
+	NMLinuxPlatformPrivate *priv = NM_LINUX_PLATFORM_GET_PRIVATE (object);
+
+	switch (prop_id) {
+	case PROP_NETLINK_THREAD:
+		/* construct-only */
+		priv->nl_thread.enabled = g_value_get_boolean (value);
+		break;
+	case PROP_ROUTE_IGNORE_PROTOCOLS:
+		/* construct-only */
+		_route_ignore_protocols_parse (NM_PLATFORM (object), g_value_get_string (value));
+		break;
+	case PROP_NETLINK_READ_BUDGET:
+		/* construct-only */
+		priv->read_budget.budget_ns = g_value_get_uint (value) * (NM_UTILS_NS_PER_SECOND / 1000);
+		break;
+	default:
+		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+		break;
+	}
 }
 
 static void
@@ -6387,6 +7575,17 @@ constructed (GObject *_object)
 	nle = nl_socket_set_passcred (priv->nlh, 1);
 	g_assert (!nle);
 
+	/* let the kernel filter dump requests (since kernel 4.20). */
+	{
+		const int one = 1;
+
+		priv->nlh_strict_chk = (setsockopt (nl_socket_get_fd (priv->nlh),
+		                                    SOL_NETLINK,
+		                                    NETLINK_GET_STRICT_CHK,
+		                                    &one,
+		                                    sizeof (one)) == 0);
+	}
+
 	/* No blocking for event socket, so that we can drain it safely. */
 	nle = nl_socket_set_nonblocking (priv->nlh);
 	g_assert (!nle);
@@ -6395,11 +7594,10 @@ constructed (GObject *_object)
 	nle = nl_socket_set_buffer_size (priv->nlh, 8*1024*1024, 0);
 	g_assert (!nle);
 
-	/* explicitly set the msg buffer size and disable MSG_PEEK.
-	 * If we later encounter NLE_MSG_TRUNC, we will adjust the buffer size. */
-	nl_socket_disable_msg_peek (priv->nlh);
-	nle = nl_socket_set_msg_buf_size (priv->nlh, 32 * 1024);
-	g_assert (!nle);
+	/* we don't receive with libnl but with recvmmsg() into preallocated
+	 * buffers of 32 KB each. If we later encounter a truncated message,
+	 * the buffers grow. */
+	priv->recv_buf = nmp_netlink_recv_buf_new (32 * 1024, NL_RECV_N_SLOTS);
 
 	nle = nl_socket_add_memberships (priv->nlh,
 	                                 RTNLGRP_LINK,
@@ -6409,7 +7607,12 @@ constructed (GObject *_object)
 	g_assert (!nle);
 	_LOGD ("Netlink socket for events established: port=%u, fd=%d", nl_socket_get_local_port (priv->nlh), nl_socket_get_fd (priv->nlh));
 
-	priv->event_channel = g_io_channel_unix_new (nl_socket_get_fd (priv->nlh));
+	if (priv->nl_thread.enabled)
+		_nl_thread_start (platform);
+
+	priv->event_channel = g_io_channel_unix_new (  priv->nl_thread.thread
+	                                             ? priv->nl_thread.wakeup_fd
+	                                             : nl_socket_get_fd (priv->nlh));
 	g_io_channel_set_encoding (priv->event_channel, NULL, NULL);
 	g_io_channel_set_close_on_unref (priv->event_channel, TRUE);
 
@@ -6475,6 +7678,11 @@ dispose (GObject *object)
 	delayed_action_wait_for_nl_response_complete_all (platform, WAIT_FOR_NL_RESPONSE_RESULT_FAILED_DISPOSING);
 
 	priv->delayed_action.flags = DELAYED_ACTION_TYPE_NONE;
+	nm_clear_g_source (&priv->read_budget.idle_id);
+	nm_clear_g_source (&priv->resync.source_id);
+	nm_clear_g_source (&priv->delayed_action.refresh_all_deferred_id);
+	priv->resync.pending = DELAYED_ACTION_TYPE_NONE;
+	priv->resync.current = DELAYED_ACTION_TYPE_NONE;
 	g_ptr_array_set_size (priv->delayed_action.list_master_connected, 0);
 	g_ptr_array_set_size (priv->delayed_action.list_refresh_link, 0);
 
@@ -6490,11 +7698,15 @@ finalize (GObject *object)
 	g_ptr_array_unref (priv->delayed_action.list_refresh_link);
 	g_array_unref (priv->delayed_action.list_wait_for_nl_response);
 
+	_nl_thread_stop ((NMPlatform *) object);
+
 	g_source_remove (priv->event_id);
 	g_io_channel_unref (priv->event_channel);
 	nl_socket_free (priv->nlh);
+	nmp_netlink_recv_buf_free (priv->recv_buf);
 
 	g_hash_table_unref (priv->wifi_data);
+	g_hash_table_unref (priv->sysctl_cache);
 
 	if (priv->sysctl_get_prev_values) {
 		sysctl_clear_cache_list = g_slist_remove (sysctl_clear_cache_list, object);
@@ -6512,10 +7724,35 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	NMPlatformClass *platform_class = NM_PLATFORM_CLASS (klass);
 
+	object_class->set_property = set_property;
 	object_class->constructed = constructed;
 	object_class->dispose = dispose;
 	object_class->finalize = finalize;
 
+	g_object_class_install_property
+	 (object_class, PROP_NETLINK_THREAD,
+	     g_param_spec_boolean (NM_LINUX_PLATFORM_NETLINK_THREAD, "", "",
+	                           FALSE,
+	                           G_PARAM_WRITABLE |
+	                           G_PARAM_CONSTRUCT_ONLY |
+	                           G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property
+	 (object_class, PROP_ROUTE_IGNORE_PROTOCOLS,
+	     g_param_spec_string (NM_LINUX_PLATFORM_ROUTE_IGNORE_PROTOCOLS, "", "",
+	                          NULL,
+	                          G_PARAM_WRITABLE |
+	                          G_PARAM_CONSTRUCT_ONLY |
+	                          G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property
+	 (object_class, PROP_NETLINK_READ_BUDGET,
+	     g_param_spec_uint (NM_LINUX_PLATFORM_NETLINK_READ_BUDGET, "", "",
+	                        0, 10000, 0,
+	                        G_PARAM_WRITABLE |
+	                        G_PARAM_CONSTRUCT_ONLY |
+	                        G_PARAM_STATIC_STRINGS));
+
 	platform_class->sysctl_set = sysctl_set;
 	platform_class->sysctl_get = sysctl_get;
 
@@ -6593,6 +7830,8 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 
 	platform_class->ip4_route_add = ip4_route_add;
 	platform_class->ip6_route_add = ip6_route_add;
+	platform_class->ip4_route_add_batch = ip4_route_add_batch;
+	platform_class->ip6_route_add_batch = ip6_route_add_batch;
 	platform_class->ip4_route_delete = ip4_route_delete;
 	platform_class->ip6_route_delete = ip6_route_delete;
 
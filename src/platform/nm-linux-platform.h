@@ -30,13 +30,32 @@
 #define NM_IS_LINUX_PLATFORM_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), NM_TYPE_LINUX_PLATFORM))
 #define NM_LINUX_PLATFORM_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), NM_TYPE_LINUX_PLATFORM, NMLinuxPlatformClass))
 
+#define NM_LINUX_PLATFORM_NETLINK_THREAD         "netlink-thread"
+#define NM_LINUX_PLATFORM_ROUTE_IGNORE_PROTOCOLS "route-ignore-protocols"
+#define NM_LINUX_PLATFORM_NETLINK_READ_BUDGET    "netlink-read-budget"
+
 typedef struct _NMLinuxPlatform NMLinuxPlatform;
 typedef struct _NMLinuxPlatformClass NMLinuxPlatformClass;
 
 GType nm_linux_platform_get_type (void);
 
 NMPlatform *nm_linux_platform_new (gboolean log_with_ptr, gboolean netns_support);
+NMPlatform *nm_linux_platform_new_full (gboolean log_with_ptr,
+                                        gboolean netns_support,
+                                        gboolean netlink_thread,
+                                        const char *route_ignore_protocols,
+                                        guint netlink_read_budget);
 
 void nm_linux_platform_setup (void);
+void nm_linux_platform_setup_full (gboolean netlink_thread,
+                                   const char *route_ignore_protocols,
+                                   guint netlink_read_budget);
+
+guint _nm_linux_platform_process_datagram (NMPlatform *platform, guint8 *buf, int len);
+void _nm_linux_platform_resync_start (NMPlatform *platform);
+void _nm_linux_platform_refresh_all (NMPlatform *platform);
+gboolean _nm_linux_platform_resync_is_running (NMPlatform *platform);
+void _nm_linux_platform_read_budget_set (NMPlatform *platform, gint64 budget_ns);
+void _nm_linux_platform_nl_thread_set_queue_max (NMPlatform *platform, int max_bytes);
 
 #endif /* __NETWORKMANAGER_LINUX_PLATFORM_H__ */
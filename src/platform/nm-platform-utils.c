@@ -565,6 +565,49 @@ nmp_utils_ip_config_source_from_rtprot (guint8 rtprot)
 	return ((int) rtprot) + 1;
 }
 
+/**
+ * nmp_utils_rtprot_from_string:
+ * @str: the name of a routing protocol as in iproute2's rt_protos,
+ *   or a number between 0 and 255.
+ *
+ * Returns: the rtm_protocol value or -1 if @str is not valid.
+ */
+int
+nmp_utils_rtprot_from_string (const char *str)
+{
+	static const struct {
+		const char *name;
+		guint8 rtprot;
+	} names[] = {
+		{ "redirect", RTPROT_REDIRECT },
+		{ "kernel",   RTPROT_KERNEL },
+		{ "boot",     RTPROT_BOOT },
+		{ "static",   RTPROT_STATIC },
+		{ "gated",    8 },
+		{ "ra",       RTPROT_RA },
+		{ "mrt",      10 },
+		{ "zebra",    11 },
+		{ "bird",     12 },
+		{ "dnrouted", 13 },
+		{ "xorp",     14 },
+		{ "ntk",      15 },
+		{ "dhcp",     RTPROT_DHCP },
+		{ "mrouted",  17 },
+		{ "babel",    42 },
+	};
+	guint i;
+
+	if (!str || !str[0])
+		return -1;
+
+	for (i = 0; i < G_N_ELEMENTS (names); i++) {
+		if (!g_ascii_strcasecmp (str, names[i].name))
+			return names[i].rtprot;
+	}
+
+	return _nm_utils_ascii_str_to_int64 (str, 0, 0, 255, -1);
+}
+
 NMIPConfigSource
 nmp_utils_ip_config_source_round_trip_rtprot (NMIPConfigSource source)
 {
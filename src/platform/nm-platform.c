@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <string.h>
@@ -88,11 +89,27 @@ enum {
 	LAST_PROP,
 };
 
+#define SYSCTL_NETDIR_CACHE_SIZE 16
+
+typedef struct {
+	int ifindex;
+	int fd;
+	char ifname[IFNAMSIZ];
+} SysctlNetdirCacheEntry;
+
 typedef struct _NMPlatformPrivate {
 	bool use_udev:1;
 	bool log_with_ptr:1;
 	NMDedupMultiIndex *multi_idx;
 	NMPCache *cache;
+
+	/* a small cache of open /sys/class/net/%s directories, so that
+	 * setting several options of one link in a row does not need to
+	 * open and verify the directory each time. */
+	struct {
+		SysctlNetdirCacheEntry entries[SYSCTL_NETDIR_CACHE_SIZE];
+		guint next;
+	} sysctl_netdir;
 } NMPlatformPrivate;
 
 G_DEFINE_TYPE (NMPlatform, nm_platform, G_TYPE_OBJECT)
@@ -215,6 +232,38 @@ nm_platform_get_multi_idx (NMPlatform *self)
 	return NM_PLATFORM_GET_PRIVATE (self)->multi_idx;
 }
 
+/**
+ * nm_platform_log_memory_stats:
+ * @self: the #NMPlatform
+ *
+ * Logs the memory used by the platform objects and by the entries
+ * of the multi index, which is shared with the IP configurations.
+ */
+void
+nm_platform_log_memory_stats (NMPlatform *self)
+{
+	NMSlabStats stats;
+	NMPObjectType obj_type;
+
+	_CHECK_SELF_VOID (self, klass);
+
+	for (obj_type = NMP_OBJECT_TYPE_UNKNOWN + 1; obj_type <= NMP_OBJECT_TYPE_MAX; obj_type++) {
+		nmp_object_get_stats (obj_type, &stats);
+		if (!stats.n_used && !stats.n_bytes)
+			continue;
+		_LOGI ("memory: %s: %"G_GSIZE_FORMAT" objects of %"G_GSIZE_FORMAT" bytes in %"G_GSIZE_FORMAT" KiB",
+		       nmp_class_from_type (obj_type)->obj_type_name,
+		       stats.n_used,
+		       stats.obj_size,
+		       stats.n_bytes / 1024);
+	}
+
+	nm_dedup_multi_index_get_stats (NM_PLATFORM_GET_PRIVATE (self)->multi_idx, &stats);
+	_LOGI ("memory: index: %"G_GSIZE_FORMAT" entries in %"G_GSIZE_FORMAT" KiB",
+	       stats.n_used,
+	       stats.n_bytes / 1024);
+}
+
 /*****************************************************************************/
 
 /**
@@ -299,20 +348,81 @@ nm_platform_process_events (NMPlatform *self)
  * Returns: on success, the open file descriptor to the /sys/class/net/%s
  *   directory.
  */
+static SysctlNetdirCacheEntry *
+_sysctl_netdir_cache_lookup (NMPlatformPrivate *priv, int ifindex)
+{
+	guint i;
+
+	for (i = 0; i < SYSCTL_NETDIR_CACHE_SIZE; i++) {
+		if (priv->sysctl_netdir.entries[i].ifindex == ifindex)
+			return &priv->sysctl_netdir.entries[i];
+	}
+	return NULL;
+}
+
+static void
+_sysctl_netdir_cache_clear_entry (SysctlNetdirCacheEntry *entry)
+{
+	if (entry->ifindex > 0) {
+		close (entry->fd);
+		entry->ifindex = 0;
+		entry->fd = -1;
+		entry->ifname[0] = '\0';
+	}
+}
+
 int
 nm_platform_sysctl_open_netdir (NMPlatform *self, int ifindex, char *out_ifname)
 {
+	NMPlatformPrivate *priv;
+	SysctlNetdirCacheEntry *entry;
 	const char*ifname_guess;
+	char ifname_buf[IFNAMSIZ];
+	int fd;
 	_CHECK_SELF_NETNS (self, klass, netns, -1);
 
 	g_return_val_if_fail (ifindex > 0, -1);
 
+	priv = NM_PLATFORM_GET_PRIVATE (self);
+
 	/* we don't have an @ifname_guess argument to make the API nicer.
 	 * But still do a cache-lookup first. Chances are good that we have
 	 * the right ifname cached and save if_indextoname() */
 	ifname_guess = nm_platform_link_get_name (self, ifindex);
 
-	return nmp_utils_sysctl_open_netdir (ifindex, ifname_guess, out_ifname);
+	/* A cached directory is only reused while the platform cache still
+	 * knows the link under the same name. Once the link is renamed or
+	 * removed, the entry is dropped and the directory opened anew. */
+	entry = _sysctl_netdir_cache_lookup (priv, ifindex);
+	if (entry) {
+		if (   ifname_guess
+		    && nm_streq (ifname_guess, entry->ifname)) {
+			fd = fcntl (entry->fd, F_DUPFD_CLOEXEC, 0);
+			if (fd >= 0) {
+				if (out_ifname)
+					strcpy (out_ifname, entry->ifname);
+				return fd;
+			}
+		}
+		_sysctl_netdir_cache_clear_entry (entry);
+	}
+
+	fd = nmp_utils_sysctl_open_netdir (ifindex, ifname_guess, ifname_buf);
+	if (fd < 0)
+		return -1;
+
+	entry = &priv->sysctl_netdir.entries[priv->sysctl_netdir.next];
+	priv->sysctl_netdir.next = (priv->sysctl_netdir.next + 1) % SYSCTL_NETDIR_CACHE_SIZE;
+	_sysctl_netdir_cache_clear_entry (entry);
+	entry->fd = fcntl (fd, F_DUPFD_CLOEXEC, 0);
+	if (entry->fd >= 0) {
+		entry->ifindex = ifindex;
+		strcpy (entry->ifname, ifname_buf);
+	}
+
+	if (out_ifname)
+		strcpy (out_ifname, ifname_buf);
+	return fd;
 }
 
 /**
@@ -3388,6 +3498,97 @@ nm_platform_ip6_route_add (NMPlatform *self, const NMPlatformIP6Route *route)
 	return klass->ip6_route_add (self, route);
 }
 
+/**
+ * nm_platform_ip4_route_add_batch:
+ * @self: the #NMPlatform instance
+ * @routes: (array length=len): the routes to add
+ * @len: the number of routes in @routes
+ * @out_success: (allow-none) (array length=len): if given, an array of
+ *   @len elements that receives for each route whether adding it succeeded.
+ *
+ * Like nm_platform_ip4_route_add(), but for a list of routes. Platform
+ * implementations that support it send all requests at once and only
+ * afterwards wait for the replies, instead of doing one round-trip per
+ * route. The routes are added in the order given.
+ *
+ * Returns: %TRUE if all routes were added successfully.
+ */
+gboolean
+nm_platform_ip4_route_add_batch (NMPlatform *self, const NMPlatformIP4Route *routes, guint len, gboolean *out_success)
+{
+	gboolean success = TRUE;
+	guint i;
+
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (routes || len == 0, FALSE);
+
+	for (i = 0; i < len; i++) {
+		g_return_val_if_fail (routes[i].plen <= 32, FALSE);
+		_LOGD ("route: adding or updating IPv4 route (batch %u/%u): %s", i + 1, len, nm_platform_ip4_route_to_string (&routes[i], NULL, 0));
+	}
+
+	if (len == 0)
+		return TRUE;
+
+	if (klass->ip4_route_add_batch)
+		return klass->ip4_route_add_batch (self, routes, len, out_success);
+
+	for (i = 0; i < len; i++) {
+		gboolean s = klass->ip4_route_add (self, &routes[i]);
+
+		if (out_success)
+			out_success[i] = s;
+		if (!s)
+			success = FALSE;
+	}
+	return success;
+}
+
+/**
+ * nm_platform_ip6_route_add_batch:
+ * @self: the #NMPlatform instance
+ * @routes: (array length=len): the routes to add
+ * @len: the number of routes in @routes
+ * @out_success: (allow-none) (array length=len): if given, an array of
+ *   @len elements that receives for each route whether adding it succeeded.
+ *
+ * The IPv6 variant of nm_platform_ip4_route_add_batch().
+ *
+ * Returns: %TRUE if all routes were added successfully.
+ */
+gboolean
+nm_platform_ip6_route_add_batch (NMPlatform *self, const NMPlatformIP6Route *routes, guint len, gboolean *out_success)
+{
+	gboolean success = TRUE;
+	guint i;
+
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (routes || len == 0, FALSE);
+
+	for (i = 0; i < len; i++) {
+		g_return_val_if_fail (routes[i].plen <= 128, FALSE);
+		_LOGD ("route: adding or updating IPv6 route (batch %u/%u): %s", i + 1, len, nm_platform_ip6_route_to_string (&routes[i], NULL, 0));
+	}
+
+	if (len == 0)
+		return TRUE;
+
+	if (klass->ip6_route_add_batch)
+		return klass->ip6_route_add_batch (self, routes, len, out_success);
+
+	for (i = 0; i < len; i++) {
+		gboolean s = klass->ip6_route_add (self, &routes[i]);
+
+		if (out_success)
+			out_success[i] = s;
+		if (!s)
+			success = FALSE;
+	}
+	return success;
+}
+
 gboolean
 nm_platform_ip4_route_delete (NMPlatform *self, int ifindex, in_addr_t network, guint8 plen, guint32 metric)
 {
@@ -5103,6 +5304,18 @@ _vtr_v6_route_add (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *rout
 	return nm_platform_ip6_route_add (self, &rt);
 }
 
+static gboolean
+_vtr_v4_route_add_batch (NMPlatform *self, const NMPlatformIPXRoute *routes, guint len, gboolean *out_success)
+{
+	return nm_platform_ip4_route_add_batch (self, (const NMPlatformIP4Route *) routes, len, out_success);
+}
+
+static gboolean
+_vtr_v6_route_add_batch (NMPlatform *self, const NMPlatformIPXRoute *routes, guint len, gboolean *out_success)
+{
+	return nm_platform_ip6_route_add_batch (self, (const NMPlatformIP6Route *) routes, len, out_success);
+}
+
 static gboolean
 _vtr_v4_route_delete (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route)
 {
@@ -5151,6 +5364,7 @@ const NMPlatformVTableRoute nm_platform_vtable_route_v4 = {
 	.route_cmp                      = (int (*) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b, gboolean consider_host_part)) nm_platform_ip4_route_cmp_full,
 	.route_to_string                = (const char *(*) (const NMPlatformIPXRoute *route, char *buf, gsize len)) nm_platform_ip4_route_to_string,
 	.route_add                      = _vtr_v4_route_add,
+	.route_add_batch                = _vtr_v4_route_add_batch,
 	.route_delete                   = _vtr_v4_route_delete,
 	.route_delete_default           = _vtr_v4_route_delete_default,
 	.metric_normalize               = _vtr_v4_metric_normalize,
@@ -5164,6 +5378,7 @@ const NMPlatformVTableRoute nm_platform_vtable_route_v6 = {
 	.route_cmp                      = (int (*) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b, gboolean consider_host_part)) nm_platform_ip6_route_cmp_full,
 	.route_to_string                = (const char *(*) (const NMPlatformIPXRoute *route, char *buf, gsize len)) nm_platform_ip6_route_to_string,
 	.route_add                      = _vtr_v6_route_add,
+	.route_add_batch                = _vtr_v6_route_add_batch,
 	.route_delete                   = _vtr_v6_route_delete,
 	.route_delete_default           = _vtr_v6_route_delete_default,
 	.metric_normalize               = nm_utils_ip6_route_metric_normalize,
@@ -5206,7 +5421,14 @@ set_property (GObject *object, guint prop_id,
 static void
 nm_platform_init (NMPlatform *self)
 {
+	NMPlatformPrivate *priv;
+	guint i;
+
 	self->_priv = G_TYPE_INSTANCE_GET_PRIVATE (self, NM_TYPE_PLATFORM, NMPlatformPrivate);
+
+	priv = NM_PLATFORM_GET_PRIVATE (self);
+	for (i = 0; i < SYSCTL_NETDIR_CACHE_SIZE; i++)
+		priv->sysctl_netdir.entries[i].fd = -1;
 }
 
 static GObject *
@@ -5236,6 +5458,10 @@ finalize (GObject *object)
 {
 	NMPlatform *self = NM_PLATFORM (object);
 	NMPlatformPrivate *priv = NM_PLATFORM_GET_PRIVATE (self);
+	guint i;
+
+	for (i = 0; i < SYSCTL_NETDIR_CACHE_SIZE; i++)
+		_sysctl_netdir_cache_clear_entry (&priv->sysctl_netdir.entries[i]);
 
 	g_clear_object (&self->_netns);
 	nm_dedup_multi_index_unref (priv->multi_idx);
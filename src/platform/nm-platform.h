@@ -367,6 +367,8 @@ typedef struct {
 	int (*route_cmp) (const NMPlatformIPXRoute *a, const NMPlatformIPXRoute *b, gboolean consider_host_part);
 	const char *(*route_to_string) (const NMPlatformIPXRoute *route, char *buf, gsize len);
 	gboolean (*route_add) (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route, gint64 metric);
+	/* @routes is a packed array of @len routes, each of size @sizeof_route. */
+	gboolean (*route_add_batch) (NMPlatform *self, const NMPlatformIPXRoute *routes, guint len, gboolean *out_success);
 	gboolean (*route_delete) (NMPlatform *self, int ifindex, const NMPlatformIPXRoute *route);
 	gboolean (*route_delete_default) (NMPlatform *self, int ifindex, guint32 metric);
 	guint32 (*metric_normalize) (guint32 metric);
@@ -644,6 +646,8 @@ typedef struct {
 
 	gboolean (*ip4_route_add) (NMPlatform *, const NMPlatformIP4Route *route);
 	gboolean (*ip6_route_add) (NMPlatform *, const NMPlatformIP6Route *route);
+	gboolean (*ip4_route_add_batch) (NMPlatform *, const NMPlatformIP4Route *routes, guint len, gboolean *out_success);
+	gboolean (*ip6_route_add_batch) (NMPlatform *, const NMPlatformIP6Route *routes, guint len, gboolean *out_success);
 	gboolean (*ip4_route_delete) (NMPlatform *, int ifindex, in_addr_t network, guint8 plen, guint32 metric);
 	gboolean (*ip6_route_delete) (NMPlatform *, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
 
@@ -960,6 +964,8 @@ const NMPlatformIP4Route *nm_platform_ip4_route_get (NMPlatform *self, int ifind
 const NMPlatformIP6Route *nm_platform_ip6_route_get (NMPlatform *self, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
 gboolean nm_platform_ip4_route_add (NMPlatform *self, const NMPlatformIP4Route *route);
 gboolean nm_platform_ip6_route_add (NMPlatform *self, const NMPlatformIP6Route *route);
+gboolean nm_platform_ip4_route_add_batch (NMPlatform *self, const NMPlatformIP4Route *routes, guint len, gboolean *out_success);
+gboolean nm_platform_ip6_route_add_batch (NMPlatform *self, const NMPlatformIP6Route *routes, guint len, gboolean *out_success);
 gboolean nm_platform_ip4_route_delete (NMPlatform *self, int ifindex, in_addr_t network, guint8 plen, guint32 metric);
 gboolean nm_platform_ip6_route_delete (NMPlatform *self, int ifindex, struct in6_addr network, guint8 plen, guint32 metric);
 
@@ -1042,4 +1048,6 @@ gboolean nm_platform_ethtool_get_link_settings (NMPlatform *self, int ifindex, g
 
 struct _NMDedupMultiIndex *nm_platform_get_multi_idx (NMPlatform *self);
 
+void nm_platform_log_memory_stats (NMPlatform *self);
+
 #endif /* __NETWORKMANAGER_PLATFORM_H__ */
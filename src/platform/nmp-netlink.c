@@ -0,0 +1,248 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nmp-netlink.h"
+
+#include <errno.h>
+#include <linux/netlink.h>
+#include <netlink/errno.h>
+
+/*****************************************************************************/
+
+/* the largest message buffer we grow to on MSG_TRUNC. Same limit as
+ * libnl's nl_socket_set_msg_buf_size() was used with before. */
+#define MSG_BUF_SIZE_MAX (512*1024)
+
+typedef union {
+	struct cmsghdr hdr;
+	char buf[CMSG_SPACE (sizeof (struct ucred))];
+} RecvCmsg;
+
+typedef struct {
+	struct ucred creds;
+	bool has_creds;
+} RecvSlot;
+
+/* NMPNetlinkRecvBuf receives netlink datagrams into preallocated slots
+ * with recvmmsg(). One call drains up to @n_slots datagrams from the socket.
+ * Unlike libnl's nl_recv(), no memory is allocated per datagram: the caller
+ * gets a pointer into the slot, which stays valid until the next call to
+ * nmp_netlink_recv(). */
+struct _NMPNetlinkRecvBuf {
+	guint8 *data;
+	gsize msg_buf_size;
+	guint n_slots;
+
+	/* the datagrams received by the last recvmmsg() call, and the
+	 * index of the next one to return. */
+	guint n_filled;
+	guint n_next;
+
+	/* a datagram was truncated. Grow @data before the next recvmmsg()
+	 * call, but not earlier, because the remaining filled slots still
+	 * point into it. */
+	bool grow_pending;
+
+	struct mmsghdr *msgs;
+	struct iovec *iovs;
+	RecvCmsg *cmsgs;
+	RecvSlot *slots;
+};
+
+/*****************************************************************************/
+
+static void
+_setup_slots (NMPNetlinkRecvBuf *rb)
+{
+	guint i;
+
+	for (i = 0; i < rb->n_slots; i++) {
+		rb->iovs[i].iov_base = &rb->data[i * rb->msg_buf_size];
+		rb->iovs[i].iov_len = rb->msg_buf_size;
+		rb->msgs[i].msg_hdr.msg_iov = &rb->iovs[i];
+		rb->msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+}
+
+NMPNetlinkRecvBuf *
+nmp_netlink_recv_buf_new (gsize msg_buf_size, guint n_slots)
+{
+	NMPNetlinkRecvBuf *rb;
+
+	g_return_val_if_fail (msg_buf_size >= NLMSG_HDRLEN, NULL);
+	g_return_val_if_fail (n_slots > 0, NULL);
+
+	rb = g_slice_new0 (NMPNetlinkRecvBuf);
+	rb->msg_buf_size = msg_buf_size;
+	rb->n_slots = n_slots;
+	rb->data = g_malloc (n_slots * msg_buf_size);
+	rb->msgs = g_new0 (struct mmsghdr, n_slots);
+	rb->iovs = g_new0 (struct iovec, n_slots);
+	rb->cmsgs = g_new0 (RecvCmsg, n_slots);
+	rb->slots = g_new0 (RecvSlot, n_slots);
+	_setup_slots (rb);
+	return rb;
+}
+
+void
+nmp_netlink_recv_buf_free (NMPNetlinkRecvBuf *rb)
+{
+	if (!rb)
+		return;
+
+	g_free (rb->data);
+	g_free (rb->msgs);
+	g_free (rb->iovs);
+	g_free (rb->cmsgs);
+	g_free (rb->slots);
+	g_slice_free (NMPNetlinkRecvBuf, rb);
+}
+
+gsize
+nmp_netlink_recv_buf_get_msg_buf_size (const NMPNetlinkRecvBuf *rb)
+{
+	g_return_val_if_fail (rb, 0);
+
+	return rb->msg_buf_size;
+}
+
+static int
+_recv_batch (NMPNetlinkRecvBuf *rb, int fd)
+{
+	guint i;
+	int r;
+
+	if (rb->grow_pending) {
+		rb->grow_pending = FALSE;
+		if (rb->msg_buf_size < MSG_BUF_SIZE_MAX) {
+			rb->msg_buf_size *= 2;
+			g_free (rb->data);
+			rb->data = g_malloc (rb->n_slots * rb->msg_buf_size);
+			_setup_slots (rb);
+		}
+	}
+
+	for (i = 0; i < rb->n_slots; i++) {
+		struct msghdr *mh = &rb->msgs[i].msg_hdr;
+
+		mh->msg_name = NULL;
+		mh->msg_namelen = 0;
+		mh->msg_control = &rb->cmsgs[i];
+		mh->msg_controllen = sizeof (rb->cmsgs[i]);
+		mh->msg_flags = 0;
+		rb->msgs[i].msg_len = 0;
+	}
+
+again:
+	r = recvmmsg (fd, rb->msgs, rb->n_slots, MSG_DONTWAIT, NULL);
+	if (r < 0) {
+		int errsv = errno;
+
+		if (errsv == EINTR)
+			goto again;
+		if (NM_IN_SET (errsv, EAGAIN, EWOULDBLOCK))
+			return -NLE_AGAIN;
+		if (errsv == ENOBUFS) {
+			/* the receive buffer of the socket overran. */
+			return -_NLE_NM_NOBUFS;
+		}
+		return -nl_syserr2nlerr (errsv);
+	}
+	if (r == 0)
+		return -NLE_AGAIN;
+
+	for (i = 0; i < (guint) r; i++) {
+		struct msghdr *mh = &rb->msgs[i].msg_hdr;
+		struct cmsghdr *cmsg;
+
+		rb->slots[i].has_creds = FALSE;
+		for (cmsg = CMSG_FIRSTHDR (mh); cmsg; cmsg = CMSG_NXTHDR (mh, cmsg)) {
+			if (   cmsg->cmsg_level == SOL_SOCKET
+			    && cmsg->cmsg_type == SCM_CREDENTIALS) {
+				memcpy (&rb->slots[i].creds, CMSG_DATA (cmsg), sizeof (struct ucred));
+				rb->slots[i].has_creds = TRUE;
+				break;
+			}
+		}
+	}
+
+	rb->n_filled = r;
+	rb->n_next = 0;
+	return 0;
+}
+
+/**
+ * nmp_netlink_recv:
+ * @rb: the receive buffer
+ * @fd: the non-blocking netlink socket
+ * @out_buf: (out): the received datagram. It is owned by @rb and
+ *   only valid until the next call.
+ * @out_creds: (out): the credentials of the sender or %NULL if the
+ *   datagram had none. Only valid until the next call.
+ *
+ * Returns the next datagram, calling recvmmsg() when all datagrams from
+ * the previous call were consumed.
+ *
+ * Returns: the length of the datagram, -NLE_AGAIN if there is nothing
+ *   to read, -_NLE_MSG_TRUNC if the datagram was truncated (the buffer
+ *   grows for the next read), -_NLE_NM_NOBUFS if the receive buffer of
+ *   the socket overran or another negative libnl error code.
+ */
+int
+nmp_netlink_recv (NMPNetlinkRecvBuf *rb,
+                  int fd,
+                  guint8 **out_buf,
+                  const struct ucred **out_creds)
+{
+	struct mmsghdr *msg;
+	RecvSlot *slot;
+	guint i;
+	int r;
+
+	nm_assert (rb);
+	nm_assert (out_buf);
+	nm_assert (out_creds);
+
+	*out_buf = NULL;
+	*out_creds = NULL;
+
+	if (rb->n_next >= rb->n_filled) {
+		rb->n_filled = 0;
+		rb->n_next = 0;
+		r = _recv_batch (rb, fd);
+		if (r < 0)
+			return r;
+	}
+
+	i = rb->n_next++;
+	msg = &rb->msgs[i];
+	slot = &rb->slots[i];
+
+	if (msg->msg_hdr.msg_flags & MSG_TRUNC) {
+		rb->grow_pending = TRUE;
+		return -_NLE_MSG_TRUNC;
+	}
+
+	*out_buf = rb->iovs[i].iov_base;
+	*out_creds = slot->has_creds ? &slot->creds : NULL;
+	return msg->msg_len;
+}
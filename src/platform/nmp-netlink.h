@@ -0,0 +1,42 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ */
+
+#ifndef __NMP_NETLINK_H__
+#define __NMP_NETLINK_H__
+
+#include <sys/socket.h>
+
+/* nm-internal error codes for libnl. Make sure they don't overlap. */
+#define _NLE_NM_NOBUFS 500
+#define _NLE_MSG_TRUNC 501
+
+typedef struct _NMPNetlinkRecvBuf NMPNetlinkRecvBuf;
+
+NMPNetlinkRecvBuf *nmp_netlink_recv_buf_new (gsize msg_buf_size, guint n_slots);
+void nmp_netlink_recv_buf_free (NMPNetlinkRecvBuf *rb);
+
+gsize nmp_netlink_recv_buf_get_msg_buf_size (const NMPNetlinkRecvBuf *rb);
+
+int nmp_netlink_recv (NMPNetlinkRecvBuf *rb,
+                      int fd,
+                      guint8 **out_buf,
+                      const struct ucred **out_creds);
+
+#endif /* __NMP_NETLINK_H__ */
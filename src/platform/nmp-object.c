@@ -457,6 +457,40 @@ nmp_class_from_type (NMPObjectType obj_type)
 
 /*****************************************************************************/
 
+/* NMPObjects are allocated from one slab per object type. With many routes,
+ * that keeps the objects of the cache densely packed, instead of scattering
+ * them over the heap among unrelated allocations. */
+static NMSlab *_obj_slabs[NMP_OBJECT_TYPE_MAX];
+
+static NMSlab *
+_obj_slab_get (const NMPClass *klass)
+{
+	NMSlab **p_slab = &_obj_slabs[klass->obj_type - 1];
+
+	if (G_UNLIKELY (!*p_slab))
+		*p_slab = nm_slab_new (klass->obj_type_name, klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object));
+	return *p_slab;
+}
+
+/**
+ * nmp_object_get_stats:
+ * @obj_type: the object type
+ * @out_stats: (out): the memory used by all objects of @obj_type,
+ *   including the objects which are not in a cache.
+ */
+void
+nmp_object_get_stats (NMPObjectType obj_type, NMSlabStats *out_stats)
+{
+	const NMPClass *klass = nmp_class_from_type (obj_type);
+
+	g_return_if_fail (klass);
+	g_return_if_fail (out_stats);
+
+	nm_slab_get_stats (_obj_slab_get (klass), out_stats);
+}
+
+/*****************************************************************************/
+
 static void
 _vt_cmd_obj_dispose_link (NMPObject *obj)
 {
@@ -483,7 +517,7 @@ _nmp_object_new_from_class (const NMPClass *klass)
 	nm_assert (klass->sizeof_data > 0);
 	nm_assert (klass->sizeof_public > 0 && klass->sizeof_public <= klass->sizeof_data);
 
-	obj = g_slice_alloc0 (klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object));
+	obj = nm_slab_alloc0 (_obj_slab_get (klass));
 	obj->_class = klass;
 	obj->parent._ref_count = 1;
 	return obj;
@@ -1281,7 +1315,7 @@ _vt_dedup_obj_destroy (NMDedupMultiObj *obj)
 	klass = o->_class;
 	if (klass->cmd_obj_dispose)
 		klass->cmd_obj_dispose (o);
-	g_slice_free1 (klass->sizeof_data + G_STRUCT_OFFSET (NMPObject, object), o);
+	nm_slab_free (_obj_slab_get (klass), o);
 }
 
 static const NMDedupMultiObj *
@@ -395,6 +395,8 @@ NMP_OBJECT_GET_TYPE (const NMPObject *obj)
 
 const NMPClass *nmp_class_from_type (NMPObjectType obj_type);
 
+void nmp_object_get_stats (NMPObjectType obj_type, NMSlabStats *out_stats);
+
 static inline const NMPObject *
 nmp_object_ref (const NMPObject *obj)
 {
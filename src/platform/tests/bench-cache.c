@@ -0,0 +1,181 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "platform/nmp-object.h"
+
+#include "nm-test-utils-core.h"
+
+NMTST_DEFINE ();
+
+/*****************************************************************************/
+
+static struct {
+	int count;
+	int rounds;
+} global_opt = {
+	.count = 1000000,
+	.rounds = 20,
+};
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionContext *context;
+	GOptionEntry options[] = {
+		{ "count", 'n', 0, G_OPTION_ARG_INT, &global_opt.count, "Number of IPv4 routes in the cache (default 1000000)", "N" },
+		{ "rounds", 'r', 0, G_OPTION_ARG_INT, &global_opt.rounds, "How often to walk all routes (default 20)", "N" },
+		{ 0 },
+	};
+	gs_free_error GError *error = NULL;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "Measure the memory and the lookup time of the platform cache with many routes. "
+	                                       "Run with NM_SLAB_DISABLE=1 to compare with allocating every object separately.");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, argc, argv, &error)) {
+		g_warning ("Error parsing command line arguments: %s", error->message);
+		g_option_context_free (context);
+		return FALSE;
+	}
+
+	g_option_context_free (context);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static gsize
+get_rss (void)
+{
+	gs_free char *contents = NULL;
+	gs_strfreev char **tokens = NULL;
+
+	if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+		return 0;
+	tokens = g_strsplit (contents, " ", -1);
+	if (!tokens[0] || !tokens[1])
+		return 0;
+	return _nm_utils_ascii_str_to_int64 (tokens[1], 10, 0, G_MAXINT64, 0) * sysconf (_SC_PAGESIZE);
+}
+
+static void
+populate (NMPCache *cache, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		nm_auto_nmpobj NMPObject *obj = NULL;
+		nm_auto_nmpobj const NMPObject *obj_old = NULL;
+		nm_auto_nmpobj const NMPObject *obj_new = NULL;
+
+		obj = nmp_object_new (NMP_OBJECT_TYPE_IP4_ROUTE, NULL);
+		obj->ip4_route.ifindex = 1 + (i % 64);
+		obj->ip4_route.network = htonl (0x0a000000u + ((guint32) i << 8));
+		obj->ip4_route.plen = 24;
+		obj->ip4_route.metric = 100;
+		obj->ip4_route.rt_source = NM_IP_CONFIG_SOURCE_RTPROT_BOOT;
+
+		nmp_cache_update_netlink (cache, obj, &obj_old, &obj_new);
+	}
+}
+
+static guint
+walk (NMPCache *cache)
+{
+	NMPLookup lookup;
+	NMDedupMultiIter iter;
+	const NMPObject *obj;
+	guint n = 0;
+	guint32 sum = 0;
+
+	nmp_lookup_init_obj_type (&lookup, NMP_OBJECT_TYPE_IP4_ROUTE);
+	nmp_cache_iter_for_each (&iter,
+	                         nmp_cache_lookup (cache, &lookup),
+	                         &obj) {
+		/* touch the object, like the users of nm_platform_lookup() do. */
+		sum += obj->ip4_route.metric;
+		n++;
+	}
+	g_assert (sum == n * 100);
+	return n;
+}
+
+int
+main (int argc, char **argv)
+{
+	nm_auto_unref_dedup_multi_index NMDedupMultiIndex *multi_idx = NULL;
+	NMPCache *cache;
+	NMSlabStats stats_obj, stats_idx;
+	gsize rss_before, rss_after;
+	gint64 start, t_populate, t_walk;
+	int r;
+
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	if (global_opt.count <= 0)
+		global_opt.count = 1;
+	if (global_opt.rounds <= 0)
+		global_opt.rounds = 1;
+
+	multi_idx = nm_dedup_multi_index_new ();
+	cache = nmp_cache_new (multi_idx, FALSE);
+
+	rss_before = get_rss ();
+	start = g_get_monotonic_time ();
+	populate (cache, global_opt.count);
+	t_populate = g_get_monotonic_time () - start;
+	rss_after = get_rss ();
+
+	/* warm up once. */
+	walk (cache);
+
+	start = g_get_monotonic_time ();
+	for (r = 0; r < global_opt.rounds; r++)
+		g_assert_cmpint (walk (cache), ==, global_opt.count);
+	t_walk = g_get_monotonic_time () - start;
+
+	nmp_object_get_stats (NMP_OBJECT_TYPE_IP4_ROUTE, &stats_obj);
+	nm_dedup_multi_index_get_stats (multi_idx, &stats_idx);
+
+	printf ("slab allocator %s\n", g_getenv ("NM_SLAB_DISABLE") ? "disabled" : "enabled");
+	printf ("populate: %d routes in %.3f ms\n", global_opt.count, t_populate / 1000.0);
+	printf ("rss:      %.1f MiB (%.1f bytes/route)\n",
+	        (rss_after - rss_before) / (1024.0 * 1024.0),
+	        (double) (rss_after - rss_before) / global_opt.count);
+	printf ("objects:  %.1f MiB, index entries: %.1f MiB\n",
+	        stats_obj.n_bytes / (1024.0 * 1024.0),
+	        stats_idx.n_bytes / (1024.0 * 1024.0));
+	printf ("walk:     %.3f ms per lookup of all routes (%.1f ns/route)\n",
+	        t_walk / 1000.0 / global_opt.rounds,
+	        t_walk * 1000.0 / global_opt.rounds / global_opt.count);
+
+	nmp_cache_free (cache);
+	return EXIT_SUCCESS;
+}
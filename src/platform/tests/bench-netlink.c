@@ -0,0 +1,334 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager -- Network link manager
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <netlink/errno.h>
+
+#include "platform/nm-linux-platform.h"
+#include "platform/nmp-netlink.h"
+
+#include "nm-test-utils-core.h"
+
+NMTST_DEFINE ();
+
+/*****************************************************************************/
+
+/* count heap allocations by interposing the allocator of glibc. */
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static volatile gsize n_allocs;
+
+void *
+malloc (size_t size)
+{
+	n_allocs++;
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+	n_allocs++;
+	return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	n_allocs++;
+	return __libc_realloc (ptr, size);
+}
+
+/*****************************************************************************/
+
+static struct {
+	char *capture;
+	char *replay;
+	int rounds;
+} global_opt = {
+	.rounds = 100,
+};
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionContext *context;
+	GOptionEntry options[] = {
+		{ "capture", 'c', 0, G_OPTION_ARG_FILENAME, &global_opt.capture, "Dump links, addresses and routes and save the netlink messages to FILE", "FILE" },
+		{ "replay", 'r', 0, G_OPTION_ARG_FILENAME, &global_opt.replay, "Replay the netlink messages from FILE instead of a live dump", "FILE" },
+		{ "rounds", 'n', 0, G_OPTION_ARG_INT, &global_opt.rounds, "How often to replay the messages (default 100)", "N" },
+		{ 0 },
+	};
+	gs_free_error GError *error = NULL;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "Measure receiving and processing netlink messages in NMPlatform.");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, argc, argv, &error)) {
+		g_warning ("Error parsing command line arguments: %s", error->message);
+		g_option_context_free (context);
+		return FALSE;
+	}
+
+	g_option_context_free (context);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+/* A capture is a list of datagrams, each a guint32 length in host byte
+ * order followed by the datagram. */
+
+static void
+capture_dump (GPtrArray *datagrams, int fd, guint16 type)
+{
+	struct {
+		struct nlmsghdr hdr;
+		struct rtgenmsg gen;
+	} req = {
+		.hdr = {
+			.nlmsg_len = NLMSG_LENGTH (sizeof (struct rtgenmsg)),
+			.nlmsg_type = type,
+			.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP,
+			.nlmsg_seq = type,
+		},
+		.gen = {
+			.rtgen_family = AF_UNSPEC,
+		},
+	};
+	guint8 buf[64 * 1024];
+
+	if (send (fd, &req, req.hdr.nlmsg_len, 0) < 0)
+		g_error ("cannot send dump request: %s", strerror (errno));
+
+	while (TRUE) {
+		struct nlmsghdr *hdr;
+		ssize_t n;
+		int len;
+
+		n = recv (fd, buf, sizeof (buf), 0);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			g_error ("cannot receive dump: %s", strerror (errno));
+		}
+
+		g_ptr_array_add (datagrams, g_bytes_new (buf, n));
+
+		len = n;
+		for (hdr = (struct nlmsghdr *) buf; NLMSG_OK (hdr, len); hdr = NLMSG_NEXT (hdr, len)) {
+			if (NM_IN_SET (hdr->nlmsg_type, NLMSG_DONE, NLMSG_ERROR))
+				return;
+		}
+	}
+}
+
+static GPtrArray *
+capture_live (void)
+{
+	GPtrArray *datagrams;
+	int fd;
+
+	fd = socket (AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd < 0)
+		g_error ("cannot open netlink socket: %s", strerror (errno));
+
+	datagrams = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	capture_dump (datagrams, fd, RTM_GETLINK);
+	capture_dump (datagrams, fd, RTM_GETADDR);
+	capture_dump (datagrams, fd, RTM_GETROUTE);
+	close (fd);
+	return datagrams;
+}
+
+static void
+capture_save (GPtrArray *datagrams, const char *filename)
+{
+	gs_free_error GError *error = NULL;
+	GString *str;
+	guint i;
+
+	str = g_string_new (NULL);
+	for (i = 0; i < datagrams->len; i++) {
+		gsize size;
+		gconstpointer data = g_bytes_get_data (datagrams->pdata[i], &size);
+		guint32 len = size;
+
+		g_string_append_len (str, (const char *) &len, sizeof (len));
+		g_string_append_len (str, data, size);
+	}
+
+	if (!g_file_set_contents (filename, str->str, str->len, &error))
+		g_error ("cannot write capture: %s", error->message);
+	g_string_free (str, TRUE);
+}
+
+static GPtrArray *
+capture_load (const char *filename)
+{
+	gs_free_error GError *error = NULL;
+	gs_free char *contents = NULL;
+	GPtrArray *datagrams;
+	gsize len, pos;
+
+	if (!g_file_get_contents (filename, &contents, &len, &error))
+		g_error ("cannot read capture: %s", error->message);
+
+	datagrams = g_ptr_array_new_with_free_func ((GDestroyNotify) g_bytes_unref);
+	for (pos = 0; pos + sizeof (guint32) <= len; ) {
+		guint32 size;
+
+		memcpy (&size, &contents[pos], sizeof (size));
+		pos += sizeof (size);
+		if (size > len - pos)
+			g_error ("capture \"%s\" is truncated", filename);
+		g_ptr_array_add (datagrams, g_bytes_new (&contents[pos], size));
+		pos += size;
+	}
+	return datagrams;
+}
+
+/*****************************************************************************/
+
+typedef struct {
+	gint64 time_us;
+	gsize n_msgs;
+	gsize n_allocs;
+} Stats;
+
+static void
+drain (NMPlatform *platform, NMPNetlinkRecvBuf *rb, int fd, Stats *stats)
+{
+	gint64 start;
+	gsize allocs;
+
+	allocs = n_allocs;
+	start = g_get_monotonic_time ();
+
+	while (TRUE) {
+		const struct ucred *creds;
+		guint8 *buf;
+		int n;
+
+		n = nmp_netlink_recv (rb, fd, &buf, &creds);
+		if (n == -NLE_AGAIN)
+			break;
+		if (n < 0)
+			g_error ("receiving failed: %s (%d)", nl_geterror (n), n);
+		stats->n_msgs += _nm_linux_platform_process_datagram (platform, buf, n);
+	}
+
+	stats->time_us += g_get_monotonic_time () - start;
+	stats->n_allocs += n_allocs - allocs;
+}
+
+static void
+replay (NMPlatform *platform, GPtrArray *datagrams, int rounds, Stats *stats)
+{
+	NMPNetlinkRecvBuf *rb;
+	int fds[2];
+	int r;
+	guint i;
+
+	if (socketpair (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds) < 0)
+		g_error ("cannot create socketpair: %s", strerror (errno));
+
+	rb = nmp_netlink_recv_buf_new (32 * 1024, 16);
+
+	for (r = 0; r < rounds; r++) {
+		for (i = 0; i < datagrams->len; ) {
+			gsize size;
+			gconstpointer data = g_bytes_get_data (datagrams->pdata[i], &size);
+
+			if (send (fds[0], data, size, 0) >= 0) {
+				i++;
+				continue;
+			}
+			if (errno != EAGAIN)
+				g_error ("cannot replay datagram: %s", strerror (errno));
+			drain (platform, rb, fds[1], stats);
+		}
+		drain (platform, rb, fds[1], stats);
+	}
+
+	nmp_netlink_recv_buf_free (rb);
+	close (fds[0]);
+	close (fds[1]);
+}
+
+int
+main (int argc, char **argv)
+{
+	gs_unref_object NMPlatform *platform = NULL;
+	GPtrArray *datagrams;
+	Stats stats = { 0 };
+
+	/* count allocations from GSlice too. */
+	setenv ("G_SLICE", "always-malloc", 1);
+
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	if (global_opt.rounds <= 0)
+		global_opt.rounds = 1;
+
+	if (global_opt.replay)
+		datagrams = capture_load (global_opt.replay);
+	else
+		datagrams = capture_live ();
+
+	if (global_opt.capture) {
+		capture_save (datagrams, global_opt.capture);
+		printf ("saved %u datagrams to %s\n", datagrams->len, global_opt.capture);
+	}
+
+	/* the platform cache is populated from the live system, so that links
+	 * from the capture are completed from the cache as in the daemon. */
+	platform = nm_linux_platform_new (FALSE, FALSE);
+
+	replay (platform, datagrams, global_opt.rounds, &stats);
+
+	if (!stats.n_msgs)
+		g_error ("the capture contains no messages");
+
+	printf ("%zu messages in %u datagrams x %d rounds\n",
+	        stats.n_msgs / global_opt.rounds, datagrams->len, global_opt.rounds);
+	printf ("%.0f messages/s  (%.3f us/message)\n",
+	        stats.n_msgs / (stats.time_us / (double) G_USEC_PER_SEC),
+	        (double) stats.time_us / stats.n_msgs);
+	printf ("%.2f allocations/message\n",
+	        (double) stats.n_allocs / stats.n_msgs);
+
+	g_ptr_array_unref (datagrams);
+	return EXIT_SUCCESS;
+}
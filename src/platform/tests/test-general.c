@@ -20,10 +20,15 @@
 
 #include "nm-default.h"
 
+#include <sys/socket.h>
 #include <linux/rtnetlink.h>
+#include <netlink/errno.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
 
 #include "platform/nm-platform-utils.h"
 #include "platform/nm-linux-platform.h"
+#include "platform/nmp-netlink.h"
 
 #include "nm-test-utils-core.h"
 
@@ -53,6 +58,257 @@ test_link_get_all (void)
 
 /*****************************************************************************/
 
+static void
+test_link_get_all_netlink_thread (void)
+{
+	gs_unref_object NMPlatform *platform = NULL;
+	gs_unref_ptrarray GPtrArray *links = NULL;
+
+	platform = nm_linux_platform_new_full (TRUE, NM_PLATFORM_NETNS_SUPPORT_DEFAULT, TRUE, NULL, 0);
+
+	links = nm_platform_link_get_all (platform, TRUE);
+	g_assert (links);
+	g_assert (nm_platform_link_get_by_ifname (platform, "lo"));
+}
+
+/*****************************************************************************/
+
+static void
+test_rtprot_from_string (void)
+{
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("kernel"), ==, RTPROT_KERNEL);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("static"), ==, RTPROT_STATIC);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("BIRD"), ==, 12);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("zebra"), ==, 11);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("0"), ==, 0);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("255"), ==, 255);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("0x10"), ==, 16);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("256"), ==, -1);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("-1"), ==, -1);
+	g_assert_cmpint (nmp_utils_rtprot_from_string ("foo"), ==, -1);
+	g_assert_cmpint (nmp_utils_rtprot_from_string (""), ==, -1);
+	g_assert_cmpint (nmp_utils_rtprot_from_string (NULL), ==, -1);
+}
+
+/*****************************************************************************/
+
+static void
+_inject_ip4_route (NMPlatform *platform, guint16 type, guint16 flags, guint8 protocol, int ifindex, in_addr_t network, guint8 plen, guint32 metric)
+{
+	struct nl_msg *msg;
+	struct nlmsghdr *hdr;
+	const struct rtmsg rtm = {
+		.rtm_family = AF_INET,
+		.rtm_dst_len = plen,
+		.rtm_table = RT_TABLE_MAIN,
+		.rtm_protocol = protocol,
+		.rtm_scope = RT_SCOPE_LINK,
+		.rtm_type = RTN_UNICAST,
+	};
+
+	msg = nlmsg_alloc_simple (type, flags);
+	g_assert (msg);
+	g_assert_cmpint (nlmsg_append (msg, (void *) &rtm, sizeof (rtm), NLMSG_ALIGNTO), >=, 0);
+	g_assert_cmpint (nla_put (msg, RTA_DST, sizeof (network), &network), >=, 0);
+	g_assert_cmpint (nla_put_u32 (msg, RTA_OIF, ifindex), >=, 0);
+	g_assert_cmpint (nla_put_u32 (msg, RTA_PRIORITY, metric), >=, 0);
+
+	hdr = nlmsg_hdr (msg);
+	g_assert_cmpint (_nm_linux_platform_process_datagram (platform, (guint8 *) hdr, hdr->nlmsg_len), ==, 1);
+	nlmsg_free (msg);
+}
+
+static void
+test_route_ignore_protocols (void)
+{
+	gs_unref_object NMPlatform *platform = NULL;
+	const NMPlatformLink *lo;
+	const in_addr_t network = nmtst_inet4_from_string ("198.51.100.0");
+
+	/* protocols that NetworkManager uses itself are rejected. */
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_MESSAGE,
+	                       "*routing protocol \"static\"*cannot be ignored*");
+	g_test_expect_message ("NetworkManager", G_LOG_LEVEL_MESSAGE,
+	                       "*routing protocol \"16\"*cannot be ignored*");
+	platform = nm_linux_platform_new_full (TRUE, NM_PLATFORM_NETNS_SUPPORT_DEFAULT, FALSE, "bird,static,16", 0);
+	g_test_assert_expected_messages ();
+	lo = nm_platform_link_get_by_ifname (platform, "lo");
+	g_assert (lo);
+
+	/* routes of ignored protocols are not cached. */
+	_inject_ip4_route (platform, RTM_NEWROUTE, NLM_F_CREATE, 12, lo->ifindex, network, 24, 4242);
+	g_assert (!nm_platform_ip4_route_get (platform, lo->ifindex, network, 24, 4242));
+
+	_inject_ip4_route (platform, RTM_NEWROUTE, NLM_F_CREATE, RTPROT_STATIC, lo->ifindex, network, 24, 4242);
+	g_assert (nm_platform_ip4_route_get (platform, lo->ifindex, network, 24, 4242));
+
+	/* an appended route of an ignored protocol leaves the cached one alone. */
+	_inject_ip4_route (platform, RTM_NEWROUTE, NLM_F_CREATE | NLM_F_APPEND, 12, lo->ifindex, network, 24, 4242);
+	g_assert (nm_platform_ip4_route_get (platform, lo->ifindex, network, 24, 4242));
+
+	/* ... but when one replaces a cached route, the cached one is gone. */
+	_inject_ip4_route (platform, RTM_NEWROUTE, NLM_F_REPLACE, 12, lo->ifindex, network, 24, 4242);
+	g_assert (!nm_platform_ip4_route_get (platform, lo->ifindex, network, 24, 4242));
+
+	/* "dhcp" was rejected from the list and is still tracked. */
+	_inject_ip4_route (platform, RTM_NEWROUTE, NLM_F_CREATE, RTPROT_DHCP, lo->ifindex, network, 24, 4242);
+	g_assert (nm_platform_ip4_route_get (platform, lo->ifindex, network, 24, 4242));
+}
+
+/*****************************************************************************/
+
+static void
+_resync_wait (NMPlatform *platform)
+{
+	const gint64 end = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+
+	while (_nm_linux_platform_resync_is_running (platform)) {
+		g_assert (g_get_monotonic_time () < end);
+		g_main_context_iteration (NULL, TRUE);
+	}
+}
+
+static void
+_assert_links_equal (NMPlatform *platform, NMPlatform *platform2)
+{
+	gs_unref_ptrarray GPtrArray *links = NULL;
+	gs_unref_ptrarray GPtrArray *links2 = NULL;
+	guint i;
+
+	links = nm_platform_link_get_all (platform, TRUE);
+	links2 = nm_platform_link_get_all (platform2, TRUE);
+	g_assert_cmpint (links->len, ==, links2->len);
+	for (i = 0; i < links->len; i++) {
+		const NMPlatformLink *l = NMP_OBJECT_CAST_LINK (links->pdata[i]);
+
+		g_assert (nm_platform_link_get (platform2, l->ifindex));
+	}
+}
+
+static void
+test_resync (gconstpointer test_data)
+{
+	const gboolean netlink_thread = GPOINTER_TO_INT (test_data);
+	gs_unref_object NMPlatform *platform = NULL;
+	gs_unref_object NMPlatform *platform2 = NULL;
+
+	platform = nm_linux_platform_new_full (TRUE, NM_PLATFORM_NETNS_SUPPORT_DEFAULT, netlink_thread, NULL, 0);
+	platform2 = nm_linux_platform_new (TRUE, NM_PLATFORM_NETNS_SUPPORT_DEFAULT);
+
+	_nm_linux_platform_resync_start (platform);
+	_resync_wait (platform);
+	g_assert (nm_platform_link_get_by_ifname (platform, "lo"));
+	_assert_links_equal (platform, platform2);
+
+	/* a blocking refresh while a resync dump runs does not wait for that
+	 * dump. It is deferred and sent once the dump terminated. */
+	_nm_linux_platform_resync_start (platform);
+	g_assert (_nm_linux_platform_resync_is_running (platform));
+	/* let the idle handler send the first resync dump. */
+	g_main_context_iteration (NULL, FALSE);
+	_nm_linux_platform_refresh_all (platform);
+	_resync_wait (platform);
+	g_assert (nm_platform_link_get_by_ifname (platform, "lo"));
+	_assert_links_equal (platform, platform2);
+}
+
+static void
+test_read_budget (gconstpointer test_data)
+{
+	const gboolean netlink_thread = GPOINTER_TO_INT (test_data);
+	gs_unref_object NMPlatform *platform = NULL;
+	gs_unref_object NMPlatform *platform2 = NULL;
+
+	platform = nm_linux_platform_new_full (TRUE, NM_PLATFORM_NETNS_SUPPORT_DEFAULT, netlink_thread, NULL, 1);
+	platform2 = nm_linux_platform_new (TRUE, NM_PLATFORM_NETNS_SUPPORT_DEFAULT);
+
+	/* with a budget of 1 ns, the event handler yields after every
+	 * datagram. The resync still completes. */
+	_nm_linux_platform_read_budget_set (platform, 1);
+	_nm_linux_platform_resync_start (platform);
+	_resync_wait (platform);
+
+	g_assert (nm_platform_link_get_by_ifname (platform, "lo"));
+	_assert_links_equal (platform, platform2);
+}
+
+static void
+test_netlink_thread_overflow (void)
+{
+	gs_unref_object NMPlatform *platform = NULL;
+	gs_unref_object NMPlatform *platform2 = NULL;
+
+	platform = nm_linux_platform_new_full (TRUE, NM_PLATFORM_NETNS_SUPPORT_DEFAULT, TRUE, NULL, 0);
+	platform2 = nm_linux_platform_new (TRUE, NM_PLATFORM_NETNS_SUPPORT_DEFAULT);
+	g_assert (!_nm_linux_platform_resync_is_running (platform));
+
+	/* with a tiny queue, already the responses to our own dumps overflow
+	 * it. The reader thread reports that like an overrun of the socket
+	 * and the cache is resynchronized. */
+	_nm_linux_platform_nl_thread_set_queue_max (platform, 1);
+	_nm_linux_platform_refresh_all (platform);
+	g_assert (_nm_linux_platform_resync_is_running (platform));
+
+	_nm_linux_platform_nl_thread_set_queue_max (platform, 0);
+	_resync_wait (platform);
+	g_assert (nm_platform_link_get_by_ifname (platform, "lo"));
+	_assert_links_equal (platform, platform2);
+}
+
+/*****************************************************************************/
+
+static void
+test_netlink_recv_buf (void)
+{
+	NMPNetlinkRecvBuf *rb;
+	const struct ucred *creds;
+	guint8 data[300];
+	guint8 *buf;
+	int fds[2];
+	int i, n;
+
+	g_assert_cmpint (socketpair (AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, fds), ==, 0);
+
+	rb = nmp_netlink_recv_buf_new (128, 2);
+
+	g_assert_cmpint (nmp_netlink_recv (rb, fds[1], &buf, &creds), ==, -NLE_AGAIN);
+
+	for (i = 0; i < (int) sizeof (data); i++)
+		data[i] = i;
+
+	/* more datagrams than slots, one of them too large. */
+	g_assert_cmpint (send (fds[0], data, 10, 0), ==, 10);
+	g_assert_cmpint (send (fds[0], data, 200, 0), ==, 200);
+	g_assert_cmpint (send (fds[0], data, 20, 0), ==, 20);
+
+	n = nmp_netlink_recv (rb, fds[1], &buf, &creds);
+	g_assert_cmpint (n, ==, 10);
+	g_assert (memcmp (buf, data, n) == 0);
+	g_assert (!creds);
+
+	g_assert_cmpint (nmp_netlink_recv (rb, fds[1], &buf, &creds), ==, -_NLE_MSG_TRUNC);
+	g_assert (!buf);
+
+	n = nmp_netlink_recv (rb, fds[1], &buf, &creds);
+	g_assert_cmpint (n, ==, 20);
+	g_assert (memcmp (buf, data, n) == 0);
+
+	/* the buffer grew after the truncated datagram. */
+	g_assert_cmpint (nmp_netlink_recv_buf_get_msg_buf_size (rb), ==, 256);
+	g_assert_cmpint (send (fds[0], data, 200, 0), ==, 200);
+	n = nmp_netlink_recv (rb, fds[1], &buf, &creds);
+	g_assert_cmpint (n, ==, 200);
+	g_assert (memcmp (buf, data, n) == 0);
+
+	g_assert_cmpint (nmp_netlink_recv (rb, fds[1], &buf, &creds), ==, -NLE_AGAIN);
+
+	nmp_netlink_recv_buf_free (rb);
+	close (fds[0]);
+	close (fds[1]);
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -62,6 +318,15 @@ main (int argc, char **argv)
 
 	g_test_add_func ("/general/init_linux_platform", test_init_linux_platform);
 	g_test_add_func ("/general/link_get_all", test_link_get_all);
+	g_test_add_func ("/general/link_get_all_netlink_thread", test_link_get_all_netlink_thread);
+	g_test_add_func ("/general/netlink_recv_buf", test_netlink_recv_buf);
+	g_test_add_func ("/general/rtprot_from_string", test_rtprot_from_string);
+	g_test_add_func ("/general/route_ignore_protocols", test_route_ignore_protocols);
+	g_test_add_data_func ("/general/resync", GINT_TO_POINTER (FALSE), test_resync);
+	g_test_add_data_func ("/general/resync_netlink_thread", GINT_TO_POINTER (TRUE), test_resync);
+	g_test_add_data_func ("/general/read_budget", GINT_TO_POINTER (FALSE), test_read_budget);
+	g_test_add_data_func ("/general/read_budget_netlink_thread", GINT_TO_POINTER (TRUE), test_read_budget);
+	g_test_add_func ("/general/netlink_thread_overflow", test_netlink_thread_overflow);
 
 	return g_test_run ();
 }
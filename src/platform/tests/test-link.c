@@ -20,6 +20,7 @@
 
 #include "nm-default.h"
 
+#include <fcntl.h>
 #include <sched.h>
 #include <sys/mount.h>
 #include <sys/stat.h>
@@ -2486,6 +2487,101 @@ test_sysctl_netns_switch (void)
 
 /*****************************************************************************/
 
+static void
+_sysctl_write_external (const char *path, const char *value)
+{
+	nm_auto_close int fd = open (path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+	gs_free char *line = g_strdup_printf ("%s\n", value);
+
+	g_assert (fd >= 0);
+	g_assert_cmpint (write (fd, line, strlen (line)), ==, strlen (line));
+}
+
+static void
+_sysctl_assert_value (const char *path, const char *value)
+{
+	gs_free char *c = NULL;
+
+	c = _get_sysctl_value (path);
+	g_assert_cmpstr (c, ==, value);
+}
+
+static void
+test_sysctl_cache (void)
+{
+	NMPlatform *const PL = NM_PLATFORM_GET;
+	const char *const IFNAME = "nm-dummy-0";
+	const char *const IFNAME2 = "nm-dummy-1";
+	const char *const PATH = "/proc/sys/net/ipv6/conf/nm-dummy-0/accept_dad";
+	int ifindex;
+	int i;
+	gs_free char *value_default = NULL;
+	const char *value;
+
+	value_default = _get_sysctl_value ("/proc/sys/net/ipv6/conf/default/accept_dad");
+	g_assert (value_default);
+	value = nm_streq (value_default, "2") ? "1" : "2";
+
+	for (i = 0; i < 2; i++) {
+		gs_free char *c = NULL;
+		int dirfd;
+		char ifname_buf[IFNAMSIZ];
+
+		ifindex = nmtstp_link_dummy_add (PL, -1, IFNAME)->ifindex;
+
+		/* the link is new, the value written before it was re-created
+		 * must not be cached anymore and is written again. */
+		_sysctl_assert_value (PATH, value_default);
+		g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), value));
+		_sysctl_assert_value (PATH, value);
+
+		/* the cached value is trusted, writing it again is skipped even if
+		 * it was changed behind our back... */
+		_sysctl_write_external (PATH, value_default);
+		g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), value));
+		_sysctl_assert_value (PATH, value_default);
+
+		/* ... until the value is read again. */
+		c = nm_platform_sysctl_get (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH));
+		g_assert_cmpstr (c, ==, value_default);
+		g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), value));
+		_sysctl_assert_value (PATH, value);
+
+		/* the netdir is cached too. Opening it twice must yield the same directory. */
+		dirfd = nm_platform_sysctl_open_netdir (PL, ifindex, ifname_buf);
+		g_assert (dirfd >= 0);
+		g_assert_cmpstr (ifname_buf, ==, IFNAME);
+		close (dirfd);
+		dirfd = nm_platform_sysctl_open_netdir (PL, ifindex, ifname_buf);
+		g_assert (dirfd >= 0);
+		g_assert_cmpstr (ifname_buf, ==, IFNAME);
+		g_assert_cmpint (ifindex, ==, (gint32) nm_platform_sysctl_get_int32 (PL, NMP_SYSCTL_PATHID_NETDIR (dirfd, ifname_buf, "ifindex"), -1));
+		close (dirfd);
+
+		/* renaming the link drops the cached netdir and sysctl values. */
+		nmtstp_run_command_check ("ip link set %s name %s", IFNAME, IFNAME2);
+		nmtstp_assert_wait_for_link (PL, IFNAME2, NM_LINK_TYPE_DUMMY, 100);
+		dirfd = nm_platform_sysctl_open_netdir (PL, ifindex, ifname_buf);
+		g_assert (dirfd >= 0);
+		g_assert_cmpstr (ifname_buf, ==, IFNAME2);
+		g_assert_cmpint (ifindex, ==, (gint32) nm_platform_sysctl_get_int32 (PL, NMP_SYSCTL_PATHID_NETDIR (dirfd, ifname_buf, "ifindex"), -1));
+		close (dirfd);
+
+		nmtstp_run_command_check ("ip link set %s name %s", IFNAME2, IFNAME);
+		nmtstp_assert_wait_for_link (PL, IFNAME, NM_LINK_TYPE_DUMMY, 100);
+		_sysctl_write_external (PATH, value_default);
+		g_assert (nm_platform_sysctl_set (PL, NMP_SYSCTL_PATHID_ABSOLUTE (PATH), value));
+		_sysctl_assert_value (PATH, value);
+
+		nmtstp_link_del (PL, -1, ifindex, IFNAME);
+
+		/* the cached netdir of a removed link is not reused. */
+		g_assert_cmpint (nm_platform_sysctl_open_netdir (PL, ifindex, ifname_buf), <, 0);
+	}
+}
+
+/*****************************************************************************/
+
 NMTstpSetupFunc const _nmtstp_setup_platform_func = SETUP;
 
 void
@@ -2542,5 +2638,6 @@ _nmtstp_setup_tests (void)
 
 		g_test_add_func ("/general/sysctl/rename", test_sysctl_rename);
 		g_test_add_func ("/general/sysctl/netns-switch", test_sysctl_netns_switch);
+		g_test_add_func ("/general/sysctl/cache", test_sysctl_cache);
 	}
 }
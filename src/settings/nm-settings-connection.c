@@ -108,6 +108,11 @@ typedef struct _NMSettingsConnectionPrivate {
 	guint64 timestamp;   /* Up-to-date timestamp of connection use */
 	GHashTable *seen_bssids; /* Up-to-date BSSIDs that's been seen for the connection */
 
+	/* The settings as returned by GetSettings(), without secrets. Serializing
+	 * a connection is expensive and clients tend to poll all connections, so
+	 * it is kept until the connection, its timestamp or its seen-bssids change. */
+	GVariant *settings_dbus;
+
 	int autoconnect_retries;
 	gint32 autoconnect_retry_time;
 
@@ -145,9 +150,16 @@ G_DEFINE_TYPE_WITH_CODE (NMSettingsConnection, nm_settings_connection, NM_TYPE_E
 
 /*****************************************************************************/
 
+static void
+_settings_dbus_clear (NMSettingsConnection *self)
+{
+	nm_clear_g_variant (&NM_SETTINGS_CONNECTION_GET_PRIVATE (self)->settings_dbus);
+}
+
 static void
 _emit_updated (NMSettingsConnection *self, gboolean by_user)
 {
+	_settings_dbus_clear (self);
 	g_signal_emit (self, signals[UPDATED], 0);
 	g_signal_emit (self, signals[UPDATED_INTERNAL], 0, by_user);
 }
@@ -1492,6 +1504,60 @@ check_writable (NMConnection *self, GError **error)
 	return TRUE;
 }
 
+static GVariant *
+_get_settings_dbus (NMSettingsConnection *self)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+	gs_unref_object NMConnection *dupl_con = NULL;
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+	guint64 timestamp = 0;
+	gs_free char **bssids = NULL;
+
+	if (priv->settings_dbus)
+		return g_variant_ref (priv->settings_dbus);
+
+	dupl_con = nm_simple_connection_new_clone (NM_CONNECTION (self));
+
+	/* Timestamp is not updated in connection's 'timestamp' property,
+	 * because it would force updating the connection and in turn
+	 * writing to /etc periodically, which we want to avoid. Rather real
+	 * timestamps are kept track of in a private variable. So, substitute
+	 * timestamp property with the real one here before returning the settings.
+	 */
+	nm_settings_connection_get_timestamp (self, &timestamp);
+	if (timestamp) {
+		s_con = nm_connection_get_setting_connection (dupl_con);
+		g_assert (s_con);
+		g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
+	}
+	/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
+	 * from the same reason as timestamp. Thus we put it here to GetSettings()
+	 * return settings too.
+	 */
+	bssids = nm_settings_connection_get_seen_bssids (self);
+	s_wifi = nm_connection_get_setting_wireless (dupl_con);
+	if (bssids && bssids[0] && s_wifi)
+		g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
+
+	/* Secrets should *never* be returned by the GetSettings method, they
+	 * get returned by the GetSecrets method which can be better
+	 * protected against leakage of secrets to unprivileged callers.
+	 */
+	priv->settings_dbus = nm_connection_to_dbus (dupl_con, NM_CONNECTION_SERIALIZE_NO_SECRETS);
+	g_assert (priv->settings_dbus);
+	g_variant_ref_sink (priv->settings_dbus);
+	return g_variant_ref (priv->settings_dbus);
+}
+
+GVariant *
+_nm_settings_connection_get_settings_dbus (NMSettingsConnection *self)
+{
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (self), NULL);
+
+	return _get_settings_dbus (self);
+}
+
 static void
 get_settings_auth_cb (NMSettingsConnection *self, 
                       GDBusMethodInvocation *context,
@@ -1499,51 +1565,16 @@ get_settings_auth_cb (NMSettingsConnection *self,
                       GError *error,
                       gpointer data)
 {
-	if (error)
+	gs_unref_variant GVariant *settings = NULL;
+
+	if (error) {
 		g_dbus_method_invocation_return_gerror (context, error);
-	else {
-		GVariant *settings;
-		NMConnection *dupl_con;
-		NMSettingConnection *s_con;
-		NMSettingWireless *s_wifi;
-		guint64 timestamp = 0;
-		char **bssids;
-
-		dupl_con = nm_simple_connection_new_clone (NM_CONNECTION (self));
-		g_assert (dupl_con);
-
-		/* Timestamp is not updated in connection's 'timestamp' property,
-		 * because it would force updating the connection and in turn
-		 * writing to /etc periodically, which we want to avoid. Rather real
-		 * timestamps are kept track of in a private variable. So, substitute
-		 * timestamp property with the real one here before returning the settings.
-		 */
-		nm_settings_connection_get_timestamp (self, &timestamp);
-		if (timestamp) {
-			s_con = nm_connection_get_setting_connection (NM_CONNECTION (dupl_con));
-			g_assert (s_con);
-			g_object_set (s_con, NM_SETTING_CONNECTION_TIMESTAMP, timestamp, NULL);
-		}
-		/* Seen BSSIDs are not updated in 802-11-wireless 'seen-bssids' property
-		 * from the same reason as timestamp. Thus we put it here to GetSettings()
-		 * return settings too.
-		 */
-		bssids = nm_settings_connection_get_seen_bssids (self);
-		s_wifi = nm_connection_get_setting_wireless (NM_CONNECTION (dupl_con));
-		if (bssids && bssids[0] && s_wifi)
-			g_object_set (s_wifi, NM_SETTING_WIRELESS_SEEN_BSSIDS, bssids, NULL);
-		g_free (bssids);
-
-		/* Secrets should *never* be returned by the GetSettings method, they
-		 * get returned by the GetSecrets method which can be better
-		 * protected against leakage of secrets to unprivileged callers.
-		 */
-		settings = nm_connection_to_dbus (NM_CONNECTION (dupl_con), NM_CONNECTION_SERIALIZE_NO_SECRETS);
-		g_assert (settings);
-		g_dbus_method_invocation_return_value (context,
-		                                       g_variant_new ("(@a{sa{sv}})", settings));
-		g_object_unref (dupl_con);
+		return;
 	}
+
+	settings = _get_settings_dbus (self);
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(@a{sa{sv}})", settings));
 }
 
 static void
@@ -2300,6 +2331,8 @@ nm_settings_connection_update_timestamp (NMSettingsConnection *self,
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
 	/* Update timestamp in private storage */
+	if (priv->timestamp != timestamp)
+		_settings_dbus_clear (self);
 	priv->timestamp = timestamp;
 	priv->timestamp_set = TRUE;
 
@@ -2369,6 +2402,8 @@ nm_settings_connection_read_and_fill_timestamp (NMSettingsConnection *self)
 		return;
 	}
 
+	if (priv->timestamp != timestamp)
+		_settings_dbus_clear (self);
 	priv->timestamp = timestamp;
 	priv->timestamp_set = TRUE;
 }
@@ -2450,6 +2485,7 @@ nm_settings_connection_add_seen_bssid (NMSettingsConnection *self,
 	/* Add the new BSSID; let the hash take ownership of the allocated BSSID string */
 	bssid_str = g_strdup (seen_bssid);
 	g_hash_table_insert (priv->seen_bssids, bssid_str, bssid_str);
+	_settings_dbus_clear (self);
 
 	/* Build up a list of all the BSSIDs in string form */
 	n = 0;
@@ -2513,6 +2549,8 @@ nm_settings_connection_read_and_fill_seen_bssids (NMSettingsConnection *self)
 	}
 	g_key_file_free (seen_bssids_file);
 
+	_settings_dbus_clear (self);
+
 	/* Update connection's seen-bssids */
 	if (tmp_strv) {
 		g_hash_table_remove_all (priv->seen_bssids);
@@ -2824,6 +2862,7 @@ dispose (GObject *object)
 	priv->pending_auths = NULL;
 
 	g_clear_pointer (&priv->seen_bssids, (GDestroyNotify) g_hash_table_destroy);
+	_settings_dbus_clear (self);
 
 	set_visible (self, FALSE);
 
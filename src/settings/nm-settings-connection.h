@@ -247,4 +247,7 @@ const char *nm_settings_connection_get_filename (NMSettingsConnection *self);
 const char *nm_settings_connection_get_id   (NMSettingsConnection *connection);
 const char *nm_settings_connection_get_uuid (NMSettingsConnection *connection);
 
+/* for tests: returns the (cached) settings as returned by GetSettings(). */
+GVariant *_nm_settings_connection_get_settings_dbus (NMSettingsConnection *self);
+
 #endif /* __NETWORKMANAGER_SETTINGS_CONNECTION_H__ */
@@ -145,7 +145,14 @@ typedef struct {
 
 	GSList *plugins;
 	gboolean connections_loaded;
+
+	/* the connections, indexed by their D-Bus path. */
 	GHashTable *connections;
+
+	/* secondary index of @connections by UUID. Once a connection is
+	 * exported, its UUID can no longer change. */
+	GHashTable *connections_by_uuid;
+
 	NMSettingsConnection **connections_cached_list;
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
@@ -313,21 +320,13 @@ NMSettingsConnection *
 nm_settings_get_connection_by_uuid (NMSettings *self, const char *uuid)
 {
 	NMSettingsPrivate *priv;
-	NMSettingsConnection *candidate;
-	GHashTableIter iter;
 
 	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
 	g_return_val_if_fail (uuid != NULL, NULL);
 
 	priv = NM_SETTINGS_GET_PRIVATE (self);
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &candidate)) {
-		if (g_strcmp0 (uuid, nm_settings_connection_get_uuid (candidate)) == 0)
-			return candidate;
-	}
-
-	return NULL;
+	return g_hash_table_lookup (priv->connections_by_uuid, uuid);
 }
 
 static void
@@ -514,15 +513,13 @@ gboolean
 nm_settings_has_connection (NMSettings *self, NMSettingsConnection *connection)
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
-	GHashTableIter iter;
-	gpointer data;
+	const char *path;
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data))
-		if (data == connection)
-			return TRUE;
+	path = nm_connection_get_path (NM_CONNECTION (connection));
+	if (!path)
+		return FALSE;
 
-	return FALSE;
+	return g_hash_table_lookup (priv->connections, path) == connection;
 }
 
 const GSList *
@@ -828,9 +825,37 @@ next:
 	return success;
 }
 
+static gboolean
+_uuid_index_remove_connection (gpointer key, gpointer value, gpointer user_data)
+{
+	return value == user_data;
+}
+
+static void
+_uuid_index_update (NMSettings *self, NMSettingsConnection *connection, gboolean remove)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	const char *uuid = nm_settings_connection_get_uuid (connection);
+
+	if (   uuid
+	    && g_hash_table_lookup (priv->connections_by_uuid, uuid) == connection) {
+		if (remove)
+			g_hash_table_remove (priv->connections_by_uuid, uuid);
+		return;
+	}
+
+	/* The UUID of an exported connection cannot change, so we don't expect
+	 * to get here. Still, don't leave a dangling entry in the index. */
+	g_hash_table_foreach_remove (priv->connections_by_uuid, _uuid_index_remove_connection, connection);
+	if (!remove && uuid)
+		g_hash_table_insert (priv->connections_by_uuid, g_strdup (uuid), connection);
+}
+
 static void
 connection_updated (NMSettingsConnection *connection, gboolean by_user, gpointer user_data)
 {
+	_uuid_index_update (NM_SETTINGS (user_data), connection, FALSE);
+
 	g_signal_emit (NM_SETTINGS (user_data),
 	               signals[CONNECTION_UPDATED],
 	               0,
@@ -874,6 +899,7 @@ connection_removed (NMSettingsConnection *connection, gpointer user_data)
 	g_object_unref (self);
 
 	/* Forget about the connection internally */
+	_uuid_index_update (self, connection, TRUE);
 	g_hash_table_remove (priv->connections, (gpointer) cpath);
 	g_clear_pointer (&priv->connections_cached_list, g_free);
 
@@ -947,20 +973,18 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 	GError *error = NULL;
-	GHashTableIter iter;
-	gpointer data;
 	const char *path;
+	const char *uuid;
 	NMSettingsConnection *existing;
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (connection));
 	g_return_if_fail (nm_connection_get_path (NM_CONNECTION (connection)) == NULL);
 
-	g_hash_table_iter_init (&iter, priv->connections);
-	while (g_hash_table_iter_next (&iter, NULL, &data)) {
-		/* prevent duplicates */
-		if (data == connection)
-			return;
-	}
+	/* prevent duplicates */
+	uuid = nm_settings_connection_get_uuid (connection);
+	if (   uuid
+	    && g_hash_table_lookup (priv->connections_by_uuid, uuid) == connection)
+		return;
 
 	if (!nm_connection_normalize (NM_CONNECTION (connection), NULL, NULL, &error)) {
 		_LOGW ("plugin provided invalid connection: %s", error->message);
@@ -1021,6 +1045,9 @@ claim_connection (NMSettings *self, NMSettingsConnection *connection)
 	g_hash_table_insert (priv->connections,
 	                     (gpointer) nm_connection_get_path (NM_CONNECTION (connection)),
 	                     g_object_ref (connection));
+	g_hash_table_insert (priv->connections_by_uuid,
+	                     g_strdup (nm_settings_connection_get_uuid (connection)),
+	                     connection);
 	g_clear_pointer (&priv->connections_cached_list, g_free);
 
 	nm_utils_log_connection_diff (NM_CONNECTION (connection), NULL, LOGL_DEBUG, LOGD_CORE, "new connection", "++ ");
@@ -1886,6 +1913,7 @@ nm_settings_init (NMSettings *self)
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
 	priv->connections = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_object_unref);
+	priv->connections_by_uuid = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
 	/* Hold a reference to the agent manager so it stays alive; the only
 	 * other holders are NMSettingsConnection objects which are often
@@ -1932,6 +1960,7 @@ finalize (GObject *object)
 	NMSettings *self = NM_SETTINGS (object);
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
+	g_hash_table_destroy (priv->connections_by_uuid);
 	g_hash_table_destroy (priv->connections);
 	g_clear_pointer (&priv->connections_cached_list, g_free);
 
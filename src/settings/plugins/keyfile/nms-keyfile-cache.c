@@ -0,0 +1,354 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service - keyfile plugin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nms-keyfile-cache.h"
+
+#include "nm-core-internal.h"
+
+#include "NetworkManagerUtils.h"
+
+/*****************************************************************************/
+
+/* The cache file holds the already normalized connections of the keyfiles
+ * that were loaded the last time, serialized as one GVariant. It is memory
+ * mapped on load, and the connections are only deserialized when the keyfile
+ * they belong to is still unchanged (same inode, size, mtime and ctime).
+ *
+ * The cache is only valid for the very same version of NetworkManager,
+ * because reading and normalizing keyfiles may behave differently across
+ * versions. */
+#define CACHE_FORMAT_VERSION  1
+#define CACHE_VARIANT_TYPE    G_VARIANT_TYPE ("(usa(sttttta{sa{sv}}))")
+
+typedef struct {
+	guint64 dev;
+	guint64 ino;
+	guint64 size;
+	guint64 mtime_ns;
+	guint64 ctime_ns;
+	GVariant *connection;
+	bool seen:1;
+} CacheEntry;
+
+/* lookup and update may be called from the worker threads of
+ * nms_keyfile_reader_from_files(), hence the mutex. */
+struct _NMSKeyfileCache {
+	GMutex lock;
+	char *filename;
+	GHashTable *entries;   /* path -> CacheEntry */
+	bool dirty:1;
+};
+
+/*****************************************************************************/
+
+#define _NMLOG_DOMAIN      LOGD_SETTINGS
+#define _NMLOG(level, ...) \
+    nm_log ((level), _NMLOG_DOMAIN, NULL, NULL, \
+            "keyfile: cache: " _NM_UTILS_MACRO_FIRST (__VA_ARGS__) \
+            _NM_UTILS_MACRO_REST (__VA_ARGS__))
+
+/*****************************************************************************/
+
+static void
+_entry_free (gpointer data)
+{
+	CacheEntry *entry = data;
+
+	g_variant_unref (entry->connection);
+	g_slice_free (CacheEntry, entry);
+}
+
+static void
+_entry_set_stat (CacheEntry *entry, const struct stat *st)
+{
+	entry->dev = st->st_dev;
+	entry->ino = st->st_ino;
+	entry->size = st->st_size;
+	entry->mtime_ns = (guint64) st->st_mtim.tv_sec * NM_UTILS_NS_PER_SECOND + st->st_mtim.tv_nsec;
+	entry->ctime_ns = (guint64) st->st_ctim.tv_sec * NM_UTILS_NS_PER_SECOND + st->st_ctim.tv_nsec;
+}
+
+static gboolean
+_entry_matches_stat (const CacheEntry *entry, const struct stat *st)
+{
+	CacheEntry tmp;
+
+	_entry_set_stat (&tmp, st);
+	return    entry->dev == tmp.dev
+	       && entry->ino == tmp.ino
+	       && entry->size == tmp.size
+	       && entry->mtime_ns == tmp.mtime_ns
+	       && entry->ctime_ns == tmp.ctime_ns;
+}
+
+/*****************************************************************************/
+
+static void
+_load (NMSKeyfileCache *cache)
+{
+	gs_free_error GError *error = NULL;
+	GMappedFile *mapped;
+	gs_unref_bytes GBytes *bytes = NULL;
+	gs_unref_variant GVariant *blob = NULL;
+	gs_unref_variant GVariant *entries = NULL;
+	const char *version;
+	guint32 format;
+	GVariantIter iter;
+	const char *path;
+	CacheEntry e;
+
+	mapped = g_mapped_file_new (cache->filename, FALSE, &error);
+	if (!mapped) {
+		if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+			_LOGD ("cannot read \"%s\": %s", cache->filename, error->message);
+		return;
+	}
+	bytes = g_mapped_file_get_bytes (mapped);
+	g_mapped_file_unref (mapped);
+
+	/* the file content is not trusted. GVariant validates the serialized
+	 * data on access. */
+	blob = g_variant_ref_sink (g_variant_new_from_bytes (CACHE_VARIANT_TYPE, bytes, FALSE));
+
+	g_variant_get (blob, "(u&s@a(sttttta{sa{sv}}))", &format, &version, &entries);
+	if (   format != CACHE_FORMAT_VERSION
+	    || !nm_streq (version, NM_DIST_VERSION)) {
+		_LOGD ("ignore \"%s\" written by a different version", cache->filename);
+		return;
+	}
+
+	g_variant_iter_init (&iter, entries);
+	while (g_variant_iter_next (&iter, "(&sttttt@a{sa{sv}})",
+	                            &path,
+	                            &e.dev, &e.ino, &e.size, &e.mtime_ns, &e.ctime_ns,
+	                            &e.connection)) {
+		CacheEntry *entry;
+
+		if (path[0] != '/') {
+			g_variant_unref (e.connection);
+			continue;
+		}
+
+		/* the connection variant references the mapped file, it is not copied. */
+		entry = g_slice_new (CacheEntry);
+		*entry = e;
+		entry->seen = FALSE;
+		g_hash_table_insert (cache->entries, g_strdup (path), entry);
+	}
+
+	_LOGD ("loaded %u entries from \"%s\"", g_hash_table_size (cache->entries), cache->filename);
+}
+
+/**
+ * nms_keyfile_cache_new:
+ * @filename: the file where the cache is stored.
+ *
+ * Returns: a new cache instance, loaded from @filename
+ *   if it exists and is valid. Otherwise, the cache starts
+ *   out empty.
+ */
+NMSKeyfileCache *
+nms_keyfile_cache_new (const char *filename)
+{
+	NMSKeyfileCache *cache;
+
+	g_return_val_if_fail (filename && filename[0] == '/', NULL);
+
+	cache = g_slice_new0 (NMSKeyfileCache);
+	g_mutex_init (&cache->lock);
+	cache->filename = g_strdup (filename);
+	cache->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, _entry_free);
+	_load (cache);
+	return cache;
+}
+
+void
+nms_keyfile_cache_free (NMSKeyfileCache *cache)
+{
+	if (!cache)
+		return;
+
+	g_hash_table_unref (cache->entries);
+	g_free (cache->filename);
+	g_mutex_clear (&cache->lock);
+	g_slice_free (NMSKeyfileCache, cache);
+}
+
+/**
+ * nms_keyfile_cache_lookup:
+ * @cache: the cache instance
+ * @full_path: the path of the keyfile
+ * @st: the current stat of @full_path
+ *
+ * Returns: (transfer full): the cached, normalized connection for @full_path
+ *   or %NULL if there is no entry or the file changed in the meantime.
+ */
+NMConnection *
+nms_keyfile_cache_lookup (NMSKeyfileCache *cache,
+                          const char *full_path,
+                          const struct stat *st)
+{
+	gs_free_error GError *error = NULL;
+	gs_unref_variant GVariant *variant = NULL;
+	CacheEntry *entry;
+	NMConnection *connection;
+
+	g_return_val_if_fail (cache, NULL);
+	g_return_val_if_fail (full_path, NULL);
+	g_return_val_if_fail (st, NULL);
+
+	g_mutex_lock (&cache->lock);
+	entry = g_hash_table_lookup (cache->entries, full_path);
+	if (entry) {
+		if (_entry_matches_stat (entry, st)) {
+			variant = g_variant_ref (entry->connection);
+			entry->seen = TRUE;
+		} else {
+			g_hash_table_remove (cache->entries, full_path);
+			cache->dirty = TRUE;
+		}
+	}
+	g_mutex_unlock (&cache->lock);
+
+	if (!variant)
+		return NULL;
+
+	/* the connection was normalized before it was put into the cache.
+	 * Don't normalize again, it happens anyway when the connection is
+	 * passed to nm_settings_connection_replace_settings(). */
+	connection = _nm_simple_connection_new_from_dbus (variant,
+	                                                  NM_SETTING_PARSE_FLAGS_NONE,
+	                                                  &error);
+	if (!connection) {
+		_LOGD ("drop invalid entry for \"%s\": %s", full_path, error->message);
+		g_mutex_lock (&cache->lock);
+		entry = g_hash_table_lookup (cache->entries, full_path);
+		if (entry && entry->connection == variant) {
+			g_hash_table_remove (cache->entries, full_path);
+			cache->dirty = TRUE;
+		}
+		g_mutex_unlock (&cache->lock);
+		return NULL;
+	}
+
+	return connection;
+}
+
+/**
+ * nms_keyfile_cache_update:
+ * @cache: the cache instance
+ * @full_path: the path of the keyfile
+ * @st: the stat of @full_path at the time it was read
+ * @connection: the normalized connection read from @full_path
+ *
+ * Adds or replaces the cache entry for @full_path. The change
+ * is only persisted by nms_keyfile_cache_commit().
+ */
+void
+nms_keyfile_cache_update (NMSKeyfileCache *cache,
+                          const char *full_path,
+                          const struct stat *st,
+                          NMConnection *connection)
+{
+	CacheEntry *entry;
+
+	g_return_if_fail (cache);
+	g_return_if_fail (full_path && full_path[0] == '/');
+	g_return_if_fail (st);
+	g_return_if_fail (NM_IS_CONNECTION (connection));
+
+	entry = g_slice_new0 (CacheEntry);
+	_entry_set_stat (entry, st);
+	entry->connection = g_variant_ref_sink (nm_connection_to_dbus (connection, NM_CONNECTION_SERIALIZE_ALL));
+	entry->seen = TRUE;
+
+	g_mutex_lock (&cache->lock);
+	g_hash_table_insert (cache->entries, g_strdup (full_path), entry);
+	cache->dirty = TRUE;
+	g_mutex_unlock (&cache->lock);
+}
+
+/**
+ * nms_keyfile_cache_commit:
+ * @cache: the cache instance
+ * @error: (allow-none): return location for a #GError
+ *
+ * Drops all entries that were neither looked up successfully nor updated
+ * since the last commit (because their keyfiles no longer exist) and writes
+ * the cache file, if anything changed. Unlike lookup and update,
+ * this must not run concurrently with other users of @cache.
+ *
+ * Returns: %TRUE on success.
+ */
+gboolean
+nms_keyfile_cache_commit (NMSKeyfileCache *cache, GError **error)
+{
+	GVariantBuilder builder;
+	GHashTableIter iter;
+	const char *path;
+	CacheEntry *entry;
+	gs_unref_variant GVariant *blob = NULL;
+
+	g_return_val_if_fail (cache, FALSE);
+
+	g_hash_table_iter_init (&iter, cache->entries);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+		if (!entry->seen) {
+			g_hash_table_iter_remove (&iter);
+			cache->dirty = TRUE;
+		}
+	}
+
+	if (!cache->dirty)
+		goto out;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sttttta{sa{sv}})"));
+	g_hash_table_iter_init (&iter, cache->entries);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &path, (gpointer *) &entry)) {
+		g_variant_builder_add (&builder, "(sttttt@a{sa{sv}})",
+		                       path,
+		                       entry->dev, entry->ino, entry->size,
+		                       entry->mtime_ns, entry->ctime_ns,
+		                       entry->connection);
+	}
+	blob = g_variant_ref_sink (g_variant_new ("(usa(sttttta{sa{sv}}))",
+	                                          (guint32) CACHE_FORMAT_VERSION,
+	                                          NM_DIST_VERSION,
+	                                          &builder));
+
+	/* the connections contain secrets. */
+	if (!nm_utils_file_set_contents (cache->filename,
+	                                 g_variant_get_data (blob),
+	                                 g_variant_get_size (blob),
+	                                 0600,
+	                                 error))
+		return FALSE;
+
+	_LOGD ("wrote %u entries to \"%s\"", g_hash_table_size (cache->entries), cache->filename);
+	cache->dirty = FALSE;
+
+out:
+	g_hash_table_iter_init (&iter, cache->entries);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+		entry->seen = FALSE;
+	return TRUE;
+}
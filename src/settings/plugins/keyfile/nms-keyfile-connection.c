@@ -136,9 +136,24 @@ nms_keyfile_connection_init (NMSKeyfileConnection *connection)
 {
 }
 
+/**
+ * nms_keyfile_connection_new:
+ * @source: (allow-none): if given, create the connection from
+ *   this in-memory connection instead of reading @full_path.
+ * @full_path: (allow-none): the keyfile of the connection
+ * @preread: (allow-none): if given and @source is %NULL, the
+ *   connection as already read from @full_path, for example by
+ *   nms_keyfile_reader_from_files().
+ * @cache: (allow-none): the cache used when reading @full_path.
+ * @error: return location for a #GError
+ *
+ * Returns: the new connection or %NULL on failure.
+ */
 NMSKeyfileConnection *
 nms_keyfile_connection_new (NMConnection *source,
                             const char *full_path,
+                            NMConnection *preread,
+                            NMSKeyfileCache *cache,
                             GError **error)
 {
 	GObject *object;
@@ -152,9 +167,13 @@ nms_keyfile_connection_new (NMConnection *source,
 	if (source)
 		tmp = g_object_ref (source);
 	else {
-		tmp = nms_keyfile_reader_from_file (full_path, error);
-		if (!tmp)
-			return NULL;
+		if (preread)
+			tmp = g_object_ref (preread);
+		else {
+			tmp = nms_keyfile_reader_from_file_full (full_path, cache, error);
+			if (!tmp)
+				return NULL;
+		}
 
 		uuid = nm_connection_get_uuid (NM_CONNECTION (tmp));
 		if (!uuid) {
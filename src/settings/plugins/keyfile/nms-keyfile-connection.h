@@ -24,6 +24,8 @@
 
 #include "settings/nm-settings-connection.h"
 
+#include "nms-keyfile-cache.h"
+
 #define NMS_TYPE_KEYFILE_CONNECTION            (nms_keyfile_connection_get_type ())
 #define NMS_KEYFILE_CONNECTION(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NMS_TYPE_KEYFILE_CONNECTION, NMSKeyfileConnection))
 #define NMS_KEYFILE_CONNECTION_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), NMS_TYPE_KEYFILE_CONNECTION, NMSKeyfileConnectionClass))
@@ -38,6 +40,8 @@ GType nms_keyfile_connection_get_type (void);
 
 NMSKeyfileConnection *nms_keyfile_connection_new (NMConnection *source,
                                                   const char *filename,
+                                                  NMConnection *preread,
+                                                  NMSKeyfileCache *cache,
                                                   GError **error);
 
 #endif /* __NMS_KEYFILE_CONNECTION_H__ */
@@ -53,6 +53,9 @@ typedef struct {
 	gulong monitor_id;
 
 	NMConfig *config;
+
+	/* normalized connections from the previous run, see read_connections(). */
+	NMSKeyfileCache *cache;
 } NMSKeyfilePluginPrivate;
 
 struct _NMSKeyfilePlugin {
@@ -72,6 +75,11 @@ G_DEFINE_TYPE_EXTENDED (NMSKeyfilePlugin, nms_keyfile_plugin, G_TYPE_OBJECT, 0,
 
 #define NMS_KEYFILE_PLUGIN_GET_PRIVATE(self) _NM_GET_PRIVATE (self, NMSKeyfilePlugin, NMS_IS_KEYFILE_PLUGIN)
 
+#define KEYFILE_CACHE_FILE NMSTATEDIR "/keyfile-cache"
+
+/* upper bound for the threads used to read the keyfiles on startup. */
+#define KEYFILE_READER_MAX_THREADS 8
+
 /*****************************************************************************/
 
 #define _NMLOG_PREFIX_NAME      "keyfile"
@@ -136,6 +144,8 @@ find_by_path (NMSKeyfilePlugin *self, const char *path)
  *   and updates it. When passing @source, this adds a connection from
  *   memory.
  * @full_path: the filename of the keyfile to be loaded
+ * @preread: (allow-none): if given (and @source is %NULL), the connection
+ *   that was already read from @full_path.
  * @connection: an existing connection that might be updated.
  *   If given, @connection must be an existing connection that is currently
  *   owned by the plugin.
@@ -165,6 +175,7 @@ static NMSKeyfileConnection *
 update_connection (NMSKeyfilePlugin *self,
                    NMConnection *source,
                    const char *full_path,
+                   NMConnection *preread,
                    NMSKeyfileConnection *connection,
                    gboolean protect_existing_connection,
                    GHashTable *protected_connections,
@@ -182,7 +193,7 @@ update_connection (NMSKeyfilePlugin *self,
 	if (full_path)
 		_LOGD ("loading from file \"%s\"...", full_path);
 
-	connection_new = nms_keyfile_connection_new (source, full_path, &local);
+	connection_new = nms_keyfile_connection_new (source, full_path, preread, priv->cache, &local);
 	if (!connection_new) {
 		/* Error; remove the connection */
 		if (source)
@@ -324,7 +335,7 @@ dir_changed (GFileMonitor *monitor,
 	case G_FILE_MONITOR_EVENT_CREATED:
 	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
 		if (exists)
-			update_connection (NMS_KEYFILE_PLUGIN (config), NULL, full_path, connection, TRUE, NULL, NULL);
+			update_connection (NMS_KEYFILE_PLUGIN (config), NULL, full_path, NULL, connection, TRUE, NULL, NULL);
 		break;
 	default:
 		break;
@@ -425,6 +436,8 @@ read_connections (NMSettingsPlugin *config)
 	guint i;
 	GPtrArray *filenames;
 	GHashTable *paths;
+	NMConnection **prereads;
+	GPtrArray **preread_warnings;
 
 	dir = g_dir_open (nms_keyfile_utils_get_path (), 0, &error);
 	if (!dir) {
@@ -437,6 +450,12 @@ read_connections (NMSettingsPlugin *config)
 
 	alive_connections = g_hash_table_new (NULL, NULL);
 
+	/* Parsing and normalizing the keyfiles is what takes time with many
+	 * profiles. Reuse the result from the previous run for all files
+	 * that didn't change. */
+	if (!priv->cache)
+		priv->cache = nms_keyfile_cache_new (KEYFILE_CACHE_FILE);
+
 	filenames = g_ptr_array_new_with_free_func (g_free);
 	while ((item = g_dir_read_name (dir))) {
 		if (nms_keyfile_utils_should_ignore_file (item))
@@ -455,13 +474,36 @@ read_connections (NMSettingsPlugin *config)
 	g_ptr_array_sort_with_data (filenames, (GCompareDataFunc) _sort_paths, paths);
 	g_hash_table_destroy (paths);
 
+	/* Read and parse the files on worker threads. Only claiming the
+	 * connections happens here, in the sorted order. */
+	prereads = nms_keyfile_reader_from_files ((const char *const *) filenames->pdata,
+	                                          filenames->len,
+	                                          priv->cache,
+	                                          MIN (g_get_num_processors (), KEYFILE_READER_MAX_THREADS),
+	                                          &preread_warnings);
+
 	for (i = 0; i < filenames->len; i++) {
-		connection = update_connection (self, NULL, filenames->pdata[i], NULL, FALSE, alive_connections, NULL);
+		/* the workers don't log. Log the parser warnings of the file here, in
+		 * order. Files that failed to load are read again, which reports the
+		 * error and the warnings. */
+		if (preread_warnings[i]) {
+			nms_keyfile_reader_log_warnings (preread_warnings[i]);
+			g_ptr_array_unref (preread_warnings[i]);
+		}
+		connection = update_connection (self, NULL, filenames->pdata[i], prereads[i], NULL, FALSE, alive_connections, NULL);
 		if (connection)
 			g_hash_table_add (alive_connections, connection);
+		g_clear_object (&prereads[i]);
 	}
+	g_free (prereads);
+	g_free (preread_warnings);
 	g_ptr_array_free (filenames, TRUE);
 
+	if (!nms_keyfile_cache_commit (priv->cache, &error)) {
+		_LOGD ("cannot write cache \"%s\": %s", KEYFILE_CACHE_FILE, error->message);
+		g_clear_error (&error);
+	}
+
 	g_hash_table_iter_init (&iter, priv->connections);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &connection)) {
 		if (   !g_hash_table_contains (alive_connections, connection)
@@ -511,7 +553,7 @@ load_connection (NMSettingsPlugin *config,
 	if (nms_keyfile_utils_should_ignore_file (filename + dir_len + 1))
 		return FALSE;
 
-	connection = update_connection (self, NULL, filename, find_by_path (self, filename), TRUE, NULL, NULL);
+	connection = update_connection (self, NULL, filename, NULL, find_by_path (self, filename), TRUE, NULL, NULL);
 
 	return (connection != NULL);
 }
@@ -542,7 +584,7 @@ add_connection (NMSettingsPlugin *config,
 		                                    error))
 			return NULL;
 	}
-	return NM_SETTINGS_CONNECTION (update_connection (self, reread ?: connection, path, NULL, FALSE, NULL, error));
+	return NM_SETTINGS_CONNECTION (update_connection (self, reread ?: connection, path, NULL, NULL, FALSE, NULL, error));
 }
 
 static GSList *
@@ -628,6 +670,8 @@ dispose (GObject *object)
 		priv->connections = NULL;
 	}
 
+	g_clear_pointer (&priv->cache, nms_keyfile_cache_free);
+
 	if (priv->config) {
 		g_signal_handlers_disconnect_by_func (priv->config, config_changed_cb, object);
 		g_clear_object (&priv->config);
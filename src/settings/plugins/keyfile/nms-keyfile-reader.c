@@ -56,8 +56,27 @@ _fmt_warn (const char *group, NMSetting *setting, const char *property_name, con
 		return message;
 }
 
+typedef struct {
+	NMLogLevel level;
+	char *uuid;
+	char *message;
+} DeferredWarning;
+
+static void
+_deferred_warning_free (gpointer data)
+{
+	DeferredWarning *w = data;
+
+	g_free (w->uuid);
+	g_free (w->message);
+	g_slice_free (DeferredWarning, w);
+}
+
 typedef struct {
 	bool verbose;
+
+	/* if set, warnings are collected here instead of being logged. */
+	GPtrArray *warnings;
 } HandlerReadData;
 
 static gboolean
@@ -87,12 +106,24 @@ _handler_read (GKeyFile *keyfile,
 		else
 			level = LOGL_INFO;
 
-		nm_log (level, LOGD_SETTINGS, NULL,
-		        nm_connection_get_uuid (connection),
-		        "keyfile: %s",
-		        _fmt_warn (warn_data->group, warn_data->setting,
-		                   warn_data->property_name, warn_data->message,
-		                   &message_free));
+		if (handler_data->warnings) {
+			DeferredWarning *w;
+
+			w = g_slice_new (DeferredWarning);
+			w->level = level;
+			w->uuid = g_strdup (nm_connection_get_uuid (connection));
+			w->message = g_strdup (_fmt_warn (warn_data->group, warn_data->setting,
+			                                  warn_data->property_name, warn_data->message,
+			                                  &message_free));
+			g_ptr_array_add (handler_data->warnings, w);
+		} else {
+			nm_log (level, LOGD_SETTINGS, NULL,
+			        nm_connection_get_uuid (connection),
+			        "keyfile: %s",
+			        _fmt_warn (warn_data->group, warn_data->setting,
+			                   warn_data->property_name, warn_data->message,
+			                   &message_free));
+		}
 		g_free (message_free);
 		return TRUE;
 	}
@@ -114,6 +145,43 @@ nms_keyfile_reader_from_keyfile (GKeyFile *key_file,
 
 NMConnection *
 nms_keyfile_reader_from_file (const char *filename, GError **error)
+{
+	return nms_keyfile_reader_from_file_full (filename, NULL, error);
+}
+
+static NMConnection *
+_read_file (const char *filename,
+            NMSKeyfileCache *cache,
+            HandlerReadData *handler_data,
+            GError **error);
+
+/**
+ * nms_keyfile_reader_from_file_full:
+ * @filename: the keyfile to read
+ * @cache: (allow-none): if given, the normalized connection is taken
+ *   from @cache if @filename didn't change since it was put there.
+ *   Otherwise the file is parsed and the result stored in @cache.
+ * @error: return location for a #GError
+ *
+ * Returns: (transfer full): the normalized connection read from @filename.
+ */
+NMConnection *
+nms_keyfile_reader_from_file_full (const char *filename,
+                                   NMSKeyfileCache *cache,
+                                   GError **error)
+{
+	HandlerReadData handler_data = {
+		.verbose = TRUE,
+	};
+
+	return _read_file (filename, cache, &handler_data, error);
+}
+
+static NMConnection *
+_read_file (const char *filename,
+            NMSKeyfileCache *cache,
+            HandlerReadData *handler_data,
+            GError **error)
 {
 	GKeyFile *key_file;
 	struct stat statbuf;
@@ -142,11 +210,17 @@ nms_keyfile_reader_from_file (const char *filename, GError **error)
 		}
 	}
 
+	if (cache) {
+		connection = nms_keyfile_cache_lookup (cache, filename, &statbuf);
+		if (connection)
+			return connection;
+	}
+
 	key_file = g_key_file_new ();
 	if (!g_key_file_load_from_file (key_file, filename, G_KEY_FILE_NONE, error))
 		goto out;
 
-	connection = nms_keyfile_reader_from_keyfile (key_file, filename, TRUE, error);
+	connection = nm_keyfile_read (key_file, filename, NULL, _handler_read, handler_data, error);
 	if (!connection)
 		goto out;
 
@@ -158,10 +232,139 @@ nms_keyfile_reader_from_file (const char *filename, GError **error)
 		g_clear_error (&verify_error);
 		g_object_unref (connection);
 		connection = NULL;
+		goto out;
 	}
 
+	if (cache)
+		nms_keyfile_cache_update (cache, filename, &statbuf, connection);
+
 out:
 	g_key_file_free (key_file);
 	return connection;
 }
 
+/*****************************************************************************/
+
+typedef struct {
+	const char *const *filenames;
+	NMSKeyfileCache *cache;
+	NMConnection **connections;
+	GPtrArray **warnings;
+} ReadFilesData;
+
+static void
+_read_files_job (gpointer job, gpointer user_data)
+{
+	ReadFilesData *data = user_data;
+	guint i = GPOINTER_TO_UINT (job) - 1;
+	HandlerReadData handler_data = {
+		.verbose = !!data->warnings,
+	};
+
+	if (data->warnings)
+		handler_data.warnings = g_ptr_array_new_with_free_func (_deferred_warning_free);
+
+	/* errors are ignored here. The caller retries failed files on the main thread,
+	 * where they are reported as usual. Warnings are not logged on the worker
+	 * either, but handed to the caller. */
+	data->connections[i] = _read_file (data->filenames[i], data->cache, &handler_data, NULL);
+
+	if (handler_data.warnings) {
+		if (data->connections[i] && handler_data.warnings->len > 0)
+			data->warnings[i] = handler_data.warnings;
+		else {
+			/* a failed file is read again by the caller, which logs
+			 * the warnings again. Drop them here. */
+			g_ptr_array_unref (handler_data.warnings);
+		}
+	}
+}
+
+/**
+ * nms_keyfile_reader_log_warnings:
+ * @warnings: (allow-none): the warnings of one file, as returned by
+ *   nms_keyfile_reader_from_files().
+ *
+ * Logs the parser warnings that were collected on a worker thread.
+ */
+void
+nms_keyfile_reader_log_warnings (GPtrArray *warnings)
+{
+	guint i;
+
+	if (!warnings)
+		return;
+
+	for (i = 0; i < warnings->len; i++) {
+		const DeferredWarning *w = warnings->pdata[i];
+
+		nm_log (w->level, LOGD_SETTINGS, NULL, w->uuid, "keyfile: %s", w->message);
+	}
+}
+
+/**
+ * nms_keyfile_reader_from_files:
+ * @filenames: the keyfiles to read
+ * @n_filenames: the number of @filenames
+ * @cache: (allow-none): the cache passed on to nms_keyfile_reader_from_file_full()
+ * @n_threads: the maximum number of worker threads. 0 means one per CPU.
+ * @out_warnings: (allow-none) (out): if given, returns an array of @n_filenames
+ *   #GPtrArray with the parser warnings of each file that was read successfully,
+ *   or %NULL if there are none. Log them with nms_keyfile_reader_log_warnings()
+ *   when claiming the connection, then unref the arrays and g_free() the array.
+ *   If not given, warnings are not logged at all.
+ *
+ * Reads, parses and normalizes @filenames like nms_keyfile_reader_from_file_full(),
+ * but spreads the work over a pool of worker threads. Nothing of this needs the
+ * main loop, only the finished connections are handed back to the caller.
+ * The function returns when all files are read.
+ *
+ * Returns: (transfer full): an array of @n_filenames connections, in the order of
+ *   @filenames. Entries for files that could not be read are %NULL.
+ *   Unref the connections and free the array with g_free().
+ */
+NMConnection **
+nms_keyfile_reader_from_files (const char *const *filenames,
+                               guint n_filenames,
+                               NMSKeyfileCache *cache,
+                               guint n_threads,
+                               GPtrArray ***out_warnings)
+{
+	ReadFilesData data = {
+		.filenames = filenames,
+		.cache = cache,
+	};
+	GThreadPool *pool;
+	guint i;
+
+	g_return_val_if_fail (filenames || n_filenames == 0, NULL);
+
+	data.connections = g_new0 (NMConnection *, MAX (n_filenames, 1));
+	if (out_warnings) {
+		data.warnings = g_new0 (GPtrArray *, MAX (n_filenames, 1));
+		*out_warnings = data.warnings;
+	}
+
+	if (n_threads == 0)
+		n_threads = g_get_num_processors ();
+	n_threads = MIN (n_threads, n_filenames);
+
+	if (n_threads <= 1) {
+		for (i = 0; i < n_filenames; i++)
+			_read_files_job (GUINT_TO_POINTER (i + 1), &data);
+		return data.connections;
+	}
+
+	/* the worker threads create NMSetting instances. Make sure all setting
+	 * types are registered before that happens concurrently. */
+	_nm_setting_ensure_all_registered ();
+
+	pool = g_thread_pool_new (_read_files_job, &data, n_threads, TRUE, NULL);
+	for (i = 0; i < n_filenames; i++)
+		g_thread_pool_push (pool, GUINT_TO_POINTER (i + 1), NULL);
+
+	/* wait for all jobs to complete. */
+	g_thread_pool_free (pool, FALSE, TRUE);
+
+	return data.connections;
+}
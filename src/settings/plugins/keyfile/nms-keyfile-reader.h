@@ -24,6 +24,8 @@
 
 #include "nm-connection.h"
 
+#include "nms-keyfile-cache.h"
+
 NMConnection *nms_keyfile_reader_from_keyfile (GKeyFile *key_file,
                                                const char *filename,
                                                gboolean verbose,
@@ -31,4 +33,16 @@ NMConnection *nms_keyfile_reader_from_keyfile (GKeyFile *key_file,
 
 NMConnection *nms_keyfile_reader_from_file (const char *filename, GError **error);
 
+NMConnection *nms_keyfile_reader_from_file_full (const char *filename,
+                                                 NMSKeyfileCache *cache,
+                                                 GError **error);
+
+NMConnection **nms_keyfile_reader_from_files (const char *const *filenames,
+                                              guint n_filenames,
+                                              NMSKeyfileCache *cache,
+                                              guint n_threads,
+                                              GPtrArray ***out_warnings);
+
+void nms_keyfile_reader_log_warnings (GPtrArray *warnings);
+
 #endif /* __NMS_KEYFILE_READER_H__ */
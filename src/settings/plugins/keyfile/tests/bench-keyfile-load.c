@@ -0,0 +1,198 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager system settings service - keyfile plugin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2018 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "nm-utils.h"
+#include "nm-core-utils.h"
+#include "settings/plugins/keyfile/nms-keyfile-reader.h"
+
+#include "nm-test-utils-core.h"
+
+NMTST_DEFINE ();
+
+static struct {
+	int count;
+	int threads;
+	gboolean keep;
+} global_opt = {
+	.count = 1000,
+};
+
+static gboolean
+read_argv (int *argc, char ***argv)
+{
+	GOptionContext *context;
+	GOptionEntry options[] = {
+		{ "count", 'n', 0, G_OPTION_ARG_INT, &global_opt.count, "Number of keyfiles to generate (default 1000)", "N" },
+		{ "threads", 't', 0, G_OPTION_ARG_INT, &global_opt.threads, "Measure with 1 up to this many threads (default: number of CPUs)", "N" },
+		{ "keep", 'k', 0, G_OPTION_ARG_NONE, &global_opt.keep, "Don't delete the generated keyfiles", NULL },
+		{ 0 },
+	};
+	gs_free_error GError *error = NULL;
+
+	context = g_option_context_new (NULL);
+	g_option_context_set_summary (context, "Measure how long it takes to read keyfiles with a varying number of threads.");
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, argc, argv, &error)) {
+		g_warning ("Error parsing command line arguments: %s", error->message);
+		g_option_context_free (context);
+		return FALSE;
+	}
+
+	g_option_context_free (context);
+	return TRUE;
+}
+
+static GPtrArray *
+generate_keyfiles (const char *dir, int count)
+{
+	GPtrArray *filenames;
+	int i;
+
+	filenames = g_ptr_array_new_with_free_func (g_free);
+	for (i = 0; i < count; i++) {
+		gs_free_error GError *error = NULL;
+		gs_free char *uuid = nm_utils_uuid_generate ();
+		gs_free char *content = NULL;
+		char *filename;
+
+		content = g_strdup_printf ("[connection]\n"
+		                           "id=bench-%d\n"
+		                           "uuid=%s\n"
+		                           "type=ethernet\n"
+		                           "interface-name=bench%d\n"
+		                           "autoconnect=false\n"
+		                           "\n"
+		                           "[ethernet]\n"
+		                           "mtu=1400\n"
+		                           "\n"
+		                           "[ipv4]\n"
+		                           "method=manual\n"
+		                           "address1=10.%d.%d.1/24,10.%d.%d.254\n"
+		                           "dns=192.0.2.1;192.0.2.2;\n"
+		                           "\n"
+		                           "[ipv6]\n"
+		                           "method=auto\n"
+		                           "addr-gen-mode=stable-privacy\n",
+		                           i, uuid, i,
+		                           (i / 256) % 256, i % 256,
+		                           (i / 256) % 256, i % 256);
+
+		filename = g_strdup_printf ("%s/bench-%d", dir, i);
+		if (!nm_utils_file_set_contents (filename, content, -1, 0600, &error))
+			g_error ("cannot write \"%s\": %s", filename, error->message);
+		g_ptr_array_add (filenames, filename);
+	}
+	return filenames;
+}
+
+static gint64
+measure (GPtrArray *filenames, NMSKeyfileCache *cache, guint n_threads)
+{
+	NMConnection **connections;
+	gint64 start, end;
+	guint i, n_failed = 0;
+
+	start = g_get_monotonic_time ();
+	connections = nms_keyfile_reader_from_files ((const char *const *) filenames->pdata,
+	                                             filenames->len,
+	                                             cache,
+	                                             n_threads,
+	                                             NULL);
+	end = g_get_monotonic_time ();
+
+	for (i = 0; i < filenames->len; i++) {
+		if (connections[i])
+			g_object_unref (connections[i]);
+		else
+			n_failed++;
+	}
+	g_free (connections);
+
+	if (n_failed)
+		g_error ("failed to read %u of %u keyfiles", n_failed, filenames->len);
+
+	return end - start;
+}
+
+int
+main (int argc, char **argv)
+{
+	gs_free_error GError *error = NULL;
+	gs_free char *dir = NULL;
+	gs_free char *cache_file = NULL;
+	GPtrArray *filenames;
+	NMSKeyfileCache *cache;
+	gint64 t;
+	guint i;
+
+	_nm_utils_set_testing (NM_UTILS_TEST_NO_KEYFILE_OWNER_CHECK);
+	nmtst_init_with_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	if (!read_argv (&argc, &argv))
+		return 2;
+
+	if (global_opt.count <= 0)
+		global_opt.count = 1;
+	if (global_opt.threads <= 0)
+		global_opt.threads = g_get_num_processors ();
+
+	dir = g_dir_make_tmp ("nm-bench-keyfile-XXXXXX", &error);
+	if (!dir)
+		g_error ("cannot create temporary directory: %s", error->message);
+
+	filenames = generate_keyfiles (dir, global_opt.count);
+	printf ("generated %d keyfiles in %s\n", global_opt.count, dir);
+
+	/* read once to warm up the page cache. */
+	measure (filenames, NULL, global_opt.threads);
+
+	for (i = 1; i <= (guint) global_opt.threads; i++) {
+		t = measure (filenames, NULL, i);
+		printf ("threads=%-3u %8.3f ms  (%.1f us/file)\n",
+		        i, t / 1000.0, (double) t / filenames->len);
+	}
+
+	/* for comparison, reading the connections from a populated cache. */
+	cache_file = g_strdup_printf ("%s/.keyfile-cache", dir);
+	cache = nms_keyfile_cache_new (cache_file);
+	measure (filenames, cache, global_opt.threads);
+	for (i = 1; i <= (guint) global_opt.threads; i++) {
+		t = measure (filenames, cache, i);
+		printf ("threads=%-3u %8.3f ms  (%.1f us/file, cached)\n",
+		        i, t / 1000.0, (double) t / filenames->len);
+	}
+	nms_keyfile_cache_free (cache);
+
+	if (!global_opt.keep) {
+		for (i = 0; i < filenames->len; i++)
+			unlink (filenames->pdata[i]);
+		unlink (cache_file);
+		rmdir (dir);
+	}
+
+	g_ptr_array_unref (filenames);
+	return 0;
+}
@@ -33,6 +33,9 @@
 #include "settings/plugins/keyfile/nms-keyfile-reader.h"
 #include "settings/plugins/keyfile/nms-keyfile-writer.h"
 #include "settings/plugins/keyfile/nms-keyfile-utils.h"
+#include "settings/plugins/keyfile/nms-keyfile-connection.h"
+#include "settings/nm-settings-connection.h"
+#include "nm-auth-manager.h"
 
 #include "nm-test-utils-core.h"
 
@@ -2645,6 +2648,195 @@ _escape_filename (const char *filename, gboolean would_be_ignored)
 		g_error ("Escaping filename \"%s\" yielded \"%s\", but this is ignored", filename, esc);
 }
 
+static void
+test_read_cached (void)
+{
+	const char *cache_file = TEST_SCRATCH_DIR "/keyfile-cache-test";
+	const char *testfile = TEST_KEYFILES_DIR "/Test_Flags_Property";
+	gs_unref_object NMConnection *connection = NULL;
+	gs_unref_object NMConnection *cached = NULL;
+	gs_free_error GError *error = NULL;
+	NMSKeyfileCache *cache;
+	struct stat st;
+	gboolean success;
+
+	unlink (cache_file);
+
+	/* the first read parses the file and populates the cache. */
+	cache = nms_keyfile_cache_new (cache_file);
+	connection = nms_keyfile_reader_from_file_full (testfile, cache, &error);
+	g_assert_no_error (error);
+	g_assert (connection);
+	success = nms_keyfile_cache_commit (cache, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	nms_keyfile_cache_free (cache);
+
+	g_assert (g_file_test (cache_file, G_FILE_TEST_EXISTS));
+
+	/* a new instance loads the entry from disk. */
+	g_assert_cmpint (stat (testfile, &st), ==, 0);
+	cache = nms_keyfile_cache_new (cache_file);
+	cached = nms_keyfile_cache_lookup (cache, testfile, &st);
+	g_assert (cached);
+	nmtst_assert_connection_equals (connection, FALSE, cached, FALSE);
+	g_clear_object (&cached);
+
+	/* a changed file invalidates the entry. */
+	st.st_mtim.tv_nsec = (st.st_mtim.tv_nsec + 1) % NM_UTILS_NS_PER_SECOND;
+	g_assert (!nms_keyfile_cache_lookup (cache, testfile, &st));
+
+	/* the entry is gone now, committing drops it from the file. */
+	success = nms_keyfile_cache_commit (cache, &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	nms_keyfile_cache_free (cache);
+
+	g_assert_cmpint (stat (testfile, &st), ==, 0);
+	cache = nms_keyfile_cache_new (cache_file);
+	g_assert (!nms_keyfile_cache_lookup (cache, testfile, &st));
+	nms_keyfile_cache_free (cache);
+
+	unlink (cache_file);
+}
+
+static const char *
+_settings_dbus_get_id (GVariant *settings)
+{
+	const char *id = NULL;
+	gs_unref_variant GVariant *s_con = NULL;
+
+	s_con = g_variant_lookup_value (settings, NM_SETTING_CONNECTION_SETTING_NAME, NM_VARIANT_TYPE_SETTING);
+	g_assert (s_con);
+	g_assert (g_variant_lookup (s_con, NM_SETTING_CONNECTION_ID, "&s", &id));
+	return id;
+}
+
+static void
+test_settings_connection_get_settings_cache (void)
+{
+	gs_unref_object NMConnection *source = NULL;
+	gs_unref_object NMSKeyfileConnection *connection = NULL;
+	gs_unref_variant GVariant *settings1 = NULL;
+	gs_unref_variant GVariant *settings2 = NULL;
+	gs_unref_variant GVariant *settings3 = NULL;
+	gs_unref_variant GVariant *settings4 = NULL;
+	gs_unref_variant GVariant *settings5 = NULL;
+	gs_unref_variant GVariant *s_wsec = NULL;
+	gs_free_error GError *error = NULL;
+	NMSettingConnection *s_con;
+	NMSettingWireless *s_wifi;
+	NMSettingWirelessSecurity *s_wsec_new;
+	GVariantBuilder secrets;
+	const char *psk;
+	GBytes *ssid;
+	gboolean success;
+
+	nm_auth_manager_setup (FALSE);
+
+	source = nmtst_create_minimal_connection ("settings-cache", NULL, NM_SETTING_WIRELESS_SETTING_NAME, &s_con);
+	s_wifi = nm_connection_get_setting_wireless (source);
+	ssid = g_bytes_new ("blahblah", 8);
+	g_object_set (s_wifi,
+	              NM_SETTING_WIRELESS_SSID, ssid,
+	              NULL);
+	g_bytes_unref (ssid);
+	s_wsec_new = (NMSettingWirelessSecurity *) nm_setting_wireless_security_new ();
+	g_object_set (s_wsec_new,
+	              NM_SETTING_WIRELESS_SECURITY_KEY_MGMT, "wpa-psk",
+	              NM_SETTING_WIRELESS_SECURITY_PSK, "old-passphrase",
+	              NULL);
+	nm_connection_add_setting (source, NM_SETTING (s_wsec_new));
+	nmtst_connection_normalize (source);
+
+	connection = nms_keyfile_connection_new (source, NULL, NULL, NULL, &error);
+	g_assert_no_error (error);
+	g_assert (NMS_IS_KEYFILE_CONNECTION (connection));
+
+	/* unchanged settings are served from the cache. */
+	settings1 = _nm_settings_connection_get_settings_dbus (NM_SETTINGS_CONNECTION (connection));
+	settings2 = _nm_settings_connection_get_settings_dbus (NM_SETTINGS_CONNECTION (connection));
+	g_assert (settings1);
+	g_assert (settings1 == settings2);
+	g_assert_cmpstr (_settings_dbus_get_id (settings1), ==, "settings-cache");
+
+	/* GetSettings never returns secrets. */
+	s_wsec = g_variant_lookup_value (settings1, NM_SETTING_WIRELESS_SECURITY_SETTING_NAME, NM_VARIANT_TYPE_SETTING);
+	g_assert (s_wsec);
+	g_assert (!g_variant_lookup (s_wsec, NM_SETTING_WIRELESS_SECURITY_PSK, "&s", &psk));
+
+	/* a changed profile yields a fresh variant. */
+	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_ID, "settings-cache-changed",
+	              NULL);
+	settings3 = _nm_settings_connection_get_settings_dbus (NM_SETTINGS_CONNECTION (connection));
+	g_assert (settings3 != settings1);
+	g_assert_cmpstr (_settings_dbus_get_id (settings1), ==, "settings-cache");
+	g_assert_cmpstr (_settings_dbus_get_id (settings3), ==, "settings-cache-changed");
+
+	/* so does a profile with updated secrets. */
+	g_variant_builder_init (&secrets, NM_VARIANT_TYPE_SETTING);
+	g_variant_builder_add (&secrets, "{sv}",
+	                       NM_SETTING_WIRELESS_SECURITY_PSK,
+	                       g_variant_new_string ("new-passphrase"));
+	success = nm_connection_update_secrets (NM_CONNECTION (connection),
+	                                        NM_SETTING_WIRELESS_SECURITY_SETTING_NAME,
+	                                        g_variant_builder_end (&secrets),
+	                                        &error);
+	g_assert_no_error (error);
+	g_assert (success);
+	settings4 = _nm_settings_connection_get_settings_dbus (NM_SETTINGS_CONNECTION (connection));
+	g_assert (settings4 != settings3);
+	g_assert (g_variant_equal (settings4, settings3));
+
+	/* and so does a new timestamp, which is only kept in private storage. */
+	nm_settings_connection_update_timestamp (NM_SETTINGS_CONNECTION (connection), 424242, FALSE);
+	settings5 = _nm_settings_connection_get_settings_dbus (NM_SETTINGS_CONNECTION (connection));
+	g_assert (settings5 != settings4);
+	g_assert (!g_variant_equal (settings5, settings4));
+}
+
+static void
+test_read_files_threaded (void)
+{
+	const char *const filenames[] = {
+		TEST_KEYFILES_DIR "/Test_Flags_Property",
+		TEST_KEYFILES_DIR "/Test_Enum_Property",
+		TEST_KEYFILES_DIR "/does-not-exist",
+		TEST_KEYFILES_DIR "/Test_Flags_Property",
+		TEST_KEYFILES_DIR "/Test_InfiniBand_Connection",
+	};
+	NMConnection **connections;
+	GPtrArray **warnings;
+	guint i;
+
+	connections = nms_keyfile_reader_from_files (filenames, G_N_ELEMENTS (filenames), NULL, 3, &warnings);
+	g_assert (connections);
+	g_assert (warnings);
+
+	for (i = 0; i < G_N_ELEMENTS (filenames); i++) {
+		gs_unref_object NMConnection *expected = NULL;
+
+		expected = nms_keyfile_reader_from_file (filenames[i], NULL);
+		if (!expected) {
+			g_assert (!connections[i]);
+			/* the caller reads failed files again, which logs their warnings. */
+			g_assert (!warnings[i]);
+		} else {
+			g_assert (connections[i]);
+			nmtst_assert_connection_equals (expected, FALSE, connections[i], FALSE);
+		}
+		g_clear_object (&connections[i]);
+		if (warnings[i])
+			g_ptr_array_unref (warnings[i]);
+	}
+	g_free (connections);
+	g_free (warnings);
+}
+
+/*****************************************************************************/
+
 static void
 test_nm_keyfile_plugin_utils_escape_filename (void)
 {
@@ -2748,6 +2940,10 @@ int main (int argc, char **argv)
 	g_test_add_func ("/keyfile/test_read_flags_property", test_read_flags_property);
 	g_test_add_func ("/keyfile/test_write_flags_property", test_write_flags_property);
 
+	g_test_add_func ("/keyfile/test_read_cached", test_read_cached);
+	g_test_add_func ("/keyfile/test_read_files_threaded", test_read_files_threaded);
+	g_test_add_func ("/keyfile/test_settings_connection_get_settings_cache", test_settings_connection_get_settings_cache);
+
 	g_test_add_func ("/keyfile/test_nm_keyfile_plugin_utils_escape_filename", test_nm_keyfile_plugin_utils_escape_filename);
 
 	return g_test_run ();
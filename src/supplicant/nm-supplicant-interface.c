@@ -41,10 +41,16 @@
 /*****************************************************************************/
 
 typedef struct {
-	GDBusProxy *proxy;
-	gulong change_id;
+	/* the last known properties of the BSS, by name. %NULL while the
+	 * initial GetAll call is pending. */
+	GHashTable *properties;
 } BssData;
 
+typedef struct {
+	NMSupplicantInterface *self;
+	char *object_path;
+} BssGetAllData;
+
 struct _AddNetworkData;
 
 typedef struct {
@@ -124,7 +130,8 @@ typedef struct {
 	AssocData *    assoc_data;
 
 	char *         net_path;
-	GHashTable *   bss_proxies;
+	GHashTable *   bss_hash;
+	guint          bss_props_changed_id;
 	char *         current_bss;
 
 	gint32         last_scan; /* timestamp as returned by nm_utils_get_monotonic_timestamp_s() */
@@ -192,121 +199,192 @@ bss_data_destroy (gpointer user_data)
 {
 	BssData *bss_data = user_data;
 
-	nm_clear_g_signal_handler (bss_data->proxy, &bss_data->change_id);
-	g_object_unref (bss_data->proxy);
+	if (bss_data->properties)
+		g_hash_table_unref (bss_data->properties);
 	g_slice_free (BssData, bss_data);
 }
 
 static void
-bss_proxy_properties_changed_cb (GDBusProxy *proxy,
-                                 GVariant *changed_properties,
-                                 char **invalidated_properties,
-                                 gpointer user_data)
+bss_data_update (BssData *bss_data, GVariant *properties)
+{
+	GVariantIter iter;
+	const char *name;
+	GVariant *value;
+
+	if (!bss_data->properties) {
+		bss_data->properties = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                              g_free, (GDestroyNotify) g_variant_unref);
+	}
+
+	g_variant_iter_init (&iter, properties);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value))
+		g_hash_table_insert (bss_data->properties, g_strdup (name), value);
+}
+
+static GVariant *
+bss_data_get_properties (BssData *bss_data)
+{
+	GVariantBuilder builder;
+	GHashTableIter iter;
+	const char *name;
+	GVariant *value;
+
+	nm_assert (bss_data->properties);
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+	g_hash_table_iter_init (&iter, bss_data->properties);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &value))
+		g_variant_builder_add (&builder, "{sv}", name, value);
+	return g_variant_builder_end (&builder);
+}
+
+static void
+bss_props_changed_cb (GDBusConnection *connection,
+                      const char *sender_name,
+                      const char *object_path,
+                      const char *interface_name,
+                      const char *signal_name,
+                      GVariant *parameters,
+                      gpointer user_data)
 {
 	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	gs_unref_variant GVariant *changed_properties = NULL;
+	BssData *bss_data;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+		return;
+
+	/* the subscription matches the BSSs of all interfaces. */
+	bss_data = g_hash_table_lookup (priv->bss_hash, object_path);
+	if (!bss_data || !bss_data->properties)
+		return;
 
 	if (priv->scanning)
 		priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
 
+	changed_properties = g_variant_get_child_value (parameters, 1);
+	bss_data_update (bss_data, changed_properties);
 	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
+	               object_path,
 	               changed_properties);
 }
 
-static GVariant *
-bss_proxy_get_properties (NMSupplicantInterface *self, GDBusProxy *proxy)
+static void
+bss_props_changed_subscribe (NMSupplicantInterface *self)
 {
-	gs_strfreev char **properties = NULL;
-	GVariantBuilder builder;
-	char **iter;
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	iter = properties = g_dbus_proxy_get_cached_property_names (proxy);
+	nm_assert (priv->iface_proxy);
+	nm_assert (!priv->bss_props_changed_id);
 
-	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
-	if (iter) {
-		while (*iter) {
-			GVariant *copy = g_dbus_proxy_get_cached_property (proxy, *iter);
+	/* A single subscription for the property changes of all BSSs, instead
+	 * of a GDBusProxy per BSS. */
+	priv->bss_props_changed_id = g_dbus_connection_signal_subscribe (g_dbus_proxy_get_connection (priv->iface_proxy),
+	                                                                 WPAS_DBUS_SERVICE,
+	                                                                 DBUS_INTERFACE_PROPERTIES,
+	                                                                 "PropertiesChanged",
+	                                                                 NULL,
+	                                                                 WPAS_DBUS_IFACE_BSS,
+	                                                                 G_DBUS_SIGNAL_FLAGS_NONE,
+	                                                                 bss_props_changed_cb,
+	                                                                 self,
+	                                                                 NULL);
+}
 
-			g_variant_builder_add (&builder, "{sv}", *iter++, copy);
-			g_variant_unref (copy);
-		}
+static void
+bss_props_changed_unsubscribe (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	if (priv->bss_props_changed_id) {
+		g_dbus_connection_signal_unsubscribe (g_dbus_proxy_get_connection (priv->iface_proxy),
+		                                      priv->bss_props_changed_id);
+		priv->bss_props_changed_id = 0;
 	}
-	return g_variant_builder_end (&builder);
 }
 
 static void
-bss_proxy_acquired_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
+bss_get_all_cb (GDBusConnection *connection, GAsyncResult *result, gpointer user_data)
 {
+	BssGetAllData *data = user_data;
 	NMSupplicantInterface *self;
 	NMSupplicantInterfacePrivate *priv;
+	gs_unref_variant GVariant *variant = NULL;
+	gs_unref_variant GVariant *props = NULL;
 	gs_free_error GError *error = NULL;
-	GVariant *props = NULL;
-	const char *object_path;
+	gs_free char *object_path = data->object_path;
 	BssData *bss_data;
-	gboolean success;
 
-	success = g_async_initable_init_finish (G_ASYNC_INITABLE (proxy), result, &error);
-	if (   !success
-	    && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	self = data->self;
+	g_slice_free (BssGetAllData, data);
+
+	variant = g_dbus_connection_call_finish (connection, result, &error);
+	if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
 		return;
 
-	self = NM_SUPPLICANT_INTERFACE (user_data);
 	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	if (!success) {
-		_LOGD ("failed to acquire BSS proxy: (%s)", error->message);
-		g_hash_table_remove (priv->bss_proxies,
-		                     g_dbus_proxy_get_object_path (proxy));
-		return;
-	}
-
-	object_path = g_dbus_proxy_get_object_path (proxy);
-	bss_data = g_hash_table_lookup (priv->bss_proxies, object_path);
-	if (!bss_data)
+	bss_data = g_hash_table_lookup (priv->bss_hash, object_path);
+	if (!bss_data || bss_data->properties)
 		return;
 
-	bss_data->change_id = g_signal_connect (proxy, "g-properties-changed", G_CALLBACK (bss_proxy_properties_changed_cb), self);
-
-	props = bss_proxy_get_properties (self, proxy);
-	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
-	               g_variant_ref_sink (props));
-	g_variant_unref (props);
+	if (!variant) {
+		_LOGD ("failed to get BSS properties: (%s)", error->message);
+		g_hash_table_remove (priv->bss_hash, object_path);
+	} else {
+		props = g_variant_get_child_value (variant, 0);
+		bss_data_update (bss_data, props);
+		g_signal_emit (self, signals[BSS_UPDATED], 0,
+		               object_path,
+		               props);
+	}
 
 	if (priv->scan_done_pending)
 		scan_done_emit_signal (self);
 }
 
+/* Add the BSS at @object_path. @properties are all its properties if they
+ * are already known, like from the BSSAdded signal. Otherwise they are
+ * fetched with GetAll. */
 static void
-bss_add_new (NMSupplicantInterface *self, const char *object_path)
+bss_add_new (NMSupplicantInterface *self, const char *object_path, GVariant *properties)
 {
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-	GDBusProxy *bss_proxy;
+	BssGetAllData *data;
 	BssData *bss_data;
 
 	g_return_if_fail (object_path != NULL);
 
-	if (g_hash_table_lookup (priv->bss_proxies, object_path))
+	if (g_hash_table_lookup (priv->bss_hash, object_path))
 		return;
 
-	bss_proxy = g_object_new (G_TYPE_DBUS_PROXY,
-	                          "g-bus-type", G_BUS_TYPE_SYSTEM,
-	                          "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-	                          "g-name", WPAS_DBUS_SERVICE,
-	                          "g-object-path", object_path,
-	                          "g-interface-name", WPAS_DBUS_IFACE_BSS,
-	                          NULL);
 	bss_data = g_slice_new0 (BssData);
-	bss_data->proxy = bss_proxy;
-	g_hash_table_insert (priv->bss_proxies,
-	                     (char *) g_dbus_proxy_get_object_path (bss_proxy),
-	                     bss_data);
-	g_async_initable_init_async (G_ASYNC_INITABLE (bss_proxy),
-	                             G_PRIORITY_DEFAULT,
-	                             priv->other_cancellable,
-	                             (GAsyncReadyCallback) bss_proxy_acquired_cb,
-	                             self);
+	g_hash_table_insert (priv->bss_hash, g_strdup (object_path), bss_data);
+
+	if (properties) {
+		bss_data_update (bss_data, properties);
+		g_signal_emit (self, signals[BSS_UPDATED], 0,
+		               object_path,
+		               properties);
+		return;
+	}
+
+	data = g_slice_new (BssGetAllData);
+	data->self = self;
+	data->object_path = g_strdup (object_path);
+	g_dbus_connection_call (g_dbus_proxy_get_connection (priv->iface_proxy),
+	                        WPAS_DBUS_SERVICE,
+	                        object_path,
+	                        DBUS_INTERFACE_PROPERTIES,
+	                        "GetAll",
+	                        g_variant_new ("(s)", WPAS_DBUS_IFACE_BSS),
+	                        G_VARIANT_TYPE ("(a{sv})"),
+	                        G_DBUS_CALL_FLAGS_NONE,
+	                        -1,
+	                        priv->other_cancellable,
+	                        (GAsyncReadyCallback) bss_get_all_cb,
+	                        data);
 }
 
 /*****************************************************************************/
@@ -334,8 +412,10 @@ set_state (NMSupplicantInterface *self, NMSupplicantInterfaceState new_state)
 		nm_clear_g_cancellable (&priv->init_cancellable);
 		nm_clear_g_cancellable (&priv->other_cancellable);
 
-		if (priv->iface_proxy)
+		if (priv->iface_proxy) {
 			g_signal_handlers_disconnect_by_data (priv->iface_proxy, self);
+			bss_props_changed_unsubscribe (self);
+		}
 	}
 
 	priv->state = new_state;
@@ -442,6 +522,48 @@ nm_supplicant_interface_get_last_scan_time (NMSupplicantInterface *self)
 	return NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self)->last_scan;
 }
 
+/* Returns the %NULL terminated list of D-Bus paths of the BSSs with known
+ * properties. Free the array with g_free(), the strings are owned by @self. */
+const char **
+nm_supplicant_interface_get_bss_paths (NMSupplicantInterface *self, guint *out_len)
+{
+	NMSupplicantInterfacePrivate *priv;
+	GHashTableIter iter;
+	const char *object_path;
+	BssData *bss_data;
+	const char **paths;
+	guint n = 0;
+
+	g_return_val_if_fail (NM_IS_SUPPLICANT_INTERFACE (self), NULL);
+
+	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	paths = g_new (const char *, g_hash_table_size (priv->bss_hash) + 1);
+	g_hash_table_iter_init (&iter, priv->bss_hash);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &object_path, (gpointer *) &bss_data)) {
+		if (bss_data->properties)
+			paths[n++] = object_path;
+	}
+	paths[n] = NULL;
+	NM_SET_OUT (out_len, n);
+	return paths;
+}
+
+/* Returns a new reference to the last known properties of the BSS, or %NULL. */
+GVariant *
+nm_supplicant_interface_get_bss_properties (NMSupplicantInterface *self, const char *object_path)
+{
+	BssData *bss_data;
+
+	g_return_val_if_fail (NM_IS_SUPPLICANT_INTERFACE (self), NULL);
+	g_return_val_if_fail (object_path, NULL);
+
+	bss_data = g_hash_table_lookup (NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self)->bss_hash, object_path);
+	if (!bss_data || !bss_data->properties)
+		return NULL;
+	return g_variant_ref_sink (bss_data_get_properties (bss_data));
+}
+
 #define MATCH_PROPERTY(p, n, v, t) (!strcmp (p, n) && g_variant_is_of_type (v, t))
 
 static void
@@ -929,32 +1051,23 @@ static void
 scan_done_emit_signal (NMSupplicantInterface *self)
 {
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-	const char *object_path;
 	BssData *bss_data;
 	gboolean success;
 	GHashTableIter iter;
 
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
+	g_hash_table_iter_init (&iter, priv->bss_hash);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &bss_data)) {
 		/* we have some BSS' that need to be initialized first. Delay
 		 * emitting signal. */
-		if (!bss_data->change_id) {
+		if (!bss_data->properties) {
 			priv->scan_done_pending = TRUE;
 			return;
 		}
 	}
 
-	/* Emit BSS_UPDATED so that wifi device has the APs (in case it removed them) */
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
-	while (g_hash_table_iter_next (&iter, (gpointer *) &object_path, (gpointer *) &bss_data)) {
-		gs_unref_variant GVariant *props = NULL;
-
-		props = bss_proxy_get_properties (self, bss_data->proxy);
-		g_signal_emit (self, signals[BSS_UPDATED], 0,
-		               object_path,
-		               g_variant_ref_sink (props));
-	}
-
+	/* All property changes were already announced with BSS_UPDATED. Don't
+	 * emit it again for every BSS. Instead, the wifi device refreshes its
+	 * APs in one go on SCAN_DONE, using nm_supplicant_interface_get_bss_paths(). */
 	success = priv->scan_done_success;
 	priv->scan_done_success = FALSE;
 	priv->scan_done_pending = FALSE;
@@ -987,7 +1100,7 @@ wpas_iface_bss_added (GDBusProxy *proxy,
 	if (priv->scanning)
 		priv->last_scan = nm_utils_get_monotonic_timestamp_s ();
 
-	bss_add_new (self, path);
+	bss_add_new (self, path, props);
 }
 
 static void
@@ -999,12 +1112,10 @@ wpas_iface_bss_removed (GDBusProxy *proxy,
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 	BssData *bss_data;
 
-	bss_data = g_hash_table_lookup (priv->bss_proxies, path);
-	if (!bss_data)
+	if (!g_hash_table_lookup (priv->bss_hash, path))
 		return;
-	g_hash_table_steal (priv->bss_proxies, path);
 	g_signal_emit (self, signals[BSS_REMOVED], 0, path);
-	bss_data_destroy (bss_data);
+	g_hash_table_remove (priv->bss_hash, path);
 }
 
 static void
@@ -1052,7 +1163,7 @@ props_changed_cb (GDBusProxy *proxy,
 	if (g_variant_lookup (changed_properties, "BSSs", "^a&o", &array)) {
 		iter = array;
 		while (*iter)
-			bss_add_new (self, *iter++);
+			bss_add_new (self, *iter++, NULL);
 		g_free (array);
 	}
 
@@ -1112,6 +1223,7 @@ on_iface_proxy_acquired (GDBusProxy *proxy, GAsyncResult *result, gpointer user_
 	                         G_CALLBACK (wpas_iface_bss_added), self);
 	_nm_dbus_signal_connect (priv->iface_proxy, "BSSRemoved", G_VARIANT_TYPE ("(o)"),
 	                         G_CALLBACK (wpas_iface_bss_removed), self);
+	bss_props_changed_subscribe (self);
 	_nm_dbus_signal_connect (priv->iface_proxy, "NetworkRequest", G_VARIANT_TYPE ("(oss)"),
 	                         G_CALLBACK (wpas_iface_network_request), self);
 
@@ -1911,7 +2023,7 @@ nm_supplicant_interface_init (NMSupplicantInterface * self)
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
 	priv->state = NM_SUPPLICANT_INTERFACE_STATE_INIT;
-	priv->bss_proxies = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, bss_data_destroy);
+	priv->bss_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, bss_data_destroy);
 }
 
 NMSupplicantInterface *
@@ -1955,15 +2067,17 @@ dispose (GObject *object)
 		assoc_return (self, error, "cancelled due to dispose of supplicant interface");
 	}
 
-	if (priv->iface_proxy)
+	if (priv->iface_proxy) {
 		g_signal_handlers_disconnect_by_data (priv->iface_proxy, object);
+		bss_props_changed_unsubscribe (self);
+	}
 	g_clear_object (&priv->iface_proxy);
 
 	nm_clear_g_cancellable (&priv->init_cancellable);
 	nm_clear_g_cancellable (&priv->other_cancellable);
 
 	g_clear_object (&priv->wpas_proxy);
-	g_clear_pointer (&priv->bss_proxies, (GDestroyNotify) g_hash_table_destroy);
+	g_clear_pointer (&priv->bss_hash, (GDestroyNotify) g_hash_table_destroy);
 
 	g_clear_pointer (&priv->net_path, g_free);
 	g_clear_pointer (&priv->dev, g_free);
@@ -110,6 +110,10 @@ const char *nm_supplicant_interface_get_current_bss (NMSupplicantInterface *self
 
 gint32 nm_supplicant_interface_get_last_scan_time (NMSupplicantInterface *self);
 
+const char **nm_supplicant_interface_get_bss_paths (NMSupplicantInterface *self, guint *out_len);
+
+GVariant *nm_supplicant_interface_get_bss_properties (NMSupplicantInterface *self, const char *object_path);
+
 const char *nm_supplicant_interface_get_ifname (NMSupplicantInterface *self);
 
 guint nm_supplicant_interface_get_max_scan_ssids (NMSupplicantInterface *self);